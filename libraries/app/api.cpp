@@ -26,8 +26,11 @@
 #include <graphene/app/api.hpp>
 #include <graphene/app/api_access.hpp>
 #include <graphene/app/application.hpp>
+#include <graphene/account_history/account_history_plugin.hpp>
+#include <graphene/account_history/account_history_store.hpp>
 #include <graphene/chain/database.hpp>
 #include <graphene/chain/get_config.hpp>
+#include <graphene/market_history/market_history_store.hpp>
 #include <graphene/utilities/key_conversion.hpp>
 #include <graphene/protocol/fee_schedule.hpp>
 #include <graphene/chain/confidential_object.hpp>
@@ -55,6 +58,14 @@ template class fc::api<graphene::app::login_api>;
 
 namespace graphene { namespace app {
 
+    /// @return the store of the irreversible account history, or nullptr if there is none
+    static const account_history::account_history_store* get_history_store( const application& app )
+    {
+       auto plugin = std::dynamic_pointer_cast<account_history::account_history_plugin>(
+                        app.get_plugin( "account_history" ) );
+       return plugin ? plugin->history_store() : nullptr;
+    }
+
     login_api::login_api(application& a)
     :_app(a)
     {
@@ -343,6 +354,16 @@ namespace graphene { namespace app {
           ++count;
        }
 
+       // older orders that have been removed from memory may be in the store
+       const auto* store = market_hist_plugin->history_store();
+       if( store != nullptr && count < limit )
+       {
+          const int64_t after_sequence = result.empty() ? std::numeric_limits<int64_t>::min()
+                                                         : result.back().key.sequence;
+          auto older = store->get_fills( a, b, after_sequence, limit - count );
+          result.insert( result.end(), older.begin(), older.end() );
+       }
+
        return result;
     }
 
@@ -361,12 +382,18 @@ namespace graphene { namespace app {
 
        vector<operation_history_object> result;
        account_id_type account;
+       const account_transaction_history_object* node = nullptr;
        try {
           account = database_api.get_account_id_from_string(account_id_or_name);
-          const account_transaction_history_object& node = account(db).statistics(db).most_recent_op(db);
-          if(start == operation_history_id_type() || start.instance.value > node.operation_id.instance.value)
-             start = node.operation_id;
+          // the most recent entry is not in memory if it has been moved to the history store
+          node = db.find( account(db).statistics(db).most_recent_op );
        } catch(...) { return result; }
+       const auto* store = get_history_store( _app );
+       if( node == nullptr && store == nullptr )
+          return result;
+       if( node != nullptr &&
+             ( start == operation_history_id_type() || start.instance.value > node->operation_id.instance.value ) )
+          start = node->operation_id;
 
        if(_app.is_plugin_enabled("elasticsearch")) {
           auto es = _app.get_plugin<elasticsearch::elasticsearch_plugin>("elasticsearch");
@@ -380,19 +407,32 @@ namespace graphene { namespace app {
           }
        }
 
-       const auto& hist_idx = db.get_index_type<account_transaction_history_index>();
-       const auto& by_op_idx = hist_idx.indices().get<by_op>();
-       auto index_start = by_op_idx.begin();
-       auto itr = by_op_idx.lower_bound(boost::make_tuple(account, start));
-
-       while(itr != index_start && itr->account == account && itr->operation_id.instance.value > stop.instance.value && result.size() < limit)
+       if( node != nullptr )
        {
-          if(itr->operation_id.instance.value <= start.instance.value)
-             result.push_back(itr->operation_id(db));
-          --itr;
+          const auto& hist_idx = db.get_index_type<account_transaction_history_index>();
+          const auto& by_op_idx = hist_idx.indices().get<by_op>();
+          auto index_start = by_op_idx.begin();
+          auto itr = by_op_idx.lower_bound(boost::make_tuple(account, start));
+
+          while(itr != index_start && itr->account == account && itr->operation_id.instance.value > stop.instance.value && result.size() < limit)
+          {
+             if(itr->operation_id.instance.value <= start.instance.value)
+                result.push_back(itr->operation_id(db));
+             --itr;
+          }
+          if(stop.instance.value == 0 && result.size() < limit && itr->account == account) {
+            result.push_back(itr->operation_id(db));
+          }
        }
-       if(stop.instance.value == 0 && result.size() < limit && itr->account == account) {
-         result.push_back(itr->operation_id(db));
+
+       if( store != nullptr && result.size() < limit )
+       {
+          // the entries up to removed_ops have been moved to the history store
+          const uint64_t max_operation = ( start == operation_history_id_type() ) ?
+                                         std::numeric_limits<uint64_t>::max() : start.instance.value;
+          auto older = store->get_account_history( account, account(db).statistics(db).removed_ops, 0,
+                                                   max_operation, stop.instance.value, limit - result.size() );
+          std::move( older.begin(), older.end(), std::back_inserter( result ) );
        }
 
        return result;
@@ -419,8 +459,11 @@ namespace graphene { namespace app {
        } catch(...) { return result; }
        const auto& stats = account(db).statistics(db);
        if( stats.most_recent_op == account_transaction_history_id_type() ) return result;
-       const account_transaction_history_object* node = &stats.most_recent_op(db);
-       if( start == operation_history_id_type() )
+       // the most recent entry is not in memory if it has been moved to the history store
+       const account_transaction_history_object* node = db.find( stats.most_recent_op );
+       const auto* store = get_history_store( _app );
+       if( node == nullptr && store == nullptr ) return result;
+       if( node != nullptr && start == operation_history_id_type() )
           start = node->operation_id;
 
        while(node && node->operation_id.instance.value > stop.instance.value && result.size() < limit)
@@ -432,13 +475,38 @@ namespace graphene { namespace app {
           }
           if( node->next == account_transaction_history_id_type() )
              node = nullptr;
-          else node = &node->next(db);
+          else node = db.find( node->next );
        }
        if( stop.instance.value == 0 && result.size() < limit ) {
           auto head = db.find(account_transaction_history_id_type());
           if (head != nullptr && head->account == account && head->operation_id(db).op.which() == operation_type)
             result.push_back(head->operation_id(db));
        }
+
+       if( store != nullptr && result.size() < limit )
+       {
+          // the entries up to removed_ops have been moved to the history store, read them in batches until
+          // enough operations of the type are found
+          uint64_t max_operation = ( start == operation_history_id_type() ) ?
+                                   std::numeric_limits<uint64_t>::max() : start.instance.value;
+          const uint32_t batch_size = std::max( limit, 100u );
+          while( result.size() < limit )
+          {
+             auto older = store->get_account_history( account, stats.removed_ops, 0, max_operation,
+                                                      stop.instance.value, batch_size );
+             if( older.empty() )
+                break;
+             const uint64_t oldest_operation = older.back().id.instance();
+             for( auto& op : older )
+             {
+                if( op.op.which() == operation_type && result.size() < limit )
+                   result.push_back( std::move(op) );
+             }
+             if( older.size() < batch_size || oldest_operation == 0 )
+                break;
+             max_operation = oldest_operation - 1;
+          }
+       }
        return result;
     }
 
@@ -482,6 +550,16 @@ namespace graphene { namespace app {
           }
           while ( itr != itr_stop && result.size() < limit );
        }
+
+       const auto* store = get_history_store( _app );
+       if( store != nullptr && start >= stop && stop <= stats.removed_ops && result.size() < limit )
+       {
+          // the entries up to removed_ops have been moved to the history store
+          auto older = store->get_account_history( account, std::min( start, stats.removed_ops ), stop,
+                                                   std::numeric_limits<uint64_t>::max(), 0,
+                                                   limit - result.size() );
+          std::move( older.begin(), older.end(), std::back_inserter( result ) );
+       }
        return result;
     }
 
@@ -530,28 +608,11 @@ namespace graphene { namespace app {
        FC_ASSERT( market_hist_plugin, "Market history plugin is not enabled" );
        FC_ASSERT(_app.chain_database());
 
-       const auto& db = *_app.chain_database();
        asset_id_type a = database_api.get_token_id_from_string( asset_a );
        asset_id_type b = database_api.get_token_id_from_string( asset_b );
-       vector<bucket_object> result;
-       result.reserve(200);
-
        if( a > b ) std::swap(a,b);
 
-       const auto& bidx = db.get_index_type<bucket_index>();
-       const auto& by_key_idx = bidx.indices().get<by_key>();
-
-       auto itr = by_key_idx.lower_bound( bucket_key( a, b, bucket_seconds, start ) );
-       while( itr != by_key_idx.end() && itr->key.open <= end && result.size() < 200 )
-       {
-          if( !(itr->key.base == a && itr->key.quote == b && itr->key.seconds == bucket_seconds) )
-          {
-            return result;
-          }
-          result.push_back(*itr);
-          ++itr;
-       }
-       return result;
+       return market_hist_plugin->get_market_history( a, b, bucket_seconds, start, end, 200 );
     } FC_CAPTURE_AND_RETHROW( (asset_a)(asset_b)(bucket_seconds)(start)(end) ) }
 
     vector<liquidity_pool_history_object> history_api::get_liquidity_pool_history(
@@ -753,8 +814,9 @@ namespace graphene { namespace app {
        vector<account_asset_balance> result;
 
        uint32_t index = 0;
-       for( const account_balance_object& bal : boost::make_iterator_range( range.first, range.second ) )
+       for( const account_balance_object* bal_ptr : boost::make_iterator_range( range.first, range.second ) )
        {
+          const account_balance_object& bal = *bal_ptr;
           if( result.size() >= limit )
              break;
 
@@ -833,8 +895,6 @@ namespace graphene { namespace app {
 
       auto plugin = _app.get_plugin<graphene::grouped_orders::grouped_orders_plugin>( "grouped_orders" );
       FC_ASSERT( plugin );
-      const auto& limit_groups = plugin->limit_order_groups();
-      vector< limit_order_group > result;
 
       asset_id_type base_asset_id = database_api.get_token_id_from_string( base_asset );
       asset_id_type quote_asset_id = database_api.get_token_id_from_string( quote_asset );
@@ -844,15 +904,8 @@ namespace graphene { namespace app {
       if( start.valid() && !start->is_null() )
          max_price = std::max( std::min( max_price, *start ), min_price );
 
-      auto itr = limit_groups.lower_bound( limit_order_group_key( group, max_price ) );
-      // use an end iterator to try to avoid expensive price comparison
-      auto end = limit_groups.upper_bound( limit_order_group_key( group, min_price ) );
-      while( itr != end && result.size() < limit )
-      {
-         result.emplace_back( *itr );
-         ++itr;
-      }
-      return result;
+      const auto groups = plugin->limit_order_groups( group, base_asset_id, quote_asset_id, max_price, limit );
+      return vector< limit_order_group >( groups.begin(), groups.end() );
    }
 
    // custom operations api
@@ -872,4 +925,73 @@ namespace graphene { namespace app {
       return results;
    }
 
+   const account_storage_catalog_index& custom_operations_api::get_catalog_index()const
+   {
+      auto plugin = _app.get_plugin<graphene::custom_operations::custom_operations_plugin>("custom_operations");
+      FC_ASSERT( plugin );
+
+      try
+      {
+         return _app.chain_database()->get_index_type< primary_index< account_storage_index > >()
+                                      .get_secondary_index< account_storage_catalog_index >();
+      }
+      catch( const fc::assert_exception& )
+      {
+         FC_THROW( "custom-operations-catalog-index is not enabled on this server." );
+      }
+   }
+
+   vector<account_storage_object> custom_operations_api::get_storage_info_by_catalog_key( std::string catalog,
+         std::string key, optional<uint32_t> olimit, optional<account_id_type> ostart_id )const
+   {
+      uint32_t limit = olimit.valid() ? *olimit : 100;
+      const auto configured_limit = _app.get_options().api_limit_get_storage_info;
+      FC_ASSERT( limit <= configured_limit,
+                 "limit can not be greater than ${configured_limit}",
+                 ("configured_limit", configured_limit) );
+
+      const auto& catalog_keys = get_catalog_index().get_catalog_keys();
+      const auto& storage_idx = _app.chain_database()->get_index_type<account_storage_index>()
+                                                      .indices().get<by_account_catalog_key>();
+
+      account_id_type start_id = ostart_id.valid() ? *ostart_id : account_id_type();
+      auto itr = catalog_keys.lower_bound( std::make_tuple( catalog, key, start_id ) );
+
+      vector<account_storage_object> results;
+      results.reserve( limit );
+      while( itr != catalog_keys.end() && results.size() < limit
+             && std::get<0>( *itr ) == catalog && std::get<1>( *itr ) == key )
+      {
+         auto aso = storage_idx.find( std::make_tuple( std::get<2>( *itr ), catalog, key ) );
+         FC_ASSERT( aso != storage_idx.end(), "Internal error" );
+         results.push_back( *aso );
+         ++itr;
+      }
+      return results;
+   }
+
+   vector<account_id_type> custom_operations_api::get_accounts_by_catalog( std::string catalog,
+         optional<uint32_t> olimit, optional<account_id_type> ostart_id )const
+   {
+      uint32_t limit = olimit.valid() ? *olimit : 100;
+      const auto configured_limit = _app.get_options().api_limit_get_storage_info;
+      FC_ASSERT( limit <= configured_limit,
+                 "limit can not be greater than ${configured_limit}",
+                 ("configured_limit", configured_limit) );
+
+      const auto& catalogs = get_catalog_index().get_catalogs();
+
+      account_id_type start_id = ostart_id.valid() ? *ostart_id : account_id_type();
+      auto itr = catalogs.lower_bound( std::make_pair( catalog, start_id ) );
+
+      vector<account_id_type> results;
+      results.reserve( limit );
+      while( itr != catalogs.end() && results.size() < limit && itr->first.first == catalog )
+      {
+         results.push_back( itr->first.second );
+         ++itr;
+      }
+      return results;
+   }
+
 } } // graphene::app
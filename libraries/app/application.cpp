@@ -394,6 +394,12 @@ void application_impl::set_api_limit() {
       _app_options.api_limit_get_liquidity_pool_history =
             _options->at("api-limit-get-liquidity-pool-history").as<uint64_t>();
    }
+   if(_options->count("api-limit-get-blocks") > 0) {
+      _app_options.api_limit_get_blocks = _options->at("api-limit-get-blocks").as<uint64_t>();
+   }
+   if(_options->count("api-limit-get-storage-info") > 0) {
+      _app_options.api_limit_get_storage_info = _options->at("api-limit-get-storage-info").as<uint64_t>();
+   }
 }
 
 graphene::chain::genesis_state_type application_impl::initialize_genesis_state() const
@@ -474,6 +480,12 @@ void application_impl::open_chain_database() const
       _chain_db->enable_standby_votes_tracking( _options->at("enable-standby-votes-tracking").as<bool>() );
    }
 
+   if( _options->count("parallel-authority-checks") > 0 )
+      _chain_db->enable_parallel_authority_checks( _options->at("parallel-authority-checks").as<bool>() );
+
+   if( _options->count("max-pending-transactions") > 0 )
+      _chain_db->set_max_pending_transactions( _options->at("max-pending-transactions").as<uint32_t>() );
+
    if( _options->count("replay-blockchain") > 0 || _options->count("revalidate-blockchain") > 0 )
       _chain_db->wipe( _data_dir / "blockchain", false );
 
@@ -625,10 +637,7 @@ bool application_impl::handle_block(const graphene::net::block_message& blk_msg,
          contained_transaction_msg_ids.reserve( contained_transaction_msg_ids.size()
                                                     + blk_msg.block.transactions.size() );
          for (const processed_transaction& ptrx : blk_msg.block.transactions)
-         {
-            graphene::net::trx_message transaction_message(ptrx);
-            contained_transaction_msg_ids.emplace_back(graphene::net::message(transaction_message).id());
-         }
+            contained_transaction_msg_ids.emplace_back(ptrx.get_message_id());
       }
 
       return result;
@@ -1125,6 +1134,12 @@ void application::set_program_options(boost::program_options::options_descriptio
          ("enable-standby-votes-tracking", bpo::value<bool>()->implicit_value(true),
           "Whether to enable tracking of votes of standby blockproducers and dxpcore members. "
           "Set it to true to provide accurate data to API clients, set to false for slightly better performance.")
+         ("parallel-authority-checks", bpo::value<bool>()->implicit_value(true),
+          "Whether to check the authorities of the transactions in a block on multiple threads before applying "
+          "them. The results are identical to checking them one by one.")
+         ("max-pending-transactions", bpo::value<uint32_t>()->default_value(0),
+          "Maximum number of transactions waiting to be included in a block, 0 for no limit. Further transactions "
+          "are rejected until a new block has been pushed.")
          ("api-limit-get-account-history-operations",boost::program_options::value<uint64_t>()->default_value(100),
           "For history_api::get_account_history_operations to set max limit value")
          ("api-limit-get-account-history",boost::program_options::value<uint64_t>()->default_value(100),
@@ -1188,6 +1203,10 @@ void application::set_program_options(boost::program_options::options_descriptio
           "Set maximum limit value for database APIs which query for liquidity pools")
          ("api-limit-get-liquidity-pool-history", boost::program_options::value<uint64_t>()->default_value(101),
           "Set maximum limit value for APIs which query for history of liquidity pools")
+         ("api-limit-get-blocks", boost::program_options::value<uint64_t>()->default_value(100),
+          "Set maximum limit value for database APIs which query for blocks")
+         ("api-limit-get-storage-info", boost::program_options::value<uint64_t>()->default_value(100),
+          "Set maximum limit value for custom operations APIs which query for stored data by catalog")
          ;
    command_line_options.add(configuration_file_options);
    command_line_options.add_options()
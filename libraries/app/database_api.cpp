@@ -94,6 +94,16 @@ database_api_impl::database_api_impl( graphene::chain::database& db, const appli
    {
       asset_in_liquidity_pools_index = nullptr;
    }
+
+   try
+   {
+      account_name_index = &_db.get_index_type< primary_index< account_index > >()
+            .get_secondary_index<graphene::chain::account_name_index>();
+   }
+   catch( const fc::assert_exception& )
+   {
+      account_name_index = nullptr;
+   }
 }
 
 database_api_impl::~database_api_impl()
@@ -251,6 +261,32 @@ optional<signed_block> database_api_impl::get_block(uint32_t block_num)const
    return _db.fetch_block_by_number(block_num);
 }
 
+vector<signed_block> database_api::get_blocks(uint32_t block_num, uint32_t limit)const
+{
+   return my->get_blocks( block_num, limit );
+}
+
+vector<signed_block> database_api_impl::get_blocks(uint32_t block_num, uint32_t limit)const
+{
+   FC_ASSERT( _app_options, "Internal error" );
+   const auto configured_limit = _app_options->api_limit_get_blocks;
+   FC_ASSERT( limit <= configured_limit,
+              "limit can not be greater than ${configured_limit}",
+              ("configured_limit", configured_limit) );
+
+   vector<signed_block> results;
+   results.reserve( limit );
+   const uint32_t head_num = _db.head_block_num();
+   for( uint32_t num = block_num; num <= head_num && results.size() < limit; ++num )
+   {
+      optional<signed_block> block = _db.fetch_block_by_number( num );
+      if( !block.valid() )
+         break;
+      results.push_back( std::move( *block ) );
+   }
+   return results;
+}
+
 processed_transaction database_api::get_transaction( uint32_t block_num, uint32_t trx_in_block )const
 {
    return my->get_transaction( block_num, trx_in_block );
@@ -373,22 +409,22 @@ vector<flat_set<account_id_type>> database_api_impl::get_key_references( vector<
 
       for( auto& a : {a1,a2,a3,a4,a5} )
       {
-          auto itr = refs.account_to_address_memberships.find(a);
-          if( itr != refs.account_to_address_memberships.end() )
+          const auto* accounts = refs.account_to_address_memberships.find(a);
+          if( accounts != nullptr )
           {
-             result.reserve( result.size() + itr->second.size() );
-             for( auto item : itr->second )
+             result.reserve( result.size() + accounts->size() );
+             for( auto item : *accounts )
              {
                 result.insert(item);
              }
           }
       }
 
-      auto itr = refs.account_to_key_memberships.find(key);
-      if( itr != refs.account_to_key_memberships.end() )
+      const auto* accounts = refs.account_to_key_memberships.find(key);
+      if( accounts != nullptr )
       {
-         result.reserve( result.size() + itr->second.size() );
-         for( auto item : itr->second ) result.insert(item);
+         result.reserve( result.size() + accounts->size() );
+         for( auto item : *accounts ) result.insert(item);
       }
       final_result.emplace_back( std::move(result) );
    }
@@ -424,8 +460,7 @@ bool database_api_impl::is_public_key_registered(string public_key) const
     const auto& idx = _db.get_index_type<account_index>();
     const auto& aidx = dynamic_cast<const base_primary_index&>(idx);
     const auto& refs = aidx.get_secondary_index<graphene::chain::account_member_index>();
-    auto itr = refs.account_to_key_memberships.find(key);
-    bool is_known = itr != refs.account_to_key_memberships.end();
+    bool is_known = refs.account_to_key_memberships.find(key) != nullptr;
 
     return is_known;
 }
@@ -668,9 +703,9 @@ vector<account_statistics_object> database_api_impl::get_top_voters(uint32_t lim
    auto last_vote_tally_time = _db.get_dynamic_global_properties().last_vote_tally_time;
    const auto& idx = _db.get_index_type<account_stats_index>().indices().get<by_voting_power_active>();
 
-   for(auto itr = idx.begin(); result.size() < limit && itr != idx.end() && itr->vote_tally_time >= last_vote_tally_time; ++itr)
+   for(auto itr = idx.begin(); result.size() < limit && itr != idx.end() && (*itr)->vote_tally_time >= last_vote_tally_time; ++itr)
    {
-      result.emplace_back(*itr);
+      result.emplace_back(**itr);
    }
 
    return result;
@@ -683,6 +718,13 @@ optional<account_object> database_api::get_account_by_name( string name )const
 
 optional<account_object> database_api_impl::get_account_by_name( string name )const
 {
+   if( account_name_index )
+   {
+      const auto id = account_name_index->find( name );
+      if( id.valid() )
+         return (*id)(_db);
+      return optional<account_object>();
+   }
    const auto& idx = _db.get_index_type<account_index>().indices().get<by_name>();
    auto itr = idx.find(name);
    if (itr != idx.end())
@@ -705,13 +747,13 @@ vector<account_id_type> database_api_impl::get_account_references( const std::st
    const auto& aidx = dynamic_cast<const base_primary_index&>(idx);
    const auto& refs = aidx.get_secondary_index<graphene::chain::account_member_index>();
    const account_id_type account_id = get_account_from_string(account_id_or_name)->id;
-   auto itr = refs.account_to_account_memberships.find(account_id);
+   const auto* accounts = refs.account_to_account_memberships.find(account_id);
    vector<account_id_type> result;
 
-   if( itr != refs.account_to_account_memberships.end() )
+   if( accounts != nullptr )
    {
-      result.reserve( itr->second.size() );
-      for( auto item : itr->second ) result.push_back(item);
+      result.reserve( accounts->size() );
+      for( auto item : *accounts ) result.push_back(item);
    }
    return result;
 }
@@ -750,6 +792,16 @@ map<string,account_id_type> database_api_impl::lookup_accounts( const string& lo
       return result;
    // In addition to the common auto-subscription rules, here we auto-subscribe if only look for one account
    bool to_subscribe = (limit == 1 && get_whether_to_subscribe( subscribe ));
+   if( account_name_index )
+   {
+      for( auto& entry : account_name_index->list( lower_bound_name, limit ) )
+      {
+         if( to_subscribe )
+            subscribe_to_item( entry.second );
+         result.insert( std::move( entry ) );
+      }
+      return result;
+   }
    for( auto itr = accounts_by_name.lower_bound(lower_bound_name);
         limit-- && itr != accounts_by_name.end();
         ++itr )
@@ -3008,6 +3060,12 @@ const account_object* database_api_impl::get_account_from_string( const std::str
    const account_object* account = nullptr;
    if (std::isdigit(name_or_id[0]))
       account = _db.find(fc::variant(name_or_id, 1).as<account_id_type>(1));
+   else if( account_name_index )
+   {
+      const auto id = account_name_index->find( name_or_id );
+      if( id.valid() )
+         account = &(*id)(_db);
+   }
    else
    {
       const auto& idx = _db.get_index_type<account_index>().indices().get<by_name>();
@@ -205,7 +205,9 @@ namespace graphene { namespace app {
           * @param a Asset symbol or ID in a trading pair
           * @param b The other asset symbol or ID in the trading pair
           * @param bucket_seconds Length of each time bucket in seconds.
-          * Note: it need to be within result of get_market_history_buckets() API, otherwise no data will be returned
+          * Note: it need to be within result of get_market_history_buckets() API, or a multiple of one of them,
+          * in which case the data is rolled up from the largest of them that divides it, otherwise no data will be
+          * returned
           * @param start The start of a time range, E.G. "2018-01-01T00:00:00"
           * @param end The end of the time range
           * @return A list of OHLCV data, in "least recent first" order.
@@ -568,6 +570,9 @@ namespace graphene { namespace app {
           * @param start Optional price to indicate the first order group to retrieve
           * @param limit Maximum number of order groups to retrieve (must not exceed 101)
           * @return The grouped limit orders, ordered from best offered price to worst
+          *
+          * A market has at most 10000 groups of each size. If its orders are spread wider than that, the orders
+          * beyond are counted in the first or the last group, whose price range is then wider than @p group.
           */
          vector< limit_order_group > get_grouped_limit_orders( std::string base_asset,
                                                                std::string quote_asset,
@@ -600,7 +605,46 @@ namespace graphene { namespace app {
           */
          vector<account_storage_object> get_storage_info(std::string account_name_or_id, std::string catalog)const;
 
-   private:
+         /**
+          * @brief Get the stored objects of all accounts with a particular catalog and key
+          *
+          * @param catalog Category classification
+          * @param key The key in the catalog
+          * @param limit The limitation of items each query can fetch, not greater than a configured value
+          * @param start_id Start account ID, fetch objects of accounts whose IDs are greater than or equal to
+          *                 this ID
+          *
+          * @return The objects in ascending order of their account IDs
+          *
+          * @note This API requires the custom_operations plugin to run with custom-operations-catalog-index
+          *       enabled.
+          * @note To get the next page, use the account ID of the last object plus one as @p start_id.
+          */
+         vector<account_storage_object> get_storage_info_by_catalog_key( std::string catalog, std::string key,
+                                                                         optional<uint32_t> limit = 100,
+                                                                         optional<account_id_type> start_id =
+                                                                               optional<account_id_type>() )const;
+
+         /**
+          * @brief Get the accounts that store objects in a particular catalog
+          *
+          * @param catalog Category classification
+          * @param limit The limitation of items each query can fetch, not greater than a configured value
+          * @param start_id Start account ID, fetch accounts whose IDs are greater than or equal to this ID
+          *
+          * @return The account IDs in ascending order
+          *
+          * @note This API requires the custom_operations plugin to run with custom-operations-catalog-index
+          *       enabled.
+          */
+         vector<account_id_type> get_accounts_by_catalog( std::string catalog,
+                                                          optional<uint32_t> limit = 100,
+                                                          optional<account_id_type> start_id =
+                                                                optional<account_id_type>() )const;
+
+      private:
+         const account_storage_catalog_index& get_catalog_index()const;
+
          application& _app;
          graphene::app::database_api database_api;
    };
@@ -744,6 +788,8 @@ FC_API(graphene::app::orders_api,
      )
 FC_API(graphene::app::custom_operations_api,
        (get_storage_info)
+       (get_storage_info_by_catalog_key)
+       (get_accounts_by_catalog)
      )
 FC_API(graphene::app::login_api,
        (login)
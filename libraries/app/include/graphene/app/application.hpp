@@ -75,6 +75,8 @@ namespace graphene { namespace app {
          uint64_t api_limit_get_tickets = 101;
          uint64_t api_limit_get_liquidity_pools = 101;
          uint64_t api_limit_get_liquidity_pool_history = 101;
+         uint64_t api_limit_get_blocks = 100;
+         uint64_t api_limit_get_storage_info = 100;
    };
 
    class application
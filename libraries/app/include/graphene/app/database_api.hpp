@@ -174,6 +174,15 @@ class database_api
        */
       optional<signed_block> get_block(uint32_t block_num)const;
 
+      /**
+       * @brief Retrieve consecutive full, signed blocks
+       * @param block_num Height of the first block to be returned
+       * @param limit Maximum number of blocks to return, can not be greater than the configured value of
+       *              api-limit-get-blocks
+       * @return the blocks from the referenced one on, up to the first block that was not found
+       */
+      vector<signed_block> get_blocks(uint32_t block_num, uint32_t limit)const;
+
       /**
        * @brief used to fetch an individual transaction.
        * @param block_num height of the block to fetch
@@ -1136,6 +1145,7 @@ FC_API(graphene::app::database_api,
    (get_block_header)
    (get_block_header_batch)
    (get_block)
+   (get_blocks)
    (get_transaction)
    (get_recent_transaction_by_id)
 
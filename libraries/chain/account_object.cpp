@@ -142,15 +142,15 @@ void account_member_index::object_inserted(const object& obj)
 
     auto account_members = get_account_members(a);
     for( auto item : account_members )
-       account_to_account_memberships[item].insert(obj.id);
+       account_to_account_memberships.insert( item, a.get_id() );
 
     auto key_members = get_key_members(a);
     for( auto item : key_members )
-       account_to_key_memberships[item].insert(obj.id);
+       account_to_key_memberships.insert( item, a.get_id() );
 
     auto address_members = get_address_members(a);
     for( auto item : address_members )
-       account_to_address_memberships[item].insert(obj.id);
+       account_to_address_memberships.insert( item, a.get_id() );
 }
 
 void account_member_index::object_removed(const object& obj)
@@ -160,15 +160,15 @@ void account_member_index::object_removed(const object& obj)
 
     auto key_members = get_key_members(a);
     for( auto item : key_members )
-       account_to_key_memberships[item].erase( obj.id );
+       account_to_key_memberships.erase( item, a.get_id() );
 
     auto address_members = get_address_members(a);
     for( auto item : address_members )
-       account_to_address_memberships[item].erase( obj.id );
+       account_to_address_memberships.erase( item, a.get_id() );
 
     auto account_members = get_account_members(a);
     for( auto item : account_members )
-       account_to_account_memberships[item].erase( obj.id );
+       account_to_account_memberships.erase( item, a.get_id() );
 }
 
 void account_member_index::about_to_modify(const object& before)
@@ -195,15 +195,15 @@ void account_member_index::object_modified(const object& after)
                            std::inserter(removed, removed.end()));
 
        for( auto itr = removed.begin(); itr != removed.end(); ++itr )
-          account_to_account_memberships[*itr].erase(after.id);
+          account_to_account_memberships.erase( *itr, a.get_id() );
 
-       vector<object_id_type> added; added.reserve(after_account_members.size());
+       vector<account_id_type> added; added.reserve(after_account_members.size());
        std::set_difference(after_account_members.begin(), after_account_members.end(),
                            before_account_members.begin(), before_account_members.end(),
                            std::inserter(added, added.end()));
 
        for( auto itr = added.begin(); itr != added.end(); ++itr )
-          account_to_account_memberships[*itr].insert(after.id);
+          account_to_account_memberships.insert( *itr, a.get_id() );
     }
 
 
@@ -216,7 +216,7 @@ void account_member_index::object_modified(const object& after)
                            std::inserter(removed, removed.end()));
 
        for( auto itr = removed.begin(); itr != removed.end(); ++itr )
-          account_to_key_memberships[*itr].erase(after.id);
+          account_to_key_memberships.erase( *itr, a.get_id() );
 
        vector<public_key_type> added; added.reserve(after_key_members.size());
        std::set_difference(after_key_members.begin(), after_key_members.end(),
@@ -224,7 +224,7 @@ void account_member_index::object_modified(const object& after)
                            std::inserter(added, added.end()));
 
        for( auto itr = added.begin(); itr != added.end(); ++itr )
-          account_to_key_memberships[*itr].insert(after.id);
+          account_to_key_memberships.insert( *itr, a.get_id() );
     }
 
     {
@@ -236,7 +236,7 @@ void account_member_index::object_modified(const object& after)
                            std::inserter(removed, removed.end()));
 
        for( auto itr = removed.begin(); itr != removed.end(); ++itr )
-          account_to_address_memberships[*itr].erase(after.id);
+          account_to_address_memberships.erase( *itr, a.get_id() );
 
        vector<address> added; added.reserve(after_address_members.size());
        std::set_difference(after_address_members.begin(), after_address_members.end(),
@@ -244,11 +244,185 @@ void account_member_index::object_modified(const object& after)
                            std::inserter(added, added.end()));
 
        for( auto itr = added.begin(); itr != added.end(); ++itr )
-          account_to_address_memberships[*itr].insert(after.id);
+          account_to_address_memberships.insert( *itr, a.get_id() );
     }
 
 }
 
+const size_t account_name_index::block_names = 32;
+
+namespace {
+   /// Calls f( name, position ) for the names of a front-coded block in order, until it returns false
+   template< typename F >
+   void for_each_name( const string& names, F&& f )
+   {
+      string name;
+      size_t position = 0;
+      for( size_t i = 0; i < names.size(); ++position )
+      {
+         const uint8_t shared = static_cast<uint8_t>( names[i] );
+         const uint8_t rest = static_cast<uint8_t>( names[i+1] );
+         name.resize( shared );
+         name.append( names, i + 2, rest );
+         i += 2 + rest;
+         if( !f( name, position ) )
+            return;
+      }
+   }
+}
+
+size_t account_name_index::find_block( const string& name )const
+{
+   // the last block whose first name is not greater than the name, or the first block
+   auto itr = std::upper_bound( _first_names.begin(), _first_names.end(), name );
+   return itr == _first_names.begin() ? 0 : ( itr - _first_names.begin() ) - 1;
+}
+
+account_name_index::entries_type account_name_index::decode( const name_block& block )
+{
+   entries_type entries;
+   entries.reserve( block.ids.size() + 1 );
+   for_each_name( block.names, [&block,&entries]( const string& name, size_t position ) {
+      entries.emplace_back( name, block.ids[position] );
+      return true;
+   });
+   return entries;
+}
+
+account_name_index::name_block account_name_index::encode( entries_type::const_iterator begin,
+                                                           entries_type::const_iterator end )
+{
+   name_block block;
+   block.ids.reserve( end - begin );
+   const string* previous = nullptr;
+   for( auto itr = begin; itr != end; ++itr )
+   {
+      const string& name = itr->first;
+      size_t shared = 0;
+      if( previous != nullptr )
+         while( shared < previous->size() && shared < name.size() && (*previous)[shared] == name[shared] )
+            ++shared;
+      block.names.push_back( static_cast<char>( shared ) );
+      block.names.push_back( static_cast<char>( name.size() - shared ) );
+      block.names.append( name, shared, string::npos );
+      block.ids.push_back( itr->second );
+      previous = &name;
+   }
+   block.names.shrink_to_fit();
+   return block;
+}
+
+void account_name_index::store( size_t position, const entries_type& entries )
+{
+   if( entries.empty() )
+   {
+      _blocks.erase( _blocks.begin() + position );
+      _first_names.erase( _first_names.begin() + position );
+      return;
+   }
+   if( entries.size() <= 2 * block_names )
+   {
+      _blocks[position] = encode( entries.begin(), entries.end() );
+      _first_names[position] = entries.front().first;
+      return;
+   }
+   const auto middle = entries.begin() + entries.size() / 2;
+   _blocks[position] = encode( entries.begin(), middle );
+   _first_names[position] = entries.front().first;
+   _blocks.insert( _blocks.begin() + position + 1, encode( middle, entries.end() ) );
+   _first_names.insert( _first_names.begin() + position + 1, middle->first );
+}
+
+void account_name_index::object_inserted( const object& obj )
+{
+   assert( dynamic_cast<const account_object*>(&obj) ); // for debug only
+   const account_object& a = static_cast<const account_object&>(obj);
+   FC_ASSERT( a.name.size() <= std::numeric_limits<uint8_t>::max(), "Account name is too long to be indexed" );
+
+   if( _blocks.empty() )
+   {
+      _blocks.emplace_back();
+      _first_names.emplace_back();
+   }
+   const size_t position = find_block( a.name );
+   entries_type entries = decode( _blocks[position] );
+   auto itr = std::lower_bound( entries.begin(), entries.end(), a.name,
+                                []( const pair<string, account_id_type>& e, const string& n ) { return e.first < n; } );
+   entries.emplace( itr, a.name, a.get_id() );
+   store( position, entries );
+   ++_size;
+}
+
+void account_name_index::object_removed( const object& obj )
+{
+   assert( dynamic_cast<const account_object*>(&obj) ); // for debug only
+   const account_object& a = static_cast<const account_object&>(obj);
+
+   if( _blocks.empty() )
+      return;
+   const size_t position = find_block( a.name );
+   entries_type entries = decode( _blocks[position] );
+   auto itr = std::lower_bound( entries.begin(), entries.end(), a.name,
+                                []( const pair<string, account_id_type>& e, const string& n ) { return e.first < n; } );
+   if( itr == entries.end() || itr->first != a.name )
+      return;
+   entries.erase( itr );
+   store( position, entries );
+   --_size;
+}
+
+optional<account_id_type> account_name_index::find( const string& name )const
+{
+   optional<account_id_type> result;
+   if( _blocks.empty() )
+      return result;
+   const name_block& block = _blocks[ find_block( name ) ];
+   for_each_name( block.names, [&block,&name,&result]( const string& n, size_t position ) {
+      if( n < name )
+         return true;
+      if( n == name )
+         result = block.ids[position];
+      return false;
+   });
+   return result;
+}
+
+vector< pair<string, account_id_type> > account_name_index::list( const string& lower_bound_name, uint32_t limit,
+                                                                  const string& prefix )const
+{
+   entries_type result;
+   if( _blocks.empty() || limit == 0 )
+      return result;
+   const string& start = std::max( lower_bound_name, prefix );
+   bool done = false;
+   for( size_t position = find_block( start ); position < _blocks.size() && !done; ++position )
+   {
+      const name_block& block = _blocks[position];
+      for_each_name( block.names, [&]( const string& n, size_t i ) {
+         if( n < start )
+            return true;
+         if( n.compare( 0, prefix.size(), prefix ) != 0 )
+         {
+            done = true;
+            return false;
+         }
+         result.emplace_back( n, block.ids[i] );
+         done = ( result.size() >= limit );
+         return !done;
+      });
+   }
+   return result;
+}
+
+size_t account_name_index::memory_usage()const
+{
+   size_t result = _blocks.capacity() * sizeof(name_block) + _first_names.capacity() * sizeof(string);
+   for( size_t i = 0; i < _blocks.size(); ++i )
+      result += _blocks[i].names.capacity() + _blocks[i].ids.capacity() * sizeof(account_id_type)
+                + _first_names[i].size();
+   return result;
+}
+
 const uint8_t  balances_by_account_index::bits = 20;
 const uint64_t balances_by_account_index::mask = (1ULL << balances_by_account_index::bits) - 1;
 
@@ -27,6 +27,7 @@
 #include <graphene/chain/hardfork.hpp>
 
 #include <graphene/chain/block_summary_object.hpp>
+#include <graphene/chain/custom_authority_object.hpp>
 #include <graphene/chain/global_property_object.hpp>
 #include <graphene/chain/operation_history_object.hpp>
 
@@ -42,6 +43,9 @@
 #include <fc/io/raw.hpp>
 #include <fc/thread/parallel.hpp>
 
+#include <algorithm>
+#include <future>
+
 namespace graphene { namespace chain {
 
 bool database::is_known_block( const block_id_type& id )const
@@ -119,7 +123,7 @@ bool database::push_block(const signed_block& new_block, uint32_t skip)
    bool result;
    detail::with_skip_flags( *this, skip, [&]()
    {
-      detail::without_pending_transactions( *this, std::move(_pending_tx),
+      detail::without_pending_transactions( *this, std::move(_pending_tx), std::move(_pending_tx_changes),
       [&]()
       {
          result = _push_block(new_block);
@@ -267,7 +271,9 @@ void database::update_blockproducers( fork_item& fork_entry )const
 processed_transaction database::push_transaction( const precomputable_transaction& trx, uint32_t skip )
 { try {
    // see https://gitlab.com/dxperts/dxperts-core/issues/1573
-   FC_ASSERT( fc::raw::pack_size( trx ) < (1024 * 1024), "Transaction exceeds maximum transaction size." );
+   FC_ASSERT( trx.get_signed_packed_size() < (1024 * 1024), "Transaction exceeds maximum transaction size." );
+   FC_ASSERT( _max_pending_transactions == 0 || _pending_tx.size() < _max_pending_transactions,
+              "Too many pending transactions, try again after the next block" );
    processed_transaction result;
    detail::with_skip_flags( *this, skip, [&]()
    {
@@ -288,9 +294,21 @@ processed_transaction database::_push_transaction( const precomputable_transacti
    // _apply_transaction fails.  If we make it to merge(), we
    // apply the changes.
 
+   // Only the changes of transactions whose operations all have complete footprints can be redone, see
+   // _restore_pending_transactions(), the others are not recorded
+   pending_transaction_changes changes;
+   const bool record_changes = std::all_of( trx.operations.begin(), trx.operations.end(),
+                                            operation_footprint_is_complete );
+   // The footprint depends on objects the transaction may remove
+   if( record_changes )
+      transaction_get_footprint( *this, trx, changes.footprint );
+
    auto temp_session = _undo_db.start_undo_session();
    auto processed_trx = _apply_transaction( trx );
+   if( record_changes )
+      _get_pending_transaction_changes( changes );
    _pending_tx.push_back(processed_trx);
+   _pending_tx_changes.push_back( std::move(changes) );
 
    // notify_changed_objects();
    // The transaction applied successfully. Merge its changes into the pending block session.
@@ -301,6 +319,166 @@ processed_transaction database::_push_transaction( const precomputable_transacti
    return processed_trx;
 }
 
+void database::_get_pending_transaction_changes( pending_transaction_changes& changes )const
+{
+   if( !_undo_db.enabled() )
+      return;
+
+   const auto& state = _undo_db.head();
+   changes.modified.reserve( state.old_values.size() );
+   for( const auto& item : state.old_values )
+      changes.modified.push_back( get_object( item.first ).clone() );
+   changes.created.reserve( state.new_ids.size() );
+   for( const auto& id : state.new_ids )
+   {
+      if( id.space() != implementation_ids || id.type() != impl_transaction_history_object_type )
+         changes.created.push_back( get_object( id ).clone() );
+   }
+   // Objects of a type are created in the order of their IDs
+   std::sort( changes.created.begin(), changes.created.end(),
+              []( const unique_ptr<object>& a, const unique_ptr<object>& b ) { return a->id < b->id; } );
+   changes.removed.reserve( state.removed.size() );
+   for( const auto& item : state.removed )
+      changes.removed.push_back( item.second->clone() );
+   changes.complete = true;
+}
+
+void database::_reapply_pending_transaction( const processed_transaction& trx,
+                                             pending_transaction_changes&& changes )
+{
+   FC_ASSERT( changes.complete );
+   if( !_pending_tx_session.valid() )
+      _pending_tx_session = _undo_db.start_undo_session();
+
+   auto temp_session = _undo_db.start_undo_session();
+   _verify_and_record_transaction( trx, false );
+
+   for( const auto& obj : changes.removed )
+      remove( get_object( obj->id ) );
+   for( const auto& obj : changes.modified )
+   {
+      auto value = obj->clone();
+      modify( get_object( obj->id ), [&value]( object& o ) { o.move_from( *value ); } );
+   }
+   for( const auto& obj : changes.created )
+   {
+      // Fails if the new head block or a transaction evaluated again took the ID
+      index& idx = get_mutable_index( obj->id );
+      FC_ASSERT( idx.get_next_id() == obj->id, "Can not create ${id} again", ("id",obj->id) );
+      insert( std::move( *obj->clone() ) );
+      idx.use_next_id();
+   }
+
+   _pending_tx.push_back( trx );
+   _pending_tx_changes.push_back( std::move(changes) );
+   temp_session.merge();
+}
+
+void database::_restore_pending_transactions( vector<processed_transaction>&& pending,
+                                              vector<pending_transaction_changes>&& changes,
+                                              const block_id_type& old_head )
+{
+   // Changes can only be redone on top of the state they were made in, plus the new head block
+   bool reuse_changes = _popped_tx.empty() && changes.size() == pending.size() && _undo_db.enabled();
+
+   for( const auto& tx : _popped_tx )
+   {
+      try {
+         if( !is_known_transaction( tx.id() ) ) {
+            _push_transaction( tx );
+         }
+      } catch ( const fc::exception& ) { // ignore invalid transactions
+      }
+   }
+   _popped_tx.clear();
+
+   // Everything changed since the pending transactions were applied
+   std::unordered_set<object_id_type> changed_ids;
+   object_footprint changed;
+   auto add_changed = [this,&changed_ids,&changed]( const object& obj ) {
+      changed_ids.insert( obj.id );
+      object_get_footprint( *this, obj, changed );
+   };
+   auto add_transaction_changes = [&add_changed]( const pending_transaction_changes& c ) {
+      for( const auto& obj : c.created )
+         add_changed( *obj );
+      for( const auto& obj : c.modified )
+         add_changed( *obj );
+      for( const auto& obj : c.removed )
+         add_changed( *obj );
+   };
+   auto depends_on_changes = [&changed_ids,&changed]( const pending_transaction_changes& c ) {
+      if( !c.complete )
+         return true;
+      for( const auto& obj : c.modified )
+         if( changed_ids.count( obj->id ) > 0 )
+            return true;
+      for( const auto& obj : c.removed )
+         if( changed_ids.count( obj->id ) > 0 )
+            return true;
+      return c.footprint.reads.intersects( changed ) || c.footprint.writes.intersects( changed );
+   };
+
+   if( reuse_changes && head_block_id() != old_head )
+   {
+      const auto head = _fork_db.fetch_block( head_block_id() );
+      const auto previous_head = _fork_db.fetch_block( old_head );
+      reuse_changes = head && previous_head && head->previous_id() == old_head && _undo_db.size() > 0
+                      && footprint_hardforks_equal( previous_head->data.timestamp, head_block_time() );
+      if( reuse_changes )
+      {
+         const auto& state = _undo_db.head();
+         for( const auto& item : state.old_values )
+            add_changed( *item.second );
+         for( const auto& item : state.removed )
+            add_changed( *item.second );
+         for( const auto& id : state.new_ids )
+            add_changed( get_object( id ) );
+         // Chain parameters and hardforks take effect at maintenance, evaluate everything again
+         reuse_changes = ( changed_ids.count( global_property_id_type() ) == 0 );
+      }
+   }
+
+   for( size_t i = 0; i < pending.size(); ++i )
+   {
+      const processed_transaction& tx = pending[i];
+      // What a transaction without recorded changes did is not known, so later ones may depend on anything
+      if( reuse_changes && !changes[i].complete )
+         reuse_changes = false;
+      try
+      {
+         if( is_known_transaction( tx.id() ) )
+         {
+            if( reuse_changes )
+               add_transaction_changes( changes[i] );
+            continue;
+         }
+         // Only the changes of transactions whose reads are all in their footprint are recorded and can be redone,
+         // the others are evaluated again
+         if( reuse_changes && !depends_on_changes( changes[i] ) )
+         {
+            try
+            {
+               _reapply_pending_transaction( tx, std::move( changes[i] ) );
+               continue;
+            }
+            catch( const fc::exception& )
+            { // e.g. expired, evaluate it again to find out
+            }
+         }
+         // Later transactions may depend on both the old and the new changes of this one
+         if( reuse_changes )
+            add_transaction_changes( changes[i] );
+         _push_transaction( tx );
+         if( reuse_changes )
+            add_transaction_changes( _pending_tx_changes.back() );
+      }
+      catch( const fc::exception& )
+      { // ignore invalid transactions
+      }
+   }
+}
+
 processed_transaction database::validate_transaction( const signed_transaction& trx )
 {
    auto session = _undo_db.start_undo_session();
@@ -380,6 +558,42 @@ signed_block database::generate_block(
    return result;
 } FC_CAPTURE_AND_RETHROW() }
 
+namespace detail {
+   struct fee_and_payer_visitor
+   {
+      typedef std::pair<account_id_type, asset> result_type;
+      template<typename Op>
+      result_type operator()( const Op& op )const { return std::make_pair( op.fee_payer(), op.fee ); }
+   };
+}
+
+/// The fee @p trx pays per kilobyte, in the core asset. Fees in other assets are converted at their core exchange rate.
+static uint64_t core_fee_per_kilobyte( const database& db, const transaction& trx, size_t packed_size )
+{
+   fc::uint128_t total_fee = 0;
+   for( const auto& op : trx.operations )
+   {
+      const asset fee = op.visit( detail::fee_and_payer_visitor() ).second;
+      if( fee.amount <= 0 )
+         continue;
+      if( fee.asset_id == asset_id_type() )
+         total_fee += fee.amount.value;
+      else
+      {
+         const asset_object* fee_asset = db.find( fee.asset_id );
+         if( fee_asset == nullptr )
+            continue;
+         try {
+            total_fee += ( fee * fee_asset->options.core_exchange_rate ).amount.value;
+         } catch( const fc::exception& ) { // overflow, it counts as no fee
+         }
+      }
+   }
+   fc::uint128_t result = total_fee * 1024 / std::max<size_t>( packed_size, 1 );
+   return result > std::numeric_limits<uint64_t>::max() ? std::numeric_limits<uint64_t>::max()
+                                                          : static_cast<uint64_t>( result );
+}
+
 signed_block database::_generate_block(
    fc::time_point_sec when,
    blockproducer_id_type blockproducer_id,
@@ -431,49 +645,164 @@ signed_block database::_generate_block(
 
    _pending_tx_session = _undo_db.start_undo_session();
 
-   uint64_t postponed_tx_count = 0;
-   for( const processed_transaction& tx : _pending_tx )
+   // Order the candidates by the fee they pay per kilobyte. The transactions of each fee payer stay in the order
+   // they arrived in, as later ones may depend on earlier ones. Transactions that are expired or can never fit are
+   // not tried.
+   const fc::time_point_sec head_time = head_block_time();
+   vector<size_t> packed_sizes( _pending_tx.size() );
+   vector<uint64_t> fee_rates( _pending_tx.size() );
+   vector< std::deque<size_t> > queues;
+   std::map<account_id_type, size_t> queue_of_payer;
+   size_t min_packed_size = std::numeric_limits<size_t>::max();
+   uint64_t skipped_tx_count = 0;
+   for( size_t i = 0; i < _pending_tx.size(); ++i )
    {
-      size_t new_total_size = total_block_size + fc::raw::pack_size( tx );
-
-      // postpone transaction if it would make block too big
-      if( new_total_size > maximum_block_size )
+      const processed_transaction& tx = _pending_tx[i];
+      packed_sizes[i] = tx.get_processed_packed_size();
+      if( tx.operations.empty() || tx.expiration < head_time
+            || max_block_header_size + packed_sizes[i] > maximum_block_size )
       {
-         postponed_tx_count++;
+         ++skipped_tx_count;
          continue;
       }
-
+      fee_rates[i] = core_fee_per_kilobyte( *this, tx, packed_sizes[i] );
+      min_packed_size = std::min( min_packed_size, packed_sizes[i] );
+      const account_id_type payer = tx.operations.front().visit( detail::fee_and_payer_visitor() ).first;
+      auto itr = queue_of_payer.find( payer );
+      if( itr == queue_of_payer.end() )
+      {
+         itr = queue_of_payer.emplace( payer, queues.size() ).first;
+         queues.emplace_back();
+      }
+      queues[itr->second].push_back( i );
+   }
+   // Queues by the fee rate of their first transaction, then by arrival, so with equal fees this is arrival order
+   auto lower_priority = [&queues,&fee_rates]( size_t a, size_t b ) {
+      const size_t first_a = queues[a].front();
+      const size_t first_b = queues[b].front();
+      if( fee_rates[first_a] != fee_rates[first_b] )
+         return fee_rates[first_a] < fee_rates[first_b];
+      return first_a > first_b;
+   };
+   vector<size_t> ready( queues.size() );
+   for( size_t i = 0; i < ready.size(); ++i )
+      ready[i] = i;
+   std::make_heap( ready.begin(), ready.end(), lower_priority );
+
+   const fc::time_point deadline = ( _block_generation_time_limit.count() > 0 )
+                                   ? fc::time_point::now() + _block_generation_time_limit
+                                   : fc::time_point::maximum();
+   // Applies a candidate to the block unless it would make the block too big
+   enum class candidate_result { applied, too_big, failed };
+   auto apply_candidate = [&]( size_t i, fc::optional<fc::exception>& error ) {
+      const processed_transaction& tx = _pending_tx[i];
+      if( total_block_size + packed_sizes[i] > maximum_block_size )
+         return candidate_result::too_big;
       try
       {
          auto temp_session = _undo_db.start_undo_session();
          processed_transaction ptx = _apply_transaction( tx );
 
-         // We have to recompute pack_size(ptx) because it may be different
-         // than pack_size(tx) (i.e. if one or more results increased
-         // their size)
-         new_total_size = total_block_size + fc::raw::pack_size( ptx );
-         // postpone transaction if it would make block too big
+         // We have to recompute the size of ptx because it may be different
+         // than the size of tx (i.e. if one or more results increased
+         // their size), the packed signed transaction is the same though
+         const size_t new_total_size = total_block_size + tx.get_signed_packed_size()
+                                       + fc::raw::pack_size( ptx.operation_results );
          if( new_total_size > maximum_block_size )
-         {
-            postponed_tx_count++;
-            continue;
-         }
+            return candidate_result::too_big;
 
          temp_session.merge();
-
          total_block_size = new_total_size;
          pending_block.transactions.push_back( ptx );
+         return candidate_result::applied;
       }
       catch ( const fc::exception& e )
       {
-         // Do nothing, transaction will not be re-applied
-         wlog( "Transaction was not processed while generating block due to ${e}", ("e", e) );
-         wlog( "The transaction was ${t}", ("t", tx) );
+         error = e;
+         return candidate_result::failed;
       }
+   };
+   auto block_is_closed = [&]() {
+      return total_block_size + min_packed_size > maximum_block_size || fc::time_point::now() > deadline;
+   };
+
+   uint64_t postponed_tx_count = 0;
+   // Transactions that failed, with their errors, in the order they were tried
+   vector< std::pair<size_t, fc::exception> > failed;
+   while( !ready.empty() )
+   {
+      // The block is full, or time is up
+      if( block_is_closed() )
+         break;
+
+      std::pop_heap( ready.begin(), ready.end(), lower_priority );
+      std::deque<size_t>& queue = queues[ready.back()];
+      const size_t i = queue.front();
+      queue.pop_front();
+
+      fc::optional<fc::exception> error;
+      const candidate_result result = apply_candidate( i, error );
+      // postpone transaction if it would make block too big, and the later ones of its fee payer with it
+      if( result == candidate_result::too_big )
+      {
+         postponed_tx_count += 1 + queue.size();
+         queue.clear();
+      }
+      else if( result == candidate_result::failed )
+         failed.emplace_back( i, *error );
+
+      if( queue.empty() )
+         ready.pop_back();
+      else
+         std::push_heap( ready.begin(), ready.end(), lower_priority );
+   }
+   for( size_t q : ready )
+      postponed_tx_count += queues[q].size();
+
+   // A failed transaction may depend on a transaction of another fee payer that was applied after it, e.g. on a
+   // transfer of the funds it spends, or on the creation of its fee payer. Failed transactions are tried again in
+   // arrival order, as long as that gets more of them into the block.
+   bool retry = true;
+   while( retry && !failed.empty() && ready.empty() )
+   {
+      retry = false;
+      std::sort( failed.begin(), failed.end(),
+                 []( const std::pair<size_t, fc::exception>& a, const std::pair<size_t, fc::exception>& b ) {
+                    return a.first < b.first;
+                 } );
+      vector< std::pair<size_t, fc::exception> > still_failed;
+      for( size_t f = 0; f < failed.size(); ++f )
+      {
+         if( block_is_closed() )
+         {
+            postponed_tx_count += failed.size() - f;
+            retry = false;
+            break;
+         }
+         fc::optional<fc::exception> error;
+         const candidate_result result = apply_candidate( failed[f].first, error );
+         if( result == candidate_result::applied )
+            retry = true;
+         else if( result == candidate_result::too_big )
+            ++postponed_tx_count;
+         else
+            still_failed.emplace_back( failed[f].first, *error );
+      }
+      failed.swap( still_failed );
+   }
+   for( const auto& item : failed )
+   {
+      // Do nothing, transaction will not be re-applied
+      wlog( "Transaction was not processed while generating block due to ${e}", ("e", item.second) );
+      wlog( "The transaction was ${t}", ("t", _pending_tx[item.first]) );
    }
    if( postponed_tx_count > 0 )
    {
-      wlog( "Postponed ${n} transactions due to block size limit", ("n", postponed_tx_count) );
+      wlog( "Postponed ${n} transactions due to block size or time limit", ("n", postponed_tx_count) );
+   }
+   if( skipped_tx_count > 0 )
+   {
+      wlog( "Skipped ${n} expired or oversized transactions", ("n", skipped_tx_count) );
    }
 
    _pending_tx_session.reset();
@@ -515,12 +844,15 @@ void database::pop_block()
    }
    pop_undo();
    _popped_tx.insert( _popped_tx.begin(), fork_db_head->data.transactions.begin(), fork_db_head->data.transactions.end() );
+   // The pending transactions were applied on top of the popped block, their changes can not be redone
+   _pending_tx_changes.clear();
 } FC_CAPTURE_AND_RETHROW() }
 
 void database::clear_pending()
 { try {
    assert( (_pending_tx.size() == 0) || _pending_tx_session.valid() );
    _pending_tx.clear();
+   _pending_tx_changes.clear();
    _pending_tx_session.reset();
 } FC_CAPTURE_AND_RETHROW() }
 
@@ -572,6 +904,16 @@ void database::apply_block( const signed_block& next_block, uint32_t skip )
    return;
 }
 
+/// Whether an operation can change the authorities that the transactions after it are checked against
+static bool operation_changes_authorities( const operation& op )
+{
+   return op.is_type<account_update_operation>()
+       || op.is_type<custom_authority_create_operation>()
+       || op.is_type<custom_authority_update_operation>()
+       || op.is_type<custom_authority_delete_operation>()
+       || op.is_type<proposal_update_operation>(); // may execute any of the above
+}
+
 void database::_apply_block( const signed_block& next_block )
 { try {
    uint32_t next_block_num = next_block.block_num();
@@ -580,7 +922,7 @@ void database::_apply_block( const signed_block& next_block )
 
    if( !(skip & skip_block_size_check) )
    {
-      FC_ASSERT( fc::raw::pack_size(next_block) <= get_global_properties().parameters.maximum_block_size );
+      FC_ASSERT( next_block.get_packed_size() <= get_global_properties().parameters.maximum_block_size );
    }
 
    FC_ASSERT( (skip & skip_merkle_check) || next_block.transaction_merkle_root == next_block.calculate_merkle_root(),
@@ -606,6 +948,10 @@ void database::_apply_block( const signed_block& next_block )
 
    _issue_453_affected_assets.clear();
 
+   vector<bool> authority_checked;
+   if( _parallel_authority_checks && !(skip & skip_transaction_signatures) && next_block.transactions.size() > 1 )
+      authority_checked = check_authorities_parallel( next_block );
+
    for( const auto& trx : next_block.transactions )
    {
       /* We do not need to push the undo state for each transaction
@@ -614,7 +960,12 @@ void database::_apply_block( const signed_block& next_block )
        * for transactions when validating broadcast transactions or
        * when building a block.
        */
-      apply_transaction( trx, skip );
+      _apply_transaction( trx, _current_trx_in_block < authority_checked.size()
+                               && authority_checked[_current_trx_in_block] );
+      // Authorities checked against the state before the block are stale after the first change to them
+      if( !authority_checked.empty() && std::any_of( trx.operations.begin(), trx.operations.end(),
+                                                     operation_changes_authorities ) )
+         authority_checked.clear();
       ++_current_trx_in_block;
    }
 
@@ -670,12 +1021,34 @@ processed_transaction database::apply_transaction(const signed_transaction& trx,
    return result;
 }
 
-processed_transaction database::_apply_transaction(const signed_transaction& trx)
+processed_transaction database::_apply_transaction(const signed_transaction& trx, bool authority_checked)
 { try {
-   uint32_t skip = get_node_properties().skip_flags;
-
    trx.validate();
 
+   _verify_and_record_transaction( trx, authority_checked );
+
+   transaction_evaluation_state eval_state(this);
+   eval_state._trx = &trx;
+   eval_state.operation_results.reserve(trx.operations.size());
+
+   //Finally process the operations
+   processed_transaction ptrx(trx);
+   _current_op_in_trx = 0;
+   for( const auto& op : ptrx.operations )
+   {
+      _current_virtual_op = 0;
+      eval_state.operation_results.emplace_back(apply_operation(eval_state, op));
+      ++_current_op_in_trx;
+   }
+   ptrx.operation_results = std::move(eval_state.operation_results);
+
+   return ptrx;
+} FC_CAPTURE_AND_RETHROW( (trx) ) }
+
+void database::_verify_and_record_transaction( const signed_transaction& trx, bool authority_checked )
+{
+   uint32_t skip = get_node_properties().skip_flags;
+
    auto& trx_idx = get_mutable_index_type<transaction_index>();
    const chain_id_type& chain_id = get_chain_id();
    if( !(skip & skip_transaction_dupe_check) )
@@ -685,11 +1058,9 @@ processed_transaction database::_apply_transaction(const signed_transaction& trx
                        "Transaction '${txid}' is already in the database",
                        ("txid",trx.id()) );
    }
-   transaction_evaluation_state eval_state(this);
    const chain_parameters& chain_parameters = get_global_properties().parameters;
-   eval_state._trx = &trx;
 
-   if( !(skip & skip_transaction_signatures) )
+   if( !(skip & skip_transaction_signatures) && !authority_checked )
    {
       bool allow_non_immediate_owner = ( head_block_time() >= HARDFORK_CORE_584_TIME );
       auto get_active = [this]( account_id_type id ) { return &id(*this).active; };
@@ -734,22 +1105,7 @@ processed_transaction database::_apply_transaction(const signed_transaction& trx
          transaction.trx = trx;
       });
    }
-
-   eval_state.operation_results.reserve(trx.operations.size());
-
-   //Finally process the operations
-   processed_transaction ptrx(trx);
-   _current_op_in_trx = 0;
-   for( const auto& op : ptrx.operations )
-   {
-      _current_virtual_op = 0;
-      eval_state.operation_results.emplace_back(apply_operation(eval_state, op));
-      ++_current_op_in_trx;
-   }
-   ptrx.operation_results = std::move(eval_state.operation_results);
-
-   return ptrx;
-} FC_CAPTURE_AND_RETHROW( (trx) ) }
+}
 
 operation_result database::apply_operation(transaction_evaluation_state& eval_state, const operation& op)
 { try {
@@ -811,6 +1167,16 @@ bool database::before_last_checkpoint()const
 static const uint32_t skip_expensive = database::skip_transaction_signatures | database::skip_blockproducer_signature
                                        | database::skip_merkle_check | database::skip_transaction_dupe_check;
 
+/// Caches the values only needed for transactions in blocks, nothing to do for single transactions
+static void precompute_block_transaction( const processed_transaction& trx, const uint32_t skip )
+{
+   if( !(skip & database::skip_block_size_check) )
+      trx.get_processed_packed_size();
+   if( !(skip & database::skip_merkle_check) )
+      trx.merkle_digest();
+}
+static void precompute_block_transaction( const precomputable_transaction&, const uint32_t ) {}
+
 template<typename Trx>
 void database::_precompute_parallel( const Trx* trx, const size_t count, const uint32_t skip )const
 {
@@ -823,6 +1189,7 @@ void database::_precompute_parallel( const Trx* trx, const size_t count, const u
          trx->id();
       if( !(skip&skip_transaction_signatures) )
          trx->get_signature_keys( get_chain_id() );
+      precompute_block_transaction( *trx, skip );
    }
 }
 
@@ -847,20 +1214,22 @@ fc::future<void> database::precompute_parallel( const signed_block& block, const
       }
    }
 
+   fc::future<void> signee;
    if( !(skip&skip_blockproducer_signature) )
-      benefactors.push_back( fc::do_parallel( [&block] () { block.signee(); } ) );
+      signee = fc::do_parallel( [&block] () { block.signee(); } );
+   block.id();
+
+   // The merkle root and the block size are calculated from the values the transactions have cached above
+   for( auto& benefactor : benefactors )
+      benefactor.wait();
    if( !(skip&skip_merkle_check) )
       block.calculate_merkle_root();
-   block.id();
+   if( !(skip&skip_block_size_check) )
+      block.get_packed_size();
 
-   if( benefactors.empty() )
+   if( !signee.valid() )
       return fc::future< void >( fc::promise< void >::create( true ) );
-
-   auto first = benefactors.begin();
-   auto benefactor = first;
-   while( ++benefactor != benefactors.end() )
-      benefactor->wait();
-   return *first;
+   return signee;
 } FC_LOG_AND_RETHROW() }
 
 fc::future<void> database::precompute_parallel( const precomputable_transaction& trx )const
@@ -870,4 +1239,60 @@ fc::future<void> database::precompute_parallel( const precomputable_transaction&
    });
 }
 
+vector<bool> database::check_authorities_parallel( const signed_block& block )const
+{ try {
+   const auto& custom_auths = get_index_type<custom_authority_index>().indices().get<by_account_custom>();
+   const chain_id_type& chain_id = get_chain_id();
+   const bool allow_non_immediate_owner = ( head_block_time() >= HARDFORK_CORE_584_TIME );
+   const bool ignore_custom_op_reqd_auths = MUST_IGNORE_CUSTOM_OP_REQD_AUTHS( head_block_time() );
+   const uint32_t max_depth = get_global_properties().parameters.max_authority_depth;
+
+   // Written by different threads, so not a vector<bool>
+   vector<uint8_t> checked( block.transactions.size(), false );
+   auto check = [&,this]( size_t base, size_t count ) {
+      auto get_active = [this]( account_id_type id ) { return &id(*this).active; };
+      auto get_owner  = [this]( account_id_type id ) { return &id(*this).owner;  };
+      for( size_t i = base; i < base + count; ++i )
+      {
+         // Custom authorities cache their predicates when they are evaluated, which is not thread safe
+         bool needs_custom = false;
+         auto get_custom = [&custom_auths,&needs_custom]( account_id_type id, const operation& op,
+                                                          rejected_predicate_map* ) {
+            auto range = custom_auths.equal_range( boost::make_tuple( id, unsigned_int(op.which()), true ) );
+            needs_custom |= ( range.first != range.second );
+            return vector<authority>();
+         };
+         try {
+            block.transactions[i].verify_authority( chain_id, get_active, get_owner, get_custom,
+                                                    allow_non_immediate_owner, ignore_custom_op_reqd_auths,
+                                                    max_depth );
+            checked[i] = !needs_custom;
+         } catch( ... ) {
+            // left to the serial check, which throws the exception in block order
+         }
+      }
+   };
+
+   // The state must not change while the checks run, so block this thread instead of yielding to other tasks
+   const uint32_t chunks = std::max<uint32_t>( fc::asio::default_io_service_scope::get_num_threads(), 1 );
+   const size_t chunk_size = ( block.transactions.size() + chunks - 1 ) / chunks;
+   vector<std::promise<void>> done( ( block.transactions.size() + chunk_size - 1 ) / chunk_size );
+   vector<fc::future<void>> benefactors;
+   benefactors.reserve( done.size() );
+   for( size_t base = 0, chunk = 0; base < block.transactions.size(); base += chunk_size, ++chunk )
+      benefactors.push_back( fc::do_parallel( [&check,&done,&block,base,chunk,chunk_size] () {
+         try {
+            check( base, std::min( chunk_size, block.transactions.size() - base ) );
+         } catch( ... ) {
+            // e.g. out of memory, the rest of the chunk is left to the serial check
+         }
+         // must be set in any case, this thread waits for it
+         done[chunk].set_value();
+      }) );
+   for( auto& d : done )
+      d.get_future().wait();
+
+   return vector<bool>( checked.begin(), checked.end() );
+} FC_CAPTURE_AND_RETHROW( (block.block_num()) ) }
+
 } }
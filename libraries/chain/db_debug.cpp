@@ -43,8 +43,8 @@ void database::debug_dump()
    const auto& db = *this;
    const asset_dynamic_data_object& core_asset_data = db.get_core_asset().dynamic_asset_data_id(db);
 
-   const auto& balance_index = db.get_index_type<account_balance_index>().indices();
-   const auto& statistics_index = db.get_index_type<account_stats_index>().indices();
+   const auto& balance_index = db.get_index_type<account_balance_index>();
+   const auto& statistics_index = db.get_index_type<account_stats_index>();
    const auto& bids = db.get_index_type<collateral_bid_index>().indices();
    const auto& settle_index = db.get_index_type<force_settlement_index>().indices();
    const auto& htlcs = db.get_index_type<htlc_index>().indices();
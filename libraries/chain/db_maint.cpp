@@ -81,9 +81,9 @@ void database::perform_account_maintenance(Type tally_helper)
    if( bal_idx.begin() != bal_idx.end() )
    {
       auto bal_itr = bal_idx.rbegin();
-      while( bal_itr->maintenance_flag )
+      while( (*bal_itr)->maintenance_flag )
       {
-         const account_balance_object& bal_obj = *bal_itr;
+         const account_balance_object& bal_obj = **bal_itr;
 
          modify( get_account_stats_by_owner( bal_obj.owner ), [&bal_obj](account_statistics_object& aso) {
             aso.core_in_balance = bal_obj.balance;
@@ -102,7 +102,7 @@ void database::perform_account_maintenance(Type tally_helper)
 
    while( stats_itr != stats_idx.end() )
    {
-      const account_statistics_object& acc_stat = *stats_itr;
+      const account_statistics_object& acc_stat = **stats_itr;
       const account_object& acc_obj = acc_stat.owner( *this );
       ++stats_itr;
 
@@ -587,8 +587,9 @@ void update_top_n_authorities( database& db )
 
          // find accounts
          const auto range = bal_idx.equal_range( boost::make_tuple( tha.asset ) );
-         for( const account_balance_object& bal : boost::make_iterator_range( range.first, range.second ) )
+         for( const account_balance_object* bal_ptr : boost::make_iterator_range( range.first, range.second ) )
          {
+             const account_balance_object& bal = *bal_ptr;
              assert( bal.asset_type == tha.asset );
              if( bal.owner == acct.id )
                 continue;
@@ -24,11 +24,16 @@
 #pragma once
 
 #include <graphene/chain/types.hpp>
+#include <graphene/db/dense_index.hpp>
 #include <graphene/db/generic_index.hpp>
 #include <graphene/protocol/account.hpp>
 
+#include <boost/functional/hash.hpp>
 #include <boost/multi_index/composite_key.hpp>
 
+#include <array>
+#include <unordered_map>
+
 namespace graphene { namespace chain {
    class database;
    class account_object;
@@ -325,6 +330,64 @@ namespace graphene { namespace chain {
          account_id_type get_id()const { return id; }
    };
 
+   /**
+    *  @brief A hash table from keys, addresses or accounts to the accounts that reference them
+    *
+    *  The table is split into shards by the high bits of the mixed hash of the key, so that growing it rehashes one
+    *  small hash table at a time instead of all entries at once. The hash is mixed because hashes of IDs are their
+    *  instance numbers, whose high bits are all zero. The referencing accounts are kept in flat sets, as most
+    *  keys are referenced by a single account. Like in the maps this replaces, entries stay when the last account
+    *  referencing them goes away.
+    */
+   template< typename Key, typename Hash = std::hash<Key>, uint8_t ShardBits = 6 >
+   class account_reference_table
+   {
+      public:
+         typedef flat_set<account_id_type> accounts_type;
+         static constexpr size_t shard_count = size_t(1) << ShardBits;
+
+         /// @return the accounts referencing the given key, or nullptr if it has never been referenced
+         const accounts_type* find( const Key& key )const
+         {
+            const auto& s = _shards[ shard_of( key ) ];
+            auto itr = s.find( key );
+            return itr == s.end() ? nullptr : &itr->second;
+         }
+
+         void insert( const Key& key, account_id_type account )
+         {
+            _shards[ shard_of( key ) ][ key ].insert( account );
+         }
+
+         void erase( const Key& key, account_id_type account )
+         {
+            auto& s = _shards[ shard_of( key ) ];
+            auto itr = s.find( key );
+            if( itr != s.end() )
+               itr->second.erase( account );
+         }
+
+         /// @return the number of keys in the table
+         size_t size()const
+         {
+            size_t result = 0;
+            for( const auto& s : _shards )
+               result += s.size();
+            return result;
+         }
+
+         /// @return the shard the key belongs to
+         static size_t shard_of( const Key& key )
+         {
+            // Fibonacci hashing, the multiplication moves the low bits of the hash into the high bits of the result
+            const uint64_t mixed = uint64_t( Hash()( key ) ) * UINT64_C(0x9E3779B97F4A7C15);
+            return size_t( mixed >> ( 64 - ShardBits ) );
+         }
+
+      private:
+         std::array< std::unordered_map< Key, accounts_type, Hash >, shard_count > _shards;
+   };
+
    /**
     *  @brief This secondary index will allow a reverse lookup of all accounts that a particular key or account
     *  is an potential signing authority.
@@ -339,10 +402,10 @@ namespace graphene { namespace chain {
 
 
          /** given an account or key, map it to the set of accounts that reference it in an active or owner authority */
-         map< account_id_type, set<account_id_type> >                    account_to_account_memberships;
-         map< public_key_type, set<account_id_type>, pubkey_comparator > account_to_key_memberships;
+         account_reference_table< account_id_type, boost::hash<account_id_type> > account_to_account_memberships;
+         account_reference_table< public_key_type >                               account_to_key_memberships;
          /** some accounts use address authorities in the genesis block */
-         map< address, set<account_id_type> >                            account_to_address_memberships;
+         account_reference_table< address >                                       account_to_address_memberships;
 
 
       protected:
@@ -355,6 +418,62 @@ namespace graphene { namespace chain {
          set<address>                            before_address_members;
    };
 
+   /**
+    *  @brief This secondary index keeps the names of all accounts in a compact sorted store
+    *
+    *  Names are kept in ascending order in blocks of up to 2 * block_names names. Within a block each name is
+    *  front-coded, i.e. stored as the length of the prefix it shares with the previous name, the length of the rest
+    *  and the rest itself. The first names of all blocks are kept in one array, so that a lookup is a binary search
+    *  over that array and a scan of a single block, which touches far less memory than walking the by_name index of
+    *  @ref account_index. Names of accounts never change, so modifications are of no interest.
+    */
+   class account_name_index : public secondary_index
+   {
+      public:
+         virtual void object_inserted( const object& obj ) override;
+         virtual void object_removed( const object& obj ) override;
+
+         /// @return the ID of the account with the given name, if there is one
+         optional<account_id_type> find( const string& name )const;
+
+         /**
+          * @brief List accounts in the order of their names
+          * @param lower_bound_name the name to start at
+          * @param limit the maximum number of accounts to list
+          * @param prefix if not empty, only accounts whose names start with this are listed
+          * @return names and IDs of the accounts
+          */
+         vector< pair<string, account_id_type> > list( const string& lower_bound_name, uint32_t limit,
+                                                       const string& prefix = string() )const;
+
+         /// @return the number of names in this index
+         size_t size()const { return _size; }
+         /// @return the number of bytes used by the names and IDs, not counting allocator overhead
+         size_t memory_usage()const;
+
+         /// Half the maximum number of names in a block
+         static const size_t block_names;
+
+      private:
+         struct name_block
+         {
+            string                  names; ///< the front-coded names
+            vector<account_id_type> ids;   ///< the IDs of the accounts, in the order of their names
+         };
+         typedef vector< pair<string, account_id_type> > entries_type;
+
+         /// @return the block which contains the given name or would contain it
+         size_t find_block( const string& name )const;
+         static entries_type decode( const name_block& block );
+         static name_block   encode( entries_type::const_iterator begin, entries_type::const_iterator end );
+         /// Replaces the block at the given position with the given entries, splitting or removing it as needed
+         void                store( size_t position, const entries_type& entries );
+
+         vector<string>     _first_names;
+         vector<name_block> _blocks;
+         size_t             _size = 0;
+   };
+
 
    /**
     *  @brief This secondary index will allow fast access to the balance objects
@@ -386,9 +505,8 @@ namespace graphene { namespace chain {
     * @ingroup object_index
     */
    typedef multi_index_container<
-      account_balance_object,
+      account_balance_object*,
       indexed_by<
-         ordered_unique< tag<by_id>, member< object, object_id_type, &object::id > >,
          ordered_non_unique< tag<by_maintenance_flag>,
                              member< account_balance_object, bool, &account_balance_object::maintenance_flag > >,
          ordered_unique< tag<by_asset_balance>,
@@ -410,7 +528,7 @@ namespace graphene { namespace chain {
    /**
     * @ingroup object_index
     */
-   typedef generic_index<account_balance_object, account_balance_object_multi_index_type> account_balance_index;
+   typedef dense_index<account_balance_object, account_balance_object_multi_index_type> account_balance_index;
 
    struct by_name;
 
@@ -437,9 +555,8 @@ namespace graphene { namespace chain {
     * @ingroup object_index
     */
    typedef multi_index_container<
-      account_statistics_object,
+      account_statistics_object*,
       indexed_by<
-         ordered_unique< tag<by_id>, member< object, object_id_type, &object::id > >,
          ordered_unique< tag<by_maintenance_seq>,
             composite_key<
                account_statistics_object,
@@ -464,7 +581,7 @@ namespace graphene { namespace chain {
    /**
     * @ingroup object_index
     */
-   typedef generic_index<account_statistics_object, account_stats_multi_index_type> account_stats_index;
+   typedef dense_index<account_statistics_object, account_stats_multi_index_type> account_stats_index;
 
 }}
 
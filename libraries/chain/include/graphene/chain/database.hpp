@@ -33,6 +33,7 @@
 #include <graphene/chain/block_database.hpp>
 #include <graphene/chain/genesis_state.hpp>
 #include <graphene/chain/evaluator.hpp>
+#include <graphene/chain/operation_footprint.hpp>
 
 #include <graphene/db/object_database.hpp>
 #include <graphene/db/object.hpp>
@@ -155,6 +156,35 @@ namespace graphene { namespace chain {
          bool _push_block( const signed_block& b );
          processed_transaction _push_transaction( const precomputable_transaction& trx );
 
+         /**
+          * The changes a pending transaction made, so that it can be applied again without evaluating its operations
+          * if the blocks pushed in the meantime did not change anything it depends on
+          */
+         struct pending_transaction_changes
+         {
+            /// Taken before the transaction was applied
+            operation_footprint          footprint;
+            /// The objects after the transaction, sorted by ID, without its entry in the transaction history
+            vector< unique_ptr<object> > created;
+            vector< unique_ptr<object> > modified;
+            /// The objects before the transaction
+            vector< unique_ptr<object> > removed;
+            /// False if the changes were not recorded, because the undo database was disabled or an operation of the
+            /// transaction does not have a complete footprint
+            bool                         complete = false;
+         };
+
+         /**
+          * Applies the pending transactions again after a block was pushed or popped. Transactions whose operations
+          * have complete footprints and do not depend on anything the new head block changed are applied by redoing
+          * their recorded changes, the others are evaluated again and dropped if they have become invalid.
+          *
+          * @param old_head the head block when the pending transactions were applied
+          */
+         void _restore_pending_transactions( vector<processed_transaction>&& pending,
+                                             vector<pending_transaction_changes>&& changes,
+                                             const block_id_type& old_head );
+
          ///@throws fc::exception if the proposed transaction fails to apply.
          processed_transaction push_proposal( const proposal_object& proposal );
 
@@ -522,6 +552,15 @@ namespace graphene { namespace chain {
          /// Enable or disable tracking of votes of standby blockproducers and dxpcore members
          inline void enable_standby_votes_tracking(bool enable)  { _track_standby_votes = enable; }
 
+         /// Enable or disable checking the authorities of the transactions in a block in parallel
+         inline void enable_parallel_authority_checks(bool enable)  { _parallel_authority_checks = enable; }
+
+         /// Limit the number of pending transactions push_transaction() accepts, 0 for no limit
+         inline void set_max_pending_transactions(size_t max)  { _max_pending_transactions = max; }
+
+         /// Limit the time spent applying transactions when generating a block, 0 for no limit
+         inline void set_block_generation_time_limit(fc::microseconds limit)  { _block_generation_time_limit = limit; }
+
          /** Precomputes digests, signatures and operation validations depending
           *  on skip flags. "Expensive" computations may be done in a parallel
           *  thread.
@@ -569,7 +608,20 @@ namespace graphene { namespace chain {
 
       private:
          void                  _apply_block( const signed_block& next_block );
-         processed_transaction _apply_transaction( const signed_transaction& trx );
+         processed_transaction _apply_transaction( const signed_transaction& trx, bool authority_checked = false );
+         /// Checks a transaction as a whole, without its operations, and adds it to the transaction history
+         void                  _verify_and_record_transaction( const signed_transaction& trx, bool authority_checked );
+         /// Records the changes of the transaction applied in the current undo session
+         void                  _get_pending_transaction_changes( pending_transaction_changes& changes )const;
+         /// Adds a pending transaction again by redoing its changes, @p changes is moved from only on success
+         void                  _reapply_pending_transaction( const processed_transaction& trx,
+                                                             pending_transaction_changes&& changes );
+         /**
+          * Checks the authorities of all transactions in a block in parallel, against the state before the block.
+          * Transactions that may need custom authorities are left to the serial check.
+          * @return for each transaction, whether its authority has been checked successfully
+          */
+         vector<bool> check_authorities_parallel( const signed_block& block )const;
          void                  _cancel_bids_and_revive_mpa( const asset_object& smarttoken, const asset_smarttoken_data_object& bad );
 
          ///Steps involved in applying a new block
@@ -624,6 +676,8 @@ namespace graphene { namespace chain {
          ///@}
 
          vector< processed_transaction >        _pending_tx;
+         /// The changes of each transaction in _pending_tx
+         vector< pending_transaction_changes >  _pending_tx_changes;
          fork_database                          _fork_db;
 
          /**
@@ -664,6 +718,17 @@ namespace graphene { namespace chain {
          /// Set it to true to provide accurate data to API clients, set to false to have better performance.
          bool                              _track_standby_votes = true;
 
+         /// Whether to check the authorities of the transactions in a block in parallel before applying them.
+         /// The results are only used until a transaction in the block changes authorities.
+         bool                              _parallel_authority_checks = false;
+
+         /// The maximum number of pending transactions push_transaction() accepts, 0 for no limit
+         size_t                            _max_pending_transactions = 0;
+
+         /// The time _generate_block() may spend applying transactions, 0 for no limit. The remaining
+         /// transactions are postponed to a later block.
+         fc::microseconds                  _block_generation_time_limit;
+
          /**
           * Whether database is successfully opened or not.
           *
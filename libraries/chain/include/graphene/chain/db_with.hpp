@@ -68,40 +68,24 @@ struct skip_flags_restorer
  */
 struct pending_transactions_restorer
 {
-   pending_transactions_restorer( database& db, std::vector<processed_transaction>&& pending_transactions )
-      : _db(db), _pending_transactions( std::move(pending_transactions) )
+   pending_transactions_restorer( database& db, std::vector<processed_transaction>&& pending_transactions,
+                                  std::vector<database::pending_transaction_changes>&& pending_changes )
+      : _db(db), _pending_transactions( std::move(pending_transactions) ),
+        _pending_changes( std::move(pending_changes) ), _head_block_id( db.head_block_id() )
    {
       _db.clear_pending();
    }
 
    ~pending_transactions_restorer()
    {
-      for( const auto& tx : _db._popped_tx )
-      {
-         try {
-            if( !_db.is_known_transaction( tx.id() ) ) {
-               _db._push_transaction( tx );
-            }
-         } catch ( const fc::exception& ) { // ignore invalid transactions
-         }
-      }
-      _db._popped_tx.clear();
-      for( const processed_transaction& tx : _pending_transactions )
-      {
-         try
-         {
-            if( !_db.is_known_transaction( tx.id() ) ) {
-               _db._push_transaction( tx );
-            }
-         }
-         catch( const fc::exception& )
-         { // ignore invalid transactions
-         }
-      }
+      _db._restore_pending_transactions( std::move(_pending_transactions), std::move(_pending_changes),
+                                         _head_block_id );
    }
 
    database& _db;
    std::vector< processed_transaction > _pending_transactions;
+   std::vector< database::pending_transaction_changes > _pending_changes;
+   block_id_type _head_block_id;
 };
 
 /**
@@ -127,14 +111,17 @@ void with_skip_flags(
  * then reset pending_transactions after callback is done.
  *
  * Pending transactions which no longer validate will be culled.
+ * Those that do not depend on the changes of the callback are
+ * restored without evaluating them again.
  */
 template< typename Lambda >
 void without_pending_transactions(
    database& db,
    std::vector<processed_transaction>&& pending_transactions,
+   std::vector<database::pending_transaction_changes>&& pending_changes,
    Lambda callback )
 {
-    pending_transactions_restorer restorer( db, std::move(pending_transactions) );
+    pending_transactions_restorer restorer( db, std::move(pending_transactions), std::move(pending_changes) );
     callback();
     return;
 }
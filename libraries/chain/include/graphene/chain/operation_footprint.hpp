@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2021 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <fc/container/flat.hpp>
+#include <graphene/protocol/operations.hpp>
+#include <graphene/protocol/transaction.hpp>
+#include <graphene/chain/types.hpp>
+
+namespace graphene { namespace db { class object; } }
+
+namespace graphene { namespace chain {
+
+class database;
+
+/**
+ * @brief A conservative description of a set of objects in the database
+ *
+ * Objects are described by what they belong to, because most objects an operation creates or changes, like balances
+ * and orders, can not be named before the operation is executed.
+ */
+struct object_footprint
+{
+   /// Accounts with their statistics, balances and the other objects they own
+   flat_set<account_id_type> accounts;
+   /// Assets with their dynamic data, smarttoken data and confidential balances
+   flat_set<asset_id_type>   assets;
+   /// All limit orders, call orders, settle orders and collateral bids that involve one of these assets
+   flat_set<asset_id_type>   markets;
+   /// Other objects, e.g. liquidity pools, HTLCs, proposals and the global properties
+   flat_set<object_id_type>  objects;
+   /// Types of objects that may be created, with instance 0, as creating an object takes the next ID of its type
+   flat_set<object_id_type>  new_objects;
+
+   /// Also accounts that are only known when executing, e.g. the owners of matched orders
+   bool all_accounts = false;
+   /// Also assets that are only known when executing, e.g. the assets of refunded fees
+   bool all_assets = false;
+   /// Any object, used when the objects can not be determined before executing, e.g. for executed proposals
+   bool everything = false;
+
+   bool intersects( const object_footprint& other )const;
+   void merge( const object_footprint& other );
+};
+
+/**
+ * @brief The objects an operation or transaction may read and write
+ *
+ * Objects that only change between blocks, like most fields of the global properties, are not included.
+ */
+struct operation_footprint
+{
+   object_footprint reads;
+   object_footprint writes;
+
+   /// @return true if executing this and @p other in a different order may give a different result
+   bool conflicts_with( const operation_footprint& other )const;
+   void merge( const operation_footprint& other );
+};
+
+/**
+ * Adds the objects @p op may read and write to @p result without executing it.
+ *
+ * Some objects are looked up in @p db, but only fields that never change, like the assets of an order. If such an
+ * object does not exist, e.g. because it is created by an earlier transaction of the same block, everything is
+ * assumed to be written.
+ */
+void operation_get_footprint( const database& db, const graphene::chain::operation& op,
+                              operation_footprint& result );
+
+void transaction_get_footprint( const database& db, const graphene::chain::transaction& tx,
+                                operation_footprint& result );
+
+/**
+ * @return true if @p op reads nothing but the objects in its footprint and the global properties, and depends on the
+ * head block time only through the hardforks compared by footprint_hardforks_equal(). The result of such an operation
+ * can only change if an object in its footprint changes.
+ */
+bool operation_footprint_is_complete( const graphene::chain::operation& op );
+
+/// @return true if the operations with complete footprints are evaluated by the same rules at both times
+bool footprint_hardforks_equal( fc::time_point_sec a, fc::time_point_sec b );
+
+/**
+ * Adds @p obj and what it belongs to, e.g. the owner of a balance or the market of an order, to @p result. Changing
+ * @p obj may change the outcome of every operation whose footprint intersects the result.
+ */
+void object_get_footprint( const database& db, const graphene::db::object& obj, object_footprint& result );
+
+} } // graphene::chain
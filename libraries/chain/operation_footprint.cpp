@@ -0,0 +1,624 @@
+/*
+ * Copyright (c) 2021 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/chain/operation_footprint.hpp>
+
+#include <graphene/chain/buyback_object.hpp>
+#include <graphene/chain/confidential_object.hpp>
+#include <graphene/chain/database.hpp>
+#include <graphene/chain/fba_accumulator_id.hpp>
+#include <graphene/chain/hardfork.hpp>
+#include <graphene/chain/htlc_object.hpp>
+#include <graphene/chain/liquidity_pool_object.hpp>
+#include <graphene/chain/market_object.hpp>
+#include <graphene/chain/special_authority_object.hpp>
+#include <graphene/chain/vesting_balance_object.hpp>
+
+namespace graphene { namespace chain { namespace detail {
+
+template<typename T>
+static bool sets_intersect( const flat_set<T>& a, const flat_set<T>& b )
+{
+   auto itr_a = a.begin();
+   auto itr_b = b.begin();
+   while( itr_a != a.end() && itr_b != b.end() )
+   {
+      if( *itr_a < *itr_b )
+         ++itr_a;
+      else if( *itr_b < *itr_a )
+         ++itr_b;
+      else
+         return true;
+   }
+   return false;
+}
+
+struct get_footprint_visitor
+{
+   const database&   _db;
+   object_footprint& _reads;
+   object_footprint& _writes;
+
+   get_footprint_visitor( const database& db, operation_footprint& result )
+      : _db( db ), _reads( result.reads ), _writes( result.writes )
+   {}
+
+   using result_type = void;
+
+   template<typename Op>
+   void operator()( const Op& op )
+   {
+      // Every operation pays its fee from the balance of the fee payer to its statistics
+      _writes.accounts.insert( op.fee_payer() );
+      _reads.assets.insert( op.fee.asset_id );
+      if( op.fee.asset_id != asset_id_type() ) // converted through the fee pool
+         _writes.assets.insert( op.fee.asset_id );
+      add( op );
+   }
+
+private:
+   /// Orders in the market may be matched, which pays their owners, market fees and refunds of deferred fees
+   void match_orders( asset_id_type a, asset_id_type b )
+   {
+      _writes.markets.insert( a );
+      _writes.markets.insert( b );
+      _writes.assets.insert( a );
+      _writes.assets.insert( b );
+      _writes.all_accounts = true;
+      _writes.all_assets = true;
+   }
+
+   /// Margin calls after the price feed or the collateral requirements of @p a changed
+   void check_call_orders( asset_id_type a )
+   {
+      _writes.markets.insert( a );
+      _writes.all_accounts = true;
+      _writes.all_assets = true;
+   }
+
+   void add_authority( const authority& auth )
+   {
+      for( const auto& account_weight : auth.account_auths )
+         _reads.accounts.insert( account_weight.first );
+   }
+
+   void add( const transfer_operation& op )
+   {
+      _writes.accounts.insert( op.to );
+      _reads.assets.insert( op.amount.asset_id );
+   }
+   void add( const limit_order_create_operation& op )
+   {
+      match_orders( op.amount_to_sell.asset_id, op.min_to_receive.asset_id );
+      _writes.new_objects.insert( limit_order_id_type() );
+   }
+   void add( const limit_order_cancel_operation& op )
+   {
+      const limit_order_object* order = _db.find( op.order );
+      if( order == nullptr )
+      {
+         _writes.everything = true;
+         return;
+      }
+      _writes.objects.insert( op.order );
+      _writes.assets.insert( order->deferred_paid_fee.asset_id );
+      // Margin calls are checked in both directions after the order is gone
+      match_orders( order->sell_token_id(), order->receive_asset_id() );
+   }
+   void add( const call_order_update_operation& op )
+   {
+      match_orders( op.delta_debt.asset_id, op.delta_collateral.asset_id );
+      _writes.new_objects.insert( call_order_id_type() );
+   }
+   void add( const bid_collateral_operation& op )
+   {
+      _writes.markets.insert( op.debt_covered.asset_id );
+      _writes.markets.insert( op.additional_collateral.asset_id );
+      _reads.assets.insert( op.debt_covered.asset_id );
+      _reads.assets.insert( op.additional_collateral.asset_id );
+      _writes.new_objects.insert( collateral_bid_id_type() );
+   }
+   void add( const account_create_operation& op )
+   {
+      _reads.accounts.insert( op.referrer );
+      add_authority( op.owner );
+      add_authority( op.active );
+      _writes.new_objects.insert( account_id_type() );
+      _writes.new_objects.insert( account_statistics_id_type() );
+      _writes.new_objects.insert( special_authority_id_type() );
+      _writes.new_objects.insert( buyback_id_type() );
+      // Registration counter and account fee scaling
+      _writes.objects.insert( dynamic_global_property_id_type() );
+      _writes.objects.insert( global_property_id_type() );
+      if( op.extensions.value.buyback_options.valid() )
+         _writes.assets.insert( op.extensions.value.buyback_options->asset_to_buy );
+   }
+   void add( const account_update_operation& op )
+   {
+      if( op.owner )
+         add_authority( *op.owner );
+      if( op.active )
+         add_authority( *op.active );
+      _writes.new_objects.insert( special_authority_id_type() );
+   }
+   void add( const account_whitelist_operation& op )
+   {
+      _writes.accounts.insert( op.account_to_list );
+   }
+   void add( const account_upgrade_operation& )
+   {
+   }
+   void add( const asset_create_operation& op )
+   {
+      _writes.new_objects.insert( asset_id_type() );
+      _writes.new_objects.insert( asset_dynamic_data_id_type() );
+      _writes.new_objects.insert( asset_smarttoken_data_id_type() );
+      if( op.smarttoken_opts.valid() )
+         _reads.assets.insert( op.smarttoken_opts->short_backing_asset );
+      if( _db.head_block_time() <= HARDFORK_CORE_429_TIME ) // an odd fee used to increase the core supply
+         _writes.assets.insert( asset_id_type() );
+   }
+   void add( const asset_update_operation& op )
+   {
+      _writes.assets.insert( op.asset_to_update );
+      if( op.new_issuer )
+         _reads.accounts.insert( *op.new_issuer );
+      if( op.new_options.flags & disable_force_settle ) // open settle orders are cancelled
+      {
+         _writes.markets.insert( op.asset_to_update );
+         _writes.all_accounts = true;
+      }
+   }
+   void add( const asset_update_issuer_operation& op )
+   {
+      _writes.assets.insert( op.asset_to_update );
+      _reads.accounts.insert( op.new_issuer );
+   }
+   void add( const asset_update_smarttoken_operation& op )
+   {
+      _writes.assets.insert( op.asset_to_update );
+      _reads.assets.insert( op.new_options.short_backing_asset );
+      check_call_orders( op.asset_to_update );
+   }
+   void add( const asset_update_feed_producers_operation& op )
+   {
+      _writes.assets.insert( op.asset_to_update );
+      _reads.accounts.insert( op.new_feed_producers.begin(), op.new_feed_producers.end() );
+      check_call_orders( op.asset_to_update );
+   }
+   void add( const asset_issue_operation& op )
+   {
+      _writes.assets.insert( op.asset_to_issue.asset_id );
+      _writes.accounts.insert( op.issue_to_account );
+   }
+   void add( const asset_reserve_operation& op )
+   {
+      _writes.assets.insert( op.amount_to_reserve.asset_id );
+   }
+   void add( const asset_fund_fee_pool_operation& op )
+   {
+      _writes.assets.insert( op.asset_id );
+   }
+   void add( const asset_settle_operation& op )
+   {
+      // Settles instantly from the settlement fund after a global settlement, otherwise adds a settle order
+      _writes.assets.insert( op.amount.asset_id );
+      _writes.markets.insert( op.amount.asset_id );
+      _writes.new_objects.insert( force_settlement_id_type() );
+   }
+   void add( const asset_global_settle_operation& op )
+   {
+      _writes.assets.insert( op.asset_to_settle );
+      check_call_orders( op.asset_to_settle );
+   }
+   void add( const asset_publish_feed_operation& op )
+   {
+      _writes.assets.insert( op.asset_id );
+      check_call_orders( op.asset_id );
+   }
+   void add( const blockproducer_create_operation& )
+   {
+      _writes.new_objects.insert( blockproducer_id_type() );
+      _writes.objects.insert( global_property_id_type() ); // next vote ID
+   }
+   void add( const blockproducer_update_operation& op )
+   {
+      _writes.objects.insert( op.blockproducer );
+   }
+   void add( const proposal_create_operation& op )
+   {
+      _writes.new_objects.insert( proposal_id_type() );
+      vector<authority> other;
+      for( const auto& proposed_op : op.proposed_ops )
+         operation_get_required_authorities( proposed_op.op, _reads.accounts, _reads.accounts, other,
+                                             MUST_IGNORE_CUSTOM_OP_REQD_AUTHS( _db.head_block_time() ) );
+      for( const auto& auth : other )
+         add_authority( auth );
+   }
+   void add( const proposal_update_operation& op )
+   {
+      // The proposal may be executed
+      _writes.objects.insert( op.proposal );
+      _writes.everything = true;
+   }
+   void add( const proposal_delete_operation& op )
+   {
+      _writes.objects.insert( op.proposal );
+   }
+   void add( const withdraw_permission_create_operation& op )
+   {
+      _reads.accounts.insert( op.authorized_account );
+      _writes.new_objects.insert( withdraw_permission_id_type() );
+   }
+   void add( const withdraw_permission_update_operation& op )
+   {
+      _writes.objects.insert( op.permission_to_update );
+   }
+   void add( const withdraw_permission_claim_operation& op )
+   {
+      _writes.objects.insert( op.withdraw_permission );
+      _writes.accounts.insert( op.withdraw_from_account );
+      _reads.assets.insert( op.amount_to_withdraw.asset_id );
+   }
+   void add( const withdraw_permission_delete_operation& op )
+   {
+      _writes.objects.insert( op.withdrawal_permission );
+   }
+   void add( const dxpcore_member_create_operation& )
+   {
+      _writes.new_objects.insert( dxpcore_member_id_type() );
+      _writes.objects.insert( global_property_id_type() ); // next vote ID
+   }
+   void add( const dxpcore_member_update_operation& op )
+   {
+      _writes.objects.insert( op.dxpcore_member );
+   }
+   void add( const dxpcore_member_update_global_parameters_operation& )
+   {
+      _writes.objects.insert( global_property_id_type() );
+   }
+   void add( const vesting_balance_create_operation& op )
+   {
+      _writes.accounts.insert( op.owner );
+      _reads.assets.insert( op.amount.asset_id );
+      _writes.new_objects.insert( vesting_balance_id_type() );
+   }
+   void add( const vesting_balance_withdraw_operation& op )
+   {
+      _writes.objects.insert( op.vesting_balance );
+   }
+   void add( const benefactor_create_operation& )
+   {
+      _writes.new_objects.insert( benefactor_id_type() );
+      _writes.new_objects.insert( vesting_balance_id_type() );
+      _writes.objects.insert( global_property_id_type() ); // next vote IDs
+   }
+   void add( const custom_operation& )
+   {
+   }
+   void add( const assert_operation& op )
+   {
+      for( const auto& pred : op.predicates )
+      {
+         if( pred.is_type<account_name_eq_lit_predicate>() )
+            _reads.accounts.insert( pred.get<account_name_eq_lit_predicate>().account_id );
+         else if( pred.is_type<asset_symbol_eq_lit_predicate>() )
+            _reads.assets.insert( pred.get<asset_symbol_eq_lit_predicate>().asset_id );
+      }
+   }
+   void add( const balance_claim_operation& op )
+   {
+      _writes.objects.insert( op.balance_to_claim );
+   }
+   void add( const override_transfer_operation& op )
+   {
+      _writes.accounts.insert( op.from );
+      _writes.accounts.insert( op.to );
+      _reads.assets.insert( op.amount.asset_id );
+   }
+   void add( const transfer_to_blind_operation& op )
+   {
+      _writes.assets.insert( op.amount.asset_id );
+      _writes.new_objects.insert( blinded_balance_id_type() );
+      _writes.objects.insert( fba_accumulator_id_type( fba_accumulator_id_transfer_to_blind ) );
+   }
+   void add( const blind_transfer_operation& op )
+   {
+      // The blinded balances are in the asset of the fee
+      _writes.assets.insert( op.fee.asset_id );
+      _writes.new_objects.insert( blinded_balance_id_type() );
+      _writes.objects.insert( fba_accumulator_id_type( fba_accumulator_id_blind_transfer ) );
+   }
+   void add( const transfer_from_blind_operation& op )
+   {
+      _writes.accounts.insert( op.to );
+      _writes.assets.insert( op.amount.asset_id );
+      _writes.objects.insert( fba_accumulator_id_type( fba_accumulator_id_transfer_from_blind ) );
+   }
+   void add( const asset_claim_fees_operation& op )
+   {
+      _writes.assets.insert( op.amount_to_claim.asset_id );
+      if( op.extensions.value.claim_from_asset_id.valid() )
+         _writes.assets.insert( *op.extensions.value.claim_from_asset_id );
+   }
+   void add( const asset_claim_pool_operation& op )
+   {
+      _writes.assets.insert( op.asset_id );
+   }
+   void add( const htlc_create_operation& op )
+   {
+      _reads.accounts.insert( op.to );
+      _reads.assets.insert( op.amount.asset_id );
+      _writes.new_objects.insert( htlc_id_type() );
+   }
+   void add( const htlc_redeem_operation& op )
+   {
+      const htlc_object* htlc = _db.find( op.htlc_id );
+      if( htlc == nullptr )
+      {
+         _writes.everything = true;
+         return;
+      }
+      _writes.objects.insert( op.htlc_id );
+      _writes.accounts.insert( htlc->transfer.to );
+   }
+   void add( const htlc_extend_operation& op )
+   {
+      _writes.objects.insert( op.htlc_id );
+   }
+   void add( const custom_authority_create_operation& op )
+   {
+      add_authority( op.auth );
+      _writes.new_objects.insert( custom_authority_id_type() );
+   }
+   void add( const custom_authority_update_operation& op )
+   {
+      if( op.new_auth )
+         add_authority( *op.new_auth );
+      _writes.objects.insert( op.authority_to_update );
+   }
+   void add( const custom_authority_delete_operation& op )
+   {
+      _writes.objects.insert( op.authority_to_delete );
+   }
+   void add( const ticket_create_operation& op )
+   {
+      _reads.assets.insert( op.amount.asset_id );
+      _writes.new_objects.insert( ticket_id_type() );
+   }
+   void add( const ticket_update_operation& op )
+   {
+      // A part of the ticket may be split off into a new one
+      _writes.objects.insert( op.ticket );
+      _writes.new_objects.insert( ticket_id_type() );
+   }
+   void add( const liquidity_pool_create_operation& op )
+   {
+      _reads.assets.insert( op.asset_a );
+      _reads.assets.insert( op.asset_b );
+      _writes.assets.insert( op.share_asset );
+      _writes.new_objects.insert( liquidity_pool_id_type() );
+   }
+   void add( const liquidity_pool_delete_operation& op )
+   {
+      const liquidity_pool_object* pool = _db.find( op.pool );
+      if( pool == nullptr )
+      {
+         _writes.everything = true;
+         return;
+      }
+      _writes.objects.insert( op.pool );
+      _writes.assets.insert( pool->share_asset );
+   }
+   void add( const liquidity_pool_deposit_operation& op )
+   {
+      add_pool_shares( op.pool );
+   }
+   void add( const liquidity_pool_withdraw_operation& op )
+   {
+      add_pool_shares( op.pool );
+   }
+   void add( const liquidity_pool_exchange_operation& op )
+   {
+      const liquidity_pool_object* pool = _db.find( op.pool );
+      if( pool == nullptr )
+      {
+         _writes.everything = true;
+         return;
+      }
+      _writes.objects.insert( op.pool );
+      _reads.assets.insert( pool->share_asset );
+      // Market fees, shared with the registrars and referrers of the trader and of the share asset issuer
+      _writes.assets.insert( pool->asset_a );
+      _writes.assets.insert( pool->asset_b );
+      _writes.all_accounts = true;
+   }
+
+   /// Changes the balances of the pool and the supply of its share asset
+   void add_pool_shares( liquidity_pool_id_type pool_id )
+   {
+      const liquidity_pool_object* pool = _db.find( pool_id );
+      if( pool == nullptr )
+      {
+         _writes.everything = true;
+         return;
+      }
+      _writes.objects.insert( pool_id );
+      _writes.assets.insert( pool->share_asset );
+      _reads.assets.insert( pool->asset_a );
+      _reads.assets.insert( pool->asset_b );
+   }
+
+   // These are not implemented or virtual, they can not be scheduled
+   void add( const account_transfer_operation& )    { _writes.everything = true; }
+   void add( const fill_order_operation& )          { _writes.everything = true; }
+   void add( const asset_settle_cancel_operation& ) { _writes.everything = true; }
+   void add( const fba_distribute_operation& )      { _writes.everything = true; }
+   void add( const execute_bid_operation& )         { _writes.everything = true; }
+   void add( const htlc_redeemed_operation& )       { _writes.everything = true; }
+   void add( const htlc_refund_operation& )         { _writes.everything = true; }
+};
+
+} // namespace detail
+
+bool object_footprint::intersects( const object_footprint& other )const
+{
+   if( everything || other.everything )
+      return true;
+   if( ( all_accounts && ( other.all_accounts || !other.accounts.empty() ) )
+         || ( other.all_accounts && !accounts.empty() ) )
+      return true;
+   if( ( all_assets && ( other.all_assets || !other.assets.empty() ) )
+         || ( other.all_assets && !assets.empty() ) )
+      return true;
+   return detail::sets_intersect( accounts, other.accounts )
+       || detail::sets_intersect( assets, other.assets )
+       || detail::sets_intersect( markets, other.markets )
+       || detail::sets_intersect( objects, other.objects )
+       || detail::sets_intersect( new_objects, other.new_objects );
+}
+
+void object_footprint::merge( const object_footprint& other )
+{
+   accounts.insert( other.accounts.begin(), other.accounts.end() );
+   assets.insert( other.assets.begin(), other.assets.end() );
+   markets.insert( other.markets.begin(), other.markets.end() );
+   objects.insert( other.objects.begin(), other.objects.end() );
+   new_objects.insert( other.new_objects.begin(), other.new_objects.end() );
+   all_accounts |= other.all_accounts;
+   all_assets |= other.all_assets;
+   everything |= other.everything;
+}
+
+bool operation_footprint::conflicts_with( const operation_footprint& other )const
+{
+   return writes.intersects( other.writes ) || writes.intersects( other.reads ) || reads.intersects( other.writes );
+}
+
+void operation_footprint::merge( const operation_footprint& other )
+{
+   reads.merge( other.reads );
+   writes.merge( other.writes );
+}
+
+void operation_get_footprint( const database& db, const operation& op, operation_footprint& result )
+{
+   detail::get_footprint_visitor vtor( db, result );
+   op.visit( vtor );
+}
+
+void transaction_get_footprint( const database& db, const transaction& tx, operation_footprint& result )
+{
+   for( const auto& op : tx.operations )
+      operation_get_footprint( db, op, result );
+}
+
+bool operation_footprint_is_complete( const operation& op )
+{
+   // Most operations read objects that are not in their footprint, e.g. the objects referenced by the accounts or
+   // assets they touch, or compare times with the head block time. They are evaluated again instead.
+   return op.is_type<transfer_operation>();
+}
+
+bool footprint_hardforks_equal( fc::time_point_sec a, fc::time_point_sec b )
+{
+   // Checked by is_authorized_asset() for transfers
+   return HARDFORK_BSIP_86_PASSED( a ) == HARDFORK_BSIP_86_PASSED( b );
+}
+
+void object_get_footprint( const database& db, const object& obj, object_footprint& result )
+{
+   result.objects.insert( obj.id );
+   if( obj.id.space() == protocol_ids )
+   {
+      switch( obj.id.type() )
+      {
+      case account_object_type:
+         result.accounts.insert( obj.id );
+         break;
+      case asset_object_type:
+         result.assets.insert( obj.id );
+         break;
+      case force_settlement_object_type:
+         result.markets.insert( static_cast<const force_settlement_object&>( obj ).settlement_asset_id() );
+         break;
+      case limit_order_object_type: {
+         const auto& order = static_cast<const limit_order_object&>( obj );
+         result.markets.insert( order.sell_token_id() );
+         result.markets.insert( order.receive_asset_id() );
+         break;
+      } case call_order_object_type: {
+         const auto& order = static_cast<const call_order_object&>( obj );
+         result.markets.insert( order.debt_type() );
+         result.markets.insert( order.collateral_type() );
+         break;
+      } case vesting_balance_object_type:
+         result.accounts.insert( static_cast<const vesting_balance_object&>( obj ).owner );
+         break;
+      default:
+         break;
+      }
+      return;
+   }
+   if( obj.id.space() != implementation_ids )
+      return;
+
+   switch( obj.id.type() )
+   {
+   case impl_asset_dynamic_data_object_type: {
+      // Usually created right before its asset and with the same instance, otherwise it may belong to any asset
+      const asset_object* a = db.find( asset_id_type( obj.id.instance() ) );
+      if( a != nullptr && a->dynamic_asset_data_id == obj.id )
+         result.assets.insert( a->id );
+      else
+         result.all_assets = true;
+      break;
+   } case impl_asset_smarttoken_data_object_type:
+      result.assets.insert( static_cast<const asset_smarttoken_data_object&>( obj ).asset_id );
+      break;
+   case impl_account_balance_object_type:
+      result.accounts.insert( static_cast<const account_balance_object&>( obj ).owner );
+      break;
+   case impl_account_statistics_object_type:
+      result.accounts.insert( static_cast<const account_statistics_object&>( obj ).owner );
+      break;
+   case impl_blinded_balance_object_type:
+      result.assets.insert( static_cast<const blinded_balance_object&>( obj ).asset_id );
+      break;
+   case impl_special_authority_object_type:
+      result.accounts.insert( static_cast<const special_authority_object&>( obj ).account );
+      break;
+   case impl_buyback_object_type:
+      result.assets.insert( static_cast<const buyback_object&>( obj ).asset_to_buy );
+      break;
+   case impl_collateral_bid_object_type: {
+      const auto& bid = static_cast<const collateral_bid_object&>( obj );
+      result.markets.insert( bid.debt_type() );
+      result.markets.insert( bid.inv_swan_price.base.asset_id );
+      break;
+   } default:
+      break;
+   }
+}
+
+} } // graphene::chain
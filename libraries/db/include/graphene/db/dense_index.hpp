@@ -0,0 +1,264 @@
+/*
+ * Copyright (c) 2021 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+#include <graphene/db/index.hpp>
+#include <boost/multi_index_container.hpp>
+#include <boost/multi_index/member.hpp>
+#include <boost/multi_index/ordered_index.hpp>
+#include <boost/multi_index/mem_fun.hpp>
+
+#include <bitset>
+#include <type_traits>
+
+namespace graphene { namespace db {
+
+   /**
+    *  @class dense_index
+    *  @brief An index that stores objects by value in chunked arrays indexed by the object instance
+    *
+    *  Lookup by ID is an array access instead of a tree search, and objects with neighbouring IDs are
+    *  neighbours in memory. Objects never move once they have been created, and chunks are never freed,
+    *  so this index is meant for object types whose IDs are (almost) dense and whose objects are rarely
+    *  removed.
+    *
+    *  All other lookups are done through MultiIndexType, a boost multi_index_container of pointers to the
+    *  objects. The key extractors of boost multi_index dereference pointers, so the same member<>,
+    *  const_mem_fun<> and composite_key<> keys as in a generic_index on ObjectType can be used. It must
+    *  not contain an index by ID. The pointers are not const because boost's member<> cannot extract keys
+    *  through pointers to const, but like all objects these must only be changed through database::modify.
+    */
+   template<typename ObjectType, typename MultiIndexType, uint8_t ChunkBits = 10>
+   class dense_index : public index
+   {
+      static_assert( std::is_same<typename MultiIndexType::value_type, ObjectType*>::value,
+                     "MultiIndexType must contain ObjectType*" );
+      static_assert( ChunkBits > 0 && ChunkBits < 32, "Invalid chunk size" );
+
+      static constexpr uint64_t chunk_size = uint64_t(1) << ChunkBits;
+      static constexpr uint64_t mask = chunk_size - 1;
+
+      struct chunk
+      {
+         typename std::aligned_storage<sizeof(ObjectType), alignof(ObjectType)>::type objects[chunk_size];
+         typename MultiIndexType::iterator positions[chunk_size];
+         std::bitset<chunk_size> used;
+      };
+
+      public:
+         typedef MultiIndexType index_type;
+         typedef ObjectType     object_type;
+
+         dense_index() = default;
+         dense_index( const dense_index& ) = delete;
+         dense_index& operator=( const dense_index& ) = delete;
+
+         virtual ~dense_index()
+         {
+            _indices.clear();
+            for( uint64_t instance = 0; instance < end_instance(); ++instance )
+               if( contains( instance ) )
+                  slot( instance )->~ObjectType();
+         }
+
+         virtual const object& insert( object&& obj )override
+         {
+            assert( nullptr != dynamic_cast<ObjectType*>(&obj) );
+            const auto instance = obj.id.instance();
+            new( allocate( instance ) ) ObjectType( std::move( static_cast<ObjectType&>(obj) ) );
+            add_to_indices( instance );
+            return *slot( instance );
+         }
+
+         virtual const object&  create(const std::function<void(object&)>& constructor )override
+         {
+            const auto id = get_next_id();
+            const auto instance = id.instance();
+            ObjectType* item = new( allocate( instance ) ) ObjectType();
+            try {
+               item->id = id;
+               constructor( *item );
+            } catch( ... ) {
+               item->~ObjectType();
+               throw;
+            }
+            add_to_indices( instance );
+            use_next_id();
+            return *item;
+         }
+
+         virtual void modify( const object& obj, const std::function<void(object&)>& m )override
+         {
+            assert(nullptr != dynamic_cast<const ObjectType*>(&obj));
+            const auto instance = obj.id.instance();
+            FC_ASSERT( contains( instance ), "Modifying non-existent object ${id}", ("id",obj.id) );
+            ObjectType* item = slot( instance );
+            std::exception_ptr exc;
+            auto ok = _indices.modify( position( instance ),
+                                       [&m, &exc, item](ObjectType*&) mutable {
+                                          try {
+                                             m(*item);
+                                          } catch (fc::exception& e) {
+                                             exc = std::current_exception();
+                                             elog("Exception while modifying object: ${e} -- object may be corrupted",
+                                                  ("e", e));
+                                          } catch (...) {
+                                             exc = std::current_exception();
+                                             elog("Unknown exception while modifying object");
+                                          }
+                                       }
+                      );
+            if( !ok ) // multi_index has dropped the object, like generic_index we lose it
+               release( instance );
+            if (exc)
+                std::rethrow_exception(exc);
+            FC_ASSERT(ok, "Could not modify object, most likely an index constraint was violated");
+         }
+
+         virtual void remove( const object& obj )override
+         {
+            const auto instance = obj.id.instance();
+            assert( contains( instance ) && &obj == slot( instance ) );
+            _indices.erase( position( instance ) );
+            release( instance );
+         }
+
+         virtual const object* find( object_id_type id )const override
+         {
+            const auto instance = id.instance();
+            if( !contains( instance ) ) return nullptr;
+            return slot( instance );
+         }
+
+         virtual void inspect_all_objects(std::function<void (const object&)> inspector)const override
+         {
+            try {
+               for( const auto& item : *this )
+                  inspector(item);
+            } FC_CAPTURE_AND_RETHROW()
+         }
+
+         /// Iterates over all objects in the order of their IDs
+         class const_iterator
+         {
+            public:
+               const_iterator( const dense_index& idx, uint64_t instance ):_index(idx),_instance(instance)
+               {
+                  skip_unused();
+               }
+               friend bool operator==( const const_iterator& a, const const_iterator& b ) { return a._instance == b._instance; }
+               friend bool operator!=( const const_iterator& a, const const_iterator& b ) { return a._instance != b._instance; }
+               const ObjectType& operator*()const { return *_index.slot( _instance ); }
+               const ObjectType* operator->()const { return _index.slot( _instance ); }
+               const_iterator operator++(int)     // postfix
+               {
+                  const_iterator result( *this );
+                  ++(*this);
+                  return result;
+               }
+               const_iterator& operator++()       // prefix
+               {
+                  ++_instance;
+                  skip_unused();
+                  return *this;
+               }
+               typedef std::forward_iterator_tag iterator_category;
+               typedef ObjectType value_type;
+               typedef std::ptrdiff_t difference_type;
+               typedef const ObjectType* pointer;
+               typedef const ObjectType& reference;
+            private:
+               void skip_unused()
+               {
+                  while( _instance < _index.end_instance() && !_index.contains( _instance ) )
+                     ++_instance;
+               }
+
+               const dense_index& _index;
+               uint64_t           _instance;
+         };
+         const_iterator begin()const { return const_iterator( *this, 0 ); }
+         const_iterator end()const   { return const_iterator( *this, end_instance() ); }
+
+         size_t size()const { return _size; }
+
+         const index_type& indices()const { return _indices; }
+
+      private:
+         uint64_t end_instance()const { return _chunks.size() << ChunkBits; }
+
+         bool contains( uint64_t instance )const
+         {
+            return instance < end_instance() && _chunks[instance >> ChunkBits]
+                   && _chunks[instance >> ChunkBits]->used.test( instance & mask );
+         }
+
+         ObjectType* slot( uint64_t instance )const
+         {
+            return reinterpret_cast<ObjectType*>( &_chunks[instance >> ChunkBits]->objects[instance & mask] );
+         }
+
+         typename index_type::iterator& position( uint64_t instance )const
+         {
+            return _chunks[instance >> ChunkBits]->positions[instance & mask];
+         }
+
+         /// @return uninitialized memory for the object with the given instance
+         void* allocate( uint64_t instance )
+         {
+            FC_ASSERT( !contains( instance ), "Could not insert object, an object with instance ${i} exists",
+                       ("i",instance) );
+            if( (instance >> ChunkBits) >= _chunks.size() )
+               _chunks.resize( (instance >> ChunkBits) + 1 );
+            if( !_chunks[instance >> ChunkBits] )
+               _chunks[instance >> ChunkBits] = std::make_unique<chunk>();
+            return slot( instance );
+         }
+
+         /// Marks a constructed object as present and adds it to the indices, or destroys it if that fails
+         void add_to_indices( uint64_t instance )
+         {
+            ObjectType* item = slot( instance );
+            auto insert_result = _indices.insert( item );
+            if( !insert_result.second )
+               item->~ObjectType();
+            FC_ASSERT( insert_result.second, "Could not insert object, most likely a uniqueness constraint was violated" );
+            position( instance ) = insert_result.first;
+            _chunks[instance >> ChunkBits]->used.set( instance & mask );
+            ++_size;
+         }
+
+         /// Destroys an object that is no longer in the indices
+         void release( uint64_t instance )
+         {
+            slot( instance )->~ObjectType();
+            _chunks[instance >> ChunkBits]->used.reset( instance & mask );
+            --_size;
+         }
+
+         vector< unique_ptr<chunk> > _chunks;
+         index_type                  _indices;
+         size_t                      _size = 0;
+   };
+
+} }
@@ -7,6 +7,7 @@
 
 #include <type_traits>
 #include <functional>
+#include <stdexcept>
 
 namespace fc {
 
@@ -241,7 +242,8 @@ template<typename T> struct wrapper { using type = T; };
 template<typename... Types, typename Callable, typename = std::enable_if_t<impl::length<Types...>::value != 0>,
          typename Return = decltype(std::declval<Callable>()(wrapper<at<list<Types...>, 0>>()))>
 Return dispatch(list<Types...>, std::size_t index, Callable c) {
-   static std::function<Return(Callable&)> call_table[] =
+   // Plain function pointers rather than std::function, so the call is a single indirect jump
+   static constexpr Return (*call_table[])(Callable&) =
       { impl::dispatch_helper<Callable, Return, wrapper<Types>>... };
    if (index < impl::length<Types...>::value) return call_table[index](c);
    throw std::out_of_range("Invalid index to fc::typelist::runtime::dispatch()");
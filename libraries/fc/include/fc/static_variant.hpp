@@ -12,30 +12,94 @@
 #pragma once
 
 #include <array>
+#include <cstddef>
 #include <functional>
+#include <initializer_list>
+#include <new>
 #include <stdexcept>
+#include <type_traits>
 #include <typeinfo>
 
 #include <fc/exception/exception.hpp>
 
+/**
+ * Alternatives of a static_variant up to this size are stored inside the static_variant itself,
+ * larger alternatives are allocated on the heap.  The static_variant is as large as its largest
+ * inline alternative, so this bounds the memory wasted when a small alternative is stored.
+ */
+#ifndef FC_STATIC_VARIANT_MAX_INLINE_SIZE
+#define FC_STATIC_VARIANT_MAX_INLINE_SIZE 128
+#endif
+
 namespace fc {
 
 // Implementation details, the user should not import this:
 namespace impl {
 
-class dynamic_storage
+constexpr size_t max_of( std::initializer_list<size_t> values )
 {
-    char* storage;
-public:
-    dynamic_storage();
+    size_t result = 0;
+    for( size_t value : values )
+        if( value > result )
+            result = value;
+    return result;
+}
+
+template<typename T>
+constexpr bool is_stored_inline()
+{
+    return sizeof(T) <= FC_STATIC_VARIANT_MAX_INLINE_SIZE && alignof(T) <= alignof(std::max_align_t);
+}
+
+/**
+ * Storage for the value of a static_variant: small alternatives live in an inline buffer,
+ * large ones on the heap with a pointer to them in the buffer.
+ * The storage doesn't know which alternative it holds, every call passes it in.
+ */
+template<typename... Types>
+class variant_storage
+{
+    static constexpr size_t size = max_of({ sizeof(void*), (is_stored_inline<Types>() ? sizeof(Types) : 0)... });
+    static constexpr size_t alignment = max_of({ alignof(void*), (is_stored_inline<Types>() ? alignof(Types) : 0)... });
+    typename std::aligned_storage<size, alignment>::type buffer;
+
+    void*& heap_pointer() const { return *reinterpret_cast<void**>( const_cast<decltype(buffer)*>(&buffer) ); }
 
-    ~dynamic_storage();
+public:
+    static bool is_inline( int64_t tag )
+    {
+        static const bool table[] = { is_stored_inline<Types>()... };
+        return table[tag];
+    }
 
-    void* data() const;
+    /// Get memory to construct a T in
+    template<typename T>
+    void* alloc()
+    {
+        if( is_stored_inline<T>() )
+            return &buffer;
+        heap_pointer() = ::operator new( sizeof(T) );
+        return heap_pointer();
+    }
 
-    void alloc( size_t size );
+    /// Free the memory of the alternative with the given tag, after it has been destroyed
+    void release( int64_t tag )
+    {
+        if( !is_inline(tag) )
+            ::operator delete( heap_pointer() );
+    }
 
-    void release();
+    template<typename T>
+    void* data() const
+    {
+        return is_stored_inline<T>() ? const_cast<void*>(static_cast<const void*>(&buffer)) : heap_pointer();
+    }
+    void* data( int64_t tag ) const
+    {
+        if( tag < 0 )
+            return nullptr;
+        return is_inline(tag) ? const_cast<void*>(static_cast<const void*>(&buffer)) : heap_pointer();
+    }
 };
 
 } // namespace impl
@@ -55,42 +119,53 @@ protected:
     template<typename X>
     using type_in_typelist = std::enable_if_t<typelist::index_of<list, X>() != -1>;
 
-    tag_type _tag;
-    impl::dynamic_storage storage;
+    /// The tag of the stored value, or -1 if constructing the value threw and there is none
+    tag_type _tag = -1;
+    impl::variant_storage<Types...> storage;
+
+    /// Construct a value of type X from the arguments, the variant must not hold a value
+    template<typename X, typename... Args>
+    void emplace(Args&&... args) {
+        void* data = storage.template alloc<X>();
+        try {
+            new(data) X( std::forward<Args>(args)... );
+        } catch( ... ) {
+            storage.release( typelist::index_of<list, X>() );
+            throw;
+        }
+        _tag = typelist::index_of<list, X>();
+    }
 
     template<typename X, typename = type_in_typelist<X>>
     void init(const X& x) {
-        _tag = typelist::index_of<list, X>();
-        storage.alloc( sizeof(X) );
-        new(storage.data()) X(x);
+        emplace<X>( x );
     }
 
     template<typename X, typename = type_in_typelist<X>>
     void init(X&& x) {
-        _tag = typelist::index_of<list, X>();
-        storage.alloc( sizeof(X) );
-        new(storage.data()) X( std::move(x) );
+        emplace<X>( std::move(x) );
     }
 
     void init_from_tag(tag_type tag)
     {
         FC_ASSERT( tag >= 0 );
         FC_ASSERT( static_cast<size_t>(tag) < count() );
-        _tag = tag;
         typelist::runtime::dispatch(list(), tag, [this](auto t) {
             using T = typename decltype(t)::type;
-            storage.alloc(sizeof(T));
-            new(reinterpret_cast<T*>(storage.data())) T();
+            this->template emplace<T>();
         });
     }
 
     void clean()
     {
-        typelist::runtime::dispatch(list(), _tag, [data=storage.data()](auto t) {
+        if( _tag < 0 )
+            return;
+        typelist::runtime::dispatch(list(), _tag, [data=storage.data(_tag)](auto t) {
             using T = typename decltype(t)::type;
             reinterpret_cast<T*>(data)->~T();
         });
-        storage.release();
+        storage.release( _tag );
+        _tag = -1;
     }
 
     template<typename T, typename = void>
@@ -233,7 +308,7 @@ public:
     template<typename X, typename = type_in_typelist<X>>
     X& get() {
         if(_tag == typelist::index_of<list, X>()) {
-            return *reinterpret_cast<X*>(storage.data());
+            return *reinterpret_cast<X*>(storage.template data<X>());
         } else {
             FC_THROW_EXCEPTION( fc::assert_exception, "static_variant does not contain a value of type ${t}", ("t",fc::get_typename<X>::name()) );
         }
@@ -241,29 +316,29 @@ public:
     template<typename X, typename = type_in_typelist<X>>
     const X& get() const {
         if(_tag == typelist::index_of<list, X>()) {
-            return *reinterpret_cast<const X*>(storage.data());
+            return *reinterpret_cast<const X*>(storage.template data<X>());
         } else {
             FC_THROW_EXCEPTION( fc::assert_exception, "static_variant does not contain a value of type ${t}", ("t",fc::get_typename<X>::name()) );
         }
     }
     template<typename visitor>
     typename visitor::result_type visit(visitor& v) {
-        return visit( _tag, v, (void*) storage.data() );
+        return visit( _tag, v, (void*) storage.data( _tag ) );
     }
 
     template<typename visitor>
     typename visitor::result_type visit(const visitor& v) {
-        return visit( _tag, v, (void*) storage.data() );
+        return visit( _tag, v, (void*) storage.data( _tag ) );
     }
 
     template<typename visitor>
     typename visitor::result_type visit(visitor& v)const {
-        return visit( _tag, v, (const void*) storage.data() );
+        return visit( _tag, v, (const void*) storage.data( _tag ) );
     }
 
     template<typename visitor>
     typename visitor::result_type visit(const visitor& v)const {
-        return visit( _tag, v, (const void*) storage.data() );
+        return visit( _tag, v, (const void*) storage.data( _tag ) );
     }
 
     template<typename visitor>
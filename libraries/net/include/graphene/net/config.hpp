@@ -84,6 +84,28 @@
 
 #define GRAPHENE_NET_MAX_INVENTORY_SIZE_IN_MINUTES           2
 
+/**
+ * The inventory we exchanged with each peer is remembered in rolling bloom filters
+ * of two generations.  A generation is retired after GRAPHENE_NET_MAX_INVENTORY_SIZE_IN_MINUTES
+ * or when this many items have been inserted into it, whichever comes first.  It holds the
+ * items of a whole window at GRAPHENE_NET_MAX_TRX_PER_SECOND, so at that rate an item is
+ * remembered for at least GRAPHENE_NET_MAX_INVENTORY_SIZE_IN_MINUTES.  A full generation
+ * takes about 430 KB, and is only allocated while a peer exchanges inventory with us.
+ * False positives only make us skip advertising an item to a peer, or ask a peer for an
+ * item it doesn't have.
+ */
+#define GRAPHENE_NET_INVENTORY_FILTER_ITEMS_PER_GENERATION   \
+   (GRAPHENE_NET_MAX_INVENTORY_SIZE_IN_MINUTES * 60 * GRAPHENE_NET_MAX_TRX_PER_SECOND)
+#define GRAPHENE_NET_INVENTORY_FILTER_FALSE_POSITIVE_RATE    0.000001
+
+/**
+ * New transactions are advertised to our peers in batches: we wait until this many
+ * items are ready, or until GRAPHENE_NET_INVENTORY_BATCH_INTERVAL_MS have passed.
+ * Blocks are always advertised right away.
+ */
+#define GRAPHENE_NET_MAX_INVENTORY_BATCH_SIZE                1000
+#define GRAPHENE_NET_INVENTORY_BATCH_INTERVAL_MS             100
+
 #define GRAPHENE_NET_MAX_BLOCKS_PER_PEER_DURING_SYNCING      200
 
 /**
@@ -109,6 +131,45 @@
 
 #define GRAPHENE_NET_MAX_TRX_PER_SECOND                      1000
 
+/**
+ * Each peer may send us this many transactions per second, with bursts of up to
+ * GRAPHENE_NET_MAX_TRX_BURST_PER_PEER transactions.  We stop fetching transactions
+ * from a peer that exceeds its budget until it has earned new tokens.
+ */
+#define GRAPHENE_NET_MAX_TRX_PER_SECOND_PER_PEER             200
+#define GRAPHENE_NET_MAX_TRX_BURST_PER_PEER                  1000
+
+/**
+ * Received transactions wait in a queue ordered by fee per kilobyte until the delegate
+ * validates them.  At most this many are handed to the delegate at a time, so that
+ * the queue decides the order, and blocks don't wait behind a long backlog.
+ */
+#define GRAPHENE_NET_MAX_TRANSACTIONS_BEING_VALIDATED        100
+/// Maximum memory used by the queue of received transactions waiting for validation
+#define GRAPHENE_NET_MAX_QUEUED_TRANSACTIONS_IN_BYTES        (16 * 1024 * 1024)
+
+/**
+ * The p2p thread answers has_item() and get_item() for recently accepted or served
+ * blocks from caches of these sizes instead of waiting for the delegate thread
+ */
+#define GRAPHENE_NET_DELEGATE_BLOCK_ID_CACHE_SIZE            10000
+#define GRAPHENE_NET_DELEGATE_BLOCK_CACHE_SIZE               100
+
+/**
+ * Peer performance records are moving averages, each new sample counts for 1/N.
+ * Peers without measurements are assumed to perform like the defaults below when
+ * estimating how quickly they would deliver a block of the reference size.
+ */
+#define GRAPHENE_NET_PEER_PERFORMANCE_AVERAGE_WEIGHT              8
+#define GRAPHENE_NET_PEER_PERFORMANCE_MAX_ITEMS_COUNTED           10000
+#define GRAPHENE_NET_PEER_PERFORMANCE_MIN_CONNECTION_DURATION_SEC 60
+#define GRAPHENE_NET_PEER_PERFORMANCE_DEFAULT_ROUND_TRIP_DELAY_MS 250
+#define GRAPHENE_NET_PEER_PERFORMANCE_DEFAULT_BLOCK_LATENCY_MS    1000
+#define GRAPHENE_NET_PEER_PERFORMANCE_DEFAULT_BYTES_PER_SECOND    (100 * 1024)
+#define GRAPHENE_NET_PEER_PERFORMANCE_REFERENCE_BLOCK_SIZE        (64 * 1024)
+/// Only blocks this recent are used to measure how quickly a peer relays blocks
+#define GRAPHENE_NET_PEER_PERFORMANCE_MAX_BLOCK_AGE_SEC           60
+
 #define GRAPHENE_NET_MAX_NESTED_OBJECTS                      (250)
 
 #define MAXIMUM_PEERDB_SIZE 1000
@@ -99,6 +99,10 @@ namespace graphene { namespace net {
       explicit trx_message(const graphene::protocol::signed_transaction& signed_trx) :
         trx(signed_trx)
       {}
+      /// Keeps the values cached in @p precomputed_trx, E.G. the message ID
+      explicit trx_message(const graphene::protocol::precomputable_transaction& precomputed_trx) :
+        trx(precomputed_trx)
+      {}
    };
 
    struct block_message
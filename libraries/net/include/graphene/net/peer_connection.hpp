@@ -27,6 +27,8 @@
 #include <graphene/net/peer_database.hpp>
 #include <graphene/net/message_oriented_connection.hpp>
 #include <graphene/net/config.hpp>
+#include <graphene/net/rolling_bloom_filter.hpp>
+#include <graphene/net/transaction_ingress_queue.hpp>
 
 #include <boost/tuple/tuple.hpp>
 
@@ -175,6 +177,8 @@ namespace graphene { namespace net
       firewalled_state is_firewalled = firewalled_state::unknown;
       fc::microseconds clock_offset;
       fc::microseconds round_trip_delay;
+      /// measured performance of this peer, loaded from and saved to the peer database
+      peer_performance_record performance;
 
       our_connection_state our_state = our_connection_state::disconnected;
       bool they_have_requested_close = false;
@@ -247,8 +251,17 @@ namespace graphene { namespace net
                                                                                                             std::hash<item_id> >,
                                                                           boost::multi_index::ordered_non_unique<boost::multi_index::tag<timestamp_index>,
                                                                                                                  boost::multi_index::member<timestamped_item_id, fc::time_point_sec, &timestamped_item_id::timestamp> > > > timestamped_items_set_type;
-      timestamped_items_set_type inventory_peer_advertised_to_us;
-      timestamped_items_set_type inventory_advertised_to_peer;
+      rolling_bloom_filter inventory_peer_advertised_to_us { GRAPHENE_NET_INVENTORY_FILTER_ITEMS_PER_GENERATION,
+                                                             GRAPHENE_NET_INVENTORY_FILTER_FALSE_POSITIVE_RATE,
+                                                             fc::minutes(GRAPHENE_NET_MAX_INVENTORY_SIZE_IN_MINUTES) };
+      rolling_bloom_filter inventory_advertised_to_peer { GRAPHENE_NET_INVENTORY_FILTER_ITEMS_PER_GENERATION,
+                                                          GRAPHENE_NET_INVENTORY_FILTER_FALSE_POSITIVE_RATE,
+                                                          fc::minutes(GRAPHENE_NET_MAX_INVENTORY_SIZE_IN_MINUTES) };
+      /// items the peer advertised to us but later told us it doesn't have, they can't be removed from the filter
+      timestamped_items_set_type inventory_peer_no_longer_has;
+      /// number of items the peer advertised to us since inventory_window_start, to detect flooding
+      uint32_t number_of_items_peer_advertised_to_us = 0;
+      fc::time_point inventory_window_start;
 
       item_to_time_map_type items_requested_from_peer;  /// items we've requested from this peer during normal operation.  fetch from another peer if this peer disconnects
       /// @}
@@ -256,6 +269,9 @@ namespace graphene { namespace net
       // if they're flooding us with transactions, we set this to avoid fetching for a few seconds to let the
       // blockchain catch up
       fc::time_point transaction_fetching_inhibited_until;
+      /// limits the rate at which we fetch transactions from this peer
+      token_bucket transaction_fetch_budget { GRAPHENE_NET_MAX_TRX_PER_SECOND_PER_PEER,
+                                              GRAPHENE_NET_MAX_TRX_BURST_PER_PEER };
 
       uint32_t last_known_fork_block_number = 0;
 
@@ -304,6 +320,9 @@ namespace graphene { namespace net
       bool is_transaction_fetching_inhibited() const;
       fc::sha512 get_shared_secret() const;
       void clear_old_inventory();
+      /// whether the peer has advertised the item to us (may return false positives)
+      bool has_advertised_item_to_us( const item_id& item ) const;
+      void on_item_advertised_to_us( const item_id& item );
       bool is_inventory_advertised_to_us_list_full_for_transactions() const;
       bool is_inventory_advertised_to_us_list_full() const;
       bool performing_firewall_check() const;
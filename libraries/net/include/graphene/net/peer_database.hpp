@@ -44,6 +44,31 @@ namespace graphene { namespace net {
     last_connection_succeeded
   };
 
+  /**
+   * Measured performance of a peer, kept across connections so that we can prefer
+   * peers that deliver blocks quickly when choosing whom to connect to and sync from
+   */
+  struct peer_performance_record
+  {
+    uint32_t average_round_trip_delay_ms = 0; ///< moving average, 0 if never measured
+    uint64_t average_bytes_per_second = 0;    ///< moving average of the receive rate of past connections, 0 if never measured
+    uint32_t average_block_latency_ms = 0;    ///< moving average of the delay between a block's timestamp and its arrival, 0 if never measured
+    uint32_t number_of_items_received = 0;
+    uint32_t number_of_invalid_items_received = 0;
+
+    void record_round_trip_delay( const fc::microseconds& round_trip_delay );
+    void record_connection_throughput( uint64_t bytes_received, const fc::microseconds& connection_duration );
+    void record_block_latency( const fc::microseconds& block_latency );
+    void record_item_received( bool valid );
+
+    /**
+     * Estimate how long it would take this peer to deliver a new block to us, penalized by the
+     * fraction of invalid items it sent.  Peers we know nothing about get average defaults.
+     * Lower is better.
+     */
+    fc::microseconds expected_block_delay() const;
+  };
+
   struct potential_peer_record
   {
     fc::ip::endpoint                  endpoint;
@@ -53,6 +78,7 @@ namespace graphene { namespace net {
     uint32_t                          number_of_successful_connection_attempts;
     uint32_t                          number_of_failed_connection_attempts;
     fc::optional<fc::exception>       last_error;
+    peer_performance_record           performance;
 
     potential_peer_record() :
       number_of_successful_connection_attempts(0),
@@ -119,6 +145,9 @@ namespace graphene { namespace net {
 
 } } // end namespace graphene::net
 
+FC_REFLECT( graphene::net::peer_performance_record,
+            (average_round_trip_delay_ms)(average_bytes_per_second)(average_block_latency_ms)
+            (number_of_items_received)(number_of_invalid_items_received) )
 FC_REFLECT_TYPENAME( graphene::net::potential_peer_record )
 
 GRAPHENE_DECLARE_EXTERNAL_SERIALIZATION( graphene::net::potential_peer_record)
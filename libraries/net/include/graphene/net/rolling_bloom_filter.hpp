@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2021 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <graphene/net/core_messages.hpp>
+
+#include <fc/bloom_filter.hpp>
+#include <fc/optional.hpp>
+#include <fc/time.hpp>
+
+namespace graphene { namespace net {
+
+  /**
+   *  Remembers a bounded number of recently inserted items with a fixed memory footprint.
+   *
+   *  Items are inserted into the current generation of two bloom filters.  When the current
+   *  generation is full, or older than the configured lifetime, it becomes the previous
+   *  generation and the old previous generation is forgotten.  An item is therefore
+   *  remembered for at least one generation, and lookups may return false positives with
+   *  roughly the configured probability, but never false negatives for remembered items.
+   *  The bit table of a generation is only allocated when the first item is inserted into it,
+   *  and released when the generation is forgotten, so an idle filter uses no memory for it.
+   */
+  class rolling_bloom_filter
+  {
+  public:
+    /**
+     *  @param items_per_generation        maximum number of items inserted into one generation
+     *  @param false_positive_probability  the false positive probability of one generation when it is full
+     *  @param generation_lifetime         maximum time a generation stays current
+     */
+    rolling_bloom_filter( uint32_t items_per_generation, double false_positive_probability,
+                          const fc::microseconds& generation_lifetime );
+
+    void insert( const item_id& item, const fc::time_point& now = fc::time_point::now() );
+    bool contains( const item_id& item ) const;
+    /// forget the previous generation if it's too old, then rotate the current one if needed
+    void expire( const fc::time_point& now = fc::time_point::now() );
+    void clear();
+
+    /// number of items inserted into the generations we currently remember
+    uint32_t size() const { return _counts[0] + _counts[1]; }
+    /// memory used by the bit tables of the generations that are allocated, in bytes
+    size_t memory_usage() const
+    { return ( _generations[0].valid() + _generations[1].valid() ) * _bytes_per_generation; }
+    /// memory used by the bit tables of both generations when both are allocated, in bytes
+    size_t max_memory_usage() const { return 2 * _bytes_per_generation; }
+
+  private:
+    void rotate( const fc::time_point& now );
+
+    uint32_t                        _items_per_generation;
+    fc::microseconds                _generation_lifetime;
+    fc::bloom_parameters            _parameters;
+    size_t                          _bytes_per_generation;
+
+    fc::optional<fc::bloom_filter>  _generations[2];
+    uint32_t                        _counts[2] = { 0, 0 };
+    size_t            _current = 0; ///< index of the current generation
+    fc::time_point    _current_start;
+  };
+
+} } // graphene::net
@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2021 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <graphene/net/core_messages.hpp>
+#include <graphene/net/message.hpp>
+
+#include <fc/time.hpp>
+
+#include <map>
+
+namespace graphene { namespace net {
+
+  /**
+   *  Limits the rate of events, allowing short bursts.
+   *
+   *  The bucket holds up to @c capacity tokens and is refilled with @c tokens_per_second tokens
+   *  per second.  Each event consumes one token, events are refused while the bucket is empty.
+   */
+  class token_bucket
+  {
+  public:
+    token_bucket( uint32_t tokens_per_second, uint32_t capacity );
+
+    /// take a token if there is one
+    bool try_consume( const fc::time_point& now = fc::time_point::now() );
+    /// the time at which the next token will be available
+    fc::time_point next_token_time( const fc::time_point& now = fc::time_point::now() );
+
+  private:
+    void refill( const fc::time_point& now );
+
+    static constexpr int64_t units_per_token = 1000000;
+    int64_t          _units_per_second;
+    int64_t          _capacity_in_units;
+    int64_t          _units;        ///< tokens available, in millionths of a token
+    fc::time_point   _last_refill;
+  };
+
+  /**
+   *  Transactions received from peers, waiting to be validated by the delegate.
+   *
+   *  Transactions are taken out in order of decreasing fee per kilobyte, and in arrival order
+   *  among equal fees.  The total size of the queued messages is bounded, when a new transaction
+   *  doesn't fit, the transactions paying the lowest fees are dropped to make room, or the new
+   *  transaction is dropped if it pays the lowest fee itself.
+   */
+  class transaction_ingress_queue
+  {
+  public:
+    struct queued_transaction
+    {
+      trx_message                     transaction_message;
+      message                         original_message;
+      message_hash_type               message_hash;
+      fc::time_point                  receive_time;
+      node_id_t                       originating_peer_id;
+      fc::optional<fc::ip::endpoint>  originating_peer_endpoint;
+    };
+
+    explicit transaction_ingress_queue( size_t max_size_in_bytes );
+
+    /**
+     *  Queue a transaction, dropping lower paying transactions if the queue is full
+     *  @return false if the transaction was dropped instead
+     */
+    bool push( queued_transaction&& trx );
+    /// take out the highest paying transaction, the queue must not be empty
+    queued_transaction pop();
+
+    bool empty() const { return _transactions.empty(); }
+    size_t size() const { return _transactions.size(); }
+    size_t size_in_bytes() const { return _size_in_bytes; }
+
+    /**
+     *  The fee paid per kilobyte of the packed transaction.  Only fees paid in the core asset count,
+     *  fees paid in other assets can't be compared without the chain state and are taken as zero.
+     */
+    static uint64_t fee_per_kilobyte( const graphene::protocol::precomputable_transaction& trx );
+
+  private:
+    /// fee per kilobyte and arrival sequence number
+    using priority_type = std::pair<uint64_t, uint64_t>;
+    struct higher_priority
+    {
+      bool operator()( const priority_type& a, const priority_type& b ) const
+      {
+        return a.first != b.first ? a.first > b.first : a.second < b.second;
+      }
+    };
+
+    static size_t size_in_queue( const queued_transaction& trx );
+
+    std::map<priority_type, queued_transaction, higher_priority> _transactions;
+    size_t    _max_size_in_bytes;
+    size_t    _size_in_bytes = 0;
+    uint64_t  _next_sequence_number = 0;
+  };
+
+} } // graphene::net
@@ -173,6 +173,7 @@ namespace graphene { namespace net { namespace detail {
       VERIFY_CORRECT_THREAD();
       ilog( "cleaning up node" );
       _node_is_shutting_down = true;
+      _validation_results_wanted.reset();
 
       {
          fc::scoped_lock<fc::mutex> lock(_active_connections.get_mutex());
@@ -186,6 +187,7 @@ namespace graphene { namespace net { namespace detail {
                if (updated_peer_record)
                {
                   updated_peer_record->last_seen_time = fc::time_point::now();
+                  updated_peer_record->performance = get_final_performance_record(active_peer);
                   _potential_peer_db.update_entry(*updated_peer_record);
                }
             }
@@ -264,8 +266,12 @@ namespace graphene { namespace net { namespace detail {
             bool initiated_connection_this_pass = false;
             _potential_peer_db_updated = false;
 
+            // collect the peers we could connect to now, and try the ones expected to deliver blocks
+            // to us the soonest first.  Peers we haven't measured yet fall in the middle, and among
+            // equally good peers, the most recently seen ones go first
+            std::vector<std::pair<fc::microseconds, fc::ip::endpoint>> candidates;
             for (peer_database::iterator iter = _potential_peer_db.begin();
-                 iter != _potential_peer_db.end() && is_wanting_new_connections();
+                 iter != _potential_peer_db.end();
                  ++iter)
             {
               fc::microseconds delay_until_retry = fc::seconds( (iter->number_of_failed_connection_attempts + 1)
@@ -276,10 +282,23 @@ namespace graphene { namespace net { namespace detail {
                     iter->last_connection_disposition != last_connection_rejected &&
                     iter->last_connection_disposition != last_connection_handshaking_failed) ||
                    (fc::time_point::now() - iter->last_connection_attempt_time) > delay_until_retry))
-              {
-                connect_to_endpoint(iter->endpoint);
-                initiated_connection_this_pass = true;
-              }
+                candidates.emplace_back(iter->performance.expected_block_delay(), iter->endpoint);
+            }
+            std::stable_sort(candidates.begin(), candidates.end(),
+                             [](const std::pair<fc::microseconds, fc::ip::endpoint>& a,
+                                const std::pair<fc::microseconds, fc::ip::endpoint>& b) {
+                               return a.first < b.first;
+                             });
+
+            for (const auto& candidate : candidates)
+            {
+              if (!is_wanting_new_connections())
+                break;
+              // connecting yields, so make sure nobody connected to it in the meantime
+              if (is_connection_to_endpoint_in_progress(candidate.second))
+                continue;
+              connect_to_endpoint(candidate.second);
+              initiated_connection_this_pass = true;
             }
 
             if (!initiated_connection_this_pass && !_potential_peer_db_updated)
@@ -420,9 +439,18 @@ namespace graphene { namespace net { namespace detail {
           {
             std::set<item_hash_t> sync_items_to_request;
 
-            // for each idle peer that we're syncing with
-            fc::scoped_lock<fc::mutex> lock(_active_connections.get_mutex());
-            for( const peer_connection_ptr& peer : _active_connections )
+            // for each idle peer that we're syncing with, fastest first, so the fastest peers get the
+            // earliest blocks we need
+            std::vector<peer_connection_ptr> peers_by_expected_delay;
+            {
+              fc::scoped_lock<fc::mutex> lock(_active_connections.get_mutex());
+              peers_by_expected_delay.assign( _active_connections.begin(), _active_connections.end() );
+            }
+            std::stable_sort( peers_by_expected_delay.begin(), peers_by_expected_delay.end(),
+                              []( const peer_connection_ptr& a, const peer_connection_ptr& b ) {
+                                return a->performance.expected_block_delay() < b->performance.expected_block_delay();
+                              });
+            for( const peer_connection_ptr& peer : peers_by_expected_delay )
             {
               if( peer->we_need_sync_items_from_peer &&
                   // if we've already scheduled a request for this peer, don't consider scheduling another
@@ -488,7 +516,7 @@ namespace graphene { namespace net { namespace detail {
       fc::scoped_lock<fc::mutex> lock(_active_connections.get_mutex());
       for( const peer_connection_ptr& peer : _active_connections )
       {
-        if (peer->inventory_peer_advertised_to_us.find(item) != peer->inventory_peer_advertised_to_us.end() )
+        if (peer->has_advertised_item_to_us(item))
           return true;
       }
       return false;
@@ -515,15 +543,20 @@ namespace graphene { namespace net { namespace detail {
         {
           peer_connection_ptr peer;
           std::vector<item_id> item_ids;
-          peer_and_items_to_fetch(const peer_connection_ptr& peer) : peer(peer) {}
+          fc::microseconds expected_delay;
+          peer_and_items_to_fetch(const peer_connection_ptr& peer) :
+            peer(peer), expected_delay(peer->performance.expected_block_delay()) {}
           bool operator<(const peer_and_items_to_fetch& rhs) const { return peer < rhs.peer; }
           size_t number_of_items() const { return item_ids.size(); }
+          /// among peers with equally many requests, prefer the fastest
+          std::pair<size_t, int64_t> load() const { return std::make_pair(item_ids.size(), expected_delay.count()); }
         };
         using fetch_messages_to_send_set = boost::multi_index_container< peer_and_items_to_fetch, bmi::indexed_by<
                  bmi::ordered_unique<
                     bmi::member<peer_and_items_to_fetch, peer_connection_ptr, &peer_and_items_to_fetch::peer> >,
                  bmi::ordered_non_unique< bmi::tag<requested_item_count_index>,
-                    bmi::const_mem_fun<peer_and_items_to_fetch, size_t, &peer_and_items_to_fetch::number_of_items> >
+                    bmi::const_mem_fun<peer_and_items_to_fetch, std::pair<size_t, int64_t>,
+                                       &peer_and_items_to_fetch::load> >
                  > >;
         fetch_messages_to_send_set items_by_peer;
 
@@ -557,10 +590,15 @@ namespace graphene { namespace net { namespace detail {
               const peer_connection_ptr& peer = peer_iter->peer;
               // if they have the item and we haven't already decided to ask them for too many other items
               if (peer_iter->item_ids.size() < GRAPHENE_NET_MAX_ITEMS_PER_PEER_DURING_NORMAL_OPERATION &&
-                  peer->inventory_peer_advertised_to_us.find(item_iter->item) != peer->inventory_peer_advertised_to_us.end())
+                  peer->has_advertised_item_to_us(item_iter->item))
               {
                 if (item_iter->item.item_type == graphene::net::trx_message_type && peer->is_transaction_fetching_inhibited())
                   next_peer_unblocked_time = std::min(peer->transaction_fetching_inhibited_until, next_peer_unblocked_time);
+                else if (item_iter->item.item_type == graphene::net::trx_message_type &&
+                         !peer->transaction_fetch_budget.try_consume())
+                  // the peer has sent us its share of transactions for now, try another peer or wait
+                  next_peer_unblocked_time = std::min(peer->transaction_fetch_budget.next_token_time(),
+                                                      next_peer_unblocked_time);
                 else
                 {
                   //dlog("requesting item ${hash} from peer ${endpoint}",
@@ -636,10 +674,34 @@ namespace graphene { namespace net { namespace detail {
       VERIFY_CORRECT_THREAD();
       while (!_advertise_inventory_loop_done.canceled())
       {
+        // advertise transactions in batches to save on inventory messages, but don't hold back blocks
+        fc::time_point batch_deadline = fc::time_point::now() + fc::milliseconds(GRAPHENE_NET_INVENTORY_BATCH_INTERVAL_MS);
+        while (!_new_inventory_contains_block && _new_inventory.size() < GRAPHENE_NET_MAX_INVENTORY_BATCH_SIZE &&
+               fc::time_point::now() < batch_deadline)
+        {
+          _retrigger_advertise_inventory_loop_promise
+                = fc::promise<void>::create("graphene::net::retrigger_advertise_inventory_loop");
+          try
+          {
+            _retrigger_advertise_inventory_loop_promise->wait_until(batch_deadline);
+          }
+          catch (const fc::timeout_exception&)
+          {
+          }
+          _retrigger_advertise_inventory_loop_promise.reset();
+        }
+
         dlog("beginning an iteration of advertise inventory");
         // swap inventory into local variable, clearing the node's copy
         std::unordered_set<item_id> inventory_to_advertise;
         _new_inventory.swap( inventory_to_advertise );
+        _new_inventory_contains_block = false;
+
+        const fc::time_point_sec oldest_advertised_item_to_keep( fc::time_point::now()
+                                                                 - fc::minutes(GRAPHENE_NET_MAX_INVENTORY_SIZE_IN_MINUTES) );
+        auto& advertised_items_by_time = _recently_advertised_items.get<peer_connection::timestamp_index>();
+        advertised_items_by_time.erase( advertised_items_by_time.begin(),
+                                        advertised_items_by_time.lower_bound(oldest_advertised_item_to_keep) );
 
         // process all inventory to advertise and construct the inventory messages we'll send
         // first, then send them all in a batch (to avoid any fiber interruption points while
@@ -650,7 +712,6 @@ namespace graphene { namespace net { namespace detail {
          for (const peer_connection_ptr& peer : _active_connections)
          {
           // only advertise to peers who are in sync with us
-          idump((peer->peer_needs_sync_items_from_us));
           if( !peer->peer_needs_sync_items_from_us )
           {
             std::map<uint32_t, std::vector<item_hash_t> > items_to_advertise_by_type;
@@ -658,18 +719,15 @@ namespace graphene { namespace net { namespace detail {
             // or anything it has advertised to us
             // group the items we need to send by type, because we'll need to send one inventory message per type
             size_t total_items_to_send = 0;
-            idump((inventory_to_advertise));
+            const fc::time_point now = fc::time_point::now();
             for (const item_id& item_to_advertise : inventory_to_advertise)
             {
-               auto adv_to_peer = peer->inventory_advertised_to_peer.find(item_to_advertise);
-               auto adv_to_us   = peer->inventory_peer_advertised_to_us.find(item_to_advertise);
-
-              if (adv_to_peer == peer->inventory_advertised_to_peer.end() &&
-                  adv_to_us == peer->inventory_peer_advertised_to_us.end())
+              if (!peer->inventory_advertised_to_peer.contains(item_to_advertise) &&
+                  !peer->has_advertised_item_to_us(item_to_advertise))
               {
                 items_to_advertise_by_type[item_to_advertise.item_type].push_back(item_to_advertise.item_hash);
-                peer->inventory_advertised_to_peer.insert(
-                         peer_connection::timestamped_item_id(item_to_advertise, fc::time_point::now()));
+                peer->inventory_advertised_to_peer.insert(item_to_advertise, now);
+                _recently_advertised_items.insert(peer_connection::timestamped_item_id(item_to_advertise, now));
                 ++total_items_to_send;
                 if (item_to_advertise.item_type == trx_message_type)
                   testnetlog("advertising transaction ${id} to peer ${endpoint}",
@@ -677,13 +735,6 @@ namespace graphene { namespace net { namespace detail {
                 dlog("advertising item ${id} to peer ${endpoint}",
                      ("id", item_to_advertise.item_hash)("endpoint", peer->get_remote_endpoint()));
               }
-              else
-              {
-                 if (adv_to_peer != peer->inventory_advertised_to_peer.end() )
-                    idump( (*adv_to_peer) );
-                 if (adv_to_us != peer->inventory_peer_advertised_to_us.end() )
-                    idump( (*adv_to_us) );
-              }
             }
               dlog("advertising ${count} new item(s) of ${types} type(s) to peer ${endpoint}",
                    ("count", total_items_to_send)
@@ -2348,7 +2399,9 @@ namespace graphene { namespace net { namespace detail {
       if (regular_item_iter != originating_peer->items_requested_from_peer.end())
       {
         originating_peer->items_requested_from_peer.erase( regular_item_iter );
-        originating_peer->inventory_peer_advertised_to_us.erase( requested_item );
+        // the item can't be removed from the inventory filter, remember that the peer doesn't have it
+        originating_peer->inventory_peer_no_longer_has.insert(
+              peer_connection::timestamped_item_id( requested_item, fc::time_point::now() ) );
         if (is_item_in_any_peers_inventory(requested_item))
         {
           _items_to_fetch.insert(prioritized_item_id(requested_item, _items_to_fetch_seq_counter));
@@ -2393,19 +2446,20 @@ namespace graphene { namespace net { namespace detail {
       for( const item_hash_t& item_hash : item_ids_inventory_message_received.item_hashes_available )
       {
         item_id advertised_item_id(item_ids_inventory_message_received.item_type, item_hash);
-        bool we_advertised_this_item_to_a_peer = false;
+        // the inventory filters of the peers may report false positives, so they can't tell this
+        bool we_advertised_this_item_to_a_peer =
+              _recently_advertised_items.find(advertised_item_id) != _recently_advertised_items.end();
         bool we_requested_this_item_from_a_peer = false;
+        if (!we_advertised_this_item_to_a_peer)
         {
            fc::scoped_lock<fc::mutex> lock(_active_connections.get_mutex());
             for (const peer_connection_ptr& peer : _active_connections)
             {
-               if (peer->inventory_advertised_to_peer.find(advertised_item_id) != peer->inventory_advertised_to_peer.end())
+               if (peer->items_requested_from_peer.find(advertised_item_id) != peer->items_requested_from_peer.end())
                {
-                  we_advertised_this_item_to_a_peer = true;
+                  we_requested_this_item_from_a_peer = true;
                   break;
                }
-               if (peer->items_requested_from_peer.find(advertised_item_id) != peer->items_requested_from_peer.end())
-                  we_requested_this_item_from_a_peer = true;
             }
         }
 
@@ -2419,7 +2473,7 @@ namespace graphene { namespace net { namespace detail {
                originating_peer->is_inventory_advertised_to_us_list_full_for_transactions()) ||
               originating_peer->is_inventory_advertised_to_us_list_full())
             break;
-          originating_peer->inventory_peer_advertised_to_us.insert(peer_connection::timestamped_item_id(advertised_item_id, fc::time_point::now()));
+          originating_peer->on_item_advertised_to_us(advertised_item_id);
           if (!we_requested_this_item_from_a_peer)
           {
             if (_recently_failed_items.find(item_id(item_ids_inventory_message_received.item_type, item_hash)) != _recently_failed_items.end())
@@ -2520,6 +2574,7 @@ namespace graphene { namespace net { namespace detail {
           if (updated_peer_record)
           {
             updated_peer_record->last_seen_time = fc::time_point::now();
+            updated_peer_record->performance = get_final_performance_record(originating_peer_ptr);
             _potential_peer_db.update_entry(*updated_peer_record);
           }
         }
@@ -2963,6 +3018,12 @@ namespace graphene { namespace net { namespace detail {
                 ("id", block_message_to_process.block_id));
           _most_recent_blocks_accepted.push_back(block_message_to_process.block_id);
 
+          // remember how quickly this peer relayed the block, older blocks would only measure our own lag
+          originating_peer->performance.record_item_received( true );
+          fc::microseconds block_latency = message_receive_time - block_message_to_process.block.timestamp;
+          if( block_latency < fc::seconds(GRAPHENE_NET_PEER_PERFORMANCE_MAX_BLOCK_AGE_SEC) )
+            originating_peer->performance.record_block_latency( block_latency );
+
           bool new_transaction_discovered = false;
           for (const item_hash_t& transaction_message_hash : contained_transaction_msg_ids)
           {
@@ -2994,8 +3055,7 @@ namespace graphene { namespace net { namespace detail {
          fc::scoped_lock<fc::mutex> lock(_active_connections.get_mutex());
          for (const peer_connection_ptr& peer : _active_connections)
          {
-            auto iter = peer->inventory_peer_advertised_to_us.find(block_message_item_id);
-            if (iter != peer->inventory_peer_advertised_to_us.end())
+            if (peer->has_advertised_item_to_us(block_message_item_id))
             {
                // this peer offered us the item.  It will eventually expire from the peer's
                // inventory_peer_advertised_to_us list after some time has passed (currently 2 minutes).
@@ -3009,7 +3069,10 @@ namespace graphene { namespace net { namespace detail {
         }
         message_propagation_data propagation_data { message_receive_time, message_validated_time,
                                                     originating_peer->node_id };
-        broadcast( block_message_to_process, propagation_data );
+        // the block is already unpacked, no need to unpack it again to get the block ID
+        message block_message_to_broadcast( block_message_to_process );
+        broadcast( block_message_to_broadcast, propagation_data, block_message_to_broadcast.id(),
+                   block_message_to_process.block_id );
         _message_cache.block_accepted();
 
         if (is_hard_fork_block(block_number))
@@ -3069,6 +3132,7 @@ namespace graphene { namespace net { namespace detail {
         else
            disconnect_exception = e;
         disconnect_reason = "You offered me a block that I have deemed to be invalid";
+        originating_peer->performance.record_item_received( false );
 
         peers_to_disconnect.insert( originating_peer->shared_from_this() );
         fc::scoped_lock<fc::mutex> lock(_active_connections.get_mutex());
@@ -3198,6 +3262,7 @@ namespace graphene { namespace net { namespace detail {
                                              - current_time_reply_message_received.request_sent_time )
                                          - ( current_time_reply_message_received.reply_transmitted_time
                                              - current_time_reply_message_received.request_received_time );
+      originating_peer->performance.record_round_trip_delay( originating_peer->round_trip_delay );
     }
 
     void node_impl::forward_firewall_check_to_next_available_peer(firewall_check_state_data* firewall_check_state)
@@ -3404,18 +3469,35 @@ namespace graphene { namespace net { namespace detail {
           trigger_fetch_items_loop();
 
         // Next: have the delegate process the message
-        fc::time_point message_validated_time;
-        try
+        if (message_to_process.msg_type.value() == trx_message_type)
         {
-          if (message_to_process.msg_type.value() == trx_message_type)
+          // queue the transaction, the delegate validates queued transactions in order of the fees they pay
+          transaction_ingress_queue::queued_transaction queued_transaction { trx_message(),
+                message_to_process, message_hash, message_receive_time, originating_peer->node_id,
+                originating_peer->get_remote_endpoint() };
+          try
           {
-            trx_message transaction_message_to_process = message_to_process.as<trx_message>();
-            dlog( "passing message containing transaction ${trx} to client",
-                  ("trx", transaction_message_to_process.trx.id()) );
-            _delegate->handle_transaction(transaction_message_to_process);
+            queued_transaction.transaction_message = message_to_process.as<trx_message>();
           }
-          else
-            _delegate->handle_message( message_to_process );
+          catch ( const fc::exception& e )
+          {
+            on_message_rejected_by_delegate( originating_peer, originating_peer->get_remote_endpoint(),
+                                             message_to_process.msg_type.value(), message_hash, e );
+            return;
+          }
+          // the message ID is the hash of the packed transaction, no need to calculate it again
+          queued_transaction.transaction_message.trx.set_message_id( message_hash );
+          if( !_transaction_ingress_queue.push( std::move(queued_transaction) ) )
+            dlog( "dropping transaction ${hash} from peer ${endpoint}, the queue is full of better paying transactions",
+                  ("hash", message_hash)("endpoint", originating_peer->get_remote_endpoint()) );
+          validate_queued_transactions();
+          return;
+        }
+
+        fc::time_point message_validated_time;
+        try
+        {
+          _delegate->handle_message( message_to_process );
           message_validated_time = fc::time_point::now();
         }
         catch ( const fc::canceled_exception& )
@@ -3424,40 +3506,94 @@ namespace graphene { namespace net { namespace detail {
         }
         catch ( const fc::exception& e )
         {
-          switch( e.code() )
-          {
-          // log common exceptions in debug level
-          case graphene::chain::duplicate_transaction::code_enum::code_value :
-          case graphene::chain::limit_order_create_kill_unfilled::code_enum::code_value :
-          case graphene::chain::limit_order_create_market_not_whitelisted::code_enum::code_value :
-          case graphene::chain::limit_order_create_market_blacklisted::code_enum::code_value :
-          case graphene::chain::limit_order_create_selling_asset_unauthorized::code_enum::code_value :
-          case graphene::chain::limit_order_create_receiving_asset_unauthorized::code_enum::code_value :
-          case graphene::chain::limit_order_create_insufficient_balance::code_enum::code_value :
-          case graphene::chain::limit_order_cancel_nonexist_order::code_enum::code_value :
-          case graphene::chain::limit_order_cancel_owner_mismatch::code_enum::code_value :
-             dlog( "client rejected message sent by peer ${peer}, ${e}",
-                   ("peer", originating_peer->get_remote_endpoint() )("e", e) );
-             break;
-          // log rarer exceptions in warn level
-          default:
-             wlog( "client rejected message sent by peer ${peer}, ${e}",
-                   ("peer", originating_peer->get_remote_endpoint() )("e", e) );
-             break;
-          }
-          // record it so we don't try to fetch this item again
-          _recently_failed_items.insert( peer_connection::timestamped_item_id(
-                item_id( message_to_process.msg_type.value(), message_hash ), fc::time_point::now() ) );
+          on_message_rejected_by_delegate( originating_peer, originating_peer->get_remote_endpoint(),
+                                           message_to_process.msg_type.value(), message_hash, e );
           return;
         }
+        originating_peer->performance.record_item_received( true );
 
         // finally, if the delegate validated the message, broadcast it to our other peers
         message_propagation_data propagation_data { message_receive_time, message_validated_time,
                                                     originating_peer->node_id };
-        broadcast( message_to_process, propagation_data );
+        broadcast( message_to_process, propagation_data, message_hash, message_hash_type() );
       }
     }
 
+    void node_impl::validate_queued_transactions()
+    {
+      VERIFY_CORRECT_THREAD();
+      if( _node_is_shutting_down || !_delegate )
+        return;
+      while( _transactions_being_validated < GRAPHENE_NET_MAX_TRANSACTIONS_BEING_VALIDATED &&
+             !_transaction_ingress_queue.empty() )
+      {
+        transaction_ingress_queue::queued_transaction queued = _transaction_ingress_queue.pop();
+        message_hash_type hash_of_message_contents = queued.transaction_message.trx.id();
+        dlog( "passing message containing transaction ${trx} to client", ("trx", hash_of_message_contents) );
+        ++_transactions_being_validated;
+        // don't wait for the delegate here, so that bursts of transactions neither block nor get blocked by
+        // block processing.  The transaction is broadcast to our other peers once the delegate accepted it.
+        std::weak_ptr<bool> results_wanted = _validation_results_wanted;
+        _delegate->handle_transaction_async( queued.transaction_message,
+              [this, results_wanted, original_message = std::move(queued.original_message), message_hash = queued.message_hash,
+               hash_of_message_contents, receive_time = queued.receive_time,
+               originating_peer_id = queued.originating_peer_id,
+               originating_peer_endpoint = queued.originating_peer_endpoint]( const fc::oexception& error ) {
+          // the node may be gone, only look at it through the handle
+          if( results_wanted.expired() || _node_is_shutting_down || !_delegate )
+            return;
+          --_transactions_being_validated;
+          // the peer may have disconnected while the transaction was waiting to be handled
+          peer_connection_ptr originating_peer = get_peer_by_node_id( originating_peer_id );
+          if( error.valid() )
+            on_message_rejected_by_delegate( originating_peer.get(), originating_peer_endpoint,
+                                             original_message.msg_type.value(), message_hash, *error );
+          else
+          {
+            if( originating_peer )
+              originating_peer->performance.record_item_received( true );
+            message_propagation_data propagation_data { receive_time, fc::time_point::now(), originating_peer_id };
+            broadcast( original_message, propagation_data, message_hash, hash_of_message_contents );
+          }
+          validate_queued_transactions();
+        });
+      }
+    }
+
+    void node_impl::on_message_rejected_by_delegate( peer_connection* originating_peer,
+                                                     const fc::optional<fc::ip::endpoint>& originating_peer_endpoint,
+                                                     uint32_t message_type, const message_hash_type& message_hash,
+                                                     const fc::exception& e )
+    {
+      VERIFY_CORRECT_THREAD();
+      switch( e.code() )
+      {
+      // log common exceptions in debug level
+      case graphene::chain::duplicate_transaction::code_enum::code_value :
+      case graphene::chain::limit_order_create_kill_unfilled::code_enum::code_value :
+      case graphene::chain::limit_order_create_market_not_whitelisted::code_enum::code_value :
+      case graphene::chain::limit_order_create_market_blacklisted::code_enum::code_value :
+      case graphene::chain::limit_order_create_selling_asset_unauthorized::code_enum::code_value :
+      case graphene::chain::limit_order_create_receiving_asset_unauthorized::code_enum::code_value :
+      case graphene::chain::limit_order_create_insufficient_balance::code_enum::code_value :
+      case graphene::chain::limit_order_cancel_nonexist_order::code_enum::code_value :
+      case graphene::chain::limit_order_cancel_owner_mismatch::code_enum::code_value :
+         dlog( "client rejected message sent by peer ${peer}, ${e}",
+               ("peer", originating_peer_endpoint )("e", e) );
+         break;
+      // log rarer exceptions in warn level, and count them against the peer
+      default:
+         wlog( "client rejected message sent by peer ${peer}, ${e}",
+               ("peer", originating_peer_endpoint )("e", e) );
+         if( originating_peer )
+            originating_peer->performance.record_item_received( false );
+         break;
+      }
+      // record it so we don't try to fetch this item again
+      _recently_failed_items.insert( peer_connection::timestamped_item_id(
+            item_id( message_type, message_hash ), fc::time_point::now() ) );
+    }
+
     void node_impl::start_synchronizing_with_peer( const peer_connection_ptr& peer )
     {
       VERIFY_CORRECT_THREAD();
@@ -4007,6 +4143,9 @@ namespace graphene { namespace net { namespace detail {
     void node_impl::set_node_delegate(std::shared_ptr<node_delegate> del, fc::thread* thread_for_delegate_calls)
     {
       VERIFY_CORRECT_THREAD();
+      // results of transactions handed to the old delegate are dropped, don't wait for them
+      _validation_results_wanted = std::make_shared<bool>( true );
+      _transactions_being_validated = 0;
       _delegate.reset();
       if (del)
         _delegate = std::make_unique<statistics_gathering_node_delegate_wrapper>(del, thread_for_delegate_calls);
@@ -4325,12 +4464,30 @@ namespace graphene { namespace net { namespace detail {
     void node_impl::move_peer_to_active_list(const peer_connection_ptr& peer)
     {
       VERIFY_CORRECT_THREAD();
+      // pick up what we've learned about this peer's performance on earlier connections
+      fc::optional<fc::ip::endpoint> inbound_endpoint = peer->get_endpoint_for_connecting();
+      if (inbound_endpoint)
+      {
+        fc::optional<potential_peer_record> peer_record = _potential_peer_db.lookup_entry_for_endpoint(*inbound_endpoint);
+        if (peer_record)
+          peer->performance = peer_record->performance;
+      }
       _active_connections.insert(peer);
       _handshaking_connections.erase(peer);
       _closing_connections.erase(peer);
       _terminating_connections.erase(peer);
     }
 
+    peer_performance_record node_impl::get_final_performance_record(const peer_connection_ptr& peer) const
+    {
+      peer_performance_record performance = peer->performance;
+      fc::time_point connection_time = peer->get_connection_time();
+      if (connection_time != fc::time_point())
+        performance.record_connection_throughput(peer->get_total_bytes_received(),
+                                                 fc::time_point::now() - connection_time);
+      return performance;
+    }
+
     void node_impl::move_peer_to_closing_list(const peer_connection_ptr& peer)
     {
       VERIFY_CORRECT_THREAD();
@@ -4385,13 +4542,19 @@ namespace graphene { namespace net { namespace detail {
       ilog( "node._items_to_fetch size: ${size}", ("size", _items_to_fetch.size() ) );
       ilog( "node._new_inventory size: ${size}", ("size", _new_inventory.size() ) );
       ilog( "node._message_cache size: ${size}", ("size", _message_cache.size() ) );
+      ilog( "node._transaction_ingress_queue size: ${size} (${bytes} bytes)",
+            ("size", _transaction_ingress_queue.size() )("bytes", _transaction_ingress_queue.size_in_bytes() ) );
       fc::scoped_lock<fc::mutex> lock(_active_connections.get_mutex());
       for( const peer_connection_ptr& peer : _active_connections )
       {
         ilog( "  peer ${endpoint}", ("endpoint", peer->get_remote_endpoint() ) );
         ilog( "    peer.ids_of_items_to_get size: ${size}", ("size", peer->ids_of_items_to_get.size() ) );
-        ilog( "    peer.inventory_peer_advertised_to_us size: ${size}", ("size", peer->inventory_peer_advertised_to_us.size() ) );
-        ilog( "    peer.inventory_advertised_to_peer size: ${size}", ("size", peer->inventory_advertised_to_peer.size() ) );
+        ilog( "    peer.inventory_peer_advertised_to_us size: ${size} (${bytes} bytes)",
+              ("size", peer->inventory_peer_advertised_to_us.size() )
+              ("bytes", peer->inventory_peer_advertised_to_us.memory_usage() ) );
+        ilog( "    peer.inventory_advertised_to_peer size: ${size} (${bytes} bytes)",
+              ("size", peer->inventory_advertised_to_peer.size() )
+              ("bytes", peer->inventory_advertised_to_peer.memory_usage() ) );
         ilog( "    peer.items_requested_from_peer size: ${size}", ("size", peer->items_requested_from_peer.size() ) );
         ilog( "    peer.sync_items_requested_from_peer size: ${size}", ("size", peer->sync_items_requested_from_peer.size() ) );
       }
@@ -4566,7 +4729,6 @@ namespace graphene { namespace net { namespace detail {
       {
         graphene::net::block_message block_message_to_broadcast = item_to_broadcast.as<graphene::net::block_message>();
         hash_of_message_contents = block_message_to_broadcast.block_id; // for debugging
-        _most_recent_blocks_accepted.push_back( block_message_to_broadcast.block_id );
       }
       else if( item_to_broadcast.msg_type.value() == graphene::net::trx_message_type )
       {
@@ -4574,10 +4736,21 @@ namespace graphene { namespace net { namespace detail {
         hash_of_message_contents = transaction_message_to_broadcast.trx.id(); // for debugging
         dlog( "broadcasting trx: ${trx}", ("trx", transaction_message_to_broadcast) );
       }
-      message_hash_type hash_of_item_to_broadcast = item_to_broadcast.id();
+      broadcast( item_to_broadcast, propagation_data, item_to_broadcast.id(), hash_of_message_contents );
+    }
+
+    void node_impl::broadcast( const message& item_to_broadcast, const message_propagation_data& propagation_data,
+                               const message_hash_type& hash_of_item_to_broadcast,
+                               const message_hash_type& hash_of_message_contents )
+    {
+      VERIFY_CORRECT_THREAD();
+      if( item_to_broadcast.msg_type.value() == graphene::net::block_message_type )
+        _most_recent_blocks_accepted.push_back( hash_of_message_contents );
 
       _message_cache.cache_message( item_to_broadcast, hash_of_item_to_broadcast, propagation_data, hash_of_message_contents );
       _new_inventory.insert( item_id(item_to_broadcast.msg_type.value(), hash_of_item_to_broadcast ) );
+      if( item_to_broadcast.msg_type.value() == graphene::net::block_message_type )
+        _new_inventory_contains_block = true;
       trigger_advertise_inventory_loop();
     }
 
@@ -4953,6 +5126,38 @@ namespace graphene { namespace net { namespace detail {
     {}
 #undef INITIALIZE_ACCUMULATOR
 
+    struct statistics_gathering_node_delegate_wrapper::queued_transaction
+    {
+      trx_message                                 transaction_message;
+      std::function<void(const fc::oexception&)>  on_handled;
+      fc::thread*                                 calling_thread;
+      std::shared_ptr<call_statistics_collector>  statistics_collector;
+      fc::oexception                              error;
+    };
+
+    statistics_gathering_node_delegate_wrapper::~statistics_gathering_node_delegate_wrapper()
+    {
+      // results reported after this point must not reach the node, which may be destroying or replacing us.
+      // The calling thread yields while waiting below, so this has to happen first
+      _alive.reset();
+      // a drain task may still refer to us, let it finish.  Tasks on the delegate thread run in order,
+      // so waiting for the most recently scheduled one is enough
+      if( _drain_transactions_done.valid() && !_drain_transactions_done.ready() )
+      {
+        try
+        {
+          _drain_transactions_done.wait();
+        }
+        catch( const fc::exception& e )
+        {
+          wlog( "Exception thrown while draining queued transactions, ignoring: ${e}", ("e", e) );
+        }
+      }
+      queued_transaction* queued = nullptr;
+      while( _transactions_to_handle.pop( queued ) )
+        delete queued;
+    }
+
     fc::variant_object statistics_gathering_node_delegate_wrapper::get_call_statistics()
     {
       fc::mutable_variant_object statistics;
@@ -5041,7 +5246,12 @@ namespace graphene { namespace net { namespace detail {
 
     bool statistics_gathering_node_delegate_wrapper::has_item( const net::item_id& id )
     {
-      INVOKE_AND_COLLECT_STATISTICS(has_item, id);
+      if( id.item_type == graphene::net::block_message_type && _recently_accepted_blocks.find( id.item_hash ) )
+        return true;
+      bool result = [&]() -> bool { INVOKE_AND_COLLECT_STATISTICS(has_item, id); }();
+      if( result && id.item_type == graphene::net::block_message_type )
+        _recently_accepted_blocks.insert( id.item_hash, true );
+      return result;
     }
 
     void statistics_gathering_node_delegate_wrapper::handle_message( const message& message_to_handle )
@@ -5052,7 +5262,13 @@ namespace graphene { namespace net { namespace detail {
     bool statistics_gathering_node_delegate_wrapper::handle_block( const graphene::net::block_message& block_message,
              bool sync_mode, std::vector<message_hash_type>& contained_transaction_msg_ids)
     {
-      INVOKE_AND_COLLECT_STATISTICS(handle_block, block_message, sync_mode, contained_transaction_msg_ids);
+      bool result = [&]() -> bool {
+        INVOKE_AND_COLLECT_STATISTICS(handle_block, block_message, sync_mode, contained_transaction_msg_ids);
+      }();
+      // the block is known now, and peers are likely to ask us for it soon
+      _recently_accepted_blocks.insert( block_message.block_id, true );
+      _recently_served_blocks.insert( block_message.block_id, message( block_message ) );
+      return result;
     }
 
     void statistics_gathering_node_delegate_wrapper::handle_transaction( const graphene::net::trx_message& transaction_message )
@@ -5060,6 +5276,68 @@ namespace graphene { namespace net { namespace detail {
       INVOKE_AND_COLLECT_STATISTICS(handle_transaction, transaction_message);
     }
 
+    void statistics_gathering_node_delegate_wrapper::handle_transaction_async(
+            const graphene::net::trx_message& transaction_message,
+            std::function<void(const fc::oexception&)> on_handled )
+    {
+      auto statistics_collector = std::make_shared<call_statistics_collector>( "handle_transaction",
+                                                     &_handle_transaction_execution_accumulator,
+                                                     &_handle_transaction_delay_before_accumulator,
+                                                     &_handle_transaction_delay_after_accumulator );
+      _transactions_to_handle.push( new queued_transaction{ transaction_message, std::move(on_handled),
+                                                            &fc::thread::current(), statistics_collector } );
+      // only schedule a drain if none is pending, a pending one will pick this transaction up
+      if( !_draining_transactions.exchange( true ) )
+        _drain_transactions_done = _thread->async( [this](){ drain_transactions_to_handle(); },
+                                                   "drain queued transactions" );
+    }
+
+    void statistics_gathering_node_delegate_wrapper::drain_transactions_to_handle()
+    {
+      // clear the flag before popping, so that a transaction pushed after we stop popping schedules a new drain
+      _draining_transactions.store( false );
+
+      using handled_batch = std::vector<std::unique_ptr<queued_transaction>>;
+      std::map<fc::thread*, std::shared_ptr<handled_batch>> handled_by_calling_thread;
+      queued_transaction* popped = nullptr;
+      while( _transactions_to_handle.pop( popped ) )
+      {
+        std::unique_ptr<queued_transaction> queued( popped );
+        {
+          call_statistics_collector::actual_execution_measurement_helper helper( queued->statistics_collector );
+          try
+          {
+            _node_delegate->handle_transaction( queued->transaction_message );
+          }
+          catch( const fc::exception& e )
+          {
+            queued->error = e;
+          }
+          catch( const std::exception& e )
+          {
+            queued->error = fc::unhandled_exception( FC_LOG_MESSAGE( warn, "${what}", ("what", e.what()) ) );
+          }
+        }
+        auto& batch = handled_by_calling_thread[queued->calling_thread];
+        if( !batch )
+          batch = std::make_shared<handled_batch>();
+        batch->emplace_back( std::move(queued) );
+      }
+
+      // report the results back in one task per calling thread instead of one task per transaction
+      std::weak_ptr<bool> alive = _alive;
+      for( auto& calling_thread_and_batch : handled_by_calling_thread )
+      {
+        std::shared_ptr<handled_batch> batch = calling_thread_and_batch.second;
+        calling_thread_and_batch.first->async( [alive, batch](){
+          if( alive.expired() )
+            return;
+          for( const auto& queued : *batch )
+            queued->on_handled( queued->error );
+        }, "report handled transactions" );
+      }
+    }
+
     std::vector<item_hash_t> statistics_gathering_node_delegate_wrapper::get_block_ids(const std::vector<item_hash_t>& blockchain_synopsis,
                                                                                        uint32_t& remaining_item_count,
                                                                                        uint32_t limit /* = 2000 */)
@@ -5069,7 +5347,16 @@ namespace graphene { namespace net { namespace detail {
 
     message statistics_gathering_node_delegate_wrapper::get_item( const item_id& id )
     {
-      INVOKE_AND_COLLECT_STATISTICS(get_item, id);
+      if( id.item_type == graphene::net::block_message_type )
+      {
+        fc::optional<message> cached_block = _recently_served_blocks.find( id.item_hash );
+        if( cached_block )
+          return *cached_block;
+      }
+      message result = [&]() -> message { INVOKE_AND_COLLECT_STATISTICS(get_item, id); }();
+      if( id.item_type == graphene::net::block_message_type )
+        _recently_served_blocks.insert( id.item_hash, result );
+      return result;
     }
 
     chain_id_type statistics_gathering_node_delegate_wrapper::get_chain_id() const
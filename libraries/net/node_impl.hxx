@@ -16,8 +16,14 @@
 #define testnetlog(...) do {} while (0)
 #endif
 
+#include <atomic>
 #include <memory>
 #include <mutex>
+#include <boost/lockfree/queue.hpp>
+#include <boost/multi_index_container.hpp>
+#include <boost/multi_index/hashed_index.hpp>
+#include <boost/multi_index/member.hpp>
+#include <boost/multi_index/sequenced_index.hpp>
 #include <fc/thread/thread.hpp>
 #include <fc/log/logger.hpp>
 #include <fc/network/tcp_socket.hpp>
@@ -148,6 +154,59 @@ public:
    }
 };   
 
+/*******
+ * A bounded cache of the most recently inserted items, safe for multithreading
+ */
+template <class Key, class Value, class Hash = std::hash<Key> >
+class concurrent_recent_items_cache
+{
+private:
+   struct entry
+   {
+      Key   key;
+      Value value;
+   };
+   using container_type = bmi::multi_index_container< entry, bmi::indexed_by<
+                                 bmi::sequenced<>,
+                                 bmi::hashed_unique< bmi::member<entry, Key, &entry::key>, Hash > > >;
+
+   mutable fc::mutex mux;
+   container_type    items;
+   const size_t      max_size;
+
+public:
+   explicit concurrent_recent_items_cache( size_t max_size ) : max_size( max_size ) {}
+
+   /// Insert or refresh an item, dropping the oldest items if the cache is full
+   void insert( const Key& key, const Value& value )
+   {
+      fc::scoped_lock<fc::mutex> lock(mux);
+      auto& idx = items.template get<1>();
+      auto itr = idx.find( key );
+      if( itr != idx.end() )
+         idx.erase( itr );
+      items.push_front( entry{ key, value } );
+      while( items.size() > max_size )
+         items.pop_back();
+   }
+
+   fc::optional<Value> find( const Key& key ) const
+   {
+      fc::scoped_lock<fc::mutex> lock(mux);
+      const auto& idx = items.template get<1>();
+      auto itr = idx.find( key );
+      if( itr == idx.end() )
+         return fc::optional<Value>();
+      return itr->value;
+   }
+
+   size_t size() const
+   {
+      fc::scoped_lock<fc::mutex> lock(mux);
+      return items.size();
+   }
+};
+
 class blockchain_tied_message_cache
 {
 private:
@@ -235,6 +294,25 @@ class statistics_gathering_node_delegate_wrapper : public node_delegate
       std::shared_ptr<node_delegate> _node_delegate;
       fc::thread *_thread;
 
+      /// A transaction waiting to be handled by the delegate, see handle_transaction_async()
+      struct queued_transaction;
+      /// Pushed by the p2p thread, drained in batches by the delegate thread
+      boost::lockfree::queue<queued_transaction*> _transactions_to_handle { 1024 };
+      /// Whether a task to drain _transactions_to_handle is scheduled on the delegate thread
+      std::atomic_bool _draining_transactions { false };
+      /// Finishes when the most recently scheduled drain of _transactions_to_handle is done
+      fc::future<void> _drain_transactions_done;
+      /// Callbacks of queued transactions are only run while this is alive
+      std::shared_ptr<bool> _alive = std::make_shared<bool>( true );
+      void drain_transactions_to_handle();
+
+      /// IDs of blocks the delegate accepted recently, lets has_item() skip the delegate thread
+      concurrent_recent_items_cache<item_hash_t, bool> _recently_accepted_blocks
+            { GRAPHENE_NET_DELEGATE_BLOCK_ID_CACHE_SIZE };
+      /// Blocks the delegate returned recently, lets get_item() skip the delegate thread
+      concurrent_recent_items_cache<item_hash_t, message> _recently_served_blocks
+            { GRAPHENE_NET_DELEGATE_BLOCK_CACHE_SIZE };
+
       using call_stats_accumulator = boost::accumulators::accumulator_set< int64_t,
                                         boost::accumulators::stats< boost::accumulators::tag::min,
                                                                     boost::accumulators::tag::rolling_mean,
@@ -336,6 +414,7 @@ class statistics_gathering_node_delegate_wrapper : public node_delegate
    public:
       statistics_gathering_node_delegate_wrapper(std::shared_ptr<node_delegate> delegate,
                                                  fc::thread* thread_for_delegate_calls);
+      ~statistics_gathering_node_delegate_wrapper() override;
 
       fc::variant_object get_call_statistics();
 
@@ -344,6 +423,15 @@ class statistics_gathering_node_delegate_wrapper : public node_delegate
       bool handle_block( const graphene::net::block_message& block_message, bool sync_mode,
                          std::vector<message_hash_type>& contained_transaction_msg_ids ) override;
       void handle_transaction( const graphene::net::trx_message& transaction_message ) override;
+      /**
+       * Queue a transaction to be handled by the delegate without waiting for the result.
+       * Queued transactions are handled in batches on the delegate thread.
+       * @param transaction_message the transaction to handle
+       * @param on_handled called on the calling thread once the transaction was handled, with the
+       *                   exception thrown by the delegate if the transaction was rejected
+       */
+      void handle_transaction_async( const graphene::net::trx_message& transaction_message,
+                                     std::function<void(const fc::oexception&)> on_handled );
       std::vector<item_hash_t> get_block_ids(const std::vector<item_hash_t>& blockchain_synopsis,
                                              uint32_t& remaining_item_count,
                                              uint32_t limit = 2000) override;
@@ -465,6 +553,21 @@ class node_impl : public peer_connection_delegate, public std::enable_shared_fro
       fc::future<void>              _advertise_inventory_loop_done;
       /// List of items we have received but not yet advertised to our peers
       concurrent_unordered_set<item_id>   _new_inventory;
+      /// true if _new_inventory contains a block, which should be advertised without waiting for a full batch
+      bool                          _new_inventory_contains_block = false;
+      /// Items we have advertised to at least one peer in the last GRAPHENE_NET_MAX_INVENTORY_SIZE_IN_MINUTES.
+      /// Unlike the inventory filters of the peers this is exact, because we never fetch an item found here.
+      peer_connection::timestamped_items_set_type _recently_advertised_items;
+      /// @}
+
+      /// Transactions received from peers, waiting for the delegate to validate them
+      /// @{
+      transaction_ingress_queue     _transaction_ingress_queue { GRAPHENE_NET_MAX_QUEUED_TRANSACTIONS_IN_BYTES };
+      /// number of transactions handed to the delegate whose results haven't come back yet
+      uint32_t                      _transactions_being_validated = 0;
+      /// results of transactions handed to the delegate only touch the node while this is alive, it is renewed
+      /// when the delegate is replaced and released when the node shuts down
+      std::shared_ptr<bool>         _validation_results_wanted = std::make_shared<bool>( true );
       /// @}
 
       fc::future<void>     _kill_inactive_conns_loop_done;
@@ -711,6 +814,14 @@ class node_impl : public peer_connection_delegate, public std::enable_shared_fro
                   peer_connection* originating_peer,
                   const message& message_to_process,
                   const message_hash_type& message_hash);
+      /// Hand queued transactions to the delegate, best paying first, while few enough are being validated
+      void validate_queued_transactions();
+      /// Log a message rejected by the delegate, count it against the peer (if still connected),
+      /// and remember it so we don't fetch it again
+      void on_message_rejected_by_delegate( peer_connection* originating_peer,
+                                            const fc::optional<fc::ip::endpoint>& originating_peer_endpoint,
+                                            uint32_t message_type, const message_hash_type& message_hash,
+                                            const fc::exception& e );
 
       void start_synchronizing();
       void start_synchronizing_with_peer(const peer_connection_ptr& peer);
@@ -727,6 +838,8 @@ class node_impl : public peer_connection_delegate, public std::enable_shared_fro
       bool is_connection_to_endpoint_in_progress(const fc::ip::endpoint& remote_endpoint);
 
       void move_peer_to_active_list(const peer_connection_ptr& peer);
+      /// The peer's performance record including the throughput of the current connection, to save on disconnect
+      peer_performance_record get_final_performance_record(const peer_connection_ptr& peer) const;
       void move_peer_to_closing_list(const peer_connection_ptr& peer);
       void move_peer_to_terminating_list(const peer_connection_ptr& peer);
 
@@ -761,6 +874,10 @@ class node_impl : public peer_connection_delegate, public std::enable_shared_fro
       uint32_t                 get_connection_count() const;
 
       void broadcast(const message& item_to_broadcast, const message_propagation_data& propagation_data);
+      /// Broadcast a message whose hash and contents hash are already known
+      void broadcast(const message& item_to_broadcast, const message_propagation_data& propagation_data,
+                     const message_hash_type& hash_of_item_to_broadcast,
+                     const message_hash_type& hash_of_message_contents);
       void broadcast(const message& item_to_broadcast);
       void sync_from(const item_id& current_head_block, const std::vector<uint32_t>& hard_fork_block_numbers);
       bool is_connected() const;
@@ -485,30 +485,47 @@ namespace graphene { namespace net
     void peer_connection::clear_old_inventory()
     {
       VERIFY_CORRECT_THREAD();
-      fc::time_point_sec oldest_inventory_to_keep(fc::time_point::now() - fc::minutes(GRAPHENE_NET_MAX_INVENTORY_SIZE_IN_MINUTES));
-
-      // expire old items from inventory_advertised_to_peer
-      auto oldest_inventory_to_keep_iter = inventory_advertised_to_peer.get<timestamp_index>().lower_bound(oldest_inventory_to_keep);
-      auto begin_iter = inventory_advertised_to_peer.get<timestamp_index>().begin();
-      unsigned number_of_elements_advertised_to_peer_to_discard = std::distance(begin_iter, oldest_inventory_to_keep_iter);
-      inventory_advertised_to_peer.get<timestamp_index>().erase(begin_iter, oldest_inventory_to_keep_iter);
-
-      // also expire items from inventory_peer_advertised_to_us
-      oldest_inventory_to_keep_iter = inventory_peer_advertised_to_us.get<timestamp_index>().lower_bound(oldest_inventory_to_keep);
-      begin_iter = inventory_peer_advertised_to_us.get<timestamp_index>().begin();
-      unsigned number_of_elements_peer_advertised_to_discard = std::distance(begin_iter, oldest_inventory_to_keep_iter);
-      inventory_peer_advertised_to_us.get<timestamp_index>().erase(begin_iter, oldest_inventory_to_keep_iter);
-      dlog("Expiring old inventory for peer ${peer}: removing ${to_peer} items advertised to peer (${remain_to_peer} left), and ${to_us} advertised to us (${remain_to_us} left)",
+      fc::time_point now = fc::time_point::now();
+      fc::time_point_sec oldest_inventory_to_keep(now - fc::minutes(GRAPHENE_NET_MAX_INVENTORY_SIZE_IN_MINUTES));
+
+      // expire old generations of the inventory filters
+      inventory_advertised_to_peer.expire(now);
+      inventory_peer_advertised_to_us.expire(now);
+
+      auto oldest_inventory_to_keep_iter = inventory_peer_no_longer_has.get<timestamp_index>().lower_bound(oldest_inventory_to_keep);
+      inventory_peer_no_longer_has.get<timestamp_index>().erase(inventory_peer_no_longer_has.get<timestamp_index>().begin(),
+                                                                oldest_inventory_to_keep_iter);
+
+      if (inventory_window_start < fc::time_point(oldest_inventory_to_keep))
+      {
+        inventory_window_start = now;
+        number_of_items_peer_advertised_to_us = 0;
+      }
+      dlog("Expiring old inventory for peer ${peer}: ${to_peer} items advertised to peer, ${to_us} advertised to us",
            ("peer", get_remote_endpoint())
-           ("to_peer", number_of_elements_advertised_to_peer_to_discard)("remain_to_peer", inventory_advertised_to_peer.size())
-           ("to_us", number_of_elements_peer_advertised_to_discard)("remain_to_us", inventory_peer_advertised_to_us.size()));
+           ("to_peer", inventory_advertised_to_peer.size())("to_us", inventory_peer_advertised_to_us.size()));
+    }
+
+    bool peer_connection::has_advertised_item_to_us( const item_id& item ) const
+    {
+      VERIFY_CORRECT_THREAD();
+      return inventory_peer_advertised_to_us.contains(item) &&
+             inventory_peer_no_longer_has.find(item) == inventory_peer_no_longer_has.end();
+    }
+
+    void peer_connection::on_item_advertised_to_us( const item_id& item )
+    {
+      VERIFY_CORRECT_THREAD();
+      inventory_peer_advertised_to_us.insert(item);
+      inventory_peer_no_longer_has.erase(item);
+      ++number_of_items_peer_advertised_to_us;
     }
 
     // we have a higher limit for blocks than transactions so we will still fetch blocks even when transactions are throttled
     bool peer_connection::is_inventory_advertised_to_us_list_full_for_transactions() const
     {
       VERIFY_CORRECT_THREAD();
-      return inventory_peer_advertised_to_us.size() > GRAPHENE_NET_MAX_INVENTORY_SIZE_IN_MINUTES * GRAPHENE_NET_MAX_TRX_PER_SECOND * 60;
+      return number_of_items_peer_advertised_to_us > GRAPHENE_NET_MAX_INVENTORY_SIZE_IN_MINUTES * GRAPHENE_NET_MAX_TRX_PER_SECOND * 60;
     }
 
     bool peer_connection::is_inventory_advertised_to_us_list_full() const
@@ -517,7 +534,7 @@ namespace graphene { namespace net
       // allow the total inventory size to be the maximum number of transactions we'll store in the inventory (above)
       // plus the maximum number of blocks that would be generated in GRAPHENE_NET_MAX_INVENTORY_SIZE_IN_MINUTES (plus one,
       // to give us some wiggle room)
-      return inventory_peer_advertised_to_us.size() >
+      return number_of_items_peer_advertised_to_us >
         GRAPHENE_NET_MAX_INVENTORY_SIZE_IN_MINUTES * GRAPHENE_NET_MAX_TRX_PER_SECOND * 60 +
         (GRAPHENE_NET_MAX_INVENTORY_SIZE_IN_MINUTES + 1) * 60 / GRAPHENE_MIN_BLOCK_INTERVAL;
     }
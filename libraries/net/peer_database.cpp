@@ -21,6 +21,9 @@
  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
  * THE SOFTWARE.
  */
+#include <algorithm>
+#include <limits>
+
 #include <boost/multi_index_container.hpp>
 #include <boost/multi_index/ordered_index.hpp>
 #include <boost/multi_index/hashed_index.hpp>
@@ -37,6 +40,75 @@
 #include <graphene/net/config.hpp>
 
 namespace graphene { namespace net {
+  namespace
+  {
+    /// Fold a new sample into a moving average, the first sample is taken as is
+    template<typename T>
+    T moving_average( T average, T sample )
+    {
+      if( average == 0 )
+        return sample;
+      return ( average * ( GRAPHENE_NET_PEER_PERFORMANCE_AVERAGE_WEIGHT - 1 ) + sample )
+             / GRAPHENE_NET_PEER_PERFORMANCE_AVERAGE_WEIGHT;
+    }
+  }
+
+  void peer_performance_record::record_round_trip_delay( const fc::microseconds& round_trip_delay )
+  {
+    if( round_trip_delay.count() < 0 )
+      return;
+    // use at least 1ms so that a measured delay can be told apart from an unmeasured one
+    uint32_t sample = std::max<uint32_t>( 1, (uint32_t)std::min<int64_t>( round_trip_delay.count() / 1000,
+                                                                          std::numeric_limits<uint32_t>::max() ) );
+    average_round_trip_delay_ms = moving_average( average_round_trip_delay_ms, sample );
+  }
+
+  void peer_performance_record::record_connection_throughput( uint64_t bytes_received,
+                                                              const fc::microseconds& connection_duration )
+  {
+    // short connections are dominated by handshaking and say little about the peer's bandwidth
+    if( connection_duration < fc::seconds(GRAPHENE_NET_PEER_PERFORMANCE_MIN_CONNECTION_DURATION_SEC) )
+      return;
+    uint64_t sample = std::max<uint64_t>( 1, bytes_received * 1000000 / connection_duration.count() );
+    average_bytes_per_second = moving_average( average_bytes_per_second, sample );
+  }
+
+  void peer_performance_record::record_block_latency( const fc::microseconds& block_latency )
+  {
+    uint32_t sample = std::max<uint32_t>( 1, (uint32_t)std::min<int64_t>( std::max<int64_t>( 0, block_latency.count() / 1000 ),
+                                                                          std::numeric_limits<uint32_t>::max() ) );
+    average_block_latency_ms = moving_average( average_block_latency_ms, sample );
+  }
+
+  void peer_performance_record::record_item_received( bool valid )
+  {
+    // halve the counters once in a while, so recent behavior counts more than the distant past
+    if( number_of_items_received >= GRAPHENE_NET_PEER_PERFORMANCE_MAX_ITEMS_COUNTED )
+    {
+      number_of_items_received /= 2;
+      number_of_invalid_items_received /= 2;
+    }
+    ++number_of_items_received;
+    if( !valid )
+      ++number_of_invalid_items_received;
+  }
+
+  fc::microseconds peer_performance_record::expected_block_delay() const
+  {
+    uint64_t round_trip_delay_ms = average_round_trip_delay_ms ? average_round_trip_delay_ms
+                                                               : GRAPHENE_NET_PEER_PERFORMANCE_DEFAULT_ROUND_TRIP_DELAY_MS;
+    uint64_t block_latency_ms = average_block_latency_ms ? average_block_latency_ms
+                                                         : GRAPHENE_NET_PEER_PERFORMANCE_DEFAULT_BLOCK_LATENCY_MS;
+    uint64_t bytes_per_second = average_bytes_per_second ? average_bytes_per_second
+                                                         : GRAPHENE_NET_PEER_PERFORMANCE_DEFAULT_BYTES_PER_SECOND;
+    uint64_t transfer_time_ms = uint64_t(GRAPHENE_NET_PEER_PERFORMANCE_REFERENCE_BLOCK_SIZE) * 1000 / bytes_per_second;
+    uint64_t delay_ms = round_trip_delay_ms + block_latency_ms + transfer_time_ms;
+    // a peer that sent us nothing but invalid items is ten times as bad as a flawless one
+    if( number_of_items_received > 0 )
+      delay_ms += delay_ms * 9 * number_of_invalid_items_received / number_of_items_received;
+    return fc::milliseconds( delay_ms );
+  }
+
   namespace detail
   {
     using namespace boost::multi_index;
@@ -285,6 +357,6 @@ FC_REFLECT_ENUM( graphene::net::potential_peer_last_connection_disposition,
 FC_REFLECT_DERIVED_NO_TYPENAME( graphene::net::potential_peer_record, BOOST_PP_SEQ_NIL,
                                 (endpoint)(last_seen_time)(last_connection_disposition)
                                 (last_connection_attempt_time)(number_of_successful_connection_attempts)
-                                (number_of_failed_connection_attempts)(last_error) )
+                                (number_of_failed_connection_attempts)(last_error)(performance) )
 
 GRAPHENE_IMPLEMENT_EXTERNAL_SERIALIZATION( graphene::net::potential_peer_record)
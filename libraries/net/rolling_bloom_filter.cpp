@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2021 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <graphene/net/rolling_bloom_filter.hpp>
+
+#include <fc/exception/exception.hpp>
+
+namespace graphene { namespace net {
+
+  namespace {
+    fc::bloom_parameters make_bloom_parameters( uint32_t items_per_generation, double false_positive_probability )
+    {
+      fc::bloom_parameters parameters;
+      parameters.projected_element_count = items_per_generation;
+      parameters.false_positive_probability = false_positive_probability;
+      FC_ASSERT( !!parameters, "Invalid bloom filter parameters" );
+      parameters.compute_optimal_parameters();
+      return parameters;
+    }
+  }
+
+  rolling_bloom_filter::rolling_bloom_filter( uint32_t items_per_generation, double false_positive_probability,
+                                              const fc::microseconds& generation_lifetime )
+    : _items_per_generation( items_per_generation ),
+      _generation_lifetime( generation_lifetime ),
+      _parameters( make_bloom_parameters( items_per_generation, false_positive_probability ) ),
+      _bytes_per_generation( _parameters.optimal_parameters.table_size / 8 ),
+      _current_start( fc::time_point::now() )
+  {
+  }
+
+  void rolling_bloom_filter::insert( const item_id& item, const fc::time_point& now )
+  {
+    if( _counts[_current] >= _items_per_generation || now - _current_start >= _generation_lifetime )
+      rotate( now );
+    if( !_generations[_current].valid() )
+      _generations[_current] = fc::bloom_filter( _parameters );
+    // item hashes are already uniformly distributed, and hashes of different item types don't collide
+    _generations[_current]->insert( item.item_hash.data(), item.item_hash.data_size() );
+    ++_counts[_current];
+  }
+
+  bool rolling_bloom_filter::contains( const item_id& item ) const
+  {
+    for( size_t i = 0; i < 2; ++i )
+      if( _counts[i] > 0 && _generations[i]->contains( item.item_hash.data(), item.item_hash.data_size() ) )
+        return true;
+    return false;
+  }
+
+  void rolling_bloom_filter::expire( const fc::time_point& now )
+  {
+    if( now - _current_start >= _generation_lifetime + _generation_lifetime )
+    {
+      clear();
+      _current_start = now;
+    }
+    else if( now - _current_start >= _generation_lifetime )
+      rotate( now );
+  }
+
+  void rolling_bloom_filter::clear()
+  {
+    for( size_t i = 0; i < 2; ++i )
+    {
+      _generations[i].reset();
+      _counts[i] = 0;
+    }
+    _current_start = fc::time_point::now();
+  }
+
+  void rolling_bloom_filter::rotate( const fc::time_point& now )
+  {
+    _current = 1 - _current;
+    _generations[_current].reset();
+    _counts[_current] = 0;
+    _current_start = now;
+  }
+
+} } // graphene::net
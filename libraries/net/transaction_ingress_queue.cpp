@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2021 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/net/transaction_ingress_queue.hpp>
+
+#include <graphene/protocol/config.hpp>
+
+#include <fc/uint128.hpp>
+
+#include <algorithm>
+#include <limits>
+
+namespace graphene { namespace net {
+
+  token_bucket::token_bucket( uint32_t tokens_per_second, uint32_t capacity ) :
+    _units_per_second( int64_t(tokens_per_second) * units_per_token ),
+    _capacity_in_units( int64_t(capacity) * units_per_token ),
+    _units( _capacity_in_units )
+  {
+  }
+
+  void token_bucket::refill( const fc::time_point& now )
+  {
+    if( now <= _last_refill )
+      return;
+    // avoid overflowing on long idle periods, a full bucket is as full as it gets
+    int64_t elapsed = std::min( ( now - _last_refill ).count(), int64_t(fc::days(1).count()) );
+    _units = std::min( _capacity_in_units, _units + elapsed * _units_per_second / 1000000 );
+    _last_refill = now;
+  }
+
+  bool token_bucket::try_consume( const fc::time_point& now )
+  {
+    refill( now );
+    if( _units < units_per_token )
+      return false;
+    _units -= units_per_token;
+    return true;
+  }
+
+  fc::time_point token_bucket::next_token_time( const fc::time_point& now )
+  {
+    refill( now );
+    if( _units >= units_per_token )
+      return now;
+    if( _units_per_second == 0 )
+      return fc::time_point::maximum();
+    int64_t missing_units = units_per_token - _units;
+    return now + fc::microseconds( ( missing_units * 1000000 + _units_per_second - 1 ) / _units_per_second );
+  }
+
+  namespace
+  {
+    /// the fee of an operation if it's paid in the core asset, otherwise zero
+    struct core_fee_visitor
+    {
+      using result_type = uint64_t;
+      template<typename Operation>
+      result_type operator()( const Operation& op ) const
+      {
+        if( op.fee.asset_id != graphene::protocol::asset_id_type() || op.fee.amount <= 0 )
+          return 0;
+        // don't trust the peer to stay within the share supply, this is not validated yet
+        return std::min<uint64_t>( op.fee.amount.value, GRAPHENE_MAX_SHARE_SUPPLY );
+      }
+    };
+  }
+
+  transaction_ingress_queue::transaction_ingress_queue( size_t max_size_in_bytes ) :
+    _max_size_in_bytes( max_size_in_bytes )
+  {
+  }
+
+  uint64_t transaction_ingress_queue::fee_per_kilobyte( const graphene::protocol::precomputable_transaction& trx )
+  {
+    fc::uint128_t total_fee = 0;
+    for( const auto& op : trx.operations )
+      total_fee += op.visit( core_fee_visitor() );
+    uint64_t packed_size = std::max<uint64_t>( 1, trx.get_packed_size() );
+    fc::uint128_t result = total_fee * 1024 / packed_size;
+    if( result > fc::uint128_t( std::numeric_limits<uint64_t>::max() ) )
+      return std::numeric_limits<uint64_t>::max();
+    return static_cast<uint64_t>( result );
+  }
+
+  size_t transaction_ingress_queue::size_in_queue( const queued_transaction& trx )
+  {
+    // the unpacked transaction takes roughly as much memory as the packed message
+    return 2 * trx.original_message.data.size() + sizeof(queued_transaction);
+  }
+
+  bool transaction_ingress_queue::push( queued_transaction&& trx )
+  {
+    priority_type priority( fee_per_kilobyte( trx.transaction_message.trx ), _next_sequence_number++ );
+    size_t trx_size = size_in_queue( trx );
+    if( trx_size > _max_size_in_bytes )
+      return false;
+
+    // make room by dropping the transactions that pay less than this one
+    while( _size_in_bytes + trx_size > _max_size_in_bytes )
+    {
+      auto lowest = std::prev( _transactions.end() );
+      if( !higher_priority()( priority, lowest->first ) )
+        return false;
+      _size_in_bytes -= size_in_queue( lowest->second );
+      _transactions.erase( lowest );
+    }
+
+    _size_in_bytes += trx_size;
+    _transactions.emplace( priority, std::move(trx) );
+    return true;
+  }
+
+  transaction_ingress_queue::queued_transaction transaction_ingress_queue::pop()
+  {
+    FC_ASSERT( !_transactions.empty(), "no transactions queued" );
+    auto highest = _transactions.begin();
+    queued_transaction trx = std::move( highest->second );
+    _size_in_bytes -= size_in_queue( trx );
+    _transactions.erase( highest );
+    return trx;
+  }
+
+} } // graphene::net
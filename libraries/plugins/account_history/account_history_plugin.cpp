@@ -23,6 +23,7 @@
  */
 
 #include <graphene/account_history/account_history_plugin.hpp>
+#include <graphene/account_history/account_history_store.hpp>
 
 #include <graphene/chain/impacted.hpp>
 
@@ -37,6 +38,8 @@
 
 #include <fc/thread/thread.hpp>
 
+#include <boost/filesystem/path.hpp>
+
 namespace graphene { namespace account_history {
 
 namespace detail
@@ -71,10 +74,14 @@ class account_history_plugin_impl
       primary_index< operation_history_index >* _oho_index;
       uint64_t _max_ops_per_account = -1;
       uint64_t _extended_max_ops_per_account = -1;
+      account_history_store _store;
 
       /** add one history record, then check and remove the earliest history record */
       void add_account_history( const account_id_type account_id, const operation_history_id_type op_id );
 
+      /** move the history of irreversible blocks from the object database to the history store */
+      void archive_irreversible_history();
+
 };
 
 void account_history_plugin_impl::update_account_histories( const signed_block& b )
@@ -194,6 +201,53 @@ void account_history_plugin_impl::update_account_histories( const signed_block&
       if (_partial_operations && ! oho.valid())
          skip_oho_id();
    }
+
+   if( _store.is_open() )
+      archive_irreversible_history();
+}
+
+void account_history_plugin_impl::archive_irreversible_history()
+{
+   graphene::chain::database& db = database();
+   const uint32_t irreversible = db.get_dynamic_global_properties().last_irreversible_block_num;
+
+   // operations are created in the order of blocks, so the irreversible ones are at the beginning
+   const auto& oho_idx = _oho_index->indices();
+   if( oho_idx.empty() || oho_idx.begin()->block_num > irreversible )
+      return;
+
+   const auto& his_idx = db.get_index_type<account_transaction_history_index>();
+   const auto& by_opid_idx = his_idx.indices().get<by_opid>();
+   vector<const operation_history_object*> operations;
+   vector<const account_transaction_history_object*> entries;
+   for( auto itr = oho_idx.begin(); itr != oho_idx.end() && itr->block_num <= irreversible; ++itr )
+   {
+      operations.push_back( &*itr );
+      auto range = by_opid_idx.equal_range( itr->id );
+      for( auto ath_itr = range.first; ath_itr != range.second; ++ath_itr )
+         entries.push_back( &*ath_itr );
+   }
+
+   _store.append( operations, entries );
+
+   // Like in add_account_history, remove the oldest entries of the accounts and unlink them
+   const auto& by_seq_idx = his_idx.indices().get<by_seq>();
+   for( const account_transaction_history_object* ath : entries )
+   {
+      auto next_itr = by_seq_idx.find( boost::make_tuple( ath->account, ath->sequence + 1 ) );
+      if( next_itr != by_seq_idx.end() )
+      {
+         db.modify( *next_itr, []( account_transaction_history_object& obj ){
+            obj.next = account_transaction_history_id_type();
+         });
+      }
+      db.modify( ath->account(db).statistics(db), []( account_statistics_object& obj ){
+         obj.removed_ops = obj.removed_ops + 1;
+      });
+      db.remove( *ath );
+   }
+   for( const operation_history_object* op : operations )
+      db.remove( *op );
 }
 
 void account_history_plugin_impl::add_account_history( const account_id_type account_id, const operation_history_id_type op_id )
@@ -205,7 +259,9 @@ void account_history_plugin_impl::add_account_history( const account_id_type acc
        obj.operation_id = op_id;
        obj.account = account_id;
        obj.sequence = stats_obj.total_ops + 1;
-       obj.next = stats_obj.most_recent_op;
+       // the most recent entry may have been moved to the history store
+       if( db.find( stats_obj.most_recent_op ) != nullptr )
+          obj.next = stats_obj.most_recent_op;
    });
    db.modify( stats_obj, [&]( account_statistics_object& obj ){
        obj.most_recent_op = ath.id;
@@ -312,6 +368,9 @@ void account_history_plugin::plugin_set_program_options(
          ("extended-history-by-registrar",
           boost::program_options::value<std::vector<std::string>>()->composing()->multitoken(),
           "Track longer history for accounts with this registrar (may specify multiple times)")
+         ("history-store-dir", boost::program_options::value<boost::filesystem::path>(),
+          "Directory to move the history of irreversible blocks to instead of keeping it in memory "
+          "(max-ops-per-account is ignored if set)")
          ;
    cfg.add(cli);
 }
@@ -337,15 +396,33 @@ void account_history_plugin::plugin_initialize(const boost::program_options::var
                   graphene::chain::account_id_type);
    LOAD_VALUE_SET(options, "extended-history-by-registrar", my->_extended_history_registrars,
                   graphene::chain::account_id_type);
+   if (options.count("history-store-dir") > 0) {
+       if( my->_max_ops_per_account != uint64_t(-1) )
+          wlog( "max-ops-per-account is ignored because history-store-dir is set" );
+       // the store keeps everything, the extended history options only matter for pruning
+       my->_max_ops_per_account = -1;
+       my->_extended_max_ops_per_account = -1;
+       my->_store.open( options["history-store-dir"].as<boost::filesystem::path>() );
+   }
 }
 
 void account_history_plugin::plugin_startup()
 {
 }
 
+void account_history_plugin::plugin_shutdown()
+{
+   my->_store.close();
+}
+
 flat_set<account_id_type> account_history_plugin::tracked_accounts() const
 {
    return my->_tracked_accounts;
 }
 
+const account_history_store* account_history_plugin::history_store() const
+{
+   return my->_store.is_open() ? &my->_store : nullptr;
+}
+
 } }
@@ -0,0 +1,368 @@
+/*
+ * Copyright (c) 2021 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <graphene/account_history/account_history_store.hpp>
+
+#include <fc/io/raw.hpp>
+
+#include <cstring>
+
+#include <boost/endian/buffers.hpp>
+
+namespace graphene { namespace account_history {
+
+using boost::endian::little_uint32_buf_t;
+using boost::endian::little_uint64_buf_t;
+
+/// Entries refer to each other by their position in the file plus one, 0 means none
+struct account_history_store::entry_record
+{
+   little_uint64_buf_t account;
+   little_uint64_buf_t sequence;
+   little_uint64_buf_t operation;       ///< the instance of the operation
+   little_uint64_buf_t operation_pos;   ///< the offset of the operation in the file of operations
+   little_uint64_buf_t previous;        ///< the previous entry of the account
+   little_uint64_buf_t skip;            ///< the newest earlier entry of the account at a multiple of skip_interval
+};
+
+/// The committed state, see @ref account_history_store::commit
+struct head_record
+{
+   little_uint64_buf_t operations_size;
+   little_uint64_buf_t entries_size;
+   little_uint64_buf_t operations_end;
+};
+
+struct account_record
+{
+   little_uint64_buf_t account;
+   little_uint64_buf_t last_entry;
+   little_uint64_buf_t last_sequence;
+   little_uint64_buf_t last_skip_entry;
+};
+
+/// Replaces a file by writing a new one and renaming it, so that a crash leaves either the old or the new file
+static void replace_file( const fc::path& file, const char* data, size_t size )
+{
+   const fc::path tmp = file.generic_string() + ".tmp";
+   {
+      std::ofstream out;
+      out.exceptions( std::ios_base::failbit | std::ios_base::badbit );
+      out.open( tmp.generic_string().c_str(), std::ofstream::binary | std::ofstream::trunc );
+      out.write( data, size );
+   }
+   fc::rename( tmp, file );
+}
+
+static void open_file( std::fstream& stream, const fc::path& file, uint64_t size )
+{
+   stream.exceptions( std::ios_base::failbit | std::ios_base::badbit );
+   if( !fc::exists( file ) )
+   {
+      FC_ASSERT( size == 0, "${f} is missing", ("f",file) );
+      stream.open( file.generic_string().c_str(), std::fstream::binary | std::fstream::in | std::fstream::out
+                                                  | std::fstream::trunc );
+      return;
+   }
+   // cut off an uncommitted batch
+   const uint64_t file_size = fc::file_size( file );
+   FC_ASSERT( file_size >= size, "${f} is shorter than committed", ("f",file)("size",file_size)("committed",size) );
+   if( file_size > size )
+   {
+      wlog( "Discarding ${n} uncommitted bytes of ${f}", ("n",file_size - size)("f",file) );
+      fc::resize_file( file, size );
+   }
+   stream.open( file.generic_string().c_str(), std::fstream::binary | std::fstream::in | std::fstream::out );
+}
+
+account_history_store::~account_history_store()
+{
+   try {
+      close();
+   } catch( const fc::exception& e ) {
+      elog( "Failed to close account history store: ${e}", ("e",e.to_detail_string()) );
+   } catch( const std::exception& e ) {
+      elog( "Failed to close account history store: ${e}", ("e",e.what()) );
+   }
+}
+
+void account_history_store::open( const fc::path& dir )
+{ try {
+   FC_ASSERT( !is_open(), "The account history store is open already" );
+   fc::create_directories( dir );
+   _dir = dir;
+
+   head_record head;
+   head.operations_size = 0;
+   head.entries_size = 0;
+   head.operations_end = 0;
+   if( fc::exists( dir / "head" ) )
+   {
+      std::ifstream in;
+      in.exceptions( std::ios_base::failbit | std::ios_base::badbit );
+      in.open( (dir / "head").generic_string().c_str(), std::ifstream::binary );
+      in.read( (char*)&head, sizeof(head) );
+   }
+   _operations_size = head.operations_size.value();
+   _entries_size = head.entries_size.value();
+   _operations_end = head.operations_end.value();
+
+   open_file( _operations, dir / "operations", _operations_size );
+   open_file( _entries, dir / "entries", _entries_size * sizeof(entry_record) );
+
+   load_accounts();
+   ilog( "Opened account history store with ${n} entries of ${a} accounts",
+         ("n",_entries_size)("a",_accounts.size()) );
+} FC_CAPTURE_AND_RETHROW( (dir) ) }
+
+bool account_history_store::is_open()const
+{
+   return _entries.is_open();
+}
+
+void account_history_store::close()
+{
+   if( !is_open() )
+      return;
+   save_accounts();
+   _operations.close();
+   _entries.close();
+   _accounts.clear();
+}
+
+void account_history_store::load_accounts()
+{
+   _accounts.clear();
+   _batches_since_save = 0;
+
+   uint64_t loaded_entries = 0;
+   const fc::path file = _dir / "accounts";
+   if( fc::exists( file ) )
+   {
+      std::ifstream in;
+      in.exceptions( std::ios_base::failbit | std::ios_base::badbit );
+      in.open( file.generic_string().c_str(), std::ifstream::binary );
+      little_uint64_buf_t entries;
+      in.read( (char*)&entries, sizeof(entries) );
+      // the snapshot can only be used if it does not contain entries that have been cut off
+      if( entries.value() <= _entries_size )
+      {
+         loaded_entries = entries.value();
+         const uint64_t count = ( fc::file_size( file ) - sizeof(entries) ) / sizeof(account_record);
+         _accounts.reserve( count );
+         account_record record;
+         for( uint64_t i = 0; i < count; ++i )
+         {
+            in.read( (char*)&record, sizeof(record) );
+            account_head& head = _accounts[record.account.value()];
+            head.last_entry = record.last_entry.value();
+            head.last_sequence = record.last_sequence.value();
+            head.last_skip_entry = record.last_skip_entry.value();
+         }
+      }
+   }
+
+   // apply the entries that have been added since the snapshot was saved
+   for( uint64_t i = loaded_entries; i < _entries_size; ++i )
+   {
+      const entry_record e = read_entry( i );
+      account_head& head = _accounts[e.account.value()];
+      head.last_entry = i + 1;
+      head.last_sequence = e.sequence.value();
+      if( head.last_sequence % skip_interval == 0 )
+         head.last_skip_entry = i + 1;
+   }
+}
+
+void account_history_store::save_accounts()
+{
+   vector<char> data( sizeof(little_uint64_buf_t) + _accounts.size() * sizeof(account_record) );
+   little_uint64_buf_t entries;
+   entries = _entries_size;
+   memcpy( data.data(), &entries, sizeof(entries) );
+   account_record* records = (account_record*)( data.data() + sizeof(entries) );
+   for( const auto& item : _accounts )
+   {
+      records->account = item.first;
+      records->last_entry = item.second.last_entry;
+      records->last_sequence = item.second.last_sequence;
+      records->last_skip_entry = item.second.last_skip_entry;
+      ++records;
+   }
+   replace_file( _dir / "accounts", data.data(), data.size() );
+   _batches_since_save = 0;
+}
+
+void account_history_store::commit()
+{
+   _operations.flush();
+   _entries.flush();
+   head_record head;
+   head.operations_size = _operations_size;
+   head.entries_size = _entries_size;
+   head.operations_end = _operations_end;
+   replace_file( _dir / "head", (const char*)&head, sizeof(head) );
+}
+
+void account_history_store::append( const vector<const operation_history_object*>& operations,
+                                    const vector<const account_transaction_history_object*>& entries )
+{ try {
+   FC_ASSERT( is_open(), "The account history store is not open" );
+   if( operations.empty() && entries.empty() )
+      return;
+
+   // Nothing is changed in memory until the batch has been committed, so that a failed write can be retried
+   uint64_t operations_size = _operations_size;
+   uint64_t entries_size = _entries_size;
+   uint64_t operations_end = _operations_end;
+   std::unordered_map< uint64_t, uint64_t > positions;
+   std::unordered_map< uint64_t, account_head > heads;
+
+   _operations.seekp( operations_size );
+   for( const operation_history_object* op : operations )
+   {
+      const uint64_t instance = op->id.instance();
+      if( instance < operations_end )
+         continue;
+      const auto data = fc::raw::pack( *op );
+      little_uint32_buf_t size;
+      size = data.size();
+      _operations.write( (const char*)&size, sizeof(size) );
+      _operations.write( data.data(), data.size() );
+      positions[instance] = operations_size;
+      operations_size += sizeof(size) + data.size();
+      operations_end = instance + 1;
+   }
+
+   _entries.seekp( entries_size * sizeof(entry_record) );
+   for( const account_transaction_history_object* ath : entries )
+   {
+      const uint64_t account = ath->account.instance.value;
+      auto head_itr = heads.find( account );
+      if( head_itr == heads.end() )
+      {
+         auto itr = _accounts.find( account );
+         head_itr = heads.emplace( account, itr == _accounts.end() ? account_head() : itr->second ).first;
+      }
+      account_head& head = head_itr->second;
+      if( ath->sequence <= head.last_sequence )
+         continue;
+      const auto pos_itr = positions.find( ath->operation_id.instance.value );
+      FC_ASSERT( pos_itr != positions.end(), "Operation ${o} of account history entry ${e} is not in the batch",
+                 ("o",ath->operation_id)("e",ath->id) );
+
+      entry_record e;
+      e.account = account;
+      e.sequence = ath->sequence;
+      e.operation = ath->operation_id.instance.value;
+      e.operation_pos = pos_itr->second;
+      e.previous = head.last_entry;
+      e.skip = head.last_skip_entry;
+      _entries.write( (const char*)&e, sizeof(e) );
+      ++entries_size;
+
+      head.last_entry = entries_size;
+      head.last_sequence = ath->sequence;
+      if( head.last_sequence % skip_interval == 0 )
+         head.last_skip_entry = entries_size;
+   }
+
+   _operations_size = operations_size;
+   _entries_size = entries_size;
+   _operations_end = operations_end;
+   commit();
+
+   for( const auto& item : heads )
+      _accounts[item.first] = item.second;
+   if( ++_batches_since_save >= accounts_save_interval )
+      save_accounts();
+} FC_CAPTURE_AND_RETHROW( (operations.size())(entries.size()) ) }
+
+uint64_t account_history_store::last_sequence( account_id_type account )const
+{
+   const auto itr = _accounts.find( account.instance.value );
+   return itr == _accounts.end() ? 0 : itr->second.last_sequence;
+}
+
+account_history_store::entry_record account_history_store::read_entry( uint64_t entry )const
+{
+   entry_record e;
+   _entries.seekg( entry * sizeof(e) );
+   _entries.read( (char*)&e, sizeof(e) );
+   return e;
+}
+
+operation_history_object account_history_store::read_operation( uint64_t position )const
+{
+   little_uint32_buf_t size;
+   _operations.seekg( position );
+   _operations.read( (char*)&size, sizeof(size) );
+   vector<char> data( size.value() );
+   _operations.read( data.data(), data.size() );
+   return fc::raw::unpack<operation_history_object>( data );
+}
+
+vector<operation_history_object> account_history_store::get_account_history( account_id_type account,
+                                                                             uint64_t max_sequence,
+                                                                             uint64_t min_sequence,
+                                                                             uint64_t max_operation,
+                                                                             uint64_t stop,
+                                                                             uint32_t limit )const
+{ try {
+   vector<operation_history_object> result;
+   if( !is_open() || limit == 0 || max_sequence < min_sequence )
+      return result;
+   const auto itr = _accounts.find( account.instance.value );
+   if( itr == _accounts.end() )
+      return result;
+
+   // Find the newest entry not after max_sequence. The sequence numbers of an account are consecutive, so the
+   // entry a skip pointer refers to is at the multiple of skip_interval before the entry it is stored in.
+   uint64_t pos = itr->second.last_entry;
+   entry_record e;
+   while( true )
+   {
+      if( pos == 0 )
+         return result;
+      e = read_entry( pos - 1 );
+      if( e.sequence.value() <= max_sequence )
+         break;
+      const uint64_t skip_sequence = ( e.sequence.value() - 1 ) / skip_interval * skip_interval;
+      pos = ( e.skip.value() != 0 && skip_sequence >= max_sequence ) ? e.skip.value() : e.previous.value();
+   }
+
+   while( e.sequence.value() >= min_sequence && result.size() < limit )
+   {
+      if( stop != 0 && e.operation.value() <= stop )
+         break;
+      if( e.operation.value() <= max_operation )
+         result.push_back( read_operation( e.operation_pos.value() ) );
+      if( e.previous.value() == 0 )
+         break;
+      e = read_entry( e.previous.value() - 1 );
+   }
+   return result;
+} FC_CAPTURE_AND_RETHROW( (account)(max_sequence)(min_sequence)(max_operation)(stop)(limit) ) }
+
+} } // graphene::account_history
@@ -61,6 +61,8 @@ namespace detail
     class account_history_plugin_impl;
 }
 
+class account_history_store;
+
 class account_history_plugin : public graphene::app::plugin
 {
    public:
@@ -73,9 +75,13 @@ class account_history_plugin : public graphene::app::plugin
          boost::program_options::options_description& cfg) override;
       void plugin_initialize(const boost::program_options::variables_map& options) override;
       void plugin_startup() override;
+      void plugin_shutdown() override;
 
       flat_set<account_id_type> tracked_accounts()const;
 
+      /// @return the store of the history of irreversible blocks, or nullptr if it is not enabled
+      const account_history_store* history_store()const;
+
    private:
       std::unique_ptr<detail::account_history_plugin_impl> my;
 };
@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) 2021 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <graphene/chain/types.hpp>
+#include <graphene/db/generic_index.hpp>
+#include <graphene/chain/operation_history_object.hpp>
+
+#include <fc/filesystem.hpp>
+
+#include <fstream>
+#include <unordered_map>
+
+namespace graphene { namespace account_history {
+   using namespace graphene::chain;
+
+   /**
+    *  @brief An append-only store on disk for the irreversible part of the account history
+    *
+    *  Operations are appended to the file "operations", each as its packed size followed by the packed
+    *  @ref operation_history_object. Account history entries are appended to the file "entries" as fixed size
+    *  records. Each record points to its operation, to the previous entry of the same account, and to the latest
+    *  earlier entry of the same account whose sequence number is a multiple of @ref skip_interval. The history of
+    *  an account can therefore be read backwards from any position without touching the entries of other accounts.
+    *
+    *  Data is written in batches, one per applied block. After the operations and entries of a batch have been
+    *  written, the sizes of both files are committed to the file "head". When the store is opened, anything beyond
+    *  the committed sizes is cut off, so a crash loses at most the batch being written, which is written again when
+    *  its block is replayed. The newest entry of each account is kept in memory, and saved to the file "accounts"
+    *  every @ref accounts_save_interval batches and on close, so that opening the store only has to read the
+    *  entries written since.
+    */
+   class account_history_store
+   {
+      public:
+         static constexpr uint64_t skip_interval = 64;
+         static constexpr uint32_t accounts_save_interval = 10000;
+
+         ~account_history_store();
+
+         void open( const fc::path& dir );
+         bool is_open()const;
+         void close();
+
+         /**
+          * @brief Add a batch of operations and account history entries and commit it
+          * @param operations the operations, in ascending order of their IDs
+          * @param entries the account history entries of the operations, in ascending order of their sequence
+          *        numbers for each account
+          * @note Operations and entries that are already in the store are skipped, so that a batch can be added
+          *       again, e.g. after the block that added it has been popped and applied again.
+          */
+         void append( const vector<const operation_history_object*>& operations,
+                      const vector<const account_transaction_history_object*>& entries );
+
+         /// @return the sequence number of the newest entry of the account in the store, or 0 if there is none
+         uint64_t last_sequence( account_id_type account )const;
+
+         /**
+          * @brief Read the history of an account from the newest entry to the oldest
+          * @param account the account
+          * @param max_sequence only entries with sequence numbers not greater than this are read
+          * @param min_sequence only entries with sequence numbers not less than this are read
+          * @param max_operation only entries of operations with instances not greater than this are read
+          * @param stop only entries of operations with instances greater than this are read, unless this is 0
+          * @param limit the maximum number of operations to read
+          * @return the operations, in descending order
+          */
+         vector<operation_history_object> get_account_history( account_id_type account,
+                                                               uint64_t max_sequence,
+                                                               uint64_t min_sequence,
+                                                               uint64_t max_operation,
+                                                               uint64_t stop,
+                                                               uint32_t limit )const;
+
+      private:
+         struct entry_record;
+
+         /// Where the newest entries of an account are in the file of entries
+         struct account_head
+         {
+            uint64_t last_entry = 0;
+            uint64_t last_sequence = 0;
+            uint64_t last_skip_entry = 0;  ///< the newest entry with a sequence number divisible by skip_interval
+         };
+
+         entry_record             read_entry( uint64_t entry )const;
+         operation_history_object read_operation( uint64_t position )const;
+         void                     commit();
+         void                     save_accounts();
+         void                     load_accounts();
+
+         fc::path                                   _dir;
+         mutable std::fstream                       _operations;
+         mutable std::fstream                       _entries;
+         uint64_t                                   _operations_size = 0;
+         uint64_t                                   _entries_size = 0;   ///< the number of entries
+         /// The ID of the newest operation in the store plus one, or 0 if the store is empty
+         uint64_t                                   _operations_end = 0;
+         uint32_t                                   _batches_since_save = 0;
+         std::unordered_map< uint64_t, account_head > _accounts;
+   };
+
+} } // graphene::account_history
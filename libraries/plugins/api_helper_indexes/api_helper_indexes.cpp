@@ -189,6 +189,11 @@ void api_helper_indexes::plugin_startup()
    for( const auto& account : database().get_index_type< account_index >().indices() )
       account_members.object_inserted( account );
 
+   // insert in the order of names, so that every insertion appends to the last block
+   auto& account_names = *database().add_secondary_index< primary_index<account_index>, account_name_index >();
+   for( const auto& account : database().get_index_type< account_index >().indices().get<by_name>() )
+      account_names.object_inserted( account );
+
    auto& approvals = *database().add_secondary_index< primary_index<proposal_index>, required_approval_index >();
    for( const auto& proposal : database().get_index_type< proposal_index >().indices() )
       approvals.object_inserted( proposal );
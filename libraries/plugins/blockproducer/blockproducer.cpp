@@ -70,6 +70,9 @@ void blockproducer_plugin::plugin_set_program_options(
                "Enable block production, even if the chain is stale.")
          ("required-participation", bpo::value<uint32_t>()->default_value(33),
                "Percent of blockproducers (0-100) that must be participating in order to produce blocks")
+         ("block-generation-time-limit", bpo::value<uint32_t>()->default_value(500),
+               "Milliseconds that may be spent applying pending transactions when producing a block, 0 for no "
+               "limit. Transactions that don't make it are left for later blocks.")
          ("blockproducer-id,w", bpo::value<vector<string>>()->composing()->multitoken(),
                ("ID of blockproducer controlled by this node (e.g. " + blockproducer_id_example +
                ", quotes are required, may specify multiple times)").c_str())
@@ -164,6 +167,11 @@ void blockproducer_plugin::plugin_initialize(const boost::program_options::varia
        else if(required_participation > 90)
            wlog("blockproducer plugin: Warning - High required participation of ${rp}% found", ("rp", required_participation));
    }
+   if( options.count("block-generation-time-limit") > 0 )
+   {
+      database().set_block_generation_time_limit(
+            fc::milliseconds( options["block-generation-time-limit"].as<uint32_t>() ) );
+   }
    ilog("blockproducer plugin:  plugin_initialize() end");
 } FC_LOG_AND_RETHROW() }
 
@@ -269,7 +277,7 @@ block_production_condition::block_production_condition_enum blockproducer_plugin
    switch( result )
    {
       case block_production_condition::produced:
-         ilog("Generated block #${n} with ${x} transaction(s) and timestamp ${t} at time ${c}", (capture));
+         ilog("Generated block #${n} with ${x} transaction(s) and timestamp ${t} at time ${c} in ${l} ms", (capture));
          break;
       case block_production_condition::not_synced:
          ilog("Not producing block because production is disabled until we receive a recent block "
@@ -375,13 +383,16 @@ block_production_condition::block_production_condition_enum blockproducer_plugin
    if( p2p_node() == nullptr )
       return block_production_condition::no_network;
 
+   const fc::time_point generation_start = fc::time_point::now();
    auto block = db.generate_block(
       scheduled_time,
       scheduled_blockproducer,
       private_key_itr->second,
       _production_skip_flags
       );
-   capture("n", block.block_num())("t", block.timestamp)("c", now)("x", block.transactions.size());
+   const fc::microseconds latency = fc::time_point::now() - generation_start;
+   capture("n", block.block_num())("t", block.timestamp)("c", now)("x", block.transactions.size())
+          ("l", latency.count() / 1000);
    fc::async( [this,block](){ p2p_node()->broadcast(net::block_message(block)); } );
 
    return block_production_condition::produced;
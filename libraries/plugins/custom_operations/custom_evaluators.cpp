@@ -29,67 +29,69 @@
 
 namespace graphene { namespace custom_operations {
 
-custom_generic_evaluator::custom_generic_evaluator(database& db, const account_id_type account)
+custom_generic_evaluator::custom_generic_evaluator(database& db)
 {
    _db = &db;
-   _account = account;
 }
 
-vector<object_id_type> custom_generic_evaluator::do_apply(const account_storage_map& op)
+void custom_generic_evaluator::do_evaluate(account_id_type account, const account_storage_map& op)
+{
+   for(auto const& row: op.key_values) {
+      const auto key = std::make_tuple(account, op.catalog, row.first);
+      if (op.remove)
+      {
+         pending_change& change = _changes[key];
+         change.remove = true;
+         change.value.reset();
+         continue;
+      }
+      if(row.first.length() > CUSTOM_OPERATIONS_MAX_KEY_SIZE)
+      {
+         wlog("Key can't be bigger than ${max} characters", ("max", CUSTOM_OPERATIONS_MAX_KEY_SIZE));
+         continue;
+      }
+      // an invalid value is skipped, leaving earlier changes of the key in place
+      try {
+         optional<variant> value;
+         if(row.second.valid())
+            value = fc::json::from_string(*row.second);
+         pending_change& change = _changes[key];
+         change.remove = false;
+         change.value = std::move(value);
+      }
+      catch(const fc::parse_error_exception& e) { wlog(e.to_detail_string()); }
+   }
+}
+
+void custom_generic_evaluator::do_apply()
 {
    const auto &index = _db->get_index_type<account_storage_index>().indices().get<by_account_catalog_key>();
-   vector<object_id_type> results;
-   results.reserve( op.key_values.size() );
 
-   if (op.remove)
-   {
-      for(auto const& row: op.key_values) {
-         auto itr = index.find(make_tuple(_account, op.catalog, row.first));
-         if(itr != index.end()) {
-            results.push_back(itr->id);
+   for(auto const& row: _changes) {
+      const pending_change& change = row.second;
+      auto itr = index.find(row.first);
+      if (change.remove)
+      {
+         if(itr != index.end())
             _db->remove(*itr);
-         }
       }
-   }
-   else {
-      for(auto const& row: op.key_values) {
-         if(row.first.length() > CUSTOM_OPERATIONS_MAX_KEY_SIZE)
-         {
-            wlog("Key can't be bigger than ${max} characters", ("max", CUSTOM_OPERATIONS_MAX_KEY_SIZE));
-            continue;
-         }
-         auto itr = index.find(make_tuple(_account, op.catalog, row.first));
-         if(itr == index.end())
-         {
-            try {
-               const auto& created = _db->create<account_storage_object>(
-                                        [&op, this, &row]( account_storage_object& aso ) {
-                  aso.account = _account;
-                  aso.catalog = op.catalog;
-                  aso.key = row.first;
-                  if(row.second.valid())
-                     aso.value = fc::json::from_string(*row.second);
-               });
-               results.push_back(created.id);
-            }
-            catch(const fc::parse_error_exception& e) { wlog(e.to_detail_string()); }
-         }
-         else
-         {
-            try {
-               _db->modify(*itr, [&row](account_storage_object &aso) {
-                  if(row.second.valid())
-                     aso.value = fc::json::from_string(*row.second);
-                  else
-                     aso.value.reset();
-               });
-               results.push_back(itr->id);
-            }
-            catch(const fc::parse_error_exception& e) { wlog((e.to_detail_string())); }
-         }
+      else if(itr == index.end())
+      {
+         _db->create<account_storage_object>([&row, &change]( account_storage_object& aso ) {
+            aso.account = std::get<0>(row.first);
+            aso.catalog = std::get<1>(row.first);
+            aso.key = std::get<2>(row.first);
+            aso.value = change.value;
+         });
+      }
+      else
+      {
+         _db->modify(*itr, [&change](account_storage_object &aso) {
+            aso.value = change.value;
+         });
       }
    }
-   return results;
+   _changes.clear();
 }
 
 } }
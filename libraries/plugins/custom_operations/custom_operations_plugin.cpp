@@ -30,6 +30,22 @@
 
 namespace graphene { namespace custom_operations {
 
+void account_storage_catalog_index::object_inserted( const object& objct )
+{ try {
+   const auto& o = static_cast<const account_storage_object&>( objct );
+   catalog_keys.emplace( o.catalog, o.key, o.account );
+   ++catalogs[ std::make_pair( o.catalog, o.account ) ]; // Note: [] operator will create an entry if not found
+} FC_CAPTURE_AND_RETHROW( (objct) ) }
+
+void account_storage_catalog_index::object_removed( const object& objct )
+{ try {
+   const auto& o = static_cast<const account_storage_object&>( objct );
+   catalog_keys.erase( std::make_tuple( o.catalog, o.key, o.account ) );
+   auto itr = catalogs.find( std::make_pair( o.catalog, o.account ) );
+   if( itr != catalogs.end() && --itr->second == 0 )
+      catalogs.erase( itr );
+} FC_CAPTURE_AND_RETHROW( (objct) ) }
+
 namespace detail
 {
 class custom_operations_plugin_impl
@@ -52,21 +68,22 @@ class custom_operations_plugin_impl
       custom_operations_plugin& _self;
 
       uint32_t _start_block = 45000000;
+      bool _catalog_index = false;
 };
 
 struct custom_op_visitor
 {
    typedef void result_type;
    account_id_type _fee_payer;
-   database* _db;
+   custom_generic_evaluator* _evaluator;
 
-   custom_op_visitor(database& db, account_id_type fee_payer) { _db = &db; _fee_payer = fee_payer; };
+   custom_op_visitor(custom_generic_evaluator& evaluator, account_id_type fee_payer)
+   { _evaluator = &evaluator; _fee_payer = fee_payer; };
 
    template<typename T>
    void operator()(T &v) const {
       v.validate();
-      custom_generic_evaluator evaluator(*_db, _fee_payer);
-      evaluator.do_apply(v);
+      _evaluator->do_evaluate(_fee_payer, v);
    }
 };
 
@@ -74,6 +91,8 @@ void custom_operations_plugin_impl::onBlock()
 {
    graphene::chain::database& db = database();
    const vector<optional< operation_history_object > >& hist = db.get_applied_operations();
+   // the custom operations of the block are evaluated one by one, and their changes are applied at once
+   custom_generic_evaluator evaluator(db);
    for( const optional< operation_history_object >& o_operation : hist )
    {
       if(!o_operation.valid() || !o_operation->op.is_type<custom_operation>())
@@ -86,15 +105,16 @@ void custom_operations_plugin_impl::onBlock()
 
       try {
          auto unpacked = fc::raw::unpack<custom_plugin_operation>(custom_op.data);
-         custom_op_visitor vtor(db, custom_op.fee_payer());
+         custom_op_visitor vtor(evaluator, custom_op.fee_payer());
          unpacked.visit(vtor);
       }
-      catch (fc::exception& e) { // only api node will know if the unpack, validate or apply fails
+      catch (fc::exception& e) { // only api node will know if the unpack or validate fails
          wlog("Custom operations plugin serializing error: ${ex} in operation: ${op}",
                ("ex", e.to_detail_string())("op", fc::json::to_string(custom_op)));
          continue;
       }
    }
+   evaluator.do_apply();
 }
 
 } // end namespace detail
@@ -125,6 +145,9 @@ void custom_operations_plugin::plugin_set_program_options(
    cli.add_options()
          ("custom-operations-start-block", boost::program_options::value<uint32_t>()->default_value(45000000),
           "Start processing custom operations transactions with the plugin only after this block")
+         ("custom-operations-catalog-index", boost::program_options::value<bool>()->default_value(false),
+          "Maintain an index of the accounts that store each catalog and key, which is required for querying "
+          "stored data by catalog")
          ;
    cfg.add(cli);
 
@@ -137,6 +160,9 @@ void custom_operations_plugin::plugin_initialize(const boost::program_options::v
    if (options.count("custom-operations-start-block") > 0) {
       my->_start_block = options["custom-operations-start-block"].as<uint32_t>();
    }
+   if (options.count("custom-operations-catalog-index") > 0) {
+      my->_catalog_index = options["custom-operations-catalog-index"].as<bool>();
+   }
 
    database().applied_block.connect( [this]( const signed_block& b) {
       if( b.block_num() >= my->_start_block )
@@ -147,6 +173,14 @@ void custom_operations_plugin::plugin_initialize(const boost::program_options::v
 void custom_operations_plugin::plugin_startup()
 {
    ilog("custom_operations: plugin_startup() begin");
+
+   if( my->_catalog_index )
+   {
+      auto& catalogs = *database().add_secondary_index< primary_index<account_storage_index>,
+                                                        account_storage_catalog_index >();
+      for( const auto& aso : database().get_index_type<account_storage_index>().indices() )
+         catalogs.object_inserted( aso );
+   }
 }
 
 } }
@@ -25,16 +25,37 @@
 #include <graphene/custom_operations/custom_objects.hpp>
 #include <graphene/custom_operations/custom_operations.hpp>
 
+#include <map>
+#include <tuple>
+
 namespace graphene { namespace custom_operations {
 
+/**
+ *  @brief Evaluates the custom operations of a block and applies their changes at once
+ *
+ *  The changes of all operations are collected by key first, so that a key that is changed several times in a
+ *  block is written to the database only once, and the objects are then visited in the order of the index.
+ */
 class custom_generic_evaluator
 {
    public:
-      database* _db;
-      account_id_type _account;
-      custom_generic_evaluator(database& db, const account_id_type account);
+      explicit custom_generic_evaluator(database& db);
 
-      vector<object_id_type> do_apply(const account_storage_map& o);
+      /// Checks an operation of an account and adds its changes, which replace earlier changes of the same keys
+      void do_evaluate(account_id_type account, const account_storage_map& o);
+      /// Applies all changes that have been added to the database
+      void do_apply();
+
+   private:
+      /// A change of a key, which either removes it or sets its value
+      struct pending_change
+      {
+         bool remove = false;
+         optional<variant> value;
+      };
+
+      database* _db;
+      std::map< std::tuple<account_id_type, string, string>, pending_change > _changes;
 };
 
 } }
@@ -26,6 +26,10 @@
 #include <boost/multi_index/composite_key.hpp>
 #include <graphene/chain/database.hpp>
 
+#include <map>
+#include <set>
+#include <tuple>
+
 namespace graphene { namespace custom_operations {
 
 using namespace chain;
@@ -69,6 +73,29 @@ typedef multi_index_container<
 
 typedef generic_index<account_storage_object, account_storage_multi_index_type> account_storage_index;
 
+/**
+ *  @brief This secondary index maps catalogs and keys to the accounts that store them.
+ *  @note The catalog and the key of a storage object never change, so modifications are not tracked.
+ */
+class account_storage_catalog_index : public secondary_index
+{
+   public:
+      /// The catalog, key and account of every storage object
+      typedef std::set< std::tuple<string, string, account_id_type> > catalog_key_set;
+      /// The number of keys of every account in every catalog, by catalog and account
+      typedef std::map< std::pair<string, account_id_type>, uint32_t > catalog_map;
+
+      void object_inserted( const object& obj ) override;
+      void object_removed( const object& obj ) override;
+
+      const catalog_key_set& get_catalog_keys()const { return catalog_keys; }
+      const catalog_map& get_catalogs()const { return catalogs; }
+
+   private:
+      catalog_key_set catalog_keys;
+      catalog_map     catalogs;
+};
+
 using account_storage_id_type = object_id<CUSTOM_OPERATIONS_SPACE_ID, account_map>;
 
 } } //graphene::custom_operations
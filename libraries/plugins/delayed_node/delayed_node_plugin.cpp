@@ -31,6 +31,8 @@
 #include <fc/rpc/websocket_api.hpp>
 #include <fc/api.hpp>
 
+#include <deque>
+
 namespace graphene { namespace delayed_node {
 namespace bpo = boost::program_options;
 
@@ -43,7 +45,35 @@ struct delayed_node_plugin_impl {
    boost::signals2::scoped_connection client_connection_closed;
    graphene::chain::block_id_type last_received_remote_head;
    graphene::chain::block_id_type last_processed_remote_head;
+   uint32_t fetch_batch_size = 100;
+   bool remote_has_get_blocks = true;
+   /// Blocks that have been fetched from the trusted node but not applied yet, they are kept across reconnections
+   std::deque<graphene::chain::signed_block> fetched_blocks;
 };
+
+/// Whether a call to the trusted node failed because the node does not have the method, i.e. it is too old
+static bool is_unknown_method_error( const fc::exception& e )
+{
+   // the error reply of the trusted node is kept in the log of the exception
+   for( const fc::log_message& msg : e.get_log() )
+   {
+      const fc::variant_object& data = msg.get_data();
+      auto reply = data.find( "data" );
+      if( reply == data.end() || !reply->value().is_object() )
+         continue;
+      auto error = reply->value().get_object().find( "error" );
+      if( error == reply->value().get_object().end() || !error->value().is_object() )
+         continue;
+      auto code = error->value().get_object().find( "code" );
+      if( code == error->value().get_object().end() || !code->value().is_numeric() )
+         continue;
+      const int64_t error_code = code->value().as_int64();
+      return error_code == -32601 // JSON-RPC "Method not found"
+             || error_code == fc::method_not_found_exception_code
+             || error_code == fc::assert_exception_code;
+   }
+   return false;
+}
 }
 
 delayed_node_plugin::delayed_node_plugin(graphene::app::application& app) :
@@ -59,6 +89,9 @@ void delayed_node_plugin::plugin_set_program_options(bpo::options_description& c
    cli.add_options()
          ("trusted-node", boost::program_options::value<std::string>(),
           "RPC endpoint of a trusted validating node (required for delayed_node)")
+         ("trusted-node-batch-size", boost::program_options::value<uint32_t>()->default_value(100),
+          "Number of blocks to request from the trusted node at once while syncing, "
+          "no more than its api-limit-get-blocks (default: 100)")
          ;
    cfg.add(cli);
 }
@@ -79,6 +112,7 @@ void delayed_node_plugin::connect()
    my->client_connection = std::make_shared<fc::rpc::websocket_api_connection>(
            con, GRAPHENE_NET_MAX_NESTED_OBJECTS );
    my->database_api = my->client_connection->get_remote_api<graphene::app::database_api>(0);
+   my->remote_has_get_blocks = true;
    my->database_api->set_block_applied_callback([this]( const fc::variant& block_id )
    {
       fc::from_variant( block_id, my->last_received_remote_head, GRAPHENE_MAX_NESTED_OBJECTS );
@@ -93,6 +127,87 @@ void delayed_node_plugin::plugin_initialize(const boost::program_options::variab
    FC_ASSERT(options.count("trusted-node") > 0);
    my = std::make_unique<detail::delayed_node_plugin_impl>();
    my->remote_endpoint = "ws://" + options.at("trusted-node").as<std::string>();
+   if( options.count("trusted-node-batch-size") > 0 )
+      my->fetch_batch_size = std::max<uint32_t>( options.at("trusted-node-batch-size").as<uint32_t>(), 1 );
+}
+
+std::vector<graphene::chain::signed_block> delayed_node_plugin::fetch_blocks( uint32_t first_block_num, uint32_t count )
+{
+   auto database_api = my->database_api;
+   if( my->remote_has_get_blocks )
+   {
+      try
+      {
+         return database_api->get_blocks( first_block_num, count );
+      }
+      catch( const fc::exception& e )
+      {
+         // other errors, e.g. of the connection, are left to the main loop which tries again
+         if( !detail::is_unknown_method_error( e ) )
+            throw;
+         wlog( "Unable to fetch blocks in batches from the trusted node, fetching them one by one: ${e}",
+               ("e", e.to_detail_string()) );
+         my->remote_has_get_blocks = false;
+      }
+   }
+   std::vector<graphene::chain::signed_block> blocks;
+   for( uint32_t i = 0; i < count; ++i )
+   {
+      fc::optional<graphene::chain::signed_block> block = database_api->get_block( first_block_num + i );
+      if( !block.valid() )
+         break;
+      blocks.push_back( std::move( *block ) );
+   }
+   return blocks;
+}
+
+void delayed_node_plugin::apply_fetched_blocks( uint32_t& synced_blocks )
+{
+   auto& db = database();
+   auto& fetched = my->fetched_blocks;
+
+   // drop blocks that have been applied already or that do not fit on the head block
+   while( !fetched.empty() && fetched.front().block_num() <= db.head_block_num() )
+      fetched.pop_front();
+   if( !fetched.empty() && fetched.front().previous != db.head_block_id() )
+   {
+      wlog( "Fetched blocks do not link to the head block, discarding them" );
+      fetched.clear();
+      return;
+   }
+
+   // check the signatures of all blocks in parallel while they are applied one by one
+   std::deque< fc::future<void> > precomputed;
+   for( const auto& block : fetched )
+      precomputed.push_back( db.precompute_parallel( block, graphene::chain::database::skip_nothing ) );
+
+   try
+   {
+      while( !fetched.empty() )
+      {
+         precomputed.front().wait();
+         precomputed.pop_front();
+         const graphene::chain::signed_block& block = fetched.front();
+         ilog("Pushing block #${n}", ("n", block.block_num()));
+         db.push_block( block );
+         fetched.pop_front();
+         synced_blocks++;
+      }
+   }
+   catch( const fc::exception& )
+   {
+      // the blocks are still being checked, they can only be discarded afterwards
+      for( auto& f : precomputed )
+      {
+         try
+         {
+            f.wait();
+         }
+         catch( const fc::exception& ) {} // already failing
+      }
+      fetched.clear();
+      throw;
+   }
 }
 
 void delayed_node_plugin::sync_with_trusted_node()
@@ -116,15 +231,30 @@ void delayed_node_plugin::sync_with_trusted_node()
          break;
       }
       pass_count++;
-      while( remote_dpo.last_irreversible_block_num > db.head_block_num() )
+      const uint32_t last_block_num = remote_dpo.last_irreversible_block_num;
+      // the next batch is requested while the fetched blocks are being applied
+      fc::future< std::vector<graphene::chain::signed_block> > next_batch;
+      while( last_block_num > db.head_block_num() )
       {
-         fc::optional<graphene::chain::signed_block> block = my->database_api->get_block( db.head_block_num()+1 );
-         // TODO: during sync, decouple requesting blocks from preprocessing + applying them
-         FC_ASSERT(block, "Trusted node claims it has blocks it doesn't actually have.");
-         ilog("Pushing block #${n}", ("n", block->block_num()));
-         db.precompute_parallel( *block, graphene::chain::database::skip_nothing ).wait();
-         db.push_block(*block);
-         synced_blocks++;
+         const uint32_t next_block_num = db.head_block_num() + 1 + my->fetched_blocks.size();
+         if( !next_batch.valid() && next_block_num <= last_block_num )
+         {
+            const uint32_t count = std::min( my->fetch_batch_size, last_block_num - next_block_num + 1 );
+            next_batch = fc::async( [this,next_block_num,count]() {
+               return fetch_blocks( next_block_num, count );
+            }, "delayed_node fetch blocks" );
+         }
+         if( my->fetched_blocks.empty() )
+         {
+            FC_ASSERT( next_batch.valid() );
+            std::vector<graphene::chain::signed_block> blocks = next_batch.wait();
+            next_batch = fc::future< std::vector<graphene::chain::signed_block> >();
+            FC_ASSERT( !blocks.empty(), "Trusted node claims it has blocks it doesn't actually have." );
+            for( auto& block : blocks )
+               my->fetched_blocks.push_back( std::move( block ) );
+            continue;
+         }
+         apply_fetched_blocks( synced_blocks );
       }
    }
 }
@@ -24,6 +24,7 @@
 #pragma once
 
 #include <graphene/app/plugin.hpp>
+#include <graphene/protocol/block.hpp>
 
 namespace graphene { namespace delayed_node {
 namespace detail { struct delayed_node_plugin_impl; }
@@ -46,6 +47,10 @@ protected:
    void connection_failed();
    void connect();
    void sync_with_trusted_node();
+   /// Fetch up to @p count consecutive blocks from the trusted node
+   std::vector<graphene::protocol::signed_block> fetch_blocks( uint32_t first_block_num, uint32_t count );
+   /// Apply the blocks that have been fetched, checking their signatures in parallel
+   void apply_fetched_blocks( uint32_t& synced_blocks );
 };
 
 } } //graphene::account_history
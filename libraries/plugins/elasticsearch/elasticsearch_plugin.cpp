@@ -26,13 +26,43 @@
 #include <graphene/chain/impacted.hpp>
 #include <graphene/chain/account_evaluator.hpp>
 #include <graphene/chain/hardfork.hpp>
+#include <fc/thread/parallel.hpp>
 #include <curl/curl.h>
 
+#include <deque>
+
 namespace graphene { namespace elasticsearch {
 
 namespace detail
 {
 
+/// The data of an operation that its documents are rendered from, copied from the database
+struct operation_snapshot
+{
+   operation_history_object                   oho;
+   int16_t                                    op_type = 0;
+   block_struct                               block_data;
+   optional<visitor_struct>                   visitor_data;
+   /// the account history entries of the impacted accounts, one document is rendered for each of them
+   vector<account_transaction_history_object> entries;
+};
+
+/// The operations of a block that documents need to be rendered for
+struct block_snapshot
+{
+   std::string                index_name;
+   vector<operation_snapshot> operations;
+};
+
+/// The rendering of the bulk lines of a range of operations of a block
+struct render_task
+{
+   std::shared_ptr<const block_snapshot> snapshot;
+   size_t                                first = 0;
+   size_t                                last = 0;
+   fc::future< vector<std::string> >     lines;
+};
+
 class elasticsearch_plugin_impl
 {
    public:
@@ -66,36 +96,84 @@ class elasticsearch_plugin_impl
       mode _elasticsearch_mode = mode::only_save;
       CURL *curl; // curl handler
       vector <string> bulk_lines; //  vector of op lines
-      vector<std::string> prepare;
+
+      /// Bulk lines being rendered in parallel, in the order they need to be sent. The rendering tasks only use
+      /// their own copies of the data, so they do not need to be waited for when the plugin is destroyed.
+      std::deque<render_task> rendered_lines;
+      /// The number of bulk lines in rendered_lines, two for every document
+      uint32_t rendered_line_count = 0;
 
       graphene::utilities::ES es;
       uint32_t limit_documents;
-      int16_t op_type;
-      operation_history_struct os;
-      block_struct bs;
-      visitor_struct vs;
-      bulk_struct bulk_line_struct;
-      std::string bulk_line;
       std::string index_name;
       bool is_sync = false;
    private:
-      bool add_elasticsearch( const account_id_type account_id, const optional<operation_history_object>& oho, const uint32_t block_number );
+      void add_elasticsearch( const account_id_type account_id, const optional<operation_history_object>& oho,
+                              operation_snapshot* snapshot );
       const account_transaction_history_object& addNewEntry(const account_statistics_object& stats_obj,
                                                             const account_id_type& account_id,
                                                             const optional <operation_history_object>& oho);
       const account_statistics_object& getStatsObject(const account_id_type& account_id);
       void growStats(const account_statistics_object& stats_obj, const account_transaction_history_object& ath);
-      void getOperationType(const optional <operation_history_object>& oho);
-      void doOperationHistory(const optional <operation_history_object>& oho);
-      void doBlock(uint32_t trx_in_block, const signed_block& b);
-      void doVisitor(const optional <operation_history_object>& oho);
+      block_struct doBlock(uint32_t trx_in_block, const signed_block& b);
+      visitor_struct doVisitor(const optional <operation_history_object>& oho);
       void checkState(const fc::time_point_sec& block_time);
       void cleanObjects(const account_transaction_history_id_type& ath, const account_id_type& account_id);
-      void createBulkLine(const account_transaction_history_object& ath);
-      void prepareBulk(const account_transaction_history_id_type& ath_id);
+      void renderDocuments(std::shared_ptr<const block_snapshot> snapshot);
+      void startRendering(render_task& task);
+      bool sendBulk();
       void populateESstruct();
 };
 
+/// Renders the history of an operation, the part of a document that all impacted accounts share
+static operation_history_struct renderOperationHistory( const operation_history_object& oho,
+                                                        bool operation_object, bool operation_string )
+{
+   operation_history_struct os;
+   os.trx_in_block = oho.trx_in_block;
+   os.op_in_trx = oho.op_in_trx;
+   os.operation_result = fc::json::to_string(oho.result);
+   os.virtual_op = oho.virtual_op;
+
+   if(operation_object) {
+      oho.op.visit(fc::from_static_variant(os.op_object, FC_PACK_MAX_DEPTH));
+      adaptor_struct adaptor;
+      os.op_object = adaptor.adapt(os.op_object.get_object());
+   }
+   if(operation_string)
+      os.op = fc::json::to_string(oho.op);
+   return os;
+}
+
+/// Renders the bulk lines of the documents of a range of operations
+static vector<std::string> renderBulkLines( const block_snapshot& snapshot, size_t first, size_t last,
+                                            bool operation_object, bool operation_string )
+{
+   vector<std::string> lines;
+   bulk_struct bulk_line_struct;
+   for( size_t i = first; i < last; ++i )
+   {
+      const operation_snapshot& op = snapshot.operations[i];
+      bulk_line_struct.operation_history = renderOperationHistory( op.oho, operation_object, operation_string );
+      bulk_line_struct.operation_type = op.op_type;
+      bulk_line_struct.operation_id_num = op.oho.id.instance();
+      bulk_line_struct.block_data = op.block_data;
+      bulk_line_struct.additional_data = op.visitor_data;
+      for( const auto& ath : op.entries )
+      {
+         bulk_line_struct.account_history = ath;
+         fc::mutable_variant_object bulk_header;
+         bulk_header["_index"] = snapshot.index_name;
+         bulk_header["_type"] = "data";
+         bulk_header["_id"] = std::string(ath.id);
+         auto prepare = graphene::utilities::createBulk( bulk_header,
+                                                         fc::json::to_string(bulk_line_struct, fc::json::legacy_generator) );
+         std::move(prepare.begin(), prepare.end(), std::back_inserter(lines));
+      }
+   }
+   return lines;
+}
+
 elasticsearch_plugin_impl::~elasticsearch_plugin_impl()
 {
    if (curl) {
@@ -121,6 +199,11 @@ bool elasticsearch_plugin_impl::update_account_histories( const signed_block& b
       else
          _oho_index->use_next_id();
    };
+
+   const bool add_documents = b.block_num() > _elasticsearch_start_es_after_block;
+   auto snapshot = std::make_shared<block_snapshot>();
+   snapshot->index_name = index_name;
+
    for( const optional< operation_history_object >& o_op : hist ) {
       optional <operation_history_object> oho;
 
@@ -146,12 +229,18 @@ bool elasticsearch_plugin_impl::update_account_histories( const signed_block& b
       }
       oho = create_oho();
 
-      // populate what we can before impacted loop
-      getOperationType(oho);
-      doOperationHistory(oho);
-      doBlock(oho->trx_in_block, b);
-      if(_elasticsearch_visitor)
-         doVisitor(oho);
+      // copy what the documents are rendered from, the rendering itself is done in parallel later
+      operation_snapshot* op_snapshot = nullptr;
+      if( add_documents )
+      {
+         snapshot->operations.emplace_back();
+         op_snapshot = &snapshot->operations.back();
+         op_snapshot->oho = *oho;
+         op_snapshot->op_type = oho->op.which();
+         op_snapshot->block_data = doBlock(oho->trx_in_block, b);
+         if(_elasticsearch_visitor)
+            op_snapshot->visitor_data = doVisitor(oho);
+      }
 
       const operation_history_object& op = *o_op;
 
@@ -173,35 +262,20 @@ bool elasticsearch_plugin_impl::update_account_histories( const signed_block& b
             impacted.insert( item.first );
 
       for( auto& account_id : impacted )
-      {
-         if(!add_elasticsearch( account_id, oho, b.block_num() ))
-         {
-            elog( "Error adding data to Elastic Search: block num ${b}, account ${a}, data ${d}",
-                  ("b",b.block_num()) ("a",account_id) ("d", oho) );
-            return false;
-         }
-      }
+         add_elasticsearch( account_id, oho, op_snapshot );
    }
+
+   if( !snapshot->operations.empty() )
+      renderDocuments( std::move(snapshot) );
+
    // we send bulk at end of block when we are in sync for better real time client experience
-   if(is_sync)
+   // limit_documents is compared with the number of bulk lines, as it has always been
+   if( is_sync || ( curl && bulk_lines.size() + rendered_line_count >= limit_documents ) )
    {
-      populateESstruct();
-      if(es.bulk_lines.size() > 0)
+      if( !sendBulk() )
       {
-         prepare.clear();
-         if(!graphene::utilities::SendBulk(std::move(es)))
-         {
-            // Note: although called with `std::move()`, `es` is not updated in `SendBulk()`
-            elog( "Error sending ${n} lines of bulk data to Elastic Search, the first lines are:",
-                  ("n",es.bulk_lines.size()) );
-            for( size_t i = 0; i < es.bulk_lines.size() && i < 10; ++i )
-            {
-               edump( (es.bulk_lines[i]) );
-            }
-            return false;
-         }
-         else
-            bulk_lines.clear();
+         elog( "Error adding data to Elastic Search: block num ${b}", ("b",b.block_num()) );
+         return false;
       }
    }
 
@@ -225,45 +299,26 @@ void elasticsearch_plugin_impl::checkState(const fc::time_point_sec& block_time)
    }
 }
 
-void elasticsearch_plugin_impl::getOperationType(const optional <operation_history_object>& oho)
-{
-   if (!oho->id.is_null())
-      op_type = oho->op.which();
-}
-
-void elasticsearch_plugin_impl::doOperationHistory(const optional <operation_history_object>& oho)
-{
-   os.trx_in_block = oho->trx_in_block;
-   os.op_in_trx = oho->op_in_trx;
-   os.operation_result = fc::json::to_string(oho->result);
-   os.virtual_op = oho->virtual_op;
-
-   if(_elasticsearch_operation_object) {
-      oho->op.visit(fc::from_static_variant(os.op_object, FC_PACK_MAX_DEPTH));
-      adaptor_struct adaptor;
-      os.op_object = adaptor.adapt(os.op_object.get_object());
-   }
-   if(_elasticsearch_operation_string)
-      os.op = fc::json::to_string(oho->op);
-}
-
-void elasticsearch_plugin_impl::doBlock(uint32_t trx_in_block, const signed_block& b)
+block_struct elasticsearch_plugin_impl::doBlock(uint32_t trx_in_block, const signed_block& b)
 {
    std::string trx_id = "";
    if(trx_in_block < b.transactions.size())
       trx_id = b.transactions[trx_in_block].id().str();
+   block_struct bs;
    bs.block_num = b.block_num();
    bs.block_time = b.timestamp;
    bs.trx_id = trx_id;
+   return bs;
 }
 
-void elasticsearch_plugin_impl::doVisitor(const optional <operation_history_object>& oho)
+visitor_struct elasticsearch_plugin_impl::doVisitor(const optional <operation_history_object>& oho)
 {
    graphene::chain::database& db = database();
 
    operation_visitor o_v;
    oho->op.visit(o_v);
 
+   visitor_struct vs;
    auto fee_asset = o_v.fee_asset(db);
    vs.fee_data.asset = o_v.fee_asset;
    vs.fee_data.asset_name = fee_asset.symbol;
@@ -296,40 +351,19 @@ void elasticsearch_plugin_impl::doVisitor(const optional <operation_history_obje
    vs.fill_data.fill_price_units = fill_price;
    vs.fill_data.fill_price = o_v.fill_fill_price;
    vs.fill_data.is_maker = o_v.fill_is_maker;
+   return vs;
 }
 
-bool elasticsearch_plugin_impl::add_elasticsearch( const account_id_type account_id,
+void elasticsearch_plugin_impl::add_elasticsearch( const account_id_type account_id,
                                                    const optional <operation_history_object>& oho,
-                                                   const uint32_t block_number)
+                                                   operation_snapshot* snapshot )
 {
    const auto &stats_obj = getStatsObject(account_id);
    const auto &ath = addNewEntry(stats_obj, account_id, oho);
    growStats(stats_obj, ath);
-   if(block_number > _elasticsearch_start_es_after_block)  {
-      createBulkLine(ath);
-      prepareBulk(ath.id);
-   }
+   if( snapshot != nullptr )
+      snapshot->entries.push_back( ath );
    cleanObjects(ath.id, account_id);
-
-   if (curl && bulk_lines.size() >= limit_documents) { // we are in bulk time, ready to add data to elasticsearech
-      prepare.clear();
-      populateESstruct();
-      if(!graphene::utilities::SendBulk(std::move(es)))
-      {
-         // Note: although called with `std::move()`, `es` is not updated in `SendBulk()`
-         elog( "Error sending ${n} lines of bulk data to Elastic Search, the first lines are:",
-               ("n",es.bulk_lines.size()) );
-         for( size_t i = 0; i < es.bulk_lines.size() && i < 10; ++i )
-         {
-            edump( (es.bulk_lines[i]) );
-         }
-         return false;
-      }
-      else
-         bulk_lines.clear();
-   }
-
-   return true;
 }
 
 const account_statistics_object& elasticsearch_plugin_impl::getStatsObject(const account_id_type& account_id)
@@ -365,29 +399,73 @@ void elasticsearch_plugin_impl::growStats(const account_statistics_object& stats
    });
 }
 
-void elasticsearch_plugin_impl::createBulkLine(const account_transaction_history_object& ath)
+void elasticsearch_plugin_impl::renderDocuments(std::shared_ptr<const block_snapshot> snapshot)
 {
-   bulk_line_struct.account_history = ath;
-   bulk_line_struct.operation_history = os;
-   bulk_line_struct.operation_type = op_type;
-   bulk_line_struct.operation_id_num = ath.operation_id.instance.value;
-   bulk_line_struct.block_data = bs;
-   if(_elasticsearch_visitor)
-      bulk_line_struct.additional_data = vs;
-   bulk_line = fc::json::to_string(bulk_line_struct, fc::json::legacy_generator);
+   // large blocks are split, so that their documents are rendered by several threads as well
+   const size_t chunk_size = 100;
+   for( const auto& op : snapshot->operations )
+      rendered_line_count += 2 * op.entries.size(); // the header and the document, see createBulk()
+   for( size_t first = 0; first < snapshot->operations.size(); first += chunk_size )
+   {
+      rendered_lines.emplace_back();
+      render_task& task = rendered_lines.back();
+      task.snapshot = snapshot;
+      task.first = first;
+      task.last = std::min( first + chunk_size, snapshot->operations.size() );
+      startRendering( task );
+   }
+}
+
+void elasticsearch_plugin_impl::startRendering(render_task& task)
+{
+   const bool operation_object = _elasticsearch_operation_object;
+   const bool operation_string = _elasticsearch_operation_string;
+   auto snapshot = task.snapshot;
+   const size_t first = task.first;
+   const size_t last = task.last;
+   task.lines = fc::do_parallel( [snapshot,first,last,operation_object,operation_string]() {
+      return renderBulkLines( *snapshot, first, last, operation_object, operation_string );
+   });
 }
 
-void elasticsearch_plugin_impl::prepareBulk(const account_transaction_history_id_type& ath_id)
-{
-   const std::string _id = fc::json::to_string(ath_id);
-   fc::mutable_variant_object bulk_header;
-   bulk_header["_index"] = index_name;
-   bulk_header["_type"] = "data";
-   bulk_header["_id"] = fc::to_string(ath_id.space_id) + "." + fc::to_string(ath_id.type_id) + "."
-                      + fc::to_string(ath_id.instance.value);
-   prepare = graphene::utilities::createBulk(bulk_header, std::move(bulk_line));
-   std::move(prepare.begin(), prepare.end(), std::back_inserter(bulk_lines));
-   prepare.clear();
+bool elasticsearch_plugin_impl::sendBulk()
+{
+   try
+   {
+      while( !rendered_lines.empty() )
+      {
+         vector<std::string> lines = rendered_lines.front().lines.wait();
+         rendered_lines.pop_front();
+         rendered_line_count -= lines.size();
+         std::move(lines.begin(), lines.end(), std::back_inserter(bulk_lines));
+      }
+   }
+   catch( const fc::exception& e )
+   {
+      // the documents of earlier blocks are only here, so they are rendered again and the block fails, to be
+      // tried again like when sending fails
+      elog( "Error rendering documents for Elastic Search: ${e}", ("e",e.to_detail_string()) );
+      startRendering( rendered_lines.front() );
+      return false;
+   }
+
+   if(bulk_lines.empty())
+      return true;
+
+   populateESstruct();
+   if(!graphene::utilities::SendBulk(std::move(es)))
+   {
+      // Note: although called with `std::move()`, `es` is not updated in `SendBulk()`
+      elog( "Error sending ${n} lines of bulk data to Elastic Search, the first lines are:",
+            ("n",es.bulk_lines.size()) );
+      for( size_t i = 0; i < es.bulk_lines.size() && i < 10; ++i )
+      {
+         edump( (es.bulk_lines[i]) );
+      }
+      return false;
+   }
+   bulk_lines.clear();
+   return true;
 }
 
 void elasticsearch_plugin_impl::cleanObjects(const account_transaction_history_id_type& ath_id, const account_id_type& account_id)
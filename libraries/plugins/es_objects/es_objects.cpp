@@ -33,6 +33,11 @@
 
 #include <graphene/utilities/elasticsearch.hpp>
 
+#include <fc/crypto/city.hpp>
+
+#include <map>
+#include <unordered_map>
+
 namespace graphene { namespace es_objects {
 
 namespace detail
@@ -49,9 +54,13 @@ class es_objects_plugin_impl
       }
       virtual ~es_objects_plugin_impl();
 
-      bool index_database(const vector<object_id_type>& ids, std::string action);
+      /// Remembers objects that have been created, changed or removed, to be exported by the next flush
+      void mark_dirty(const vector<object_id_type>& ids, bool created);
+      /// Exports the objects that are dirty if the flush interval has passed
+      bool index_database();
+      /// Exports the objects that are dirty and sends all pending documents, regardless of the flush interval
+      bool flush();
       bool genesis();
-      void remove_from_database(object_id_type id, std::string index);
 
       es_objects_plugin& _self;
       std::string _es_objects_elasticsearch_url = "http://localhost:9200/";
@@ -66,6 +75,7 @@ class es_objects_plugin_impl
       bool _es_objects_asset_smarttoken = true;
       std::string _es_objects_index_prefix = "objects-";
       uint32_t _es_objects_start_es_after_block = 0;
+      uint32_t _es_objects_flush_interval = 0;
       CURL *curl; // curl handler
       vector <std::string> bulk;
       vector<std::string> prepare;
@@ -76,8 +86,22 @@ class es_objects_plugin_impl
       fc::time_point_sec block_time;
 
    private:
+      /// @return the name of the index of an object, or nullptr if objects of its type are not exported
+      const char* index_name(object_id_type id)const;
+      void prepare_object(const object& obj, const string& index_name);
+      void remove_from_database(object_id_type id, const string& index_name);
+      /// Adds the current state of the dirty objects to the pending documents
+      void prepare_dirty_objects();
+      bool send_bulk();
+
       template<typename T>
-      void prepareTemplate(T blockchain_object, string index_name);
+      void prepareTemplate(const T& blockchain_object, const string& index_name);
+
+      /// Dirty objects, and whether they have been created since the last flush
+      std::map<object_id_type, bool> _dirty;
+      /// Hashes of the packed objects as they have been exported last, by object ID
+      std::unordered_map<object_id_type, uint64_t> _exported;
+      fc::time_point_sec _last_flush;
 };
 
 bool es_objects_plugin_impl::genesis()
@@ -91,154 +115,191 @@ bool es_objects_plugin_impl::genesis()
 
    if (_es_objects_accounts) {
       auto &index_accounts = db.get_index(1, 2);
-      index_accounts.inspect_all_objects([this, &db](const graphene::db::object &o) {
-         auto obj = db.find_object(o.id);
-         auto a = static_cast<const account_object *>(obj);
-         prepareTemplate<account_object>(*a, "account");
+      index_accounts.inspect_all_objects([this](const graphene::db::object &o) {
+         prepareTemplate<account_object>(static_cast<const account_object &>(o), "account");
       });
    }
    if (_es_objects_assets) {
       auto &index_assets = db.get_index(1, 3);
-      index_assets.inspect_all_objects([this, &db](const graphene::db::object &o) {
-         auto obj = db.find_object(o.id);
-         auto a = static_cast<const asset_object *>(obj);
-         prepareTemplate<asset_object>(*a, "asset");
+      index_assets.inspect_all_objects([this](const graphene::db::object &o) {
+         prepareTemplate<asset_object>(static_cast<const asset_object &>(o), "asset");
       });
    }
    if (_es_objects_balances) {
       auto &index_balances = db.get_index(2, 5);
-      index_balances.inspect_all_objects([this, &db](const graphene::db::object &o) {
-         auto obj = db.find_object(o.id);
-         auto b = static_cast<const account_balance_object *>(obj);
-         prepareTemplate<account_balance_object>(*b, "balance");
+      index_balances.inspect_all_objects([this](const graphene::db::object &o) {
+         prepareTemplate<account_balance_object>(static_cast<const account_balance_object &>(o), "balance");
       });
    }
 
-   graphene::utilities::ES es;
-   es.curl = curl;
-   es.bulk_lines = bulk;
-   es.elasticsearch_url = _es_objects_elasticsearch_url;
-   es.auth = _es_objects_auth;
-   if (!graphene::utilities::SendBulk(std::move(es)))
+   if (!send_bulk())
       FC_THROW_EXCEPTION(graphene::chain::plugin_exception, "Error inserting genesis data.");
-   else
-      bulk.clear();
 
    return true;
 }
 
-bool es_objects_plugin_impl::index_database(const vector<object_id_type>& ids, std::string action)
+const char* es_objects_plugin_impl::index_name(object_id_type id)const
+{
+   if (id.is<proposal_object>())
+      return _es_objects_proposals ? "proposal" : nullptr;
+   if (id.is<account_object>())
+      return _es_objects_accounts ? "account" : nullptr;
+   if (id.is<asset_object>())
+      return _es_objects_assets ? "asset" : nullptr;
+   if (id.is<account_balance_object>())
+      return _es_objects_balances ? "balance" : nullptr;
+   if (id.is<limit_order_object>())
+      return _es_objects_limit_orders ? "limitorder" : nullptr;
+   if (id.is<asset_smarttoken_data_object>())
+      return _es_objects_asset_smarttoken ? "smarttoken" : nullptr;
+   return nullptr;
+}
+
+void es_objects_plugin_impl::mark_dirty(const vector<object_id_type>& ids, bool created)
+{
+   for (auto const &id: ids) {
+      if (index_name(id) != nullptr)
+         _dirty.emplace(id, created); // an object that is already dirty keeps its flag
+   }
+}
+
+bool es_objects_plugin_impl::index_database()
 {
    graphene::chain::database &db = _self.database();
 
    block_time = db.head_block_time();
    block_number = db.head_block_num();
 
-   if(block_number > _es_objects_start_es_after_block) {
-
-      // check if we are in replay or in sync and change number of bulk documents accordingly
-      uint32_t limit_documents = 0;
-      if ((fc::time_point::now() - block_time) < fc::seconds(30))
-         limit_documents = _es_objects_bulk_sync;
-      else
-         limit_documents = _es_objects_bulk_replay;
-
-
-      for (auto const &value: ids) {
-         if (value.is<proposal_object>() && _es_objects_proposals) {
-            auto obj = db.find_object(value);
-            auto p = static_cast<const proposal_object *>(obj);
-            if (p != nullptr) {
-               if (action == "delete")
-                  remove_from_database(p->id, "proposal");
-               else
-                  prepareTemplate<proposal_object>(*p, "proposal");
-            }
-         } else if (value.is<account_object>() && _es_objects_accounts) {
-            auto obj = db.find_object(value);
-            auto a = static_cast<const account_object *>(obj);
-            if (a != nullptr) {
-               if (action == "delete")
-                  remove_from_database(a->id, "account");
-               else
-                  prepareTemplate<account_object>(*a, "account");
-            }
-         } else if (value.is<asset_object>() && _es_objects_assets) {
-            auto obj = db.find_object(value);
-            auto a = static_cast<const asset_object *>(obj);
-            if (a != nullptr) {
-               if (action == "delete")
-                  remove_from_database(a->id, "asset");
-               else
-                  prepareTemplate<asset_object>(*a, "asset");
-            }
-         } else if (value.is<account_balance_object>() && _es_objects_balances) {
-            auto obj = db.find_object(value);
-            auto b = static_cast<const account_balance_object *>(obj);
-            if (b != nullptr) {
-               if (action == "delete")
-                  remove_from_database(b->id, "balance");
-               else
-                  prepareTemplate<account_balance_object>(*b, "balance");
-            }
-         } else if (value.is<limit_order_object>() && _es_objects_limit_orders) {
-            auto obj = db.find_object(value);
-            auto l = static_cast<const limit_order_object *>(obj);
-            if (l != nullptr) {
-               if (action == "delete")
-                  remove_from_database(l->id, "limitorder");
-               else
-                  prepareTemplate<limit_order_object>(*l, "limitorder");
-            }
-         } else if (value.is<asset_smarttoken_data_object>() && _es_objects_asset_smarttoken) {
-            auto obj = db.find_object(value);
-            auto ba = static_cast<const asset_smarttoken_data_object *>(obj);
-            if (ba != nullptr) {
-               if (action == "delete")
-                  remove_from_database(ba->id, "smarttoken");
-               else
-                  prepareTemplate<asset_smarttoken_data_object>(*ba, "smarttoken");
-            }
-         }
-      }
+   if(block_number <= _es_objects_start_es_after_block) {
+      _dirty.clear();
+      return true;
+   }
+
+   // all changes of the objects since the last flush are exported at once, as the current state of each object
+   if (block_time >= _last_flush + _es_objects_flush_interval) {
+      prepare_dirty_objects();
+      _last_flush = block_time;
+   }
 
-      if (curl && bulk.size() >= limit_documents) { // we are in bulk time, ready to add data to elasticsearech
+   // check if we are in replay or in sync and change number of bulk documents accordingly
+   uint32_t limit_documents = 0;
+   if ((fc::time_point::now() - block_time) < fc::seconds(30))
+      limit_documents = _es_objects_bulk_sync;
+   else
+      limit_documents = _es_objects_bulk_replay;
 
-         graphene::utilities::ES es;
-         es.curl = curl;
-         es.bulk_lines = bulk;
-         es.elasticsearch_url = _es_objects_elasticsearch_url;
-         es.auth = _es_objects_auth;
+   if (curl && bulk.size() >= limit_documents) // we are in bulk time, ready to add data to elasticsearech
+      return send_bulk();
 
-         if (!graphene::utilities::SendBulk(std::move(es)))
-            return false;
-         else
-            bulk.clear();
+   return true;
+}
+
+bool es_objects_plugin_impl::flush()
+{
+   prepare_dirty_objects();
+   if (curl && !bulk.empty())
+      return send_bulk();
+   return true;
+}
+
+void es_objects_plugin_impl::prepare_dirty_objects()
+{
+   graphene::chain::database &db = _self.database();
+
+   for (auto const &dirty: _dirty) {
+      const object_id_type id = dirty.first;
+      const object* obj = db.find_object(id);
+      if (obj != nullptr)
+         prepare_object(*obj, index_name(id));
+      else {
+         // objects that have been created and removed since the last flush have never been exported
+         auto exported = _exported.find(id);
+         if (!dirty.second || exported != _exported.end())
+            remove_from_database(id, index_name(id));
+         if (exported != _exported.end())
+            _exported.erase(exported);
       }
    }
+   _dirty.clear();
+}
+
+void es_objects_plugin_impl::prepare_object(const object& obj, const string& index_name)
+{
+   const object_id_type id = obj.id;
+   if (id.is<proposal_object>())
+      prepareTemplate<proposal_object>(static_cast<const proposal_object &>(obj), index_name);
+   else if (id.is<account_object>())
+      prepareTemplate<account_object>(static_cast<const account_object &>(obj), index_name);
+   else if (id.is<asset_object>())
+      prepareTemplate<asset_object>(static_cast<const asset_object &>(obj), index_name);
+   else if (id.is<account_balance_object>())
+      prepareTemplate<account_balance_object>(static_cast<const account_balance_object &>(obj), index_name);
+   else if (id.is<limit_order_object>())
+      prepareTemplate<limit_order_object>(static_cast<const limit_order_object &>(obj), index_name);
+   else if (id.is<asset_smarttoken_data_object>())
+      prepareTemplate<asset_smarttoken_data_object>(static_cast<const asset_smarttoken_data_object &>(obj),
+                                                    index_name);
+}
 
+bool es_objects_plugin_impl::send_bulk()
+{
+   graphene::utilities::ES es;
+   es.curl = curl;
+   es.bulk_lines = bulk;
+   es.elasticsearch_url = _es_objects_elasticsearch_url;
+   es.auth = _es_objects_auth;
+
+   if (!graphene::utilities::SendBulk(std::move(es)))
+      return false;
+
+   bulk.clear();
    return true;
 }
 
-void es_objects_plugin_impl::remove_from_database( object_id_type id, std::string index)
+void es_objects_plugin_impl::remove_from_database(object_id_type id, const string& index_name)
 {
    if(_es_objects_keep_only_current)
    {
       fc::mutable_variant_object delete_line;
       delete_line["_id"] = string(id);
-      delete_line["_index"] = _es_objects_index_prefix + index;
+      delete_line["_index"] = _es_objects_index_prefix + index_name;
       delete_line["_type"] = "data";
       fc::mutable_variant_object final_delete_line;
       final_delete_line["delete"] = delete_line;
-      prepare.push_back(fc::json::to_string(final_delete_line));
+      bulk.push_back(fc::json::to_string(final_delete_line));
+   }
+   else
+   {
+      // the history of the object is kept, so its removal is recorded as a tombstone document
+      fc::mutable_variant_object bulk_header;
+      bulk_header["_index"] = _es_objects_index_prefix + index_name;
+      bulk_header["_type"] = "data";
+
+      fc::mutable_variant_object o;
+      o["object_id"] = string(id);
+      o["block_time"] = block_time;
+      o["block_number"] = block_number;
+      o["removed"] = true;
+
+      prepare = graphene::utilities::createBulk(bulk_header, fc::json::to_string(o, fc::json::legacy_generator));
       std::move(prepare.begin(), prepare.end(), std::back_inserter(bulk));
       prepare.clear();
    }
 }
 
 template<typename T>
-void es_objects_plugin_impl::prepareTemplate(T blockchain_object, string index_name)
+void es_objects_plugin_impl::prepareTemplate(const T& blockchain_object, const string& index_name)
 {
+   // objects that have been changed back to the state that has been exported last are not exported again
+   const vector<char> packed = fc::raw::pack(blockchain_object);
+   const uint64_t hash = fc::city_hash64(packed.data(), packed.size());
+   auto exported = _exported.emplace(blockchain_object.id, hash);
+   if (!exported.second) {
+      if (exported.first->second == hash)
+         return;
+      exported.first->second = hash;
+   }
+
    fc::mutable_variant_object bulk_header;
    bulk_header["_index"] = _es_objects_index_prefix + index_name;
    bulk_header["_type"] = "data";
@@ -316,6 +377,9 @@ void es_objects_plugin::plugin_set_program_options(
                "Keep only current state of the objects(true)")
          ("es-objects-start-es-after-block", boost::program_options::value<uint32_t>(),
                "Start doing ES job after block(0)")
+         ("es-objects-flush-interval", boost::program_options::value<uint32_t>(),
+               "Seconds of block time to collect changes of objects before exporting their current state, "
+               "0 exports at every block(0)")
          ;
    cfg.add(cli);
 }
@@ -361,6 +425,9 @@ void es_objects_plugin::plugin_initialize(const boost::program_options::variable
    if (options.count("es-objects-start-es-after-block") > 0) {
       my->_es_objects_start_es_after_block = options["es-objects-start-es-after-block"].as<uint32_t>();
    }
+   if (options.count("es-objects-flush-interval") > 0) {
+      my->_es_objects_flush_interval = options["es-objects-flush-interval"].as<uint32_t>();
+   }
 
    database().applied_block.connect([this](const signed_block &b) {
       if(b.block_num() == 1 && my->_es_objects_start_es_after_block == 0) {
@@ -370,7 +437,8 @@ void es_objects_plugin::plugin_initialize(const boost::program_options::variable
    });
    database().new_objects.connect([this]( const vector<object_id_type>& ids,
          const flat_set<account_id_type>& impacted_accounts ) {
-      if(!my->index_database(ids, "create"))
+      my->mark_dirty(ids, true);
+      if(!my->index_database())
       {
          FC_THROW_EXCEPTION(graphene::chain::plugin_exception,
                "Error creating object from ES database, we are going to keep trying.");
@@ -378,7 +446,8 @@ void es_objects_plugin::plugin_initialize(const boost::program_options::variable
    });
    database().changed_objects.connect([this]( const vector<object_id_type>& ids,
          const flat_set<account_id_type>& impacted_accounts ) {
-      if(!my->index_database(ids, "update"))
+      my->mark_dirty(ids, false);
+      if(!my->index_database())
       {
          FC_THROW_EXCEPTION(graphene::chain::plugin_exception,
                "Error updating object from ES database, we are going to keep trying.");
@@ -386,7 +455,8 @@ void es_objects_plugin::plugin_initialize(const boost::program_options::variable
    });
    database().removed_objects.connect([this](const vector<object_id_type>& ids,
          const vector<const object*>& objs, const flat_set<account_id_type>& impacted_accounts) {
-      if(!my->index_database(ids, "delete"))
+      my->mark_dirty(ids, false);
+      if(!my->index_database())
       {
          FC_THROW_EXCEPTION(graphene::chain::plugin_exception,
                "Error deleting object from ES database, we are going to keep trying.");
@@ -407,4 +477,12 @@ void es_objects_plugin::plugin_startup()
    ilog("elasticsearch OBJECTS: plugin_startup() begin");
 }
 
+void es_objects_plugin::plugin_shutdown()
+{
+   // Objects that changed since the last flush, and documents that did not fill a bulk yet, are not sent by
+   // applying blocks anymore.
+   if (!my->flush())
+      elog("elasticsearch OBJECTS: failed to send the objects changed since the last flush");
+}
+
 } }
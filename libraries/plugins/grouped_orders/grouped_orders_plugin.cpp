@@ -26,214 +26,254 @@
 
 #include <graphene/chain/market_object.hpp>
 
+#include <cmath>
+
 namespace graphene { namespace grouped_orders {
 
-namespace detail
+/// @return the natural logarithm of a price
+static double log_price( const price& p )
 {
+   return std::log( static_cast<double>( p.base.amount.value ) )
+        - std::log( static_cast<double>( p.quote.amount.value ) );
+}
 
-class grouped_orders_plugin_impl
+/// @return the number of the bucket that contains a price, given the logarithm of both
+static int64_t bucket_number( double log_price, double bucket_width )
 {
-   public:
-      explicit grouped_orders_plugin_impl(grouped_orders_plugin& _plugin)
-      :_self( _plugin ) {}
-
-      graphene::chain::database& database()
-      {
-         return _self.database();
-      }
-
-      grouped_orders_plugin&     _self;
-      flat_set<uint16_t>         _tracked_groups;
-};
+   return static_cast<int64_t>( std::floor( log_price / bucket_width ) );
+}
 
-/**
- *  @brief This secondary index is used to track changes on limit order objects.
- */
-class limit_order_group_index : public secondary_index
+/// @return a price of @p base in @p quote whose natural logarithm is close to @p lp
+static price price_from_log( double lp, asset_id_type base, asset_id_type quote )
 {
-   public:
-      limit_order_group_index( const flat_set<uint16_t>& groups ) : _tracked_groups( groups ) {};
-
-      virtual void object_inserted( const object& obj ) override;
-      virtual void object_removed( const object& obj ) override;
-      virtual void about_to_modify( const object& before ) override;
-      virtual void object_modified( const object& after  ) override;
-
-      const flat_set<uint16_t>& get_tracked_groups() const
-      { return _tracked_groups; }
+   // use the largest amounts that fit, to lose as little precision as possible
+   const double max_amount = static_cast<double>( GRAPHENE_MAX_SHARE_SUPPLY );
+   double base_amount = max_amount;
+   double quote_amount = max_amount;
+   if( lp >= 0 )
+      quote_amount = std::max( 1.0, std::round( max_amount / std::exp( lp ) ) );
+   else
+      base_amount = std::max( 1.0, std::round( max_amount * std::exp( lp ) ) );
+   return price( asset( static_cast<int64_t>( base_amount ), base ),
+                 asset( static_cast<int64_t>( quote_amount ), quote ) );
+}
 
-      const map< limit_order_group_key, limit_order_group_data >& get_order_groups() const
-      { return _og_data; }
+limit_order_group_index::limit_order_group_index( const flat_set<uint16_t>& groups )
+   : _tracked_groups( groups )
+{
+   _bucket_widths.reserve( _tracked_groups.size() );
+   for( uint16_t group : _tracked_groups )
+      _bucket_widths.push_back( std::log1p( static_cast<double>( group ) / GRAPHENE_100_PERCENT ) );
+}
 
-   private:
-      void remove_order( const limit_order_object& obj, bool remove_empty = true );
+void limit_order_group_index::object_inserted( const object& objct )
+{ try {
+   add_order( static_cast<const limit_order_object&>( objct ) );
+} FC_CAPTURE_AND_RETHROW( (objct) ); }
 
-      /** tracked groups */
-      flat_set<uint16_t> _tracked_groups;
+void limit_order_group_index::object_removed( const object& objct )
+{ try {
+   remove_order( static_cast<const limit_order_object&>( objct ) );
+} FC_CAPTURE_AND_RETHROW( (objct) ); }
 
-      /** maps the group key to group data */
-      map< limit_order_group_key, limit_order_group_data > _og_data;
-};
+void limit_order_group_index::about_to_modify( const object& objct )
+{ try {
+   remove_order( static_cast<const limit_order_object&>( objct ) );
+} FC_CAPTURE_AND_RETHROW( (objct) ); }
 
-void limit_order_group_index::object_inserted( const object& objct )
+void limit_order_group_index::object_modified( const object& objct )
 { try {
-   const limit_order_object& o = static_cast<const limit_order_object&>( objct );
+   add_order( static_cast<const limit_order_object&>( objct ) );
+} FC_CAPTURE_AND_RETHROW( (objct) ); }
 
-   auto& idx = _og_data;
+void limit_order_group_index::add_order( const limit_order_object& o )
+{
+   auto& books = _books[ std::make_pair( o.sell_price.base.asset_id, o.sell_price.quote.asset_id ) ];
+   if( books.empty() )
+      books.resize( _tracked_groups.size() );
 
-   for( uint16_t group : get_tracked_groups() )
+   const double lp = log_price( o.sell_price );
+   for( size_t i = 0; i < books.size(); ++i )
    {
-      auto create_ogo = [&]() {
-         idx[ limit_order_group_key( group, o.sell_price ) ] = limit_order_group_data( o.sell_price, o.for_sale );
-      };
-      // if idx is empty, insert this order
-      // Note: not capped
-      if( idx.empty() )
-      {
-         create_ogo();
-         continue;
-      }
+      limit_order_group_book& book = books[i];
+      const int64_t number = bucket_number( lp, _bucket_widths[i] );
 
-      // cap the price
-      price capped_price = o.sell_price;
-      price max = o.sell_price.max();
-      price min = o.sell_price.min();
-      bool capped_max = false;
-      bool capped_min = false;
-      if( o.sell_price > max )
+      // extend the array to the bucket of the order, as far as possible
+      if( book.buckets.empty() )
       {
-         capped_price = max;
-         capped_max = true;
+         book.first_bucket = number;
+         book.buckets.resize( 1 );
       }
-      else if( o.sell_price < min )
+      else if( number < book.first_bucket )
       {
-         capped_price = min;
-         capped_min = true;
+         const int64_t room = max_buckets - book.buckets.size();
+         const int64_t added = std::min( book.first_bucket - number, room );
+         book.buckets.insert( book.buckets.begin(), added, limit_order_bucket() );
+         book.first_bucket -= added;
       }
-      // if idx is not empty, find the group that is next to this order
-      auto itr = idx.lower_bound( limit_order_group_key( group, capped_price ) );
-      bool check_previous = false;
-      if( itr == idx.end() || itr->first.group != group
-            || itr->first.min_price.base.asset_id != o.sell_price.base.asset_id
-            || itr->first.min_price.quote.asset_id != o.sell_price.quote.asset_id )
-         // not same market or group type
-         check_previous = true;
-      else // same market and group type
+      else if( number >= book.first_bucket + int64_t( book.buckets.size() ) )
       {
-         bool update_max = false;
-         if( capped_price > itr->second.max_price ) // implies itr->min_price <= itr->max_price < max
-         {
-            update_max = true;
-            price max_price = itr->first.min_price * ratio_type( GRAPHENE_100_PERCENT + group, GRAPHENE_100_PERCENT );
-            // max_price should have been capped here
-            if( capped_price > max_price ) // new order is out of range
-               check_previous = true;
-         }
-         if( !check_previous ) // new order is within the range
-         {
-            if( capped_min && o.sell_price < itr->first.min_price )
-            {  // need to update itr->min_price here, if itr is below min, and new order is even lower
-               // TODO improve performance
-               limit_order_group_data data( itr->second.max_price, o.for_sale + itr->second.total_for_sale );
-               idx.erase( itr );
-               idx[ limit_order_group_key( group, o.sell_price ) ] = data;
-            }
-            else
-            {
-               if( update_max || ( capped_max && o.sell_price > itr->second.max_price ) )
-                  itr->second.max_price = o.sell_price; // store real price here, not capped
-               itr->second.total_for_sale += o.for_sale;
-            }
-         }
+         const int64_t room = max_buckets - book.buckets.size();
+         const int64_t added = std::min( number - book.first_bucket - int64_t( book.buckets.size() ) + 1, room );
+         book.buckets.resize( book.buckets.size() + added );
       }
 
-      if( check_previous )
+      int64_t pos = number - book.first_bucket;
+      if( pos < 0 || pos >= int64_t( book.buckets.size() ) )
       {
-         if( itr == idx.begin() ) // no previous
-            create_ogo();
-         else
-         {
-            --itr; // should be valid
-            if( itr->first.group != group || itr->first.min_price.base.asset_id != o.sell_price.base.asset_id
-                                          || itr->first.min_price.quote.asset_id != o.sell_price.quote.asset_id )
-               // not same market or group type
-               create_ogo();
-            else // same market and group type
-            {
-               // due to lower_bound, always true: capped_price < itr->first.min_price, so no need to check again,
-               // if new order is in range of itr group, always need to update itr->first.min_price, unless
-               //   o.sell_price is higher than max
-               price min_price = itr->second.max_price / ratio_type( GRAPHENE_100_PERCENT + group, GRAPHENE_100_PERCENT );
-               // min_price should have been capped here
-               if( capped_price < min_price ) // new order is out of range
-                  create_ogo();
-               else if( capped_max && o.sell_price >= itr->first.min_price )
-               {  // itr is above max, and price of new order is even higher
-                  if( o.sell_price > itr->second.max_price )
-                     itr->second.max_price = o.sell_price;
-                  itr->second.total_for_sale += o.for_sale;
-               }
-               else
-               {  // new order is within the range
-                  // TODO improve performance
-                  limit_order_group_data data( itr->second.max_price, o.for_sale + itr->second.total_for_sale );
-                  idx.erase( itr );
-                  idx[ limit_order_group_key( group, o.sell_price ) ] = data;
-               }
-            }
-         }
+         pos = ( pos < 0 ? 0 : int64_t( book.buckets.size() ) - 1 );
+         ++book.outer_orders;
       }
+
+      limit_order_bucket& bucket = book.buckets[pos];
+      ++bucket.orders;
+      bucket.total_for_sale += o.for_sale;
+      ++book.orders;
    }
-} FC_CAPTURE_AND_RETHROW( (objct) ); }
+}
 
-void limit_order_group_index::object_removed( const object& objct )
-{ try {
-   const limit_order_object& o = static_cast<const limit_order_object&>( objct );
-   remove_order( o );
-} FC_CAPTURE_AND_RETHROW( (objct) ); }
+void limit_order_group_index::remove_order( const limit_order_object& o )
+{
+   auto itr = _books.find( std::make_pair( o.sell_price.base.asset_id, o.sell_price.quote.asset_id ) );
+   if( itr == _books.end() )
+   {
+      // should not happen
+      wlog( "can not find the order group containing order for removing (market dismatch): ${o}", ("o",o) );
+      return;
+   }
 
-void limit_order_group_index::about_to_modify( const object& objct )
-{ try {
-   const limit_order_object& o = static_cast<const limit_order_object&>( objct );
-   remove_order( o, false );
-} FC_CAPTURE_AND_RETHROW( (objct) ); }
+   const double lp = log_price( o.sell_price );
+   for( size_t i = 0; i < itr->second.size(); ++i )
+   {
+      limit_order_group_book& book = itr->second[i];
+      const int64_t number = bucket_number( lp, _bucket_widths[i] );
 
-void limit_order_group_index::object_modified( const object& objct )
-{ try {
-   object_inserted( objct );
-} FC_CAPTURE_AND_RETHROW( (objct) ); }
+      // the array does not move while there are orders beyond its ends, so they are found in the outermost buckets
+      int64_t pos = number - book.first_bucket;
+      const bool outer = ( pos < 0 || pos >= int64_t( book.buckets.size() ) );
+      if( outer )
+         pos = ( pos < 0 ? 0 : int64_t( book.buckets.size() ) - 1 );
 
-void limit_order_group_index::remove_order( const limit_order_object& o, bool remove_empty )
-{
-   auto& idx = _og_data;
+      if( book.buckets.empty() || book.buckets[pos].orders == 0 || book.buckets[pos].total_for_sale < o.for_sale )
+      {
+         // should not happen
+         wlog( "can not find the order group containing order for removing (amount dismatch): ${o}", ("o",o) );
+         continue;
+      }
 
-   for( uint16_t group : get_tracked_groups() )
-   {
-      // find the group that should contain this order
-      auto itr = idx.lower_bound( limit_order_group_key( group, o.sell_price ) );
-      if( itr == idx.end() || itr->first.group != group
-            || itr->first.min_price.base.asset_id != o.sell_price.base.asset_id
-            || itr->first.min_price.quote.asset_id != o.sell_price.quote.asset_id
-            || itr->second.max_price < o.sell_price )
+      limit_order_bucket& bucket = book.buckets[pos];
+      --bucket.orders;
+      bucket.total_for_sale -= o.for_sale;
+      --book.orders;
+      if( outer )
+         --book.outer_orders;
+
+      // shrink the array to the buckets that are not empty
+      if( book.orders == 0 )
+         book.buckets.clear();
+      else if( book.outer_orders == 0 )
       {
-         // can not find corresponding group, should not happen
-         wlog( "can not find the order group containing order for removing (price dismatch): ${o}", ("o",o) );
+         while( book.buckets.front().orders == 0 )
+         {
+            book.buckets.pop_front();
+            ++book.first_bucket;
+         }
+         while( book.buckets.back().orders == 0 )
+            book.buckets.pop_back();
+      }
+   }
+}
+
+vector< std::pair<limit_order_group_key, limit_order_group_data> > limit_order_group_index::get_order_groups(
+      const limit_order_multi_index_type& orders, uint16_t group,
+      asset_id_type base, asset_id_type quote, const price& start, uint32_t limit )const
+{
+   vector< std::pair<limit_order_group_key, limit_order_group_data> > result;
+
+   auto group_itr = _tracked_groups.find( group );
+   auto itr = _books.find( std::make_pair( base, quote ) );
+   if( group_itr == _tracked_groups.end() || itr == _books.end() )
+      return result;
+
+   const size_t i = group_itr - _tracked_groups.begin();
+   const double width = _bucket_widths[i];
+   const limit_order_group_book& book = itr->second[i];
+   if( book.buckets.empty() )
+      return result;
+
+   // the orders of the market, from the highest price to the lowest
+   const auto& price_idx = orders.get<by_price>();
+   const auto market_begin = price_idx.lower_bound( std::make_tuple( price::max( base, quote ) ) );
+   const auto market_end = price_idx.upper_bound( std::make_tuple( price::min( base, quote ) ) );
+
+   const int64_t last = int64_t( book.buckets.size() ) - 1;
+   auto position_of = [&book,width,last]( const limit_order_object& o ) {
+      const int64_t pos = bucket_number( log_price( o.sell_price ), width ) - book.first_bucket;
+      return std::min( std::max( pos, int64_t( 0 ) ), last );
+   };
+
+   int64_t pos = std::min( bucket_number( log_price( start ), width ) - book.first_bucket, last );
+   for( ; pos >= 0 && result.size() < limit; --pos )
+   {
+      const limit_order_bucket& bucket = book.buckets[pos];
+      if( bucket.orders == 0 )
          continue;
+
+      // The orders of the bucket are between the prices of its ends. These prices are rounded, so the orders
+      // next to them are checked until the first and the last order in the bucket are found. The outermost
+      // buckets reach to the ends of the market.
+      auto high = market_begin;
+      if( pos < last )
+      {
+         high = price_idx.lower_bound( std::make_tuple(
+                     price_from_log( double( book.first_bucket + pos + 1 ) * width, base, quote ) ) );
+         while( high != market_begin && position_of( *std::prev( high ) ) <= pos )
+            --high;
+         while( high != market_end && position_of( *high ) > pos )
+            ++high;
       }
-      else // found
+      auto low = market_end;
+      if( pos > 0 )
       {
-         if( itr->second.total_for_sale < o.for_sale )
-            // should not happen
-            wlog( "can not find the order group containing order for removing (amount dismatch): ${o}", ("o",o) );
-         else if( !remove_empty || itr->second.total_for_sale > o.for_sale )
-            itr->second.total_for_sale -= o.for_sale;
-         else
-            // it's the only order in the group and need to be removed
-            idx.erase( itr );
+         low = price_idx.lower_bound( std::make_tuple(
+                     price_from_log( double( book.first_bucket + pos ) * width, base, quote ) ) );
+         while( low != market_end && position_of( *low ) >= pos )
+            ++low;
+         while( low != market_begin && position_of( *std::prev( low ) ) < pos )
+            --low;
       }
+      if( high == market_end || low == market_begin || position_of( *high ) != pos )
+      {
+         // should not happen
+         wlog( "can not find the orders of a non-empty order group: ${g} ${b} ${q} ${n}",
+               ("g",group)("b",base)("q",quote)("n",book.first_bucket + pos) );
+         continue;
+      }
+
+      result.emplace_back( limit_order_group_key( group, std::prev( low )->sell_price ),
+                           limit_order_group_data( high->sell_price, bucket.total_for_sale ) );
    }
+   return result;
 }
 
+namespace detail
+{
+
+class grouped_orders_plugin_impl
+{
+   public:
+      explicit grouped_orders_plugin_impl(grouped_orders_plugin& _plugin)
+      :_self( _plugin ) {}
+
+      graphene::chain::database& database()
+      {
+         return _self.database();
+      }
+
+      grouped_orders_plugin&     _self;
+      flat_set<uint16_t>         _tracked_groups;
+};
+
 } // end namespace detail
 
 
@@ -280,7 +320,7 @@ void grouped_orders_plugin::plugin_initialize(const boost::program_options::vari
 void grouped_orders_plugin::plugin_startup()
 {
    auto& groups = *database().add_secondary_index< primary_index<limit_order_index>,
-                                                   detail::limit_order_group_index >( my->_tracked_groups );
+                                                   limit_order_group_index >( my->_tracked_groups );
    for( const auto& order : database().get_index_type< limit_order_index >().indices() )
       groups.object_inserted( order );
 }
@@ -290,12 +330,13 @@ const flat_set<uint16_t>& grouped_orders_plugin::tracked_groups() const
    return my->_tracked_groups;
 }
 
-const map< limit_order_group_key, limit_order_group_data >& grouped_orders_plugin::limit_order_groups()
+vector< std::pair<limit_order_group_key, limit_order_group_data> > grouped_orders_plugin::limit_order_groups(
+      uint16_t group, asset_id_type base, asset_id_type quote, const price& start, uint32_t limit )
 {
    const auto& idx = database().get_index_type< limit_order_index >();
    const auto& pidx = dynamic_cast<const primary_index< limit_order_index >&>(idx);
-   const auto& logidx = pidx.get_secondary_index< detail::limit_order_group_index >();
-   return logidx.get_order_groups();
+   const auto& logidx = pidx.get_secondary_index< limit_order_group_index >();
+   return logidx.get_order_groups( idx.indices(), group, base, quote, start, limit );
 }
 
 } }
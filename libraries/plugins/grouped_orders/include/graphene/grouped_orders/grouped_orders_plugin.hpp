@@ -25,6 +25,9 @@
 
 #include <graphene/app/plugin.hpp>
 #include <graphene/chain/database.hpp>
+#include <graphene/chain/market_object.hpp>
+
+#include <deque>
 
 namespace graphene { namespace grouped_orders {
 using namespace chain;
@@ -57,6 +60,88 @@ struct limit_order_group_data
    share_type    total_for_sale; ///< asset id is min_price.base.asset_id
 };
 
+/**
+ *  @brief The orders of a market in one price bucket of a tracked group
+ *
+ *  Bucket number @c n of group @c g holds the prices from @c (1+g/10000)^n inclusive to @c (1+g/10000)^(n+1)
+ *  exclusive. The lowest and the highest price of the orders in a bucket are not kept, they are looked up in
+ *  @ref limit_order_index when the bucket is queried.
+ */
+struct limit_order_bucket
+{
+   uint32_t      orders = 0;     ///< the number of orders in the bucket
+   share_type    total_for_sale; ///< asset id is the base asset of the prices
+};
+
+/**
+ *  @brief The buckets of one tracked group in one market
+ *
+ *  The buckets are kept in an array of consecutive bucket numbers, from the lowest bucket that is not empty to
+ *  the highest one, so that adding or removing an order only has to find its bucket by number. The array has at
+ *  most @ref limit_order_group_index::max_buckets buckets. While it is full, orders with prices beyond its ends
+ *  are added to the outermost buckets, and the array is not moved until these orders are gone. The price range
+ *  of an outermost bucket that holds such orders is then wider than the group, so that no order is left out of
+ *  the totals.
+ */
+struct limit_order_group_book
+{
+   int64_t                         first_bucket = 0; ///< the number of the first bucket in the array
+   uint32_t                        orders = 0;       ///< the number of orders in all buckets
+   uint32_t                        outer_orders = 0; ///< the number of orders that are beyond the ends of the array
+   std::deque<limit_order_bucket>  buckets;
+};
+
+/**
+ *  @brief This secondary index sums up the limit orders of every market in buckets of prices, for every tracked
+ *         group.
+ */
+class limit_order_group_index : public secondary_index
+{
+   public:
+      /// The maximum number of buckets of a group in a market
+      static constexpr uint32_t max_buckets = 10000;
+
+      explicit limit_order_group_index( const flat_set<uint16_t>& groups );
+
+      void object_inserted( const object& obj ) override;
+      void object_removed( const object& obj ) override;
+      void about_to_modify( const object& before ) override;
+      void object_modified( const object& after ) override;
+
+      const flat_set<uint16_t>& get_tracked_groups()const
+      { return _tracked_groups; }
+
+      /**
+       * @brief Get the groups of orders that sell an asset for another
+       * @param orders the limit orders of the database, to look up the lowest and the highest price of a group
+       * @param group one of the tracked groups
+       * @param base the asset being sold
+       * @param quote the asset being purchased
+       * @param start the groups are returned starting with the one that contains this price
+       * @param limit the maximum number of groups to return
+       * @return the groups that are not empty, from the highest price to the lowest
+       *
+       * The lowest and the highest group may cover a wider price range than @p group when the market has orders
+       * that are more than @ref max_buckets groups apart, see @ref limit_order_group_book.
+       */
+      vector< std::pair<limit_order_group_key, limit_order_group_data> > get_order_groups(
+            const limit_order_multi_index_type& orders, uint16_t group,
+            asset_id_type base, asset_id_type quote, const price& start, uint32_t limit )const;
+
+   private:
+      void add_order( const limit_order_object& o );
+      void remove_order( const limit_order_object& o );
+
+      /** tracked groups */
+      flat_set<uint16_t> _tracked_groups;
+
+      /** the logarithm of the ratio between the ends of a bucket, for every tracked group in the same order */
+      vector<double> _bucket_widths;
+
+      /** maps a market to its books, one for every tracked group in the same order */
+      map< std::pair<asset_id_type, asset_id_type>, vector<limit_order_group_book> > _books;
+};
+
 namespace detail
 {
     class grouped_orders_plugin_impl;
@@ -65,6 +150,8 @@ namespace detail
 /**
  *  The grouped orders plugin can be configured to track any number of price diff percentages via its configuration.
  *  Every time when there is a change on an order in object database, it will update internal state to reflect the change.
+ *  Orders are grouped in buckets of prices on a logarithmic scale, the highest price of a bucket is the lowest price
+ *  plus the tracked percentage.
  */
 class grouped_orders_plugin : public graphene::app::plugin
 {
@@ -82,7 +169,9 @@ class grouped_orders_plugin : public graphene::app::plugin
 
       const flat_set<uint16_t>&   tracked_groups()const;
 
-      const map< limit_order_group_key, limit_order_group_data >& limit_order_groups();
+      /// @see limit_order_group_index::get_order_groups
+      vector< std::pair<limit_order_group_key, limit_order_group_data> > limit_order_groups( uint16_t group,
+            asset_id_type base, asset_id_type quote, const price& start, uint32_t limit );
 
    private:
       std::unique_ptr<detail::grouped_orders_plugin_impl> my;
@@ -54,10 +54,11 @@ enum market_history_object_type
    order_history_object_type = 0,
    bucket_object_type = 1,
    market_ticker_object_type = 2,
-   market_ticker_meta_object_type = 3,
+   market_ticker_meta_object_type = 3, // no longer used
    liquidity_pool_history_object_type = 4,
    liquidity_pool_ticker_meta_object_type = 5,
-   liquidity_pool_ticker_object_type = 6
+   liquidity_pool_ticker_object_type = 6,
+   market_ticker_slot_object_type = 7
 };
 
 struct bucket_key
@@ -154,13 +155,25 @@ struct market_ticker_object : public abstract_object<market_ticker_object>
    fc::uint128_t       quote_volume;
 };
 
-struct market_ticker_meta_object : public abstract_object<market_ticker_meta_object>
+/**
+ *  The maker fills of a market in a time slot of @ref slot_seconds seconds. The slots of the last 24 hours of each
+ *  market form a ring: fills are added to the newest slot, and the slots that have become older than 24 hours are
+ *  rolled out of the market ticker and removed, which costs the same no matter how many fills they contain.
+ */
+struct market_ticker_slot_object : public abstract_object<market_ticker_slot_object>
 {
    static constexpr uint8_t space_id = MARKET_HISTORY_SPACE_ID;
-   static constexpr uint8_t type_id  = market_ticker_meta_object_type;
+   static constexpr uint8_t type_id  = market_ticker_slot_object_type;
+
+   static constexpr uint32_t slot_seconds = 60;
 
-   object_id_type      rolling_min_order_his_id;
-   bool                skip_min_order_his_id = false;
+   asset_id_type       base;
+   asset_id_type       quote;
+   fc::time_point_sec  open;
+   share_type          close_base;   ///< the price of the latest fill in the slot
+   share_type          close_quote;
+   fc::uint128_t       base_volume;
+   fc::uint128_t       quote_volume;
 };
 
 struct by_key;
@@ -216,9 +229,36 @@ typedef multi_index_container<
    >
 > market_ticker_object_multi_index_type;
 
+struct by_market_open;
+struct by_open;
+typedef multi_index_container<
+   market_ticker_slot_object,
+   indexed_by<
+      ordered_unique< tag<by_id>, member< object, object_id_type, &object::id > >,
+      ordered_unique<
+         tag<by_market_open>,
+         composite_key<
+            market_ticker_slot_object,
+            member<market_ticker_slot_object, asset_id_type, &market_ticker_slot_object::base>,
+            member<market_ticker_slot_object, asset_id_type, &market_ticker_slot_object::quote>,
+            member<market_ticker_slot_object, fc::time_point_sec, &market_ticker_slot_object::open>
+         >
+      >,
+      ordered_unique<
+         tag<by_open>,
+         composite_key<
+            market_ticker_slot_object,
+            member<market_ticker_slot_object, fc::time_point_sec, &market_ticker_slot_object::open>,
+            member<object, object_id_type, &object::id>
+         >
+      >
+   >
+> market_ticker_slot_multi_index_type;
+
 typedef generic_index<bucket_object, bucket_object_multi_index_type> bucket_index;
 typedef generic_index<order_history_object, order_history_multi_index_type> history_index;
 typedef generic_index<market_ticker_object, market_ticker_object_multi_index_type> market_ticker_index;
+typedef generic_index<market_ticker_slot_object, market_ticker_slot_multi_index_type> market_ticker_slot_index;
 
 
 /** Stores operation histories related to liquidity pools */
@@ -372,10 +412,13 @@ namespace detail
     class market_history_plugin_impl;
 }
 
+class market_history_store;
+
 /**
  *  The market history plugin can be configured to track any number of intervals via its configuration.  Once per block it
- *  will scan the virtual operations and look for fill_order_operations and then adjust the appropriate bucket objects for
- *  each fill order.
+ *  will scan the virtual operations and look for fill_order_operations, roll up the fill orders of each market and then
+ *  adjust the appropriate bucket objects once per market.  Buckets of sizes that are multiples of a tracked size are
+ *  rolled up from the tracked buckets when they are queried.
  */
 class market_history_plugin : public graphene::app::plugin
 {
@@ -390,11 +433,29 @@ class market_history_plugin : public graphene::app::plugin
       void plugin_initialize(
          const boost::program_options::variables_map& options) override;
       void plugin_startup() override;
+      void plugin_shutdown() override;
 
       uint32_t                    max_history()const;
       const flat_set<uint32_t>&   tracked_buckets()const;
       uint32_t                    max_order_his_records_per_market()const;
       uint32_t                    max_order_his_seconds_per_market()const;
+      /**
+       * @brief Get buckets of a market, from memory and from the store
+       * @param base the asset with the lower ID
+       * @param quote the asset with the higher ID
+       * @param bucket_seconds the bucket size, which needs to be a tracked size or a multiple of one. Buckets of
+       *        other sizes are rolled up from the buckets of the largest tracked size that divides it, and have no ID.
+       *        If there is no such tracked size, nothing is returned.
+       * @param start only buckets that open at or after this time are returned
+       * @param end only buckets that open at or before this time are returned
+       * @param limit the maximum number of buckets to return
+       * @return the buckets, from the oldest to the newest
+       */
+      vector<bucket_object> get_market_history( asset_id_type base, asset_id_type quote, uint32_t bucket_seconds,
+                                                fc::time_point_sec start, fc::time_point_sec end,
+                                                uint32_t limit )const;
+      /// @return the store of removed history, or nullptr if it is not enabled
+      const market_history_store* history_store()const;
 
    private:
       std::unique_ptr<detail::market_history_plugin_impl> my;
@@ -417,8 +478,10 @@ FC_REFLECT_DERIVED( graphene::market_history::market_ticker_object, (graphene::d
                     (last_day_base)(last_day_quote)
                     (latest_base)(latest_quote)
                     (base_volume)(quote_volume) )
-FC_REFLECT_DERIVED( graphene::market_history::market_ticker_meta_object, (graphene::db::object),
-                    (rolling_min_order_his_id)(skip_min_order_his_id) )
+FC_REFLECT_DERIVED( graphene::market_history::market_ticker_slot_object, (graphene::db::object),
+                    (base)(quote)(open)
+                    (close_base)(close_quote)
+                    (base_volume)(quote_volume) )
 FC_REFLECT_DERIVED( graphene::market_history::liquidity_pool_history_object, (graphene::db::object),
                     (pool)(sequence)(time)(op_type)(op) )
 FC_REFLECT_DERIVED( graphene::market_history::liquidity_pool_ticker_meta_object, (graphene::db::object),
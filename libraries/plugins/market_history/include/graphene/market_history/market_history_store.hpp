@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2021 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <graphene/market_history/market_history_plugin.hpp>
+
+#include <fc/filesystem.hpp>
+
+#include <memory>
+
+namespace graphene { namespace market_history {
+
+   namespace detail
+   {
+      template<typename Codec> class segment_file;
+      struct fill_codec;
+      struct bucket_codec;
+   }
+
+   /**
+    *  @brief An append-only columnar store on disk for market history that has been removed from memory
+    *
+    *  Filled orders are stored per market and buckets per market and bucket size, each in the order of time. The
+    *  records of such a series are collected in memory and written to disk in segments of @ref segment_records
+    *  records. In a segment every field is stored as a column of variable length integers, most of them as
+    *  differences to the previous record, which compresses prices, volumes and times to a few bytes each.
+    *
+    *  Segments are written to the files "fills" and "buckets" and read through a memory mapping of them. The sizes of
+    *  both files are committed to the file "head" after every segment, so that a crash can not leave a partially
+    *  written segment behind. The segments that have not been written yet are lost in a crash, but they are added
+    *  again when the blocks are replayed, because records that are older than the newest record of their series in
+    *  the store are skipped.
+    */
+   class market_history_store
+   {
+      public:
+         static constexpr uint32_t segment_records = 1024;
+
+         market_history_store();
+         ~market_history_store();
+
+         void open( const fc::path& dir );
+         bool is_open()const;
+         /// Writes all records that are still in memory and closes the store
+         void close();
+
+         /// Adds filled orders, which need to be in ascending order of time for each market
+         void append( const vector<order_history_object>& fills );
+         /// Adds buckets, which need to be in ascending order of time for each market and bucket size
+         void append( const vector<bucket_object>& buckets );
+
+         /**
+          * @brief Read filled orders of a market from the newest to the oldest
+          * @param base the asset with the lower ID
+          * @param quote the asset with the higher ID
+          * @param after_sequence only orders older than the order with this sequence number are read
+          * @param limit the maximum number of orders to read
+          */
+         vector<order_history_object> get_fills( asset_id_type base, asset_id_type quote,
+                                                 int64_t after_sequence, uint32_t limit )const;
+
+         /**
+          * @brief Read buckets of a market from the oldest to the newest
+          * @param base the asset with the lower ID
+          * @param quote the asset with the higher ID
+          * @param seconds the bucket size
+          * @param start only buckets that open at or after this time are read
+          * @param end only buckets that open at or before this time are read
+          * @param limit the maximum number of buckets to read
+          */
+         vector<bucket_object> get_buckets( asset_id_type base, asset_id_type quote, uint32_t seconds,
+                                            fc::time_point_sec start, fc::time_point_sec end, uint32_t limit )const;
+
+      private:
+         void commit();
+
+         fc::path                                                 _dir;
+         std::unique_ptr< detail::segment_file<detail::fill_codec> >   _fills;
+         std::unique_ptr< detail::segment_file<detail::bucket_codec> > _buckets;
+   };
+
+} } // graphene::market_history
@@ -23,6 +23,7 @@
  */
 
 #include <graphene/market_history/market_history_plugin.hpp>
+#include <graphene/market_history/market_history_store.hpp>
 
 #include <graphene/chain/account_evaluator.hpp>
 #include <graphene/chain/account_object.hpp>
@@ -34,12 +35,140 @@
 #include <graphene/protocol/fee_schedule.hpp>
 
 #include <fc/thread/thread.hpp>
+#include <fc/uint128.hpp>
+
+#include <boost/filesystem/path.hpp>
+
+#include <deque>
+#include <map>
 
 namespace graphene { namespace market_history {
 
 namespace detail
 {
 
+/// History that has been removed from memory in a block, to be moved to the store once the block is irreversible
+struct archived_history
+{
+   uint32_t                     block_num = 0;
+   block_id_type                block_id;
+   vector<order_history_object> fills;
+   vector<bucket_object>        buckets;
+};
+
+/// OHLCV data of consecutive fills or buckets of a market, in columns
+struct ohlcv_columns
+{
+   vector<int64_t> open_base;
+   vector<int64_t> open_quote;
+   vector<int64_t> high_base;
+   vector<int64_t> high_quote;
+   vector<int64_t> low_base;
+   vector<int64_t> low_quote;
+   vector<int64_t> close_base;
+   vector<int64_t> close_quote;
+   vector<int64_t> base_volume;
+   vector<int64_t> quote_volume;
+
+   size_t size()const { return close_base.size(); }
+
+   void push_back( int64_t ob, int64_t oq, int64_t hb, int64_t hq, int64_t lb, int64_t lq, int64_t cb, int64_t cq,
+                   int64_t bv, int64_t qv )
+   {
+      open_base.push_back( ob );
+      open_quote.push_back( oq );
+      high_base.push_back( hb );
+      high_quote.push_back( hq );
+      low_base.push_back( lb );
+      low_quote.push_back( lq );
+      close_base.push_back( cb );
+      close_quote.push_back( cq );
+      base_volume.push_back( bv );
+      quote_volume.push_back( qv );
+   }
+
+   /// A fill is a row whose open, high, low and close are all the fill price
+   void push_back_fill( int64_t price_base, int64_t price_quote, int64_t volume_base, int64_t volume_quote )
+   {
+      push_back( price_base, price_quote, price_base, price_quote, price_base, price_quote, price_base, price_quote,
+                 volume_base, volume_quote );
+   }
+
+   void push_back( const bucket_object& b )
+   {
+      push_back( b.open_base.value, b.open_quote.value, b.high_base.value, b.high_quote.value,
+                 b.low_base.value, b.low_quote.value, b.close_base.value, b.close_quote.value,
+                 b.base_volume.value, b.quote_volume.value );
+   }
+};
+
+/// Maker fills of a block, by market
+typedef std::map< std::pair<asset_id_type,asset_id_type>, ohlcv_columns > market_fills;
+
+/// @return whether the price a_base/a_quote is lower than the price b_base/b_quote
+static bool price_less( int64_t a_base, int64_t a_quote, int64_t b_base, int64_t b_quote )
+{
+   return fc::uint128_t( b_quote ) * a_base < fc::uint128_t( a_quote ) * b_base;
+}
+
+/// Adds volumes, capped at the maximum value instead of overflowing
+static int64_t add_volume( int64_t a, int64_t b )
+{
+   return ( a > std::numeric_limits<int64_t>::max() - b ) ? std::numeric_limits<int64_t>::max() : ( a + b );
+}
+
+/**
+ * @brief Roll up the rows [first,last) of OHLCV columns
+ * @return a bucket with the same data as if the rows were added to it one by one, without a key
+ */
+static bucket_object rollup( const ohlcv_columns& c, size_t first, size_t last )
+{
+   size_t high = first;
+   size_t low = first;
+   int64_t base_volume = 0;
+   int64_t quote_volume = 0;
+   for( size_t i = first; i < last; ++i )
+   {
+      if( price_less( c.high_base[high], c.high_quote[high], c.high_base[i], c.high_quote[i] ) )
+         high = i;
+      if( price_less( c.low_base[i], c.low_quote[i], c.low_base[low], c.low_quote[low] ) )
+         low = i;
+      base_volume = add_volume( base_volume, c.base_volume[i] );
+      quote_volume = add_volume( quote_volume, c.quote_volume[i] );
+   }
+   bucket_object b;
+   b.open_base = c.open_base[first];
+   b.open_quote = c.open_quote[first];
+   b.high_base = c.high_base[high];
+   b.high_quote = c.high_quote[high];
+   b.low_base = c.low_base[low];
+   b.low_quote = c.low_quote[low];
+   b.close_base = c.close_base[last - 1];
+   b.close_quote = c.close_quote[last - 1];
+   b.base_volume = base_volume;
+   b.quote_volume = quote_volume;
+   return b;
+}
+
+/// Adds the OHLCV data of a later period to a bucket
+static void merge_bucket( bucket_object& b, const bucket_object& later )
+{
+   if( price_less( b.high_base.value, b.high_quote.value, later.high_base.value, later.high_quote.value ) )
+   {
+      b.high_base = later.high_base;
+      b.high_quote = later.high_quote;
+   }
+   if( price_less( later.low_base.value, later.low_quote.value, b.low_base.value, b.low_quote.value ) )
+   {
+      b.low_base = later.low_base;
+      b.low_quote = later.low_quote;
+   }
+   b.close_base = later.close_base;
+   b.close_quote = later.close_quote;
+   b.base_volume = add_volume( b.base_volume.value, later.base_volume.value );
+   b.quote_volume = add_volume( b.quote_volume.value, later.quote_volume.value );
+}
+
 class market_history_plugin_impl
 {
    public:
@@ -55,6 +184,16 @@ class market_history_plugin_impl
       void update_liquidity_pool_histories( time_point_sec time, const operation_history_object& oho,
                                             const liquidity_pool_ticker_meta_object*& lp_meta );
 
+      /// move the history removed in blocks up to the given one to the store
+      void archive_history( uint32_t last_block_num );
+
+      /// add the maker fills of a block to the buckets of all tracked sizes
+      void update_buckets( fc::time_point_sec now, const market_fills& fills, archived_history* archive );
+
+      /// get buckets of a tracked size from the store and from memory
+      vector<bucket_object> get_buckets( asset_id_type base, asset_id_type quote, uint32_t seconds,
+                                         fc::time_point_sec start, fc::time_point_sec end, uint32_t limit );
+
       graphene::chain::database& database()
       {
          return _self.database();
@@ -65,6 +204,8 @@ class market_history_plugin_impl
       uint32_t                   _maximum_history_per_bucket_size = 1000;
       uint32_t                   _max_order_his_records_per_market = 1000;
       uint32_t                   _max_order_his_seconds_per_market = 259200;
+      market_history_store       _store;
+      std::deque<archived_history> _pending_archive;
 };
 
 
@@ -72,10 +213,12 @@ struct operation_process_fill_order
 {
    market_history_plugin&            _plugin;
    fc::time_point_sec                _now;
-   const market_ticker_meta_object*& _meta;
+   archived_history*                 _archive;
+   market_fills&                     _fills;
 
-   operation_process_fill_order( market_history_plugin& mhp, fc::time_point_sec n, const market_ticker_meta_object*& meta )
-   :_plugin(mhp),_now(n),_meta(meta) {}
+   operation_process_fill_order( market_history_plugin& mhp, fc::time_point_sec n, archived_history* archive,
+                                 market_fills& fills )
+   :_plugin(mhp),_now(n),_archive(archive),_fills(fills) {}
 
    typedef void result_type;
 
@@ -106,25 +249,12 @@ struct operation_process_fill_order
       else
          hkey.sequence = 0;
 
-      const auto& new_order_his_obj = db.create<order_history_object>( [&]( order_history_object& ho ) {
+      db.create<order_history_object>( [&]( order_history_object& ho ) {
          ho.key = hkey;
          ho.time = _now;
          ho.op = o;
       });
 
-      // save a reference to market ticker meta object
-      if( _meta == nullptr )
-      {
-         const auto& meta_idx = db.get_index_type<simple_index<market_ticker_meta_object>>();
-         if( meta_idx.size() == 0 )
-            _meta = &db.create<market_ticker_meta_object>( [&]( market_ticker_meta_object& mtm ) {
-               mtm.rolling_min_order_his_id = new_order_his_obj.id;
-               mtm.skip_min_order_his_id = false;
-            });
-         else
-            _meta = &( *meta_idx.begin() );
-      }
-
       // To remove old filled order data
       const auto max_records = _plugin.max_order_his_records_per_market();
       hkey.sequence += max_records;
@@ -144,6 +274,8 @@ struct operation_process_fill_order
                {
                   auto old_itr = itr;
                   ++itr;
+                  if( _archive != nullptr )
+                     _archive->fills.push_back( *old_itr );
                   db.remove( *old_itr );
                }
             }
@@ -153,6 +285,8 @@ struct operation_process_fill_order
                {
                   auto old_itr = time_itr;
                   ++time_itr;
+                  if( _archive != nullptr )
+                     _archive->fills.push_back( *old_itr );
                   db.remove( *old_itr );
                }
             }
@@ -205,91 +339,40 @@ struct operation_process_fill_order
          });
       }
 
-      // To update buckets data
-      const auto max_history = _plugin.max_history();
-      if( max_history == 0 ) return;
-
-      const auto& buckets = _plugin.tracked_buckets();
-      if( buckets.size() == 0 ) return;
-
-      const auto& bucket_idx = db.get_index_type<bucket_index>();
-      for( auto bucket : buckets )
+      // To update the slot of the ticker, which rolls the fill out of the ticker after 24 hours
+      const auto slot_seconds = market_ticker_slot_object::slot_seconds;
+      const fc::time_point_sec slot_open( _now.sec_since_epoch() / slot_seconds * slot_seconds );
+      const auto& slot_idx = db.get_index_type<market_ticker_slot_index>().indices().get<by_market_open>();
+      auto slot_itr = slot_idx.find( std::make_tuple( key.base, key.quote, slot_open ) );
+      if( slot_itr == slot_idx.end() )
       {
-          auto bucket_num = _now.sec_since_epoch() / bucket;
-          fc::time_point_sec cutoff;
-          if( bucket_num > max_history )
-             cutoff = cutoff + ( bucket * ( bucket_num - max_history ) );
-
-          key.seconds = bucket;
-          key.open    = fc::time_point_sec() + ( bucket_num * bucket );
-
-          const auto& by_key_idx = bucket_idx.indices().get<by_key>();
-          auto bucket_itr = by_key_idx.find( key );
-          if( bucket_itr == by_key_idx.end() )
-          { // create new bucket
-            /* const auto& obj = */
-            db.create<bucket_object>( [&]( bucket_object& b ){
-                 b.key = key;
-                 b.base_volume = trade_price.base.amount;
-                 b.quote_volume = trade_price.quote.amount;
-                 b.open_base = fill_price.base.amount;
-                 b.open_quote = fill_price.quote.amount;
-                 b.close_base = fill_price.base.amount;
-                 b.close_quote = fill_price.quote.amount;
-                 b.high_base = b.close_base;
-                 b.high_quote = b.close_quote;
-                 b.low_base = b.close_base;
-                 b.low_quote = b.close_quote;
-            });
-            //wlog( "    creating bucket ${b}", ("b",obj) );
-          }
-          else
-          { // update existing bucket
-             //wlog( "    before updating bucket ${b}", ("b",*bucket_itr) );
-             db.modify( *bucket_itr, [&]( bucket_object& b ){
-                  try {
-                     b.base_volume += trade_price.base.amount;
-                  } catch( fc::overflow_exception& ) {
-                     b.base_volume = std::numeric_limits<int64_t>::max();
-                  }
-                  try {
-                     b.quote_volume += trade_price.quote.amount;
-                  } catch( fc::overflow_exception& ) {
-                     b.quote_volume = std::numeric_limits<int64_t>::max();
-                  }
-                  b.close_base = fill_price.base.amount;
-                  b.close_quote = fill_price.quote.amount;
-                  if( b.high() < fill_price )
-                  {
-                      b.high_base = b.close_base;
-                      b.high_quote = b.close_quote;
-                  }
-                  if( b.low() > fill_price )
-                  {
-                      b.low_base = b.close_base;
-                      b.low_quote = b.close_quote;
-                  }
-             });
-             //wlog( "    after bucket bucket ${b}", ("b",*bucket_itr) );
-          }
-
-          {
-             key.open = fc::time_point_sec();
-             bucket_itr = by_key_idx.lower_bound( key );
-
-             while( bucket_itr != by_key_idx.end() &&
-                    bucket_itr->key.base == key.base &&
-                    bucket_itr->key.quote == key.quote &&
-                    bucket_itr->key.seconds == bucket &&
-                    bucket_itr->key.open < cutoff )
-             {
-              //  elog( "    removing old bucket ${b}", ("b", *bucket_itr) );
-                auto old_bucket_itr = bucket_itr;
-                ++bucket_itr;
-                db.remove( *old_bucket_itr );
-             }
-          }
+         db.create<market_ticker_slot_object>( [&]( market_ticker_slot_object& s ) {
+            s.base         = key.base;
+            s.quote        = key.quote;
+            s.open         = slot_open;
+            s.close_base   = fill_price.base.amount;
+            s.close_quote  = fill_price.quote.amount;
+            s.base_volume  = trade_price.base.amount.value;
+            s.quote_volume = trade_price.quote.amount.value;
+         });
       }
+      else
+      {
+         db.modify( *slot_itr, [&]( market_ticker_slot_object& s ) {
+            s.close_base   = fill_price.base.amount;
+            s.close_quote  = fill_price.quote.amount;
+            s.base_volume  += trade_price.base.amount.value;  // ignore overflow
+            s.quote_volume += trade_price.quote.amount.value; // ignore overflow
+         });
+      }
+
+      // To update buckets data, which is done for all fills of the block at once
+      if( _plugin.max_history() == 0 || _plugin.tracked_buckets().empty() )
+         return;
+
+      _fills[ std::make_pair( key.base, key.quote ) ].push_back_fill(
+            fill_price.base.amount.value, fill_price.quote.amount.value,
+            trade_price.base.amount.value, trade_price.quote.amount.value );
    }
 };
 
@@ -297,16 +380,15 @@ void market_history_plugin_impl::update_market_histories( const signed_block& b
 {
    graphene::chain::database& db = database();
 
-   const market_ticker_meta_object* _meta = nullptr;
-   const auto& meta_idx = db.get_index_type<simple_index<market_ticker_meta_object>>();
-   if( meta_idx.size() > 0 )
-      _meta = &( *meta_idx.begin() );
-
    const liquidity_pool_ticker_meta_object* _lp_meta = nullptr;
    const auto& lp_meta_idx = db.get_index_type<simple_index<liquidity_pool_ticker_meta_object>>();
    if( lp_meta_idx.size() > 0 )
       _lp_meta = &( *lp_meta_idx.begin() );
 
+   archived_history archive;
+   archived_history* archive_ptr = _store.is_open() ? &archive : nullptr;
+   market_fills fills;
+
    const vector<optional< operation_history_object > >& hist = db.get_applied_operations();
    for( const optional< operation_history_object >& o_op : hist )
    {
@@ -315,80 +397,35 @@ void market_history_plugin_impl::update_market_histories( const signed_block& b
          // process market history
          try
          {
-            o_op->op.visit( operation_process_fill_order( _self, b.timestamp, _meta ) );
+            o_op->op.visit( operation_process_fill_order( _self, b.timestamp, archive_ptr, fills ) );
          } FC_CAPTURE_AND_LOG( (o_op) )
          // process liquidity pool history
          update_liquidity_pool_histories( b.timestamp, *o_op, _lp_meta );
       }
    }
-   // roll out expired data from ticker
-   if( _meta != nullptr )
+   update_buckets( b.timestamp, fills, archive_ptr );
+   // roll out the slots that are older than 24 hours from the tickers
    {
-      time_point_sec last_day = b.timestamp - 86400;
-      object_id_type last_min_his_id = _meta->rolling_min_order_his_id;
-      bool skip = _meta->skip_min_order_his_id;
-
+      const time_point_sec last_day = b.timestamp - 86400;
       const auto& ticker_idx = db.get_index_type<market_ticker_index>().indices().get<by_market>();
-      const auto& history_idx = db.get_index_type<history_index>().indices().get<by_id>();
-      auto history_itr = history_idx.lower_bound( _meta->rolling_min_order_his_id );
-      while( history_itr != history_idx.end() && history_itr->time < last_day )
+      const auto& slot_idx = db.get_index_type<market_ticker_slot_index>().indices().get<by_open>();
+      auto slot_itr = slot_idx.begin();
+      while( slot_itr != slot_idx.end()
+             && slot_itr->open + market_ticker_slot_object::slot_seconds <= last_day )
       {
-         const fill_order_operation& o = history_itr->op;
-         if( skip && history_itr->id == _meta->rolling_min_order_his_id )
-            skip = false;
-         else if( o.is_maker )
+         const market_ticker_slot_object& slot = *slot_itr;
+         ++slot_itr;
+         auto ticker_itr = ticker_idx.find( std::make_tuple( slot.base, slot.quote ) );
+         if( ticker_itr != ticker_idx.end() ) // should always be true
          {
-            bucket_key key;
-            key.base    = o.pays.asset_id;
-            key.quote   = o.receives.asset_id;
-
-            price trade_price = o.pays / o.receives;
-
-            if( key.base > key.quote )
-            {
-               std::swap( key.base, key.quote );
-               trade_price = ~trade_price;
-            }
-
-            price fill_price = o.fill_price;
-            if( fill_price.base.asset_id > fill_price.quote.asset_id )
-               fill_price = ~fill_price;
-
-            auto ticker_itr = ticker_idx.find( std::make_tuple( key.base, key.quote ) );
-            if( ticker_itr != ticker_idx.end() ) // should always be true
-            {
-               db.modify( *ticker_itr, [&]( market_ticker_object& mt ) {
-                  mt.last_day_base  = fill_price.base.amount;
-                  mt.last_day_quote = fill_price.quote.amount;
-                  mt.base_volume    -= trade_price.base.amount.value;  // ignore underflow
-                  mt.quote_volume   -= trade_price.quote.amount.value; // ignore underflow
-               });
-            }
-         }
-         last_min_his_id = history_itr->id;
-         ++history_itr;
-      }
-      // update meta
-      if( history_itr != history_idx.end() ) // if still has some data rolling
-      {
-         if( history_itr->id != _meta->rolling_min_order_his_id ) // if rolled out some
-         {
-            db.modify( *_meta, [&]( market_ticker_meta_object& mtm ) {
-               mtm.rolling_min_order_his_id = history_itr->id;
-               mtm.skip_min_order_his_id = false;
-            });
-         }
-      }
-      else // if all data are rolled out
-      {
-         if( !_meta->skip_min_order_his_id
-             || last_min_his_id != _meta->rolling_min_order_his_id ) // if rolled out some
-         {
-            db.modify( *_meta, [&]( market_ticker_meta_object& mtm ) {
-               mtm.rolling_min_order_his_id = last_min_his_id;
-               mtm.skip_min_order_his_id = true;
+            db.modify( *ticker_itr, [&slot]( market_ticker_object& mt ) {
+               mt.last_day_base  = slot.close_base;
+               mt.last_day_quote = slot.close_quote;
+               mt.base_volume    -= slot.base_volume;  // ignore underflow
+               mt.quote_volume   -= slot.quote_volume; // ignore underflow
             });
          }
+         db.remove( slot );
       }
    }
    // roll out expired data from LP ticker
@@ -494,6 +531,129 @@ void market_history_plugin_impl::update_market_histories( const signed_block& b
          }
       }
    }
+
+   if( _store.is_open() )
+   {
+      if( !archive.fills.empty() || !archive.buckets.empty() )
+      {
+         archive.block_num = b.block_num();
+         archive.block_id = b.id();
+         _pending_archive.push_back( std::move( archive ) );
+      }
+      archive_history( db.get_dynamic_global_properties().last_irreversible_block_num );
+   }
+}
+
+void market_history_plugin_impl::archive_history( uint32_t last_block_num )
+{ try {
+   const graphene::chain::database& db = database();
+   while( !_pending_archive.empty() && _pending_archive.front().block_num <= last_block_num )
+   {
+      const archived_history& h = _pending_archive.front();
+      // skip blocks that have been popped, the objects they removed are in memory again
+      if( db.get_block_id_for_num( h.block_num ) == h.block_id )
+      {
+         _store.append( h.fills );
+         _store.append( h.buckets );
+      }
+      _pending_archive.pop_front();
+   }
+} FC_CAPTURE_AND_LOG( (last_block_num) ) }
+
+void market_history_plugin_impl::update_buckets( fc::time_point_sec now, const market_fills& fills,
+                                                 archived_history* archive )
+{
+   graphene::chain::database& db = database();
+   const auto& by_key_idx = db.get_index_type<bucket_index>().indices().get<by_key>();
+
+   for( const auto& market : fills )
+   {
+      // all fills of a block are in the same bucket of each size, so they are rolled up only once
+      const bucket_object block_data = rollup( market.second, 0, market.second.size() );
+
+      bucket_key key;
+      key.base  = market.first.first;
+      key.quote = market.first.second;
+      for( auto bucket : _tracked_buckets )
+      {
+         auto bucket_num = now.sec_since_epoch() / bucket;
+         fc::time_point_sec cutoff;
+         if( bucket_num > _maximum_history_per_bucket_size )
+            cutoff = cutoff + ( bucket * ( bucket_num - _maximum_history_per_bucket_size ) );
+
+         key.seconds = bucket;
+         key.open    = fc::time_point_sec() + ( bucket_num * bucket );
+
+         auto bucket_itr = by_key_idx.find( key );
+         if( bucket_itr == by_key_idx.end() )
+         {
+            db.create<bucket_object>( [&key,&block_data]( bucket_object& b ) {
+               b.key = key;
+               b.open_base = block_data.open_base;
+               b.open_quote = block_data.open_quote;
+               b.high_base = block_data.high_base;
+               b.high_quote = block_data.high_quote;
+               b.low_base = block_data.low_base;
+               b.low_quote = block_data.low_quote;
+               b.close_base = block_data.close_base;
+               b.close_quote = block_data.close_quote;
+               b.base_volume = block_data.base_volume;
+               b.quote_volume = block_data.quote_volume;
+            });
+         }
+         else
+         {
+            db.modify( *bucket_itr, [&block_data]( bucket_object& b ) {
+               merge_bucket( b, block_data );
+            });
+         }
+
+         key.open = fc::time_point_sec();
+         bucket_itr = by_key_idx.lower_bound( key );
+         while( bucket_itr != by_key_idx.end() &&
+                bucket_itr->key.base == key.base &&
+                bucket_itr->key.quote == key.quote &&
+                bucket_itr->key.seconds == bucket &&
+                bucket_itr->key.open < cutoff )
+         {
+            auto old_bucket_itr = bucket_itr;
+            ++bucket_itr;
+            if( archive != nullptr )
+               archive->buckets.push_back( *old_bucket_itr );
+            db.remove( *old_bucket_itr );
+         }
+      }
+   }
+}
+
+vector<bucket_object> market_history_plugin_impl::get_buckets( asset_id_type base, asset_id_type quote,
+                                                               uint32_t seconds, fc::time_point_sec start,
+                                                               fc::time_point_sec end, uint32_t limit )
+{
+   const graphene::chain::database& db = database();
+   const auto& by_key_idx = db.get_index_type<bucket_index>().indices().get<by_key>();
+
+   vector<bucket_object> result;
+   auto itr = by_key_idx.lower_bound( bucket_key( base, quote, seconds, start ) );
+
+   // buckets that have been removed from memory may be in the store, they are older than those in memory
+   if( _store.is_open() )
+   {
+      fc::time_point_sec store_end = end;
+      if( itr != by_key_idx.end() && itr->key.base == base && itr->key.quote == quote
+            && itr->key.seconds == seconds && itr->key.open <= end )
+         store_end = itr->key.open - 1;
+      result = _store.get_buckets( base, quote, seconds, start, store_end, limit );
+   }
+
+   while( itr != by_key_idx.end() && itr->key.open <= end && result.size() < limit )
+   {
+      if( !( itr->key.base == base && itr->key.quote == quote && itr->key.seconds == seconds ) )
+         break;
+      result.push_back( *itr );
+      ++itr;
+   }
+   return result;
 }
 
 struct get_liquidity_pool_id_visitor
@@ -761,7 +921,11 @@ void market_history_plugin::plugin_set_program_options(
            "Will only store matched orders in last X seconds for each market in order history for querying, "
            "or those meet the other option, which has more data (default: 259200 (3 days)). "
            "This parameter is reused for liquidity pools as operations in last X seconds per pool in history. "
-           "Note: this parameter need to be greater than 24 hours to be able to serve market ticker data correctly.")
+           "Note: this parameter need to be greater than 24 hours to be able to serve liquidity pool ticker data "
+           "correctly.")
+         ("market-history-store-dir", boost::program_options::value<boost::filesystem::path>(),
+           "Directory to keep the order history and buckets in that have been removed from memory "
+           "due to the options above, so that they can still be queried")
          ;
    cfg.add(cli);
 }
@@ -773,7 +937,7 @@ void market_history_plugin::plugin_initialize(const boost::program_options::vari
    database().add_index< primary_index< bucket_index  > >();
    database().add_index< primary_index< history_index  > >();
    database().add_index< primary_index< market_ticker_index, 8 > >(); // 256 markets per chunk
-   database().add_index< primary_index< simple_index< market_ticker_meta_object > > >();
+   database().add_index< primary_index< market_ticker_slot_index > >();
 
    database().add_index< primary_index< liquidity_pool_history_index > >();
    database().add_index< primary_index< simple_index< liquidity_pool_ticker_meta_object > > >();
@@ -791,12 +955,22 @@ void market_history_plugin::plugin_initialize(const boost::program_options::vari
       my->_max_order_his_records_per_market = options["max-order-his-records-per-market"].as<uint32_t>();
    if( options.count( "max-order-his-seconds-per-market" ) > 0 )
       my->_max_order_his_seconds_per_market = options["max-order-his-seconds-per-market"].as<uint32_t>();
+   if( options.count( "market-history-store-dir" ) > 0 )
+      my->_store.open( options["market-history-store-dir"].as<boost::filesystem::path>() );
 } FC_CAPTURE_AND_RETHROW() }
 
 void market_history_plugin::plugin_startup()
 {
 }
 
+void market_history_plugin::plugin_shutdown()
+{
+   // The database is rewound to the last irreversible block when it is closed, so the history removed in later
+   // blocks is in memory again and is removed again when these blocks are applied after a restart.
+   my->_pending_archive.clear();
+   my->_store.close();
+}
+
 const flat_set<uint32_t>& market_history_plugin::tracked_buckets() const
 {
    return my->_tracked_buckets;
@@ -817,4 +991,62 @@ uint32_t market_history_plugin::max_order_his_seconds_per_market()const
    return my->_max_order_his_seconds_per_market;
 }
 
+vector<bucket_object> market_history_plugin::get_market_history( asset_id_type base, asset_id_type quote,
+                                                                uint32_t bucket_seconds, fc::time_point_sec start,
+                                                                fc::time_point_sec end, uint32_t limit )const
+{ try {
+   if( base > quote )
+      std::swap( base, quote );
+   if( my->_tracked_buckets.find( bucket_seconds ) != my->_tracked_buckets.end() )
+      return my->get_buckets( base, quote, bucket_seconds, start, end, limit );
+
+   // roll up the largest tracked size that the requested size is a multiple of
+   uint32_t source_seconds = 0;
+   for( auto bucket : my->_tracked_buckets )
+   {
+      if( bucket_seconds % bucket == 0 )
+         source_seconds = bucket;
+   }
+   if( bucket_seconds == 0 || source_seconds == 0 || end < start )
+      return {};
+
+   // the rolled up buckets open at multiples of their size, the first one at or after start
+   const uint64_t first_open = ( uint64_t(start.sec_since_epoch()) + bucket_seconds - 1 ) / bucket_seconds
+                               * bucket_seconds;
+   const uint32_t last_open = end.sec_since_epoch() / bucket_seconds * bucket_seconds;
+   if( first_open > last_open )
+      return {};
+   const uint64_t last_source_open = std::min<uint64_t>( uint64_t(last_open) + bucket_seconds - source_seconds,
+                                                         std::numeric_limits<uint32_t>::max() );
+   const uint64_t source_limit = std::min<uint64_t>( uint64_t(limit) * ( bucket_seconds / source_seconds ),
+                                                     std::numeric_limits<uint32_t>::max() );
+   const vector<bucket_object> sources = my->get_buckets( base, quote, source_seconds,
+                                                          fc::time_point_sec( uint32_t(first_open) ),
+                                                          fc::time_point_sec( uint32_t(last_source_open) ),
+                                                          uint32_t(source_limit) );
+
+   detail::ohlcv_columns columns;
+   for( const auto& b : sources )
+      columns.push_back( b );
+
+   vector<bucket_object> result;
+   size_t first = 0;
+   while( first < sources.size() && result.size() < limit )
+   {
+      const uint32_t open = sources[first].key.open.sec_since_epoch() / bucket_seconds * bucket_seconds;
+      size_t last = first + 1;
+      while( last < sources.size() && sources[last].key.open.sec_since_epoch() - open < bucket_seconds )
+         ++last;
+      result.push_back( detail::rollup( columns, first, last ) );
+      result.back().key = bucket_key( base, quote, bucket_seconds, fc::time_point_sec( open ) );
+      first = last;
+   }
+   return result;
+} FC_CAPTURE_AND_RETHROW( (base)(quote)(bucket_seconds)(start)(end)(limit) ) }
+
+const market_history_store* market_history_plugin::history_store()const
+{
+   return my->_store.is_open() ? &my->_store : nullptr;
+}
+
 } }
@@ -0,0 +1,717 @@
+/*
+ * Copyright (c) 2021 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <graphene/market_history/market_history_store.hpp>
+
+#include <fc/interprocess/file_mapping.hpp>
+
+#include <boost/endian/buffers.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+
+namespace graphene { namespace market_history {
+
+namespace detail {
+
+using boost::endian::little_int64_buf_t;
+using boost::endian::little_uint32_buf_t;
+using boost::endian::little_uint64_buf_t;
+
+/// Identifies a market, or a market and a bucket size
+struct series_key
+{
+   uint64_t base = 0;
+   uint64_t quote = 0;
+   uint32_t seconds = 0;
+
+   friend bool operator < ( const series_key& a, const series_key& b )
+   {
+      return std::tie( a.base, a.quote, a.seconds ) < std::tie( b.base, b.quote, b.seconds );
+   }
+};
+
+struct segment_header
+{
+   little_uint64_buf_t base;
+   little_uint64_buf_t quote;
+   little_uint32_buf_t seconds;
+   little_uint32_buf_t count;
+   little_uint32_buf_t size;        ///< the size of the columns following the header
+   little_int64_buf_t  first_key;
+   little_int64_buf_t  last_key;
+};
+
+/// Writes columns of variable length integers
+class column_writer
+{
+   public:
+      explicit column_writer( vector<char>& out ):_out(out) {}
+
+      void put( uint64_t v )
+      {
+         while( v >= 0x80 )
+         {
+            _out.push_back( char( v | 0x80 ) );
+            v >>= 7;
+         }
+         _out.push_back( char( v ) );
+      }
+      void put_signed( int64_t v ) { put( ( uint64_t(v) << 1 ) ^ uint64_t( v >> 63 ) ); }
+
+   private:
+      vector<char>& _out;
+};
+
+class column_reader
+{
+   public:
+      column_reader( const char* data, size_t size ):_pos(data),_end(data + size) {}
+
+      uint64_t get()
+      {
+         uint64_t v = 0;
+         for( uint8_t shift = 0; ; shift += 7 )
+         {
+            FC_ASSERT( _pos < _end && shift < 64, "Corrupt market history segment" );
+            const uint8_t b = uint8_t( *_pos++ );
+            v |= uint64_t( b & 0x7f ) << shift;
+            if( b < 0x80 )
+               return v;
+         }
+      }
+      int64_t get_signed()
+      {
+         const uint64_t v = get();
+         return int64_t( v >> 1 ) ^ -int64_t( v & 1 );
+      }
+
+   private:
+      const char* _pos;
+      const char* _end;
+};
+
+/// Encodes a column of values as differences to the previous value
+template<typename Rows, typename Field>
+static void put_deltas( column_writer& w, const Rows& rows, Field field )
+{
+   int64_t prev = 0;
+   for( const auto& r : rows )
+   {
+      const int64_t v = field( r );
+      w.put_signed( v - prev );
+      prev = v;
+   }
+}
+
+template<typename Rows, typename Field>
+static void put_values( column_writer& w, const Rows& rows, Field field )
+{
+   for( const auto& r : rows )
+      w.put_signed( field( r ) );
+}
+
+template<typename Rows, typename Field>
+static void get_deltas( column_reader& r, Rows& rows, Field field )
+{
+   int64_t prev = 0;
+   for( auto& row : rows )
+   {
+      prev += r.get_signed();
+      field( row, prev );
+   }
+}
+
+template<typename Rows, typename Field>
+static void get_values( column_reader& r, Rows& rows, Field field )
+{
+   for( auto& row : rows )
+      field( row, r.get_signed() );
+}
+
+/// Stores filled orders, in ascending order of time, i.e. descending sequence numbers
+struct fill_codec
+{
+   typedef order_history_object record_type;
+
+   enum flags
+   {
+      is_maker           = 1,
+      pays_base          = 2,
+      fill_price_in_base = 4
+   };
+
+   static series_key series_of( const record_type& r )
+   {
+      series_key k;
+      k.base = r.key.base.instance.value;
+      k.quote = r.key.quote.instance.value;
+      return k;
+   }
+
+   static int64_t key_of( const record_type& r ) { return -r.key.sequence; }
+
+   /// Only fills between the two assets of the market can be stored in columns
+   static bool is_valid( const record_type& r )
+   {
+      const auto& o = r.op;
+      const auto& fp = o.fill_price;
+      return ( ( o.pays.asset_id == r.key.base && o.receives.asset_id == r.key.quote )
+               || ( o.pays.asset_id == r.key.quote && o.receives.asset_id == r.key.base ) )
+             && ( ( fp.base.asset_id == r.key.base && fp.quote.asset_id == r.key.quote )
+                  || ( fp.base.asset_id == r.key.quote && fp.quote.asset_id == r.key.base ) );
+   }
+
+   static void encode( const vector<record_type>& rows, vector<char>& out )
+   {
+      column_writer w( out );
+      put_deltas( w, rows, []( const record_type& r ) { return int64_t( r.id.instance() ); } );
+      put_deltas( w, rows, []( const record_type& r ) { return r.key.sequence; } );
+      put_deltas( w, rows, []( const record_type& r ) { return int64_t( r.time.sec_since_epoch() ); } );
+      put_values( w, rows, []( const record_type& r ) {
+         return int64_t( ( r.op.is_maker ? is_maker : 0 )
+                         | ( r.op.pays.asset_id == r.key.base ? pays_base : 0 )
+                         | ( r.op.fill_price.base.asset_id == r.key.base ? fill_price_in_base : 0 ) );
+      });
+      // the amounts of the base and the quote asset
+      put_values( w, rows, []( const record_type& r ) {
+         return ( r.op.pays.asset_id == r.key.base ? r.op.pays : r.op.receives ).amount.value;
+      });
+      put_values( w, rows, []( const record_type& r ) {
+         return ( r.op.pays.asset_id == r.key.base ? r.op.receives : r.op.pays ).amount.value;
+      });
+      // fill prices of consecutive orders are close to each other
+      put_deltas( w, rows, []( const record_type& r ) {
+         const auto& fp = r.op.fill_price;
+         return ( fp.base.asset_id == r.key.base ? fp.base : fp.quote ).amount.value;
+      });
+      put_deltas( w, rows, []( const record_type& r ) {
+         const auto& fp = r.op.fill_price;
+         return ( fp.base.asset_id == r.key.base ? fp.quote : fp.base ).amount.value;
+      });
+      put_values( w, rows, []( const record_type& r ) { return int64_t( r.op.order_id.number ); } );
+      put_values( w, rows, []( const record_type& r ) { return int64_t( r.op.account_id.instance.value ); } );
+      put_values( w, rows, []( const record_type& r ) { return int64_t( r.op.fee.asset_id.instance.value ); } );
+      put_values( w, rows, []( const record_type& r ) { return r.op.fee.amount.value; } );
+   }
+
+   static void decode( const series_key& s, const char* data, size_t size, vector<record_type>& rows )
+   {
+      const asset_id_type base( s.base );
+      const asset_id_type quote( s.quote );
+      column_reader r( data, size );
+      get_deltas( r, rows, []( record_type& row, int64_t v ) {
+         row.id = object_id_type( MARKET_HISTORY_SPACE_ID, order_history_object_type, v );
+      });
+      get_deltas( r, rows, [base,quote]( record_type& row, int64_t v ) {
+         row.key.base = base;
+         row.key.quote = quote;
+         row.key.sequence = v;
+      });
+      get_deltas( r, rows, []( record_type& row, int64_t v ) { row.time = fc::time_point_sec( uint32_t(v) ); } );
+      vector<int64_t> flags( rows.size() );
+      for( auto& f : flags )
+         f = r.get_signed();
+      for( size_t i = 0; i < rows.size(); ++i )
+      {
+         auto& o = rows[i].op;
+         o.is_maker = ( flags[i] & is_maker ) != 0;
+         const bool pb = ( flags[i] & pays_base ) != 0;
+         o.pays.asset_id = pb ? base : quote;
+         o.receives.asset_id = pb ? quote : base;
+         const bool fb = ( flags[i] & fill_price_in_base ) != 0;
+         o.fill_price.base.asset_id = fb ? base : quote;
+         o.fill_price.quote.asset_id = fb ? quote : base;
+      }
+      size_t i = 0;
+      get_values( r, rows, [&flags,&i]( record_type& row, int64_t v ) {
+         ( ( flags[i++] & pays_base ) ? row.op.pays : row.op.receives ).amount = v;
+      });
+      i = 0;
+      get_values( r, rows, [&flags,&i]( record_type& row, int64_t v ) {
+         ( ( flags[i++] & pays_base ) ? row.op.receives : row.op.pays ).amount = v;
+      });
+      i = 0;
+      get_deltas( r, rows, [&flags,&i]( record_type& row, int64_t v ) {
+         ( ( flags[i++] & fill_price_in_base ) ? row.op.fill_price.base : row.op.fill_price.quote ).amount = v;
+      });
+      i = 0;
+      get_deltas( r, rows, [&flags,&i]( record_type& row, int64_t v ) {
+         ( ( flags[i++] & fill_price_in_base ) ? row.op.fill_price.quote : row.op.fill_price.base ).amount = v;
+      });
+      get_values( r, rows, []( record_type& row, int64_t v ) { row.op.order_id.number = uint64_t(v); } );
+      get_values( r, rows, []( record_type& row, int64_t v ) { row.op.account_id = account_id_type( v ); } );
+      get_values( r, rows, []( record_type& row, int64_t v ) { row.op.fee.asset_id = asset_id_type( v ); } );
+      get_values( r, rows, []( record_type& row, int64_t v ) { row.op.fee.amount = v; } );
+   }
+};
+
+/// Stores buckets of one size, in ascending order of their opening times
+struct bucket_codec
+{
+   typedef bucket_object record_type;
+
+   static series_key series_of( const record_type& r )
+   {
+      series_key k;
+      k.base = r.key.base.instance.value;
+      k.quote = r.key.quote.instance.value;
+      k.seconds = r.key.seconds;
+      return k;
+   }
+
+   static int64_t key_of( const record_type& r ) { return r.key.open.sec_since_epoch(); }
+
+   static bool is_valid( const record_type& ) { return true; }
+
+   static void encode( const vector<record_type>& rows, vector<char>& out )
+   {
+      column_writer w( out );
+      put_deltas( w, rows, []( const record_type& r ) { return int64_t( r.id.instance() ); } );
+      put_deltas( w, rows, []( const record_type& r ) { return key_of( r ); } );
+      put_deltas( w, rows, []( const record_type& r ) { return r.high_base.value; } );
+      put_deltas( w, rows, []( const record_type& r ) { return r.high_quote.value; } );
+      put_deltas( w, rows, []( const record_type& r ) { return r.low_base.value; } );
+      put_deltas( w, rows, []( const record_type& r ) { return r.low_quote.value; } );
+      put_deltas( w, rows, []( const record_type& r ) { return r.open_base.value; } );
+      put_deltas( w, rows, []( const record_type& r ) { return r.open_quote.value; } );
+      put_deltas( w, rows, []( const record_type& r ) { return r.close_base.value; } );
+      put_deltas( w, rows, []( const record_type& r ) { return r.close_quote.value; } );
+      put_values( w, rows, []( const record_type& r ) { return r.base_volume.value; } );
+      put_values( w, rows, []( const record_type& r ) { return r.quote_volume.value; } );
+   }
+
+   static void decode( const series_key& s, const char* data, size_t size, vector<record_type>& rows )
+   {
+      const asset_id_type base( s.base );
+      const asset_id_type quote( s.quote );
+      const uint32_t seconds = s.seconds;
+      column_reader r( data, size );
+      get_deltas( r, rows, []( record_type& row, int64_t v ) {
+         row.id = object_id_type( MARKET_HISTORY_SPACE_ID, bucket_object_type, v );
+      });
+      get_deltas( r, rows, [base,quote,seconds]( record_type& row, int64_t v ) {
+         row.key = bucket_key( base, quote, seconds, fc::time_point_sec( uint32_t(v) ) );
+      });
+      get_deltas( r, rows, []( record_type& row, int64_t v ) { row.high_base = v; } );
+      get_deltas( r, rows, []( record_type& row, int64_t v ) { row.high_quote = v; } );
+      get_deltas( r, rows, []( record_type& row, int64_t v ) { row.low_base = v; } );
+      get_deltas( r, rows, []( record_type& row, int64_t v ) { row.low_quote = v; } );
+      get_deltas( r, rows, []( record_type& row, int64_t v ) { row.open_base = v; } );
+      get_deltas( r, rows, []( record_type& row, int64_t v ) { row.open_quote = v; } );
+      get_deltas( r, rows, []( record_type& row, int64_t v ) { row.close_base = v; } );
+      get_deltas( r, rows, []( record_type& row, int64_t v ) { row.close_quote = v; } );
+      get_values( r, rows, []( record_type& row, int64_t v ) { row.base_volume = v; } );
+      get_values( r, rows, []( record_type& row, int64_t v ) { row.quote_volume = v; } );
+   }
+};
+
+/**
+ * The segments of all series of one kind of records in one file, and the records that have not been written to it
+ */
+template<typename Codec>
+class segment_file
+{
+   public:
+      typedef typename Codec::record_type record_type;
+
+      void open( const fc::path& file, uint64_t committed_size )
+      {
+         _path = file;
+         _file.exceptions( std::ios_base::failbit | std::ios_base::badbit );
+         if( !fc::exists( file ) )
+         {
+            FC_ASSERT( committed_size == 0, "${f} is missing", ("f",file) );
+            _file.open( file.generic_string().c_str(), std::fstream::binary | std::fstream::in | std::fstream::out
+                                                       | std::fstream::trunc );
+         }
+         else
+         {
+            const uint64_t file_size = fc::file_size( file );
+            FC_ASSERT( file_size >= committed_size, "${f} is shorter than committed",
+                       ("f",file)("size",file_size)("committed",committed_size) );
+            if( file_size > committed_size )
+            {
+               wlog( "Discarding ${n} uncommitted bytes of ${f}", ("n",file_size - committed_size)("f",file) );
+               fc::resize_file( file, committed_size );
+            }
+            _file.open( file.generic_string().c_str(), std::fstream::binary | std::fstream::in | std::fstream::out );
+         }
+         _size = committed_size;
+
+         // rebuild the index of the segments from their headers
+         uint64_t offset = 0;
+         while( offset < _size )
+         {
+            segment_header h;
+            _file.seekg( offset );
+            _file.read( (char*)&h, sizeof(h) );
+            series_key k;
+            k.base = h.base.value();
+            k.quote = h.quote.value();
+            k.seconds = h.seconds.value();
+            segment_info info;
+            info.offset = offset + sizeof(h);
+            info.size = h.size.value();
+            info.count = h.count.value();
+            info.first_key = h.first_key.value();
+            info.last_key = h.last_key.value();
+            series& s = _series[k];
+            s.segments.push_back( info );
+            s.last_key = info.last_key;
+            offset = info.offset + info.size;
+         }
+         FC_ASSERT( offset == _size, "${f} ends within a segment", ("f",file) );
+      }
+
+      bool is_open()const { return _file.is_open(); }
+
+      void close()
+      {
+         _region.reset();
+         _mapping.reset();
+         _mapped_size = 0;
+         _file.close();
+         _series.clear();
+      }
+
+      uint64_t size()const { return _size; }
+
+      /// @return whether segments have been written
+      bool append( const vector<const record_type*>& records )
+      {
+         std::map< series_key, vector<const record_type*> > by_series;
+         for( const record_type* r : records )
+         {
+            if( Codec::is_valid( *r ) )
+               by_series[Codec::series_of( *r )].push_back( r );
+            else
+               wlog( "Can not store ${r} in the market history store", ("r",*r) );
+         }
+
+         bool written = false;
+         for( auto& item : by_series )
+         {
+            auto& rows = item.second;
+            std::stable_sort( rows.begin(), rows.end(), []( const record_type* a, const record_type* b ) {
+               return Codec::key_of( *a ) < Codec::key_of( *b );
+            });
+            series& s = _series[item.first];
+            for( const record_type* r : rows )
+            {
+               // skip what has been stored already, e.g. when blocks are replayed
+               if( Codec::key_of( *r ) <= s.last_key )
+                  continue;
+               s.tail.push_back( *r );
+               s.last_key = Codec::key_of( *r );
+               if( s.tail.size() >= market_history_store::segment_records )
+               {
+                  write_segment( item.first, s );
+                  written = true;
+               }
+            }
+         }
+         return written;
+      }
+
+      /// Writes the records of all series that are still in memory, @return whether segments have been written
+      bool write_all()
+      {
+         bool written = false;
+         for( auto& item : _series )
+         {
+            if( !item.second.tail.empty() )
+            {
+               write_segment( item.first, item.second );
+               written = true;
+            }
+         }
+         return written;
+      }
+
+      void flush() { _file.flush(); }
+
+      /// Visits the records of a series with keys up to max_key from the newest to the oldest while visit returns true
+      template<typename Visitor>
+      void visit_backward( const series_key& k, int64_t max_key, Visitor visit )const
+      {
+         const auto itr = _series.find( k );
+         if( itr == _series.end() )
+            return;
+         const series& s = itr->second;
+         for( auto r = s.tail.rbegin(); r != s.tail.rend(); ++r )
+            if( Codec::key_of( *r ) <= max_key && !visit( *r ) )
+               return;
+         auto seg = std::upper_bound( s.segments.begin(), s.segments.end(), max_key,
+                                      []( int64_t key, const segment_info& info ) { return key < info.first_key; } );
+         vector<record_type> rows;
+         while( seg != s.segments.begin() )
+         {
+            --seg;
+            read_segment( k, *seg, rows );
+            for( auto r = rows.rbegin(); r != rows.rend(); ++r )
+               if( Codec::key_of( *r ) <= max_key && !visit( *r ) )
+                  return;
+         }
+      }
+
+      /// Visits the records of a series with keys from min_key from the oldest to the newest while visit returns true
+      template<typename Visitor>
+      void visit_forward( const series_key& k, int64_t min_key, Visitor visit )const
+      {
+         const auto itr = _series.find( k );
+         if( itr == _series.end() )
+            return;
+         const series& s = itr->second;
+         auto seg = std::lower_bound( s.segments.begin(), s.segments.end(), min_key,
+                                      []( const segment_info& info, int64_t key ) { return info.last_key < key; } );
+         vector<record_type> rows;
+         for( ; seg != s.segments.end(); ++seg )
+         {
+            read_segment( k, *seg, rows );
+            for( const auto& r : rows )
+               if( Codec::key_of( r ) >= min_key && !visit( r ) )
+                  return;
+         }
+         for( const auto& r : s.tail )
+            if( Codec::key_of( r ) >= min_key && !visit( r ) )
+               return;
+      }
+
+   private:
+      struct segment_info
+      {
+         uint64_t offset = 0;   ///< of the columns
+         uint32_t size = 0;
+         uint32_t count = 0;
+         int64_t  first_key = 0;
+         int64_t  last_key = 0;
+      };
+
+      struct series
+      {
+         vector<segment_info> segments;
+         vector<record_type>  tail;
+         int64_t              last_key = std::numeric_limits<int64_t>::min();
+      };
+
+      void write_segment( const series_key& k, series& s )
+      {
+         vector<char> columns;
+         Codec::encode( s.tail, columns );
+
+         segment_header h;
+         h.base = k.base;
+         h.quote = k.quote;
+         h.seconds = k.seconds;
+         h.count = s.tail.size();
+         h.size = columns.size();
+         h.first_key = Codec::key_of( s.tail.front() );
+         h.last_key = Codec::key_of( s.tail.back() );
+         _file.seekp( _size );
+         _file.write( (const char*)&h, sizeof(h) );
+         _file.write( columns.data(), columns.size() );
+
+         segment_info info;
+         info.offset = _size + sizeof(h);
+         info.size = columns.size();
+         info.count = s.tail.size();
+         info.first_key = h.first_key.value();
+         info.last_key = h.last_key.value();
+         s.segments.push_back( info );
+         s.tail.clear();
+         _size = info.offset + info.size;
+      }
+
+      void read_segment( const series_key& k, const segment_info& info, vector<record_type>& rows )const
+      {
+         if( _mapped_size < info.offset + info.size )
+         {
+            // the file has grown since it has been mapped
+            _region.reset();
+            _mapping.reset();
+            _mapping = std::make_unique<fc::file_mapping>( _path.generic_string().c_str(), fc::read_only );
+            _region = std::make_unique<fc::mapped_region>( *_mapping, fc::read_only );
+            _mapped_size = _region->get_size();
+            FC_ASSERT( _mapped_size >= info.offset + info.size, "Could not map ${f}", ("f",_path) );
+         }
+         rows.clear();
+         rows.resize( info.count );
+         Codec::decode( k, (const char*)_region->get_address() + info.offset, info.size, rows );
+      }
+
+      fc::path                            _path;
+      mutable std::fstream                _file;
+      uint64_t                            _size = 0;
+      std::map< series_key, series >      _series;
+      mutable std::unique_ptr<fc::file_mapping>  _mapping;
+      mutable std::unique_ptr<fc::mapped_region> _region;
+      mutable uint64_t                    _mapped_size = 0;
+};
+
+/// The committed sizes of the files
+struct head_record
+{
+   little_uint64_buf_t fills_size;
+   little_uint64_buf_t buckets_size;
+};
+
+} // detail
+
+market_history_store::market_history_store()
+   : _fills( std::make_unique< detail::segment_file<detail::fill_codec> >() ),
+     _buckets( std::make_unique< detail::segment_file<detail::bucket_codec> >() )
+{
+   // Nothing else to do
+}
+
+market_history_store::~market_history_store()
+{
+   try {
+      close();
+   } catch( const fc::exception& e ) {
+      elog( "Failed to close market history store: ${e}", ("e",e.to_detail_string()) );
+   } catch( const std::exception& e ) {
+      elog( "Failed to close market history store: ${e}", ("e",e.what()) );
+   }
+}
+
+void market_history_store::open( const fc::path& dir )
+{ try {
+   FC_ASSERT( !is_open(), "The market history store is open already" );
+   fc::create_directories( dir );
+   _dir = dir;
+
+   detail::head_record head;
+   head.fills_size = 0;
+   head.buckets_size = 0;
+   if( fc::exists( dir / "head" ) )
+   {
+      std::ifstream in;
+      in.exceptions( std::ios_base::failbit | std::ios_base::badbit );
+      in.open( (dir / "head").generic_string().c_str(), std::ifstream::binary );
+      in.read( (char*)&head, sizeof(head) );
+   }
+   _fills->open( dir / "fills", head.fills_size.value() );
+   _buckets->open( dir / "buckets", head.buckets_size.value() );
+} FC_CAPTURE_AND_RETHROW( (dir) ) }
+
+bool market_history_store::is_open()const
+{
+   return _fills->is_open();
+}
+
+void market_history_store::close()
+{
+   if( !is_open() )
+      return;
+   const bool fills_written = _fills->write_all();
+   const bool buckets_written = _buckets->write_all();
+   if( fills_written || buckets_written )
+      commit();
+   _fills->close();
+   _buckets->close();
+}
+
+void market_history_store::commit()
+{
+   _fills->flush();
+   _buckets->flush();
+
+   detail::head_record head;
+   head.fills_size = _fills->size();
+   head.buckets_size = _buckets->size();
+
+   // replace the file, so that a crash leaves either the old or the new one
+   const fc::path tmp = _dir / "head.tmp";
+   {
+      std::ofstream out;
+      out.exceptions( std::ios_base::failbit | std::ios_base::badbit );
+      out.open( tmp.generic_string().c_str(), std::ofstream::binary | std::ofstream::trunc );
+      out.write( (const char*)&head, sizeof(head) );
+   }
+   fc::rename( tmp, _dir / "head" );
+}
+
+void market_history_store::append( const vector<order_history_object>& fills )
+{ try {
+   FC_ASSERT( is_open(), "The market history store is not open" );
+   vector<const order_history_object*> records;
+   records.reserve( fills.size() );
+   for( const auto& f : fills )
+      records.push_back( &f );
+   if( _fills->append( records ) )
+      commit();
+} FC_CAPTURE_AND_RETHROW( (fills.size()) ) }
+
+void market_history_store::append( const vector<bucket_object>& buckets )
+{ try {
+   FC_ASSERT( is_open(), "The market history store is not open" );
+   vector<const bucket_object*> records;
+   records.reserve( buckets.size() );
+   for( const auto& b : buckets )
+      records.push_back( &b );
+   if( _buckets->append( records ) )
+      commit();
+} FC_CAPTURE_AND_RETHROW( (buckets.size()) ) }
+
+vector<order_history_object> market_history_store::get_fills( asset_id_type base, asset_id_type quote,
+                                                              int64_t after_sequence, uint32_t limit )const
+{ try {
+   vector<order_history_object> result;
+   if( !is_open() || limit == 0 || after_sequence == std::numeric_limits<int64_t>::max() )
+      return result;
+   detail::series_key k;
+   k.base = base.instance.value;
+   k.quote = quote.instance.value;
+   // older orders have greater sequence numbers, i.e. smaller keys
+   _fills->visit_backward( k, -( after_sequence + 1 ), [&result,limit]( const order_history_object& o ) {
+      result.push_back( o );
+      return result.size() < limit;
+   });
+   return result;
+} FC_CAPTURE_AND_RETHROW( (base)(quote)(after_sequence)(limit) ) }
+
+vector<bucket_object> market_history_store::get_buckets( asset_id_type base, asset_id_type quote, uint32_t seconds,
+                                                         fc::time_point_sec start, fc::time_point_sec end,
+                                                         uint32_t limit )const
+{ try {
+   vector<bucket_object> result;
+   if( !is_open() || limit == 0 || end < start )
+      return result;
+   detail::series_key k;
+   k.base = base.instance.value;
+   k.quote = quote.instance.value;
+   k.seconds = seconds;
+   _buckets->visit_forward( k, start.sec_since_epoch(), [&result,limit,end]( const bucket_object& b ) {
+      if( b.key.open > end )
+         return false;
+      result.push_back( b );
+      return result.size() < limit;
+   });
+   return result;
+} FC_CAPTURE_AND_RETHROW( (base)(quote)(seconds)(start)(end)(limit) ) }
+
+} } // graphene::market_history
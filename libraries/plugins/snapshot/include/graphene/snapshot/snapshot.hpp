@@ -26,10 +26,121 @@
 #include <graphene/app/plugin.hpp>
 #include <graphene/chain/database.hpp>
 
+#include <fc/io/raw.hpp>
+#include <fc/thread/future.hpp>
 #include <fc/time.hpp>
 
+#include <fstream>
+#include <memory>
+
+namespace fc { class thread; }
+
 namespace graphene { namespace snapshot_plugin {
 
+/// The format of a snapshot file
+enum snapshot_format : uint8_t
+{
+   binary = 0, ///< compressed chunks of objects packed with fc::raw, see @ref snapshot_chunk_header
+   json   = 1  ///< one object in JSON per line, without a header, as written by earlier versions
+};
+
+/**
+ *  @brief The header of a snapshot file, which follows the magic bytes at the beginning of the file
+ */
+struct snapshot_header
+{
+   static constexpr uint32_t current_version = 1;
+
+   uint32_t                        version = current_version;
+   uint8_t                         format = binary; ///< the format of the records, only binary so far
+   uint32_t                        block_num = 0;
+   graphene::chain::block_id_type  block_id;
+   fc::time_point_sec              timestamp;
+};
+
+/**
+ *  @brief The header of a chunk of objects in a snapshot file
+ *
+ *  A snapshot file consists of magic bytes, the packed @ref snapshot_header and any number of chunks. A chunk
+ *  consists of this packed header, followed by the records of up to @ref max_objects objects of the same index,
+ *  compressed with zlib. A record is a packed object prefixed with its size as an unsigned varint. Snapshots in
+ *  the JSON format are plain text files without chunks.
+ */
+struct snapshot_chunk_header
+{
+   static constexpr uint32_t max_objects = 10000;
+
+   uint8_t   space_id = 0;
+   uint8_t   type_id = 0;
+   uint32_t  objects = 0;
+   uint32_t  size = 0;            ///< the size of the records
+   uint32_t  compressed_size = 0; ///< the size of the compressed records
+};
+
+/**
+ *  @brief A copy of all objects of a database at a block, which can be written while the database changes
+ */
+struct snapshot_state
+{
+   snapshot_header                                      header;
+   std::vector< std::unique_ptr<graphene::db::object> > objects; ///< in the order of their indexes
+};
+
+/// Copies all objects of a database
+std::shared_ptr<snapshot_state> capture_snapshot( const graphene::chain::database& db );
+
+/// Writes a snapshot to a file, which is replaced when the snapshot is complete
+void write_snapshot( const snapshot_state& state, snapshot_format format, const fc::path& dest );
+
+/**
+ *  @brief Reads a snapshot file in the binary format, e.g. to load the state at its block into an analysis tool
+ */
+class snapshot_reader
+{
+   public:
+      explicit snapshot_reader( const fc::path& file );
+
+      const snapshot_header& header()const { return _header; }
+
+      /// Continue reading with the first chunk
+      void rewind();
+
+      /**
+       * @brief Read the header of the next chunk, skipping the records of the current chunk if they are not read
+       * @return false at the end of the file
+       */
+      bool next_chunk( snapshot_chunk_header& chunk );
+
+      /// Read the records of the current chunk, i.e. the packed objects
+      std::vector<std::string> read_records();
+
+      /// Read all objects of type @p T and call @p f with each of them
+      template<typename T, typename F>
+      void for_each_object( F&& f )
+      {
+         rewind();
+         snapshot_chunk_header chunk;
+         while( next_chunk( chunk ) )
+         {
+            if( chunk.space_id != T::space_id || chunk.type_id != T::type_id )
+               continue;
+            for( const std::string& record : read_records() )
+            {
+               T obj;
+               fc::datastream<const char*> ds( record.data(), record.size() );
+               fc::raw::unpack( ds, obj, GRAPHENE_MAX_NESTED_OBJECTS );
+               f( obj );
+            }
+         }
+      }
+
+   private:
+      std::ifstream   _file;
+      snapshot_header _header;
+      std::streamoff  _first_chunk = 0;
+      uint32_t        _unread_size = 0; ///< the size of the records of the current chunk that have not been read
+};
+
 class snapshot_plugin : public graphene::app::plugin {
    public:
       using graphene::app::plugin::plugin;
@@ -43,6 +154,7 @@ class snapshot_plugin : public graphene::app::plugin {
       ) override;
 
       void plugin_initialize( const boost::program_options::variables_map& options ) override;
+      void plugin_shutdown() override;
 
    private:
        void check_snapshot( const graphene::chain::signed_block& b);
@@ -50,6 +162,15 @@ class snapshot_plugin : public graphene::app::plugin {
        uint32_t           snapshot_block = -1, last_block = 0;
        fc::time_point_sec snapshot_time = fc::time_point_sec::maximum(), last_time = fc::time_point_sec(1);
        fc::path           dest;
+       snapshot_format    format = json;
+
+       std::shared_ptr<fc::thread> _thread;  ///< writes snapshots, so that blocks can be applied meanwhile
+       fc::future<void>            _writing;
 };
 
 } } //graphene::snapshot_plugin
+
+FC_REFLECT_ENUM( graphene::snapshot_plugin::snapshot_format, (binary)(json) )
+FC_REFLECT( graphene::snapshot_plugin::snapshot_header, (version)(format)(block_num)(block_id)(timestamp) )
+FC_REFLECT( graphene::snapshot_plugin::snapshot_chunk_header,
+            (space_id)(type_id)(objects)(size)(compressed_size) )
@@ -25,7 +25,9 @@
 
 #include <graphene/chain/database.hpp>
 
-#include <fc/io/fstream.hpp>
+#include <fc/compress/zlib.hpp>
+#include <fc/io/json.hpp>
+#include <fc/thread/thread.hpp>
 
 using namespace graphene::snapshot_plugin;
 using std::string;
@@ -36,6 +38,9 @@ namespace bpo = boost::program_options;
 static const char* OPT_BLOCK_NUM  = "snapshot-at-block";
 static const char* OPT_BLOCK_TIME = "snapshot-at-time";
 static const char* OPT_DEST       = "snapshot-to";
+static const char* OPT_FORMAT     = "snapshot-format";
+
+static const char snapshot_magic[8] = { 'G', 'R', 'P', 'H', 'S', 'N', 'A', 'P' };
 
 void snapshot_plugin::plugin_set_program_options(
    boost::program_options::options_description& command_line_options,
@@ -44,7 +49,10 @@ void snapshot_plugin::plugin_set_program_options(
    command_line_options.add_options()
          (OPT_BLOCK_NUM, bpo::value<uint32_t>(), "Block number after which to do a snapshot")
          (OPT_BLOCK_TIME, bpo::value<string>(), "Block time (ISO format) after which to do a snapshot")
-         (OPT_DEST, bpo::value<string>(), "Pathname of JSON file where to store the snapshot")
+         (OPT_DEST, bpo::value<string>(), "Pathname of the file where to store the snapshot")
+         (OPT_FORMAT, bpo::value<string>()->default_value("json"),
+          "Format of the snapshot, json (one object per line, as before) or binary (compressed chunks of packed "
+          "objects, can be read with snapshot_reader)")
          ;
    config_file_options.add(command_line_options);
 }
@@ -72,6 +80,8 @@ void snapshot_plugin::plugin_initialize(const boost::program_options::variables_
          snapshot_block = options[OPT_BLOCK_NUM].as<uint32_t>();
       if( options.count(OPT_BLOCK_TIME) > 0 )
          snapshot_time = fc::time_point_sec::from_iso_string( options[OPT_BLOCK_TIME].as<std::string>() );
+      if( options.count(OPT_FORMAT) > 0 )
+         format = fc::reflector<snapshot_format>::from_string( options[OPT_FORMAT].as<std::string>().c_str() );
       database().applied_block.connect( [&]( const graphene::chain::signed_block& b ) {
          check_snapshot( b );
       });
@@ -82,19 +92,27 @@ void snapshot_plugin::plugin_initialize(const boost::program_options::variables_
    ilog("snapshot plugin: plugin_initialize() end");
 } FC_LOG_AND_RETHROW() }
 
-static void create_snapshot( const graphene::chain::database& db, const fc::path& dest )
+void snapshot_plugin::plugin_shutdown()
 {
-   ilog("snapshot plugin: creating snapshot");
-   fc::ofstream out;
    try
    {
-      out.open( dest );
+      if( _writing.valid() )
+         _writing.wait();
    }
-   catch ( fc::exception& e )
+   catch( const fc::exception& e )
    {
-      wlog( "Failed to open snapshot destination: ${ex}", ("ex",e) );
-      return;
+      wlog( "Failed to wait for the snapshot being written: ${ex}", ("ex",e) );
    }
+   if( _thread )
+      _thread->quit();
+}
+
+std::shared_ptr<snapshot_state> graphene::snapshot_plugin::capture_snapshot( const graphene::chain::database& db )
+{
+   auto state = std::make_shared<snapshot_state>();
+   state->header.block_num = db.head_block_num();
+   state->header.block_id = db.head_block_id();
+   state->header.timestamp = db.head_block_time();
    for( uint32_t space_id = 0; space_id < 256; space_id++ )
       for( uint32_t type_id = 0; type_id < 256; type_id++ )
       {
@@ -107,12 +125,131 @@ static void create_snapshot( const graphene::chain::database& db, const fc::path
             continue;
          }
          auto& index = db.get_index( (uint8_t)space_id, (uint8_t)type_id );
-         index.inspect_all_objects( [&out]( const graphene::db::object& o ) {
-            out << fc::json::to_string( o.to_variant() ) << '\n';
+         index.inspect_all_objects( [&state]( const graphene::db::object& o ) {
+            state->objects.push_back( o.clone() );
          });
       }
+   return state;
+}
+
+static void write_chunk( std::ofstream& out, snapshot_chunk_header& chunk, string& records )
+{
+   const string compressed = fc::zlib_compress( records );
+   chunk.size = records.size();
+   chunk.compressed_size = compressed.size();
+   const auto packed = fc::raw::pack( chunk );
+   out.write( packed.data(), packed.size() );
+   out.write( compressed.data(), compressed.size() );
+   records.clear();
+   chunk.objects = 0;
+}
+
+void graphene::snapshot_plugin::write_snapshot( const snapshot_state& state, snapshot_format format,
+                                                const fc::path& dest )
+{
+   const fc::path temp = dest.string() + ".tmp";
+   std::ofstream out( temp.string(), std::ios::binary | std::ios::trunc );
+   FC_ASSERT( out, "Failed to open snapshot destination ${f}", ("f",temp) );
+
+   if( format == json )
+   {
+      for( const auto& obj : state.objects )
+         out << fc::json::to_string( obj->to_variant() ) << '\n';
+   }
+   else
+   {
+      snapshot_header header = state.header;
+      header.format = binary;
+      out.write( snapshot_magic, sizeof(snapshot_magic) );
+      const auto packed_header = fc::raw::pack( header );
+      out.write( packed_header.data(), packed_header.size() );
+
+      snapshot_chunk_header chunk;
+      string records;
+      for( const auto& obj : state.objects )
+      {
+         const graphene::db::object_id_type id = obj->id;
+         if( chunk.objects > 0 && ( chunk.space_id != id.space() || chunk.type_id != id.type()
+                                    || chunk.objects == snapshot_chunk_header::max_objects ) )
+            write_chunk( out, chunk, records );
+         chunk.space_id = id.space();
+         chunk.type_id = id.type();
+         ++chunk.objects;
+
+         const auto packed = fc::raw::pack( obj->pack() ); // with the size in front
+         records.append( packed.data(), packed.size() );
+      }
+      if( chunk.objects > 0 )
+         write_chunk( out, chunk, records );
+   }
+
    out.close();
-   ilog("snapshot plugin: created snapshot");
+   FC_ASSERT( out, "Failed to write snapshot to ${f}", ("f",temp) );
+   fc::rename( temp, dest );
+}
+
+snapshot_reader::snapshot_reader( const fc::path& file )
+   : _file( file.string(), std::ios::binary )
+{
+   FC_ASSERT( _file, "Failed to open snapshot ${f}", ("f",file) );
+
+   char magic[sizeof(snapshot_magic)];
+   FC_ASSERT( _file.read( magic, sizeof(magic) ) && std::equal( magic, magic + sizeof(magic), snapshot_magic ),
+              "${f} is not a snapshot", ("f",file) );
+
+   vector<char> packed( fc::raw::pack_size( _header ) );
+   FC_ASSERT( _file.read( packed.data(), packed.size() ), "Failed to read snapshot ${f}", ("f",file) );
+   _header = fc::raw::unpack<snapshot_header>( packed );
+   FC_ASSERT( _header.version == snapshot_header::current_version,
+              "Unsupported snapshot version ${v}", ("v",_header.version) );
+   FC_ASSERT( _header.format == binary, "Unsupported snapshot format ${f}", ("f",_header.format) );
+
+   _first_chunk = _file.tellg();
+}
+
+void snapshot_reader::rewind()
+{
+   _file.clear();
+   _file.seekg( _first_chunk );
+   _unread_size = 0;
+}
+
+bool snapshot_reader::next_chunk( snapshot_chunk_header& chunk )
+{
+   if( _unread_size > 0 )
+   {
+      _file.seekg( _unread_size, std::ios::cur );
+      _unread_size = 0;
+   }
+
+   vector<char> packed( fc::raw::pack_size( chunk ) );
+   if( !_file.read( packed.data(), packed.size() ) )
+   {
+      FC_ASSERT( _file.gcount() == 0, "Truncated snapshot" );
+      return false;
+   }
+   chunk = fc::raw::unpack<snapshot_chunk_header>( packed );
+   _unread_size = chunk.compressed_size;
+   return true;
+}
+
+vector<string> snapshot_reader::read_records()
+{
+   string compressed( _unread_size, '\0' );
+   FC_ASSERT( _file.read( &compressed[0], compressed.size() ), "Truncated snapshot" );
+   _unread_size = 0;
+   const string data = fc::zlib_decompress( compressed );
+
+   vector<string> records;
+   fc::datastream<const char*> ds( data.data(), data.size() );
+   while( ds.remaining() > 0 )
+   {
+      fc::unsigned_int size;
+      fc::raw::unpack( ds, size );
+      records.emplace_back( size.value, '\0' );
+      ds.read( &records.back()[0], size.value );
+   }
+   return records;
 }
 
 void snapshot_plugin::check_snapshot( const graphene::chain::signed_block& b )
@@ -120,7 +257,35 @@ void snapshot_plugin::check_snapshot( const graphene::chain::signed_block& b )
     uint32_t current_block = b.block_num();
     if( (last_block < snapshot_block && snapshot_block <= current_block)
            || (last_time < snapshot_time && snapshot_time <= b.timestamp) )
-       create_snapshot( database(), dest );
+    {
+       // only copying the objects blocks the application of blocks, they are written by another thread
+       ilog("snapshot plugin: copying objects");
+       std::shared_ptr<snapshot_state> state = capture_snapshot( database() );
+       if( !_thread )
+          _thread = std::make_shared<fc::thread>( "snapshot" );
+       if( _writing.valid() )
+          _writing.wait();
+       _writing = _thread->async( [state, this]() {
+          ilog("snapshot plugin: creating snapshot");
+          try
+          {
+             write_snapshot( *state, format, dest );
+             ilog("snapshot plugin: created snapshot");
+          }
+          catch( const fc::exception& e )
+          {
+             wlog( "Failed to create snapshot: ${ex}", ("ex",e) );
+          }
+          catch( const std::exception& e )
+          {
+             wlog( "Failed to create snapshot: ${ex}", ("ex",e.what()) );
+          }
+          catch( ... )
+          {
+             wlog( "Failed to create snapshot" );
+          }
+       }, "snapshot" );
+    }
     last_block = current_block;
     last_time = b.timestamp;
 } FC_LOG_AND_RETHROW() }
@@ -67,6 +67,12 @@ namespace graphene { namespace protocol {
       return signee() == expected_signee;
    }
 
+   void signed_block_header::clear_cache()
+   {
+      _signee = fc::ecc::public_key();
+      _block_id = block_id_type();
+   }
+
    const checksum_type& signed_block::calculate_merkle_root()const
    {
       static const checksum_type empty_checksum;
@@ -98,6 +104,28 @@ namespace graphene { namespace protocol {
       }
       return _calculated_merkle_root;
    }
+
+   uint64_t signed_block::get_packed_size()const
+   {
+      if( _packed_size == 0 )
+      {
+         uint64_t size = fc::raw::pack_size( static_cast<const signed_block_header&>( *this ) )
+                         + fc::raw::pack_size( fc::unsigned_int( transactions.size() ) );
+         for( const auto& trx : transactions )
+            size += trx.get_processed_packed_size();
+         _packed_size = size;
+      }
+      return _packed_size;
+   }
+
+   void signed_block::clear_cache()
+   {
+      signed_block_header::clear_cache();
+      _calculated_merkle_root = checksum_type();
+      _packed_size = 0;
+      for( auto& trx : transactions )
+         trx.clear_cache();
+   }
 } }
 
 GRAPHENE_IMPLEMENT_EXTERNAL_SERIALIZATION( graphene::protocol::block_header)
@@ -34,6 +34,40 @@ namespace graphene { namespace protocol {
    {
    }
 
+   fee_schedule::fee_schedule( const fee_schedule& other )
+      : parameters( other.parameters ), scale( other.scale )
+   {
+      update_positions();
+   }
+
+   fee_schedule::fee_schedule( fee_schedule&& other )
+      : parameters( std::move(other.parameters) ), scale( other.scale )
+   {
+      update_positions();
+   }
+
+   fee_schedule& fee_schedule::operator=( const fee_schedule& other )
+   {
+      if( &other != this )
+      {
+         parameters = other.parameters;
+         scale = other.scale;
+         update_positions();
+      }
+      return *this;
+   }
+
+   fee_schedule& fee_schedule::operator=( fee_schedule&& other )
+   {
+      if( &other != this )
+      {
+         parameters = std::move(other.parameters);
+         scale = other.scale;
+         update_positions();
+      }
+      return *this;
+   }
+
    fee_schedule fee_schedule::get_default()
    {
       fee_schedule result;
@@ -42,9 +76,33 @@ namespace graphene { namespace protocol {
          fee_parameters x; x.set_which(i);
          result.parameters.insert(x);
       }
+      result.update_positions();
       return result;
    }
 
+   void fee_schedule::update_positions()
+   {
+      _positions.assign( fee_parameters::count(), std::numeric_limits<uint16_t>::max() );
+      uint16_t position = 0;
+      for( const fee_parameters& params : parameters )
+         _positions[params.which()] = position++;
+   }
+
+   const fee_parameters* fee_schedule::find_parameters( fee_parameters::tag_type tag )const
+   {
+      if( tag >= 0 && static_cast<size_t>(tag) < _positions.size() && _positions[tag] < parameters.size() )
+      {
+         const fee_parameters& params = *parameters.nth( _positions[tag] );
+         if( params.which() == tag )
+            return &params;
+      }
+      // Parameters may have been changed directly since the table was built
+      fee_parameters key;
+      key.set_which( tag );
+      auto itr = parameters.find( key );
+      return itr != parameters.end() ? &*itr : nullptr;
+   }
+
    struct set_fee_visitor
    {
       typedef void result_type;
@@ -46,8 +46,8 @@ namespace graphene { namespace protocol {
             return op.calculate_fee( param.get<OpType>() ).value;
          } catch (fc::assert_exception& e) {
              fee_parameters params; params.set_which(current_op);
-             auto itr = param.parameters.find(params);
-             if( itr != param.parameters.end() ) params = *itr;
+             const fee_parameters* found = param.find_parameters(current_op);
+             if( found != nullptr ) params = *found;
              return op.calculate_fee( params.get<typename OpType::fee_parameters_type>() ).value;
          }
       }
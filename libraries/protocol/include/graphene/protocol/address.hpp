@@ -63,6 +63,18 @@ namespace graphene { namespace protocol {
 
 } } // namespace graphene::protocol
 
+namespace std
+{
+   template<>
+   struct hash<graphene::protocol::address>
+   {
+      size_t operator()( const graphene::protocol::address& a )const
+      {
+         return std::hash<fc::ripemd160>()( a.addr );
+      }
+   };
+}
+
 namespace fc
 {
    void to_variant( const graphene::protocol::address& var,  fc::variant& vo, uint32_t max_depth = 1 );
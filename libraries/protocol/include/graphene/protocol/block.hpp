@@ -49,6 +49,8 @@ namespace graphene { namespace protocol {
       const fc::ecc::public_key& signee()const;
       void                       sign( const fc::ecc::private_key& signer );
       bool                       validate_signee( const fc::ecc::public_key& expected_signee )const;
+      /// Forget the cached ID and signee, must be called if the header is modified after they have been calculated
+      void                       clear_cache();
 
       signature_type             blockproducer_signature;
    protected:
@@ -60,9 +62,14 @@ namespace graphene { namespace protocol {
    {
    public:
       const checksum_type& calculate_merkle_root()const;
+      /// @return the size of the packed block, calculated from the cached sizes of its transactions
+      uint64_t             get_packed_size()const;
+      /// Forget the cached values of the block and of its transactions
+      void                 clear_cache();
       vector<processed_transaction> transactions;
    protected:
       mutable checksum_type   _calculated_merkle_root;
+      mutable uint64_t        _packed_size = 0;
    };
 
 } } // graphene::protocol
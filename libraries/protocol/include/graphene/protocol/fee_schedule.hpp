@@ -24,6 +24,8 @@
 #pragma once
 #include <graphene/protocol/operations.hpp>
 
+#include <limits>
+
 namespace graphene { namespace protocol {
 
    template<typename T> struct transform_to_fee_parameters;
@@ -34,30 +36,109 @@ namespace graphene { namespace protocol {
    };
    using fee_parameters = transform_to_fee_parameters<operation>::type;
 
+   template<typename Operation> class fee_helper;
+
+   /**
+    *  @brief contains all of the parameters necessary to calculate the fee for any operation
+    */
+   struct fee_schedule
+   {
+      fee_schedule();
+      /// Copies and moves rebuild the table of positions for the parameters they receive
+      fee_schedule( const fee_schedule& other );
+      fee_schedule( fee_schedule&& other );
+      fee_schedule& operator=( const fee_schedule& other );
+      fee_schedule& operator=( fee_schedule&& other );
+
+      static fee_schedule get_default();
+
+      /**
+       *  Finds the appropriate fee parameter struct for the operation
+       *  and then calculates the appropriate fee in CORE asset.
+       */
+      asset calculate_fee( const operation& op )const;
+      /**
+       *  Finds the appropriate fee parameter struct for the operation
+       *  and then calculates the appropriate fee in an asset specified
+       *  implicitly by core_exchange_rate.
+       */
+      asset calculate_fee( const operation& op, const price& core_exchange_rate )const;
+      /**
+       *  Updates the operation with appropriate fee and returns the fee.
+       */
+      asset set_fee( operation& op, const price& core_exchange_rate = price::unit_price() )const;
+
+      void zero_all_fees();
+
+      /**
+       *  Validates all of the parameters are present and accounted for.
+       */
+      void validate()const {}
+
+      template<typename Operation>
+      const typename Operation::fee_parameters_type& get()const
+      {
+         return fee_helper<Operation>().cget(*this);
+      }
+      template<typename Operation>
+      typename Operation::fee_parameters_type& get()
+      {
+         return fee_helper<Operation>().get(*this);
+      }
+      template<typename Operation>
+      bool exists()const
+      {
+         return find<typename Operation::fee_parameters_type>() != nullptr;
+      }
+
+      /// @return the parameters of the given type, or nullptr if there are none
+      template<typename FeeParameters>
+      const FeeParameters* find()const
+      {
+         const fee_parameters* params = find_parameters( fee_parameters::tag<FeeParameters>::value );
+         return params != nullptr ? &params->template get<FeeParameters>() : nullptr;
+      }
+      /// @return the parameters with the given tag, or nullptr if there are none
+      const fee_parameters* find_parameters( fee_parameters::tag_type tag )const;
+      /// Rebuilds the table used by find_parameters(), which needs to be done after parameters were replaced
+      void update_positions();
+
+      /**
+       *  @note must be sorted by fee_parameters.which() and have no duplicates
+       */
+      fee_parameters::flat_set_type parameters;
+      uint32_t                 scale = GRAPHENE_100_PERCENT; ///< fee * scale / GRAPHENE_100_PERCENT
+      private:
+      static void set_fee_parameters(fee_schedule& sched);
+
+      /// Position in parameters of the parameters with each tag
+      std::vector<uint16_t> _positions;
+   };
+
    template<typename Operation>
    class fee_helper {
      public:
-      const typename Operation::fee_parameters_type& cget(const fee_parameters::flat_set_type& parameters)const
+      const typename Operation::fee_parameters_type& cget(const fee_schedule& schedule)const
       {
-         auto itr = parameters.find( typename Operation::fee_parameters_type() );
-         FC_ASSERT( itr != parameters.end() );
-         return itr->template get<typename Operation::fee_parameters_type>();
+         const auto* params = schedule.find<typename Operation::fee_parameters_type>();
+         FC_ASSERT( params != nullptr );
+         return *params;
       }
    };
 
    template<>
    class fee_helper<account_create_operation> {
      public:
-      const account_create_operation::fee_parameters_type& cget(const fee_parameters::flat_set_type& parameters)const
+      const account_create_operation::fee_parameters_type& cget(const fee_schedule& schedule)const
       {
-         auto itr = parameters.find( account_create_operation::fee_parameters_type() );
-         FC_ASSERT( itr != parameters.end() );
-         return itr->get<account_create_operation::fee_parameters_type>();
+         const auto* params = schedule.find<account_create_operation::fee_parameters_type>();
+         FC_ASSERT( params != nullptr );
+         return *params;
       }
-      typename account_create_operation::fee_parameters_type& get(fee_parameters::flat_set_type& parameters)const
+      typename account_create_operation::fee_parameters_type& get(fee_schedule& schedule)const
       {
-         auto itr = parameters.find( account_create_operation::fee_parameters_type() );
-         FC_ASSERT( itr != parameters.end() );
+         auto itr = schedule.parameters.find( account_create_operation::fee_parameters_type() );
+         FC_ASSERT( itr != schedule.parameters.end() );
          return itr->get<account_create_operation::fee_parameters_type>();
       }
    };
@@ -65,14 +146,14 @@ namespace graphene { namespace protocol {
    template<>
    class fee_helper<bid_collateral_operation> {
      public:
-      const bid_collateral_operation::fee_parameters_type& cget(const fee_parameters::flat_set_type& parameters)const
+      const bid_collateral_operation::fee_parameters_type& cget(const fee_schedule& schedule)const
       {
-         auto itr = parameters.find( bid_collateral_operation::fee_parameters_type() );
-         if ( itr != parameters.end() )
-            return itr->get<bid_collateral_operation::fee_parameters_type>();
+         const auto* params = schedule.find<bid_collateral_operation::fee_parameters_type>();
+         if ( params != nullptr )
+            return *params;
 
          static bid_collateral_operation::fee_parameters_type bid_collateral_dummy;
-         bid_collateral_dummy.fee = fee_helper<call_order_update_operation>().cget(parameters).fee;
+         bid_collateral_dummy.fee = fee_helper<call_order_update_operation>().cget(schedule).fee;
          return bid_collateral_dummy;
       }
    };
@@ -80,14 +161,14 @@ namespace graphene { namespace protocol {
    template<>
    class fee_helper<asset_update_issuer_operation> {
      public:
-      const asset_update_issuer_operation::fee_parameters_type& cget(const fee_parameters::flat_set_type& parameters)const
+      const asset_update_issuer_operation::fee_parameters_type& cget(const fee_schedule& schedule)const
       {
-         auto itr = parameters.find( asset_update_issuer_operation::fee_parameters_type() );
-         if ( itr != parameters.end() )
-            return itr->get<asset_update_issuer_operation::fee_parameters_type>();
+         const auto* params = schedule.find<asset_update_issuer_operation::fee_parameters_type>();
+         if ( params != nullptr )
+            return *params;
 
          static asset_update_issuer_operation::fee_parameters_type dummy;
-         dummy.fee = fee_helper<asset_update_operation>().cget(parameters).fee;
+         dummy.fee = fee_helper<asset_update_operation>().cget(schedule).fee;
          return dummy;
       }
    };
@@ -95,14 +176,14 @@ namespace graphene { namespace protocol {
    template<>
    class fee_helper<asset_claim_pool_operation> {
      public:
-      const asset_claim_pool_operation::fee_parameters_type& cget(const fee_parameters::flat_set_type& parameters)const
+      const asset_claim_pool_operation::fee_parameters_type& cget(const fee_schedule& schedule)const
       {
-         auto itr = parameters.find( asset_claim_pool_operation::fee_parameters_type() );
-         if ( itr != parameters.end() )
-            return itr->get<asset_claim_pool_operation::fee_parameters_type>();
+         const auto* params = schedule.find<asset_claim_pool_operation::fee_parameters_type>();
+         if ( params != nullptr )
+            return *params;
 
          static asset_claim_pool_operation::fee_parameters_type asset_claim_pool_dummy;
-         asset_claim_pool_dummy.fee = fee_helper<asset_fund_fee_pool_operation>().cget(parameters).fee;
+         asset_claim_pool_dummy.fee = fee_helper<asset_fund_fee_pool_operation>().cget(schedule).fee;
          return asset_claim_pool_dummy;
       }
    };
@@ -110,7 +191,7 @@ namespace graphene { namespace protocol {
    template<>
    class fee_helper<ticket_create_operation> {
      public:
-      const ticket_create_operation::fee_parameters_type& cget(const fee_parameters::flat_set_type& parameters)const
+      const ticket_create_operation::fee_parameters_type& cget(const fee_schedule& schedule)const
       {
          static ticket_create_operation::fee_parameters_type param;
          return param;
@@ -120,7 +201,7 @@ namespace graphene { namespace protocol {
    template<>
    class fee_helper<ticket_update_operation> {
      public:
-      const ticket_update_operation::fee_parameters_type& cget(const fee_parameters::flat_set_type& parameters)const
+      const ticket_update_operation::fee_parameters_type& cget(const fee_schedule& schedule)const
       {
          static ticket_update_operation::fee_parameters_type param;
          return param;
@@ -130,11 +211,11 @@ namespace graphene { namespace protocol {
    template<>
    class fee_helper<htlc_create_operation> {
      public:
-      const htlc_create_operation::fee_parameters_type& cget(const fee_parameters::flat_set_type& parameters)const
+      const htlc_create_operation::fee_parameters_type& cget(const fee_schedule& schedule)const
       {
-         auto itr = parameters.find( htlc_create_operation::fee_parameters_type() );
-         if ( itr != parameters.end() )
-            return itr->get<htlc_create_operation::fee_parameters_type>();
+         const auto* params = schedule.find<htlc_create_operation::fee_parameters_type>();
+         if ( params != nullptr )
+            return *params;
 
          static htlc_create_operation::fee_parameters_type htlc_create_operation_fee_dummy;
          return htlc_create_operation_fee_dummy;
@@ -144,11 +225,11 @@ namespace graphene { namespace protocol {
    template<>
    class fee_helper<htlc_redeem_operation> {
      public:
-      const htlc_redeem_operation::fee_parameters_type& cget(const fee_parameters::flat_set_type& parameters)const
+      const htlc_redeem_operation::fee_parameters_type& cget(const fee_schedule& schedule)const
       {
-         auto itr = parameters.find( htlc_redeem_operation::fee_parameters_type() );
-         if ( itr != parameters.end() )
-            return itr->get<htlc_redeem_operation::fee_parameters_type>();
+         const auto* params = schedule.find<htlc_redeem_operation::fee_parameters_type>();
+         if ( params != nullptr )
+            return *params;
 
          static htlc_redeem_operation::fee_parameters_type htlc_redeem_operation_fee_dummy;
          return htlc_redeem_operation_fee_dummy;
@@ -157,74 +238,16 @@ namespace graphene { namespace protocol {
    template<>
    class fee_helper<htlc_extend_operation> {
      public:
-      const htlc_extend_operation::fee_parameters_type& cget(const fee_parameters::flat_set_type& parameters)const
+      const htlc_extend_operation::fee_parameters_type& cget(const fee_schedule& schedule)const
       {
-         auto itr = parameters.find( htlc_extend_operation::fee_parameters_type() );
-         if ( itr != parameters.end() )
-            return itr->get<htlc_extend_operation::fee_parameters_type>();
+         const auto* params = schedule.find<htlc_extend_operation::fee_parameters_type>();
+         if ( params != nullptr )
+            return *params;
 
          static htlc_extend_operation::fee_parameters_type htlc_extend_operation_fee_dummy;
          return htlc_extend_operation_fee_dummy;
       }
    };
-   /**
-    *  @brief contains all of the parameters necessary to calculate the fee for any operation
-    */
-   struct fee_schedule
-   {
-      fee_schedule();
-
-      static fee_schedule get_default();
-
-      /**
-       *  Finds the appropriate fee parameter struct for the operation
-       *  and then calculates the appropriate fee in CORE asset.
-       */
-      asset calculate_fee( const operation& op )const;
-      /**
-       *  Finds the appropriate fee parameter struct for the operation
-       *  and then calculates the appropriate fee in an asset specified
-       *  implicitly by core_exchange_rate.
-       */
-      asset calculate_fee( const operation& op, const price& core_exchange_rate )const;
-      /**
-       *  Updates the operation with appropriate fee and returns the fee.
-       */
-      asset set_fee( operation& op, const price& core_exchange_rate = price::unit_price() )const;
-
-      void zero_all_fees();
-
-      /**
-       *  Validates all of the parameters are present and accounted for.
-       */
-      void validate()const {}
-
-      template<typename Operation>
-      const typename Operation::fee_parameters_type& get()const
-      {
-         return fee_helper<Operation>().cget(parameters);
-      }
-      template<typename Operation>
-      typename Operation::fee_parameters_type& get()
-      {
-         return fee_helper<Operation>().get(parameters);
-      }
-      template<typename Operation>
-      bool exists()const
-      {
-         auto itr = parameters.find(typename Operation::fee_parameters_type());
-         return itr != parameters.end();
-      }
-
-      /**
-       *  @note must be sorted by fee_parameters.which() and have no duplicates
-       */
-      fee_parameters::flat_set_type parameters;
-      uint32_t                 scale = GRAPHENE_100_PERCENT; ///< fee * scale / GRAPHENE_100_PERCENT
-      private:
-      static void set_fee_parameters(fee_schedule& sched);
-   };
-
    typedef fee_schedule fee_schedule_type;
 
 } } // graphene::protocol
@@ -124,7 +124,7 @@ namespace graphene { namespace protocol {
 
    protected:
       // Calculate the digest used for signature validation
-      digest_type sig_digest( const chain_id_type& chain_id )const;
+      virtual digest_type sig_digest( const chain_id_type& chain_id )const;
       mutable transaction_id_type _tx_id_buffer;
    };
 
@@ -241,9 +241,43 @@ namespace graphene { namespace protocol {
       virtual void                             validate()const override;
       virtual const flat_set<public_key_type>& get_signature_keys( const chain_id_type& chain_id )const override;
       virtual uint64_t                         get_packed_size()const override;
+
+      /**
+       * @brief Get the hash of the packed @ref signed_transaction part of this transaction.
+       * @return The RIPEMD-160 hash, which is also the ID of the p2p message carrying this transaction
+       * @note The hash is calculated on the first call and then cached in @ref _message_id.
+       */
+      const fc::ripemd160&                     get_message_id()const;
+      /**
+       * @brief Set the cached message ID when it is already known, E.G. when this transaction was
+       *        unpacked from a p2p message whose ID has been calculated.
+       * @param message_id The RIPEMD-160 hash of the packed @ref signed_transaction part of this transaction
+       */
+      void                                     set_message_id( const fc::ripemd160& message_id )const
+      { _message_id = message_id; }
+
+      /**
+       * @brief Get the packed @ref signed_transaction part of this transaction.
+       * @note The transaction is packed on the first call and the bytes are cached. The ID, the packed sizes, the
+       *       message ID and the digest for signature validation are all calculated from these bytes, so that the
+       *       transaction is packed only once. Copies of this transaction share the cached bytes.
+       */
+      const vector<char>&                      get_packed_signed_transaction()const;
+      /// @return the size of the packed @ref signed_transaction part of this transaction, i.e. with signatures
+      uint64_t                                 get_signed_packed_size()const;
+
+      /**
+       * @brief Forget all cached values.
+       * @note Must be called if this transaction is modified after any cached value has been calculated.
+       */
+      virtual void                             clear_cache();
    protected:
+      virtual digest_type sig_digest( const chain_id_type& chain_id )const override;
+
       mutable bool _validated = false;
       mutable uint64_t _packed_size = 0;
+      mutable fc::ripemd160 _message_id;
+      mutable std::shared_ptr<const vector<char>> _packed_signed_transaction;
    };
 
    /**
@@ -297,7 +331,15 @@ namespace graphene { namespace protocol {
 
       vector<operation_result> operation_results;
 
-      digest_type merkle_digest()const;
+      /// @return the digest of this transaction in the merkle tree of its block, cached after the first call
+      const digest_type& merkle_digest()const;
+      /// @return the size of this transaction packed with its operation results, cached after the first call
+      uint64_t           get_processed_packed_size()const;
+
+      virtual void       clear_cache() override;
+   protected:
+      mutable digest_type _merkle_digest;
+      mutable uint64_t    _processed_packed_size = 0;
    };
 
    /// @} transactions group
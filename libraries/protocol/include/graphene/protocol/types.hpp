@@ -27,6 +27,7 @@
 #include <vector>
 #include <deque>
 #include <cstdint>
+#include <cstring>
 
 #include <boost/preprocessor/seq/for_each.hpp>
 #include <boost/preprocessor/seq/transform.hpp>
@@ -276,6 +277,21 @@ public:
 struct fee_schedule;
 } }  // graphene::protocol
 
+namespace std
+{
+   template<>
+   struct hash<graphene::protocol::public_key_type>
+   {
+      size_t operator()( const graphene::protocol::public_key_type& k )const
+      {
+         // skip the first byte of the compressed key, which only tells the parity of y
+         size_t s;
+         std::memcpy( (char*)&s, k.key_data.data() + 1, sizeof(s) );
+         return s;
+      }
+   };
+}
+
 namespace fc {
 void to_variant(const graphene::protocol::public_key_type& var,  fc::variant& vo, uint32_t max_depth = 2);
 void from_variant(const fc::variant& var,  graphene::protocol::public_key_type& vo, uint32_t max_depth = 2);
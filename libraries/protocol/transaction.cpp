@@ -33,11 +33,31 @@
 
 namespace graphene { namespace protocol {
 
-digest_type processed_transaction::merkle_digest()const
+const digest_type& processed_transaction::merkle_digest()const
 {
-   digest_type::encoder enc;
-   fc::raw::pack( enc, *this );
-   return enc.result();
+   if( !_merkle_digest._hash[0].value() )
+   {
+      const vector<char>& packed = get_packed_signed_transaction();
+      digest_type::encoder enc;
+      enc.write( packed.data(), packed.size() );
+      fc::raw::pack( enc, operation_results );
+      _merkle_digest = enc.result();
+   }
+   return _merkle_digest;
+}
+
+uint64_t processed_transaction::get_processed_packed_size()const
+{
+   if( _processed_packed_size == 0 )
+      _processed_packed_size = get_signed_packed_size() + fc::raw::pack_size( operation_results );
+   return _processed_packed_size;
+}
+
+void processed_transaction::clear_cache()
+{
+   precomputable_transaction::clear_cache();
+   _merkle_digest = digest_type();
+   _processed_packed_size = 0;
 }
 
 digest_type transaction::digest()const
@@ -434,7 +454,11 @@ set<public_key_type> signed_transaction::minimize_required_signatures(
 const transaction_id_type& precomputable_transaction::id()const
 {
    if( !_tx_id_buffer._hash[0].value() )
-      transaction::id();
+   {
+      const vector<char>& packed = get_packed_signed_transaction();
+      auto h = digest_type::hash( packed.data(), _packed_size );
+      memcpy(_tx_id_buffer._hash, h._hash, std::min(sizeof(_tx_id_buffer), sizeof(h)));
+   }
    return _tx_id_buffer;
 }
 
@@ -448,10 +472,51 @@ void precomputable_transaction::validate() const
 uint64_t precomputable_transaction::get_packed_size()const
 {
    if( _packed_size == 0 )
-      _packed_size = transaction::get_packed_size();
+      get_packed_signed_transaction();
    return _packed_size;
 }
 
+uint64_t precomputable_transaction::get_signed_packed_size()const
+{
+   return get_packed_signed_transaction().size();
+}
+
+const vector<char>& precomputable_transaction::get_packed_signed_transaction()const
+{
+   if( !_packed_signed_transaction )
+   {
+      // Pack the transaction part first to learn its size, then append the signatures
+      auto packed = std::make_shared<vector<char>>( fc::raw::pack( static_cast<const transaction&>( *this ) ) );
+      _packed_size = packed->size();
+      const vector<char> packed_signatures = fc::raw::pack( signatures );
+      packed->insert( packed->end(), packed_signatures.begin(), packed_signatures.end() );
+      _packed_signed_transaction = std::move( packed );
+   }
+   return *_packed_signed_transaction;
+}
+
+digest_type precomputable_transaction::sig_digest( const chain_id_type& chain_id )const
+{
+   // This is also used for signing, so the bytes are not packed and cached here, as they would miss the signature
+   if( !_packed_signed_transaction )
+      return transaction::sig_digest( chain_id );
+   const vector<char>& packed = *_packed_signed_transaction;
+   digest_type::encoder enc;
+   fc::raw::pack( enc, chain_id );
+   enc.write( packed.data(), _packed_size );
+   return enc.result();
+}
+
+const fc::ripemd160& precomputable_transaction::get_message_id()const
+{
+   if( _message_id == fc::ripemd160() )
+   {
+      const vector<char>& packed = get_packed_signed_transaction();
+      _message_id = fc::ripemd160::hash( packed.data(), packed.size() );
+   }
+   return _message_id;
+}
+
 const flat_set<public_key_type>& precomputable_transaction::get_signature_keys( const chain_id_type& chain_id )const
 {
    // Strictly we should check whether the given chain ID is same as the one used to initialize the `signees` field.
@@ -461,6 +526,16 @@ const flat_set<public_key_type>& precomputable_transaction::get_signature_keys(
    return _signees;
 }
 
+void precomputable_transaction::clear_cache()
+{
+   _tx_id_buffer = transaction_id_type();
+   _signees.clear();
+   _validated = false;
+   _packed_size = 0;
+   _message_id = fc::ripemd160();
+   _packed_signed_transaction.reset();
+}
+
 void signed_transaction::verify_authority( const chain_id_type& chain_id,
                                            const std::function<const authority*(account_id_type)>& get_active,
                                            const std::function<const authority*(account_id_type)>& get_owner,
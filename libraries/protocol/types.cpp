@@ -109,7 +109,9 @@ namespace fc
         if (!vo) vo = std::make_shared<const graphene::protocol::fee_schedule>();
         // Convert the non-const shared_ptr<const fee_schedule> to a non-const fee_schedule& so we can write it
         // Don't decrement max_depth since we're not actually deserializing at this step
-        from_variant(var, const_cast<graphene::protocol::fee_schedule&>(*vo), max_depth);
+        auto& fees = const_cast<graphene::protocol::fee_schedule&>(*vo);
+        from_variant(var, fees, max_depth);
+        fees.update_positions();
     }
 
 namespace raw {
@@ -63,9 +63,7 @@ namespace buf = boost::unit_test::framework;
 
 void clearable_block::clear()
 {
-   _calculated_merkle_root = checksum_type();
-   _signee = fc::ecc::public_key();
-   _block_id = block_id_type();
+   clear_cache();
 }
 
 database_fixture_base::database_fixture_base()
@@ -210,6 +208,19 @@ std::shared_ptr<boost::program_options::variables_map> database_fixture_base::in
       fc::set_option( options, "max-ops-per-account", (uint64_t)125 );
       fc::set_option( options, "api-limit-get-account-history", (uint64_t)250 );
    }
+   if(fixture.current_test_name =="get_account_history_from_store"
+         || fixture.current_test_name =="get_account_history_operations_from_store")
+   {
+      fc::set_option( options, "history-store-dir", boost::filesystem::path(fixture.data_dir.path() / "history") );
+   }
+   if(fixture.current_test_name =="get_market_history_from_store")
+   {
+      fc::set_option( options, "market-history-store-dir",
+                      boost::filesystem::path(fixture.data_dir.path() / "market_history") );
+      fc::set_option( options, "max-order-his-records-per-market", (uint32_t)2 );
+      fc::set_option( options, "max-order-his-seconds-per-market", (uint32_t)1 );
+      fc::set_option( options, "history-per-size", (uint32_t)2 );
+   }
    if(fixture.current_test_name =="api_limit_get_grouped_limit_orders")
    {
       fc::set_option( options, "api-limit-get-grouped-limit-orders", (uint64_t)250 );
@@ -331,12 +342,16 @@ std::shared_ptr<boost::program_options::variables_map> database_fixture_base::in
    // load ES or AH, but not both
    if(fixture.current_test_name == "elasticsearch_account_history" ||
          fixture.current_test_name == "elasticsearch_suite" ||
-         fixture.current_test_name == "elasticsearch_history_api") {
+         fixture.current_test_name == "elasticsearch_history_api" ||
+         fixture.current_test_name == "elasticsearch_replay_benchmark") {
       fixture.app.register_plugin<graphene::elasticsearch::elasticsearch_plugin>(true);
 
       fc::set_option( options, "elasticsearch-node-url", GRAPHENE_TESTING_ES_URL );
-      fc::set_option( options, "elasticsearch-bulk-replay", uint32_t(2) );
-      fc::set_option( options, "elasticsearch-bulk-sync", uint32_t(2) );
+      if( fixture.current_test_name != "elasticsearch_replay_benchmark" ) // the benchmark uses the default sizes
+      {
+         fc::set_option( options, "elasticsearch-bulk-replay", uint32_t(2) );
+         fc::set_option( options, "elasticsearch-bulk-sync", uint32_t(2) );
+      }
       fc::set_option( options, "elasticsearch-start-es-after-block", uint32_t(0) );
       fc::set_option( options, "elasticsearch-visitor", false );
       fc::set_option( options, "elasticsearch-operation-object", true );
@@ -380,10 +395,15 @@ std::shared_ptr<boost::program_options::variables_map> database_fixture_base::in
    }
 
    if(fixture.current_test_name == "custom_operations_account_storage_map_test" ||
-      fixture.current_test_name == "custom_operations_account_storage_list_test") {
+      fixture.current_test_name == "custom_operations_account_storage_list_test" ||
+      fixture.current_test_name == "custom_operations_account_storage_catalog_test") {
       fixture.app.register_plugin<graphene::custom_operations::custom_operations_plugin>(true);
       fc::set_option( options, "custom-operations-start-block", uint32_t(1) );
    }
+   if(fixture.current_test_name == "custom_operations_account_storage_catalog_test") {
+      fc::set_option( options, "custom-operations-catalog-index", true );
+      fc::set_option( options, "api-limit-get-storage-info", uint64_t(2) );
+   }
 
    fc::set_option( options, "bucket-size", string("[15]") );
 
@@ -455,8 +475,8 @@ void database_fixture_base::verify_asset_supplies( const database& db )
    const asset_dynamic_data_object& core_asset_data = db.get_core_asset().dynamic_asset_data_id(db);
    BOOST_CHECK(core_asset_data.fee_pool == 0);
 
-   const auto& statistics_index = db.get_index_type<account_stats_index>().indices();
-   const auto& acct_balance_index = db.get_index_type<account_balance_index>().indices();
+   const auto& statistics_index = db.get_index_type<account_stats_index>();
+   const auto& acct_balance_index = db.get_index_type<account_balance_index>();
    const auto& settle_index = db.get_index_type<force_settlement_index>().indices();
    const auto& bids = db.get_index_type<collateral_bid_index>().indices();
    map<asset_id_type,share_type> total_balances;
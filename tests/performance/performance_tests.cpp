@@ -28,18 +28,42 @@
 
 #include <graphene/chain/account_object.hpp>
 #include <graphene/chain/asset_object.hpp>
+#include <graphene/chain/operation_history_object.hpp>
 #include <graphene/chain/proposal_object.hpp>
 
+#include <graphene/db/dense_index.hpp>
 #include <graphene/db/simple_index.hpp>
 
+#include <graphene/grouped_orders/grouped_orders_plugin.hpp>
+
+#include <graphene/net/peer_connection.hpp>
+
+#include <graphene/utilities/elasticsearch.hpp>
+#include <graphene/utilities/tempdir.hpp>
+
 #include <fc/crypto/digest.hpp>
 
 #include "../common/database_fixture.hpp"
 #include <cstdlib>
 #include <iostream>
+#include <random>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
 
 using namespace graphene::chain;
 
+/// @return the number of bytes allocated on the heap, or 0 if that can not be told on this platform
+static uint64_t heap_usage()
+{
+#if defined(__GLIBC__) && ( __GLIBC__ > 2 || ( __GLIBC__ == 2 && __GLIBC_MINOR__ >= 33 ) )
+   return mallinfo2().uordblks;
+#else
+   return 0;
+#endif
+}
+
 BOOST_FIXTURE_TEST_SUITE( performance_tests, database_fixture )
 
 BOOST_AUTO_TEST_CASE( sigcheck_benchmark )
@@ -208,4 +232,610 @@ BOOST_AUTO_TEST_CASE( one_hundred_k_benchmark )
    db._undo_db.enable();
 } FC_LOG_AND_RETHROW() }
 
+BOOST_AUTO_TEST_CASE( inventory_bookkeeping_benchmark )
+{ try {
+   using graphene::net::item_id;
+   using graphene::net::peer_connection;
+   using graphene::net::rolling_bloom_filter;
+
+   // 1000 transactions per second for 20 seconds, each advertised to us by one of 100 peers,
+   // then advertised by us to all other peers
+   const uint32_t peers = 100;
+   const uint32_t items = 20000;
+   std::vector<item_id> inventory;
+   inventory.reserve( items );
+   for( uint32_t i = 0; i < items; ++i )
+      inventory.emplace_back( graphene::net::trx_message_type, fc::ripemd160::hash( fc::to_string(i) ) );
+
+   {
+      std::vector<peer_connection::timestamped_items_set_type> advertised_to_us( peers );
+      std::vector<peer_connection::timestamped_items_set_type> advertised_to_peer( peers );
+      auto start = fc::time_point::now();
+      for( uint32_t i = 0; i < items; ++i )
+      {
+         const fc::time_point_sec now = start + fc::milliseconds( i );
+         advertised_to_us[ i % peers ].insert( peer_connection::timestamped_item_id( inventory[i], now ) );
+         for( uint32_t p = 0; p < peers; ++p )
+            if( advertised_to_us[p].find( inventory[i] ) == advertised_to_us[p].end()
+                  && advertised_to_peer[p].find( inventory[i] ) == advertised_to_peer[p].end() )
+               advertised_to_peer[p].insert( peer_connection::timestamped_item_id( inventory[i], now ) );
+      }
+      auto elapsed = fc::time_point::now() - start;
+      wlog( "Benchmark: multi_index inventory bookkeeping for ${p} peers and ${n} items took ${t}ms, "
+            "${e} entries of at least ${s} bytes each",
+            ("p",peers)("n",items)("t",elapsed.count()/1000)
+            ("e",items * peers)("s",sizeof(peer_connection::timestamped_item_id)) );
+   }
+
+   {
+      const rolling_bloom_filter empty_filter( GRAPHENE_NET_INVENTORY_FILTER_ITEMS_PER_GENERATION,
+                                               GRAPHENE_NET_INVENTORY_FILTER_FALSE_POSITIVE_RATE,
+                                               fc::minutes(GRAPHENE_NET_MAX_INVENTORY_SIZE_IN_MINUTES) );
+      std::vector<rolling_bloom_filter> advertised_to_us( peers, empty_filter );
+      std::vector<rolling_bloom_filter> advertised_to_peer( peers, empty_filter );
+      uint64_t false_positives = 0;
+      auto start = fc::time_point::now();
+      for( uint32_t i = 0; i < items; ++i )
+      {
+         const fc::time_point now = start + fc::milliseconds( i );
+         advertised_to_us[ i % peers ].insert( inventory[i], now );
+         for( uint32_t p = 0; p < peers; ++p )
+         {
+            if( !advertised_to_us[p].contains( inventory[i] ) && !advertised_to_peer[p].contains( inventory[i] ) )
+               advertised_to_peer[p].insert( inventory[i], now );
+            else if( p != i % peers )
+               ++false_positives;
+         }
+      }
+      auto elapsed = fc::time_point::now() - start;
+      size_t memory = 0;
+      for( uint32_t p = 0; p < peers; ++p )
+         memory += advertised_to_us[p].memory_usage() + advertised_to_peer[p].memory_usage();
+      wlog( "Benchmark: rolling bloom filter inventory bookkeeping for ${p} peers and ${n} items took ${t}ms, "
+            "using ${m} bytes, at most ${x} bytes, with ${f} false positives",
+            ("p",peers)("n",items)("t",elapsed.count()/1000)
+            ("m",memory)("x",2 * peers * empty_filter.max_memory_usage())("f",false_positives) );
+      uint64_t total_size = 0;
+      for( uint32_t p = 0; p < peers; ++p )
+         total_size += advertised_to_us[p].size() + advertised_to_peer[p].size();
+      BOOST_CHECK_EQUAL( total_size + false_positives, uint64_t(items) * peers );
+   }
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( operation_copy_benchmark )
+{ try {
+   const uint32_t cycles = 100000;
+   const uint32_t ops_per_trx = 10;
+
+   transfer_operation transfer;
+   transfer.from = account_id_type(1);
+   transfer.to = account_id_type(2);
+   transfer.amount = asset( 1000 );
+   signed_transaction trx;
+   for( uint32_t i = 0; i < ops_per_trx; ++i )
+      trx.operations.push_back( transfer );
+
+   std::vector<operation_history_object> history( cycles );
+   for( uint32_t i = 0; i < cycles; ++i )
+   {
+      history[i].op = transfer;
+      history[i].result = void_result();
+   }
+
+   wlog( "Benchmark: sizeof(operation) is ${o}, sizeof(operation_history_object) is ${h}",
+         ("o",sizeof(operation))("h",sizeof(operation_history_object)) );
+
+   {
+      uint64_t total_ops = 0;
+      auto start = fc::time_point::now();
+      for( uint32_t i = 0; i < cycles; ++i )
+      {
+         signed_transaction copy( trx );
+         total_ops += copy.operations.size();
+      }
+      auto elapsed = fc::time_point::now() - start;
+      BOOST_CHECK_EQUAL( total_ops, uint64_t(cycles) * ops_per_trx );
+      wlog( "Benchmark: ${n} copies of a transaction with ${o} operations took ${t}ms, ${r} operations/s",
+            ("n",cycles)("o",ops_per_trx)("t",elapsed.count()/1000)
+            ("r",(total_ops*1000000)/elapsed.count()) );
+   }
+
+   {
+      auto start = fc::time_point::now();
+      std::vector<operation_history_object> copy( history );
+      auto elapsed = fc::time_point::now() - start;
+      BOOST_CHECK_EQUAL( copy.size(), history.size() );
+      wlog( "Benchmark: copying ${n} operation history objects took ${t}ms",
+            ("n",cycles)("t",elapsed.count()/1000) );
+   }
+} FC_LOG_AND_RETHROW() }
+
+struct fee_payer_visitor
+{
+   typedef account_id_type result_type;
+   template<typename T>
+   account_id_type operator()( const T& o )const { return o.fee_payer(); }
+};
+
+BOOST_AUTO_TEST_CASE( operation_dispatch_benchmark )
+{ try {
+   const uint32_t cycles = 1000000;
+   const uint32_t trx_per_block = 1000;
+   const uint32_t ops_per_trx = 10;
+   const uint32_t blocks = 100;
+
+   transfer_operation transfer;
+   transfer.from = account_id_type(1);
+   transfer.to = account_id_type(2);
+   transfer.amount = asset( 1000 );
+   const operation op = transfer;
+
+   {
+      uint64_t sum = 0;
+      auto start = fc::time_point::now();
+      for( uint32_t i = 0; i < cycles; ++i )
+         sum += op.visit( fee_payer_visitor() ).instance.value;
+      auto elapsed = fc::time_point::now() - start;
+      BOOST_CHECK_EQUAL( sum, uint64_t(cycles) );
+      wlog( "Benchmark: ${n} operation visits took ${t}ms", ("n",cycles)("t",elapsed.count()/1000) );
+   }
+
+   signed_block block;
+   signed_transaction trx;
+   for( uint32_t i = 0; i < ops_per_trx; ++i )
+      trx.operations.push_back( op );
+   block.transactions.resize( trx_per_block, processed_transaction( trx ) );
+
+   {
+      std::vector<char> packed;
+      auto start = fc::time_point::now();
+      for( uint32_t i = 0; i < blocks; ++i )
+         packed = fc::raw::pack( block );
+      auto pack_elapsed = fc::time_point::now() - start;
+
+      signed_block unpacked;
+      start = fc::time_point::now();
+      for( uint32_t i = 0; i < blocks; ++i )
+         unpacked = fc::raw::unpack<signed_block>( packed );
+      auto unpack_elapsed = fc::time_point::now() - start;
+      BOOST_CHECK_EQUAL( unpacked.transactions.size(), trx_per_block );
+      wlog( "Benchmark: packing ${n} blocks of ${o} operations took ${p}ms, unpacking them took ${u}ms",
+            ("n",blocks)("o",trx_per_block * ops_per_trx)
+            ("p",pack_elapsed.count()/1000)("u",unpack_elapsed.count()/1000) );
+   }
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( dense_index_benchmark )
+{ try {
+   typedef graphene::db::generic_index< account_balance_object, multi_index_container<
+      account_balance_object,
+      indexed_by<
+         ordered_unique< tag<by_id>, member< object, object_id_type, &object::id > >,
+         ordered_non_unique< tag<by_maintenance_flag>,
+                             member< account_balance_object, bool, &account_balance_object::maintenance_flag > >
+      >
+   > > tree_balance_index;
+   typedef graphene::db::dense_index< account_balance_object, multi_index_container<
+      account_balance_object*,
+      indexed_by<
+         ordered_non_unique< tag<by_maintenance_flag>,
+                             member< account_balance_object, bool, &account_balance_object::maintenance_flag > >
+      >
+   > > dense_balance_index;
+
+   const uint32_t objects = 1000000;
+   const uint32_t lookups = 10000000;
+
+   auto run = [objects,lookups]( graphene::db::index& idx, const char* name ) {
+      auto start = fc::time_point::now();
+      for( uint32_t i = 0; i < objects; ++i )
+         idx.create( [i]( object& o ) {
+            static_cast<account_balance_object&>( o ).owner = account_id_type( i );
+         });
+      auto create_elapsed = fc::time_point::now() - start;
+
+      // a cheap pseudo-random sequence of ids, to defeat the prefetcher
+      uint64_t sum = 0;
+      start = fc::time_point::now();
+      for( uint64_t i = 0; i < lookups; ++i )
+         sum += static_cast<const account_balance_object*>(
+                   idx.find( account_balance_id_type( (i * 7919) % objects ) ) )->owner.instance.value;
+      auto get_elapsed = fc::time_point::now() - start;
+
+      start = fc::time_point::now();
+      for( uint64_t i = 0; i < objects; ++i )
+         idx.modify( *idx.find( account_balance_id_type( (i * 7919) % objects ) ), []( object& o ) {
+            static_cast<account_balance_object&>( o ).balance += 1;
+         });
+      auto modify_elapsed = fc::time_point::now() - start;
+
+      wlog( "Benchmark: ${name} account balances: ${n} creates took ${c}ms, ${l} lookups took ${g}ms, "
+            "${n} modifications took ${m}ms (checksum ${s})",
+            ("name",name)("n",objects)("l",lookups)("c",create_elapsed.count()/1000)
+            ("g",get_elapsed.count()/1000)("m",modify_elapsed.count()/1000)("s",sum) );
+   };
+
+   {
+      graphene::db::primary_index< tree_balance_index > tree( db );
+      run( tree, "generic_index" );
+   }
+   {
+      graphene::db::primary_index< dense_balance_index > dense( db );
+      run( dense, "dense_index" );
+   }
+
+   // the account statistics in the database, through the dense index of the chain
+   const uint32_t accounts = 100000;
+   const auto& stats_idx = db.get_index_type< account_stats_index >();
+   const uint64_t first = stats_idx.size();
+   for( uint32_t i = 0; i < accounts; ++i )
+      db.create<account_statistics_object>( [i]( account_statistics_object& s ) {
+         s.owner = account_id_type( i );
+         s.name = "account" + fc::to_string( i );
+      });
+   {
+      uint64_t sum = 0;
+      auto start = fc::time_point::now();
+      for( uint64_t i = 0; i < lookups; ++i )
+         sum += db.get( account_statistics_id_type( first + (i * 7919) % accounts ) ).total_ops;
+      auto elapsed = fc::time_point::now() - start;
+      wlog( "Benchmark: ${l} lookups of ${n} account statistics took ${t}ms (checksum ${s})",
+            ("l",lookups)("n",accounts)("t",elapsed.count()/1000)("s",sum) );
+   }
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( block_pipeline_cache_benchmark )
+{ try {
+   const uint32_t trx_per_block = 1000;
+   const uint32_t ops_per_trx = 10;
+   const uint32_t blocks = 20;
+   const chain_id_type& chain_id = db.get_chain_id();
+   const auto key = fc::ecc::private_key::regenerate( fc::sha256::hash( string("key") ) );
+
+   signed_block block;
+   for( uint32_t i = 0; i < trx_per_block; ++i )
+   {
+      signed_transaction trx;
+      for( uint32_t j = 0; j < ops_per_trx; ++j )
+      {
+         transfer_operation transfer;
+         transfer.from = account_id_type(1);
+         transfer.to = account_id_type(2);
+         transfer.amount = asset( i * ops_per_trx + j );
+         trx.operations.push_back( transfer );
+      }
+      trx.sign( key, chain_id );
+      block.transactions.emplace_back( trx );
+      block.transactions.back().operation_results.resize( ops_per_trx );
+   }
+
+   // What a block goes through from the p2p layer to being applied: the ID of the message carrying each
+   // transaction, the transaction size and ID, the merkle root and the block size
+   uint64_t sum = 0;
+   auto start = fc::time_point::now();
+   for( uint32_t i = 0; i < blocks; ++i )
+   {
+      for( const auto& trx : block.transactions )
+      {
+         const signed_transaction& strx = trx;
+         sum += fc::ripemd160::hash( fc::raw::pack( strx ) )._hash[0].value();
+         sum += fc::raw::pack_size( static_cast<const transaction&>( trx ) );
+         sum += trx.digest()._hash[0].value();
+         sum += digest_type::hash( trx )._hash[0].value();
+      }
+      sum += fc::raw::pack_size( block );
+   }
+   auto uncached_elapsed = fc::time_point::now() - start;
+
+   start = fc::time_point::now();
+   for( uint32_t i = 0; i < blocks; ++i )
+   {
+      block.clear_cache();
+      for( const auto& trx : block.transactions )
+      {
+         sum += trx.get_message_id()._hash[0].value();
+         sum += trx.get_packed_size();
+         sum += trx.id()._hash[0].value();
+         sum += trx.merkle_digest()._hash[0].value();
+      }
+      sum += block.get_packed_size();
+   }
+   auto cached_elapsed = fc::time_point::now() - start;
+
+   wlog( "Benchmark: hashing and sizing ${n} blocks of ${t} transactions took ${u}ms packing each time, "
+         "${c}ms packing each transaction once (checksum ${s})",
+         ("n",blocks)("t",trx_per_block)("u",uncached_elapsed.count()/1000)("c",cached_elapsed.count()/1000)
+         ("s",sum) );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( account_lookup_benchmark )
+{ try {
+   const uint32_t accounts = 1000000;
+   const uint32_t lookups = 1000000;
+
+   std::mt19937 rng( 42 );
+   vector<account_object> objects( accounts );
+   vector<public_key_type> keys( accounts );
+   for( uint32_t i = 0; i < accounts; ++i )
+   {
+      objects[i].id = account_id_type( i );
+      objects[i].name = "account-" + fc::to_string( rng() ) + "-" + fc::to_string( i );
+      fc::ecc::public_key_data data;
+      for( auto& c : data )
+         c = static_cast<unsigned char>( rng() );
+      keys[i] = public_key_type( data );
+   }
+
+   auto report = [accounts,lookups]( const char* what, uint64_t memory, fc::microseconds insert_time,
+                                     fc::microseconds lookup_time, uint64_t sum ) {
+      wlog( "Benchmark: ${w}: ${n} inserts took ${i}ms, ${l} lookups took ${t}ms, using ${m} bytes (checksum ${s})",
+            ("w",what)("n",accounts)("l",lookups)("i",insert_time.count()/1000)("t",lookup_time.count()/1000)
+            ("m",memory)("s",sum) );
+   };
+
+   {
+      const uint64_t heap_before = heap_usage();
+      auto start = fc::time_point::now();
+      std::map< public_key_type, std::set<account_id_type>, pubkey_comparator > references;
+      for( uint32_t i = 0; i < accounts; ++i )
+         references[ keys[i] ].insert( objects[i].get_id() );
+      auto insert_elapsed = fc::time_point::now() - start;
+      const uint64_t memory = heap_usage() - heap_before;
+      uint64_t sum = 0;
+      start = fc::time_point::now();
+      for( uint32_t i = 0; i < lookups; ++i )
+         sum += references.find( keys[ (i * 7919) % accounts ] )->second.begin()->instance.value;
+      report( "map of key references", memory, insert_elapsed, fc::time_point::now() - start, sum );
+   }
+   {
+      const uint64_t heap_before = heap_usage();
+      auto start = fc::time_point::now();
+      account_reference_table< public_key_type > references;
+      for( uint32_t i = 0; i < accounts; ++i )
+         references.insert( keys[i], objects[i].get_id() );
+      auto insert_elapsed = fc::time_point::now() - start;
+      const uint64_t memory = heap_usage() - heap_before;
+      uint64_t sum = 0;
+      start = fc::time_point::now();
+      for( uint32_t i = 0; i < lookups; ++i )
+         sum += references.find( keys[ (i * 7919) % accounts ] )->begin()->instance.value;
+      report( "hashed table of key references", memory, insert_elapsed, fc::time_point::now() - start, sum );
+   }
+
+   {
+      // account_name_index is kept next to the by_name index of account_index, which stays in place, so the
+      // names are indexed twice and the memory of both is reported
+      typedef multi_index_container< pair<string, account_id_type>, indexed_by<
+         ordered_unique< member< pair<string, account_id_type>, string, &pair<string, account_id_type>::first > >
+      > > names_by_name;
+      uint64_t heap_before = heap_usage();
+      auto start = fc::time_point::now();
+      names_by_name names;
+      for( uint32_t i = 0; i < accounts; ++i )
+         names.emplace( objects[i].name, objects[i].get_id() );
+      auto insert_elapsed = fc::time_point::now() - start;
+      const uint64_t ordered_memory = heap_usage() - heap_before;
+      uint64_t sum = 0;
+      start = fc::time_point::now();
+      for( uint32_t i = 0; i < lookups; ++i )
+         sum += names.find( objects[ (i * 7919) % accounts ].name )->second.instance.value;
+      report( "ordered index of names", ordered_memory, insert_elapsed, fc::time_point::now() - start, sum );
+
+      heap_before = heap_usage();
+      start = fc::time_point::now();
+      account_name_index compact_names;
+      for( uint32_t i = 0; i < accounts; ++i )
+         compact_names.object_inserted( objects[i] );
+      insert_elapsed = fc::time_point::now() - start;
+      const uint64_t compact_memory = heap_usage() - heap_before;
+      sum = 0;
+      start = fc::time_point::now();
+      for( uint32_t i = 0; i < lookups; ++i )
+         sum += compact_names.find( objects[ (i * 7919) % accounts ].name )->instance.value;
+      report( "front-coded account_name_index", compact_memory, insert_elapsed, fc::time_point::now() - start, sum );
+      wlog( "Benchmark: account_name_index reports ${m} bytes for ${n} names",
+            ("m",compact_names.memory_usage())("n",compact_names.size()) );
+      wlog( "Benchmark: both name indexes use ${t} bytes, the front-coded index adds ${p}% to the ordered index",
+            ("t",ordered_memory + compact_memory)
+            ("p",ordered_memory == 0 ? 0 : compact_memory * 100 / ordered_memory) );
+   }
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( grouped_orders_benchmark )
+{ try {
+   // A market maker keeps orders on both sides of a price that moves randomly. In every step it replaces one of
+   // them, and another one is partially filled.
+   const uint32_t resting_orders = 1000;
+   const uint32_t steps = 1000000;
+   const asset_id_type core;
+   const asset_id_type usd( 1 );
+
+   auto run = [=]( const flat_set<uint16_t>& groups ) {
+      graphene::grouped_orders::limit_order_group_index idx( groups );
+      std::mt19937 rng( 42 );
+      std::normal_distribution<double> offset( 0, 0.01 );
+      std::normal_distribution<double> move( 0, 0.0005 );
+      double mid = 1.0;
+
+      auto place = [&]( limit_order_object& o ) {
+         const int64_t amount = 100000000;
+         const int64_t other = static_cast<int64_t>( amount * mid * ( 1 + std::abs( offset( rng ) ) ) );
+         if( o.id.instance() % 2 == 0 ) // ask
+            o.sell_price = price( asset( amount, core ), asset( other, usd ) );
+         else // bid
+            o.sell_price = price( asset( other, usd ), asset( amount, core ) );
+         o.for_sale = 1000000 + rng() % 1000000;
+      };
+
+      // the groups look up their lowest and highest prices in the orders
+      limit_order_multi_index_type book;
+      vector<limit_order_object> orders( resting_orders );
+      for( uint32_t i = 0; i < resting_orders; ++i )
+      {
+         orders[i].id = limit_order_id_type( i );
+         place( orders[i] );
+         book.insert( orders[i] );
+         idx.object_inserted( orders[i] );
+      }
+      auto update = [&book]( const limit_order_object& o ) {
+         book.replace( book.find( o.id ), o );
+      };
+
+      uint64_t sum = 0;
+      auto start = fc::time_point::now();
+      for( uint32_t i = 0; i < steps; ++i )
+      {
+         mid *= 1 + move( rng );
+
+         limit_order_object& replaced = orders[ rng() % resting_orders ];
+         idx.object_removed( replaced );
+         place( replaced );
+         update( replaced );
+         idx.object_inserted( replaced );
+
+         limit_order_object& filled = orders[ rng() % resting_orders ];
+         idx.about_to_modify( filled );
+         filled.for_sale -= filled.for_sale / 10;
+         update( filled );
+         idx.object_modified( filled );
+
+         if( i % 1000 == 0 )
+            for( uint16_t group : groups )
+               sum += idx.get_order_groups( book, group, core, usd, price::max( core, usd ), 100 ).size();
+      }
+      auto elapsed = fc::time_point::now() - start;
+
+      wlog( "Benchmark: grouped orders with ${g} tracked groups: ${n} order replacements and fills took ${t}ms "
+            "(checksum ${s})",
+            ("g",groups.size())("n",steps)("t",elapsed.count()/1000)("s",sum) );
+   };
+
+   run( flat_set<uint16_t>{ 10, 100 } );
+   run( flat_set<uint16_t>{ 1, 2, 5, 10, 20, 50, 100, 200, 500, 1000 } );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( pending_transactions_redo_benchmark )
+{ try {
+   // A node keeps 1000 transfers pending while it receives blocks of 1000 other transfers. The pending transfers do
+   // not depend on the first block, so their recorded changes are redone. The second block pays to their senders,
+   // so they are evaluated again.
+   const uint32_t transfers = 1000;
+   const fc::ecc::private_key key = generate_private_key( "bench" );
+   const public_key_type pub_key = key.get_public_key();
+
+   vector<account_id_type> senders;
+   vector<account_id_type> others;
+   for( uint32_t i = 0; i < transfers; ++i )
+   {
+      senders.push_back( create_account( "sender" + fc::to_string( i ), pub_key ).id );
+      others.push_back( create_account( "other" + fc::to_string( i ), pub_key ).id );
+      transfer( account_id_type(), senders.back(), asset( 1000000 ) );
+      transfer( account_id_type(), others.back(), asset( 1000000 ) );
+   }
+   generate_block();
+
+   fc::temp_directory dir( graphene::utilities::temp_directory_path() );
+   database node;
+   node.open( dir.path(), [this]{ return genesis_state; }, "TEST" );
+   for( uint32_t n = 1; n <= db.head_block_num(); ++n )
+      PUSH_BLOCK( node, *db.fetch_block_by_number( n ), ~0 );
+
+   auto make_transfer = [&key]( const database& d, account_id_type from, account_id_type to ) {
+      signed_transaction tx;
+      transfer_operation op;
+      op.from = from;
+      op.to = to;
+      op.amount = asset( 1 );
+      op.fee = d.current_fee_schedule().calculate_fee( op );
+      tx.operations.push_back( op );
+      test::set_expiration( d, tx );
+      tx.sign( key, d.get_chain_id() );
+      return tx;
+   };
+   for( uint32_t i = 0; i < transfers; ++i )
+      PUSH_TX( node, make_transfer( node, senders[i], senders[ ( i + 1 ) % transfers ] ), database::skip_nothing );
+
+   auto push_block_of_transfers = [&]( const vector<account_id_type>& to, const std::string& label ) {
+      for( uint32_t i = 0; i < transfers; ++i )
+         PUSH_TX( db, make_transfer( db, others[i], to[i] ), database::skip_nothing );
+      const signed_block b = generate_block();
+      auto start = fc::time_point::now();
+      PUSH_BLOCK( node, b, database::skip_nothing );
+      auto elapsed = fc::time_point::now() - start;
+      BOOST_CHECK( node.head_block_id() == db.head_block_id() );
+      wlog( "Benchmark: pushing a block of ${n} transfers with ${p} pending transfers that ${l} took ${t}ms",
+            ("n",transfers)("p",transfers)("l",label)("t",elapsed.count()/1000) );
+   };
+   vector<account_id_type> shifted_others( others.begin() + 1, others.end() );
+   shifted_others.push_back( others.front() );
+   push_block_of_transfers( shifted_others, "are redone" );
+   push_block_of_transfers( senders, "are evaluated again" );
+} FC_LOG_AND_RETHROW() }
+
+/// Applies blocks of transfers between 100 accounts. The blocks are older than 30 seconds, so plugins handle them
+/// like during a replay.
+static void apply_transfer_blocks( database_fixture& fixture, const std::string& label )
+{
+   const uint32_t accounts = 100;
+   const uint32_t blocks = 200;
+   const uint32_t transactions_per_block = 10;
+   database& db = fixture.db;
+
+   transfer_operation op;
+   op.amount = asset( 1 );
+   op.fee = db.current_fee_schedule().calculate_fee( op );
+   vector<account_id_type> ids;
+   for( uint32_t i = 0; i < accounts; ++i )
+   {
+      ids.push_back( fixture.create_account( "bench" + fc::to_string( i ) ).id );
+      fixture.transfer( account_id_type(), ids.back(),
+                        asset( op.fee.amount * blocks * transactions_per_block * 2 + 1000000 ) );
+   }
+   fixture.generate_block();
+
+   auto start = fc::time_point::now();
+   for( uint32_t b = 0; b < blocks; ++b )
+   {
+      for( uint32_t t = 0; t < transactions_per_block; ++t )
+      {
+         fixture.trx.clear();
+         test::set_expiration( db, fixture.trx );
+         for( uint32_t i = 0; i < accounts; ++i )
+         {
+            op.from = ids[i];
+            op.to = ids[ ( i + t + 1 ) % accounts ];
+            fixture.trx.operations.push_back( op );
+         }
+         PUSH_TX( db, fixture.trx, ~0 );
+      }
+      fixture.generate_block();
+   }
+   auto elapsed = fc::time_point::now() - start;
+   fixture.trx.clear();
+
+   const uint64_t transfers = uint64_t( blocks ) * transactions_per_block * accounts;
+   wlog( "Benchmark: ${l}: ${n} transfers in ${b} blocks took ${t}ms, ${tps} transfers/s",
+         ("l",label)("n",transfers)("b",blocks)("t",elapsed.count()/1000)
+         ("tps",transfers*1000000/elapsed.count()) );
+}
+
+BOOST_AUTO_TEST_CASE( replay_benchmark )
+{ try {
+   apply_transfer_blocks( *this, "without plugins" );
+} FC_LOG_AND_RETHROW() }
+
+// Needs an Elasticsearch node at GRAPHENE_TESTING_ES_URL, like the tests of the elasticsearch plugin
+BOOST_AUTO_TEST_CASE( elasticsearch_replay_benchmark )
+{ try {
+   apply_transfer_blocks( *this, "with the elasticsearch plugin" );
+
+   CURL* curl = curl_easy_init();
+   graphene::utilities::ES es;
+   es.curl = curl;
+   es.elasticsearch_url = GRAPHENE_TESTING_ES_URL;
+   es.index_prefix = es_index_prefix;
+   graphene::utilities::deleteAll( es );
+   curl_easy_cleanup( curl );
+} FC_LOG_AND_RETHROW() }
+
 BOOST_AUTO_TEST_SUITE_END()
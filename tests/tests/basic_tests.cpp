@@ -32,6 +32,9 @@
 
 #include <graphene/db/simple_index.hpp>
 
+#include <graphene/net/peer_database.hpp>
+#include <graphene/net/transaction_ingress_queue.hpp>
+
 #include <fc/crypto/digest.hpp>
 #include <fc/crypto/hex.hpp>
 #include "../common/database_fixture.hpp"
@@ -614,6 +617,171 @@ BOOST_AUTO_TEST_CASE( merkle_root )
    BOOST_CHECK( block.calculate_merkle_root() == c(dO) );
 }
 
+BOOST_AUTO_TEST_CASE( cached_packed_sizes_and_hashes )
+{
+   const auto key = fc::ecc::private_key::regenerate( fc::sha256::hash( string("key") ) );
+   signed_transaction trx;
+   transfer_operation transfer;
+   transfer.from = account_id_type(1);
+   transfer.to = account_id_type(2);
+   transfer.amount = asset( 1000 );
+   trx.operations.push_back( transfer );
+   trx.operations.push_back( transfer );
+   trx.set_expiration( fc::time_point_sec( 1000000 ) );
+   trx.sign( key, db.get_chain_id() );
+
+   processed_transaction ptx( trx );
+   ptx.operation_results.push_back( void_result() );
+   ptx.operation_results.push_back( asset( 1 ) );
+
+   // the cached values are the same as the ones calculated without cache
+   auto check = [this]( const processed_transaction& t ) {
+      const signed_transaction& strx = t;
+      BOOST_CHECK_EQUAL( t.get_packed_size(), fc::raw::pack_size( static_cast<const transaction&>( t ) ) );
+      BOOST_CHECK_EQUAL( t.get_signed_packed_size(), fc::raw::pack_size( strx ) );
+      BOOST_CHECK_EQUAL( t.get_processed_packed_size(), fc::raw::pack_size( t ) );
+      BOOST_CHECK( t.get_packed_signed_transaction() == fc::raw::pack( strx ) );
+      BOOST_CHECK( t.id() == signed_transaction( strx ).id() );
+      BOOST_CHECK( t.get_message_id() == fc::ripemd160::hash( fc::raw::pack( strx ) ) );
+      BOOST_CHECK( t.merkle_digest() == digest_type::hash( t ) );
+      BOOST_CHECK( t.get_signature_keys( db.get_chain_id() )
+                   == signed_transaction( strx ).get_signature_keys( db.get_chain_id() ) );
+   };
+   check( ptx );
+
+   // copies share the cache
+   processed_transaction copy( ptx );
+   BOOST_CHECK( &copy.get_packed_signed_transaction() == &ptx.get_packed_signed_transaction() );
+   check( copy );
+
+   // the cached values are recalculated after clearing them
+   copy.operations.pop_back();
+   copy.operation_results.pop_back();
+   copy.signatures.clear();
+   copy.clear_cache();
+   copy.sign( key, db.get_chain_id() );
+   BOOST_CHECK( copy.id() != ptx.id() );
+   check( copy );
+
+   clearable_block block;
+   block.transactions.push_back( ptx );
+   block.transactions.push_back( copy );
+   BOOST_CHECK_EQUAL( block.get_packed_size(), fc::raw::pack_size( static_cast<const signed_block&>( block ) ) );
+   block.transactions.pop_back();
+   block.clear();
+   BOOST_CHECK_EQUAL( block.get_packed_size(), fc::raw::pack_size( static_cast<const signed_block&>( block ) ) );
+}
+
+BOOST_AUTO_TEST_CASE( account_reference_table_shards )
+{
+   // Consecutive account IDs, whose hashes are their instances, are spread across all shards
+   using table_type = account_reference_table< account_id_type, boost::hash<account_id_type> >;
+   const size_t shards = table_type::shard_count;
+   const size_t keys = 100 * shards;
+   vector<size_t> counts( shards );
+   for( size_t i = 0; i < keys; ++i )
+      ++counts[ table_type::shard_of( account_id_type( i ) ) ];
+   for( size_t count : counts )
+   {
+      BOOST_CHECK_GT( count, 50u );
+      BOOST_CHECK_LT( count, 150u );
+   }
+
+   // Lookups find the keys in their shards
+   table_type table;
+   for( size_t i = 0; i < keys; ++i )
+      table.insert( account_id_type( i ), account_id_type( i + 1 ) );
+   BOOST_CHECK_EQUAL( table.size(), keys );
+   for( size_t i = 0; i < keys; ++i )
+   {
+      const auto* accounts = table.find( account_id_type( i ) );
+      BOOST_REQUIRE( accounts != nullptr );
+      BOOST_CHECK( accounts->size() == 1 && *accounts->begin() == account_id_type( i + 1 ) );
+   }
+   BOOST_CHECK( table.find( account_id_type( keys ) ) == nullptr );
+
+   // Keys are spread as well
+   vector<size_t> key_counts( shards );
+   for( uint32_t i = 0; i < keys; ++i )
+   {
+      const public_key_type key = fc::ecc::private_key::regenerate( fc::sha256::hash( fc::to_string( i ) ) )
+                                                         .get_public_key();
+      ++key_counts[ account_reference_table< public_key_type >::shard_of( key ) ];
+   }
+   for( size_t count : key_counts )
+      BOOST_CHECK_GT( count, 50u );
+}
+
+BOOST_AUTO_TEST_CASE( account_name_index_test )
+{
+   account_name_index names;
+   std::map<string, account_id_type> expected;
+   vector<account_object> accounts;
+
+   // enough names for many blocks, inserted in random order
+   std::mt19937 rng( 42 );
+   for( uint32_t i = 0; i < 1000; ++i )
+   {
+      account_object a;
+      a.id = account_id_type( i );
+      a.name = ( rng() % 2 ? "alice-" : "bob-" ) + fc::to_string( rng() % 100000 ) + "-" + fc::to_string( i );
+      accounts.push_back( a );
+   }
+   std::shuffle( accounts.begin(), accounts.end(), rng );
+   for( const auto& a : accounts )
+   {
+      names.object_inserted( a );
+      expected[a.name] = a.get_id();
+   }
+   BOOST_CHECK_EQUAL( names.size(), expected.size() );
+
+   auto same = []( const pair<string, account_id_type>& a, const pair<const string, account_id_type>& b ) {
+      return a.first == b.first && a.second == b.second;
+   };
+   auto check = [&names,&expected,&same]() {
+      for( const auto& e : expected )
+      {
+         BOOST_REQUIRE( names.find( e.first ).valid() );
+         BOOST_CHECK( *names.find( e.first ) == e.second );
+      }
+      BOOST_CHECK( !names.find( "" ).valid() );
+      BOOST_CHECK( !names.find( "alice" ).valid() );
+      BOOST_CHECK( !names.find( "carol" ).valid() );
+
+      auto all = names.list( "", 10000 );
+      BOOST_CHECK( std::equal( all.begin(), all.end(), expected.begin(), expected.end(), same ) );
+
+      auto from_bob = names.list( "b", 10 );
+      BOOST_REQUIRE_EQUAL( from_bob.size(), 10u );
+      BOOST_CHECK( std::equal( from_bob.begin(), from_bob.end(), expected.lower_bound( "b" ), same ) );
+
+      auto alices = names.list( "", 10000, "alice-" );
+      auto alice_end = expected.lower_bound( "b" );
+      BOOST_CHECK_EQUAL( alices.size(), size_t( std::distance( expected.begin(), alice_end ) ) );
+      BOOST_CHECK( std::equal( alices.begin(), alices.end(), expected.begin(), alice_end, same ) );
+
+      BOOST_CHECK( names.list( "bob-", 10, "alice-" ).empty() );
+      BOOST_CHECK( names.list( "", 10, "carol" ).empty() );
+   };
+   check();
+
+   // remove half of them, including whole blocks
+   for( size_t i = 0; i < accounts.size(); i += 2 )
+   {
+      names.object_removed( accounts[i] );
+      expected.erase( accounts[i].name );
+   }
+   BOOST_CHECK_EQUAL( names.size(), expected.size() );
+   BOOST_CHECK( !names.find( accounts[0].name ).valid() );
+   check();
+
+   for( size_t i = 1; i < accounts.size(); i += 2 )
+      names.object_removed( accounts[i] );
+   BOOST_CHECK_EQUAL( names.size(), 0u );
+   BOOST_CHECK( names.list( "", 10 ).empty() );
+   BOOST_CHECK( !names.find( accounts[1].name ).valid() );
+}
+
 /**
  * Reproduces https://gitlab.com/dxperts/dxperts-core/issues/888 and tests fix for it.
  */
@@ -629,4 +797,122 @@ BOOST_AUTO_TEST_CASE( smarttoken_feed_expiration_test )
    BOOST_CHECK( !o.feed_is_expired( now ) );
 }
 
+BOOST_AUTO_TEST_CASE( peer_performance_record_test )
+{
+   graphene::net::peer_performance_record unknown;
+   graphene::net::peer_performance_record fast;
+   graphene::net::peer_performance_record slow;
+
+   fast.record_round_trip_delay( fc::milliseconds(20) );
+   fast.record_block_latency( fc::milliseconds(300) );
+   fast.record_connection_throughput( 60 * 1024 * 1024, fc::minutes(1) );
+   BOOST_CHECK_EQUAL( fast.average_round_trip_delay_ms, 20u );
+   BOOST_CHECK_EQUAL( fast.average_block_latency_ms, 300u );
+   BOOST_CHECK_EQUAL( fast.average_bytes_per_second, 1024u * 1024 );
+
+   slow.record_round_trip_delay( fc::milliseconds(800) );
+   slow.record_block_latency( fc::seconds(2) );
+
+   BOOST_CHECK( fast.expected_block_delay() < unknown.expected_block_delay() );
+   BOOST_CHECK( unknown.expected_block_delay() < slow.expected_block_delay() );
+
+   // too short to tell anything about the peer's bandwidth
+   slow.record_connection_throughput( 1024, fc::seconds(1) );
+   BOOST_CHECK_EQUAL( slow.average_bytes_per_second, 0u );
+
+   // new samples move the average without replacing it
+   fast.record_round_trip_delay( fc::milliseconds(100) );
+   BOOST_CHECK_EQUAL( fast.average_round_trip_delay_ms, 30u );
+
+   // invalid items make a fast peer look slow
+   fc::microseconds delay_before_invalid_items = fast.expected_block_delay();
+   for( int i = 0; i < 10; ++i )
+      fast.record_item_received( i % 2 == 0 );
+   BOOST_CHECK_EQUAL( fast.number_of_items_received, 10u );
+   BOOST_CHECK_EQUAL( fast.number_of_invalid_items_received, 5u );
+   BOOST_CHECK( fast.expected_block_delay().count() > delay_before_invalid_items.count() * 5 );
+}
+
+BOOST_AUTO_TEST_CASE( token_bucket_test )
+{
+   fc::time_point now = fc::time_point::now();
+   graphene::net::token_bucket bucket( 10, 3 );
+
+   // a full bucket allows a burst
+   BOOST_CHECK( bucket.try_consume( now ) );
+   BOOST_CHECK( bucket.try_consume( now ) );
+   BOOST_CHECK( bucket.try_consume( now ) );
+   BOOST_CHECK( !bucket.try_consume( now ) );
+   BOOST_CHECK( bucket.next_token_time( now ) == now + fc::milliseconds(100) );
+
+   // then refills at the configured rate
+   BOOST_CHECK( !bucket.try_consume( now + fc::milliseconds(99) ) );
+   BOOST_CHECK( bucket.try_consume( now + fc::milliseconds(100) ) );
+
+   // but never above its capacity
+   now += fc::hours(1);
+   BOOST_CHECK( bucket.try_consume( now ) );
+   BOOST_CHECK( bucket.try_consume( now ) );
+   BOOST_CHECK( bucket.try_consume( now ) );
+   BOOST_CHECK( !bucket.try_consume( now ) );
+}
+
+BOOST_AUTO_TEST_CASE( transaction_ingress_queue_test )
+{
+   using graphene::net::transaction_ingress_queue;
+
+   auto make_transaction = []( int64_t fee, asset_id_type fee_asset = asset_id_type() ) {
+      transfer_operation op;
+      op.fee = asset( fee, fee_asset );
+      op.amount = asset( fee );
+      signed_transaction trx;
+      trx.operations.push_back( op );
+      graphene::net::trx_message msg( trx );
+      return transaction_ingress_queue::queued_transaction { msg, graphene::net::message( msg ),
+                                                             graphene::net::message_hash_type(), fc::time_point(),
+                                                             graphene::net::node_id_t(), fc::optional<fc::ip::endpoint>() };
+   };
+
+   transaction_ingress_queue::queued_transaction cheap = make_transaction( 10 );
+   transaction_ingress_queue::queued_transaction expensive = make_transaction( 1000 );
+   transaction_ingress_queue::queued_transaction uia_fee = make_transaction( 100000, asset_id_type(1) );
+   BOOST_CHECK_GT( transaction_ingress_queue::fee_per_kilobyte( expensive.transaction_message.trx ),
+                   transaction_ingress_queue::fee_per_kilobyte( cheap.transaction_message.trx ) );
+   BOOST_CHECK_EQUAL( transaction_ingress_queue::fee_per_kilobyte( uia_fee.transaction_message.trx ), 0u );
+
+   // best paying first, arrival order among equal fees
+   {
+      transaction_ingress_queue queue( 1024 * 1024 );
+      BOOST_CHECK( queue.push( make_transaction( 10 ) ) );
+      BOOST_CHECK( queue.push( make_transaction( 1000 ) ) );
+      BOOST_CHECK( queue.push( make_transaction( 100, asset_id_type(1) ) ) );
+      BOOST_CHECK( queue.push( make_transaction( 10 ) ) );
+      BOOST_CHECK_EQUAL( queue.size(), 4u );
+      BOOST_CHECK_EQUAL( queue.pop().transaction_message.trx.operations.front().get<transfer_operation>().fee.amount.value, 1000 );
+      auto first_cheap = queue.pop();
+      auto second_cheap = queue.pop();
+      BOOST_CHECK_EQUAL( first_cheap.transaction_message.trx.operations.front().get<transfer_operation>().fee.amount.value, 10 );
+      BOOST_CHECK_EQUAL( second_cheap.transaction_message.trx.operations.front().get<transfer_operation>().fee.amount.value, 10 );
+      BOOST_CHECK( queue.pop().transaction_message.trx.operations.front().get<transfer_operation>().fee.asset_id == asset_id_type(1) );
+      BOOST_CHECK( queue.empty() );
+      BOOST_CHECK_EQUAL( queue.size_in_bytes(), 0u );
+   }
+
+   // a full queue drops the lowest paying transactions
+   {
+      transaction_ingress_queue sizing_queue( 1024 * 1024 );
+      sizing_queue.push( make_transaction( 10 ) );
+      size_t one_transaction = sizing_queue.size_in_bytes();
+
+      transaction_ingress_queue queue( 2 * one_transaction );
+      BOOST_CHECK( queue.push( make_transaction( 10 ) ) );
+      BOOST_CHECK( queue.push( make_transaction( 20 ) ) );
+      BOOST_CHECK( !queue.push( make_transaction( 5 ) ) );
+      BOOST_CHECK( queue.push( make_transaction( 30 ) ) );
+      BOOST_CHECK_EQUAL( queue.size(), 2u );
+      BOOST_CHECK_EQUAL( queue.pop().transaction_message.trx.operations.front().get<transfer_operation>().fee.amount.value, 30 );
+      BOOST_CHECK_EQUAL( queue.pop().transaction_message.trx.operations.front().get<transfer_operation>().fee.amount.value, 20 );
+   }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
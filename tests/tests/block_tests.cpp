@@ -71,6 +71,47 @@ genesis_state_type make_genesis()
    return genesis_state;
 }
 
+/// Three databases to compare parallel authority checks with sequential ones: db1 produces the blocks, db2 applies
+/// them with parallel authority checks and db3 without
+struct parallel_authority_checks_fixture
+{
+   fc::temp_directory dir1{graphene::utilities::temp_directory_path()};
+   fc::temp_directory dir2{graphene::utilities::temp_directory_path()};
+   fc::temp_directory dir3{graphene::utilities::temp_directory_path()};
+   database db1;
+   database db2;
+   database db3;
+   const fc::ecc::private_key init_account_priv_key =
+       fc::ecc::private_key::regenerate(fc::sha256::hash(string("null_key")));
+   const public_key_type init_account_pub_key = init_account_priv_key.get_public_key();
+
+   parallel_authority_checks_fixture()
+   {
+      db1.open(dir1.path(), make_genesis, "TEST");
+      db2.open(dir2.path(), make_genesis, "TEST");
+      db3.open(dir3.path(), make_genesis, "TEST");
+      db2.enable_parallel_authority_checks(true);
+   }
+
+   static const account_object &get_account(const database &db, const string &name)
+   {
+      const auto &idx = db.get_index_type<account_index>().indices().get<by_name>();
+      auto itr = idx.find(name);
+      BOOST_REQUIRE(itr != idx.end());
+      return *itr;
+   }
+
+   /// Pushes a transaction with one operation, signed with the given key, to db1
+   void push(const operation &op, const fc::ecc::private_key &key)
+   {
+      signed_transaction trx;
+      set_expiration(db1, trx);
+      trx.operations.push_back(op);
+      trx.sign(key, db1.get_chain_id());
+      PUSH_TX(db1, trx, database::skip_nothing);
+   }
+};
+
 BOOST_AUTO_TEST_SUITE(block_tests)
 
 BOOST_AUTO_TEST_CASE(block_database_test)
@@ -768,6 +809,278 @@ BOOST_AUTO_TEST_CASE(duplicate_transactions)
    }
 }
 
+BOOST_FIXTURE_TEST_CASE(parallel_authority_checks, parallel_authority_checks_fixture)
+{
+   try
+   {
+      auto new_key = fc::ecc::private_key::regenerate(fc::sha256::hash(string("new_key")));
+      public_key_type new_pub_key = new_key.get_public_key();
+
+      auto update_memo_key = [this](const string &name, const public_key_type &key) {
+         account_update_operation uop;
+         uop.account = get_account(db1, name).id;
+         uop.new_options = get_account(db1, name).options;
+         uop.new_options->memo_key = key;
+         return uop;
+      };
+
+      // Checked in parallel against the state before the block
+      account_create_operation cop;
+      cop.registrar = get_account(db1, "init0").id;
+      cop.name = "matrix";
+      cop.owner = authority(1, init_account_pub_key, 1);
+      cop.active = cop.owner;
+      cop.options.memo_key = init_account_pub_key;
+      push(cop, init_account_priv_key);
+      push(update_memo_key("init3", new_pub_key), init_account_priv_key);
+
+      // Changes the authorities, so the checks of all later transactions are stale
+      account_update_operation aop;
+      aop.account = get_account(db1, "init1").id;
+      aop.active = authority(1, new_pub_key, 1);
+      push(aop, init_account_priv_key);
+
+      // Only valid after the previous transaction
+      push(update_memo_key("init1", new_pub_key), new_key);
+
+      auto b = db1.generate_block(db1.get_slot_time(1), db1.get_scheduled_blockproducer(1), init_account_priv_key,
+                                  database::skip_nothing);
+      BOOST_REQUIRE_EQUAL(b.transactions.size(), 4u);
+      PUSH_BLOCK(db2, b, database::skip_nothing);
+      PUSH_BLOCK(db3, b, database::skip_nothing);
+
+      BOOST_CHECK(db2.head_block_id() == db1.head_block_id());
+      BOOST_CHECK(db3.head_block_id() == db1.head_block_id());
+      for (const string name : {"init1", "init3", "matrix"})
+      {
+         BOOST_CHECK_EQUAL(fc::json::to_string(get_account(db2, name)), fc::json::to_string(get_account(db1, name)));
+         BOOST_CHECK_EQUAL(fc::json::to_string(get_account(db3, name)), fc::json::to_string(get_account(db1, name)));
+      }
+      BOOST_CHECK(get_account(db2, "init1").options.memo_key == new_pub_key);
+
+      // A block with a transaction that fails the check is rejected like without parallel checks
+      auto bad_key = fc::ecc::private_key::regenerate(fc::sha256::hash(string("bad_key")));
+      signed_block bad_block;
+      for (const auto &key : {init_account_priv_key, bad_key})
+      {
+         signed_transaction trx;
+         set_expiration(db1, trx);
+         trx.operations.push_back(update_memo_key("init1", key.get_public_key()));
+         trx.sign(key, db1.get_chain_id());
+         bad_block.transactions.push_back(trx);
+      }
+      bad_block.previous = db1.head_block_id();
+      bad_block.timestamp = db1.get_slot_time(1);
+      bad_block.blockproducer = db1.get_scheduled_blockproducer(1);
+      bad_block.transaction_merkle_root = bad_block.calculate_merkle_root();
+      bad_block.sign(init_account_priv_key);
+      GRAPHENE_REQUIRE_THROW(PUSH_BLOCK(db2, bad_block, database::skip_nothing), fc::exception);
+      GRAPHENE_REQUIRE_THROW(PUSH_BLOCK(db3, bad_block, database::skip_nothing), fc::exception);
+      BOOST_CHECK(db2.head_block_id() == db3.head_block_id());
+   }
+   catch (fc::exception &e)
+   {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE(restore_pending_transactions)
+{
+   try
+   {
+      fc::temp_directory dir1(graphene::utilities::temp_directory_path()),
+          dir2(graphene::utilities::temp_directory_path());
+      database db1,
+          db2;
+      db1.open(dir1.path(), make_genesis, "TEST");
+      db2.open(dir2.path(), make_genesis, "TEST");
+
+      auto init_account_priv_key = fc::ecc::private_key::regenerate(fc::sha256::hash(string("null_key")));
+      public_key_type init_account_pub_key = init_account_priv_key.get_public_key();
+      public_key_type key1 = fc::ecc::private_key::regenerate(fc::sha256::hash(string("key1"))).get_public_key();
+      public_key_type key2 = fc::ecc::private_key::regenerate(fc::sha256::hash(string("key2"))).get_public_key();
+
+      auto get_account = [](const database &db, const string &name) -> const account_object & {
+         const auto &idx = db.get_index_type<account_index>().indices().get<by_name>();
+         auto itr = idx.find(name);
+         BOOST_REQUIRE(itr != idx.end());
+         return *itr;
+      };
+      auto push = [&init_account_priv_key](database &db, const operation &op) {
+         signed_transaction trx;
+         set_expiration(db, trx);
+         trx.operations.push_back(op);
+         trx.sign(init_account_priv_key, db.get_chain_id());
+         PUSH_TX(db, trx, database::skip_nothing);
+      };
+      auto update_memo_key = [&get_account](const database &db, const string &name, const public_key_type &key) {
+         account_update_operation uop;
+         uop.account = get_account(db, name).id;
+         uop.new_options = get_account(db, name).options;
+         uop.new_options->memo_key = key;
+         return uop;
+      };
+      auto generate = [&init_account_priv_key](database &db) {
+         return db.generate_block(db.get_slot_time(1), db.get_scheduled_blockproducer(1), init_account_priv_key,
+                                  database::skip_nothing);
+      };
+
+      // Accounts that do not produce blocks, so only their own transactions change them
+      for (const string name : {"alice", "bob", "carol", "dave", "erin"})
+      {
+         account_create_operation cop;
+         cop.registrar = get_account(db1, "init0").id;
+         cop.name = name;
+         cop.owner = authority(1, init_account_pub_key, 1);
+         cop.active = cop.owner;
+         cop.options.memo_key = init_account_pub_key;
+         push(db1, cop);
+      }
+      asset_create_operation aop;
+      aop.issuer = get_account(db1, "init0").id;
+      aop.symbol = "PENDING";
+      aop.common_options.core_exchange_rate = price(asset(1, asset_id_type(1)), asset(1));
+      push(db1, aop);
+      const asset_id_type uia = db1.get_index_type<asset_index>().indices().get<by_symbol>().find("PENDING")->id;
+      for (const string name : {"alice", "bob"})
+      {
+         asset_issue_operation iop;
+         iop.issuer = aop.issuer;
+         iop.asset_to_issue = asset(1000, uia);
+         iop.issue_to_account = get_account(db1, name).id;
+         push(db1, iop);
+      }
+      PUSH_BLOCK(db2, generate(db1), database::skip_nothing);
+
+      auto transfer = [&get_account,&uia](const database &db, const string &from, const string &to, int64_t amount) {
+         transfer_operation top;
+         top.from = get_account(db, from).id;
+         top.to = get_account(db, to).id;
+         top.amount = asset(amount, uia);
+         return top;
+      };
+      auto balance = [&get_account,&uia](const database &db, const string &name) {
+         return db.get_balance(get_account(db, name).id, uia).amount.value;
+      };
+
+      push(db1, transfer(db1, "alice", "carol", 10));
+      push(db1, transfer(db1, "bob", "erin", 10));
+      push(db1, update_memo_key(db1, "bob", key1));
+
+      size_t notified = 0;
+      auto connection = db1.on_pending_transaction.connect([&notified](const signed_transaction &) { ++notified; });
+
+      // Another node includes a transfer of alice, so the pending transfer of alice is evaluated again and the one
+      // of bob is redone. Account updates read more than their footprint, so the update of bob is evaluated again.
+      push(db2, transfer(db2, "alice", "dave", 5));
+      PUSH_BLOCK(db1, generate(db2), database::skip_nothing);
+      BOOST_CHECK_EQUAL(notified, 2u);
+      BOOST_CHECK_EQUAL(balance(db1, "alice"), 985);
+      BOOST_CHECK_EQUAL(balance(db1, "bob"), 990);
+      BOOST_CHECK_EQUAL(balance(db1, "erin"), 10);
+      BOOST_CHECK(get_account(db1, "bob").options.memo_key == key1);
+
+      // The restored transactions make a valid block
+      auto b = generate(db1);
+      BOOST_CHECK_EQUAL(b.transactions.size(), 3u);
+      PUSH_BLOCK(db2, b, database::skip_nothing);
+      BOOST_CHECK(db2.head_block_id() == db1.head_block_id());
+      for (const string name : {"alice", "bob", "carol", "dave", "erin"})
+         BOOST_CHECK_EQUAL(balance(db2, name), balance(db1, name));
+      BOOST_CHECK(get_account(db2, "bob").options.memo_key == key1);
+
+      // The number of pending transactions is limited
+      db1.set_max_pending_transactions(1);
+      push(db1, update_memo_key(db1, "alice", key2));
+      GRAPHENE_REQUIRE_THROW(push(db1, update_memo_key(db1, "bob", key2)), fc::exception);
+      generate(db1);
+      push(db1, update_memo_key(db1, "bob", key2));
+      connection.disconnect();
+   }
+   catch (fc::exception &e)
+   {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_FIXTURE_TEST_CASE(parallel_authority_checks_replay, parallel_authority_checks_fixture)
+{
+   try
+   {
+      std::map<string, fc::ecc::private_key> active_keys;
+
+      auto update_memo_key = [&](const string &name, const public_key_type &key) {
+         account_update_operation uop;
+         uop.account = get_account(db1, name).id;
+         uop.new_options = get_account(db1, name).options;
+         uop.new_options->memo_key = key;
+         push(uop, active_keys.count(name) ? active_keys.at(name) : init_account_priv_key);
+      };
+
+      // Build a chain whose blocks mix transactions that can be checked against the state before the block with
+      // transactions that depend on authority changes earlier in the same block
+      for (uint32_t i = 1; i <= 30; ++i)
+      {
+         const auto key = fc::ecc::private_key::regenerate(fc::sha256::hash("replay_key" + fc::to_string(i)));
+         const public_key_type pub_key = key.get_public_key();
+
+         account_create_operation cop;
+         cop.registrar = get_account(db1, "init0").id;
+         cop.name = "replay" + fc::to_string(i);
+         cop.owner = authority(1, init_account_pub_key, 1);
+         cop.active = cop.owner;
+         cop.options.memo_key = init_account_pub_key;
+         push(cop, init_account_priv_key);
+
+         update_memo_key("init" + fc::to_string(i % 10), pub_key);
+         if (i > 1)
+            update_memo_key("replay" + fc::to_string(i - 1), pub_key);
+
+         if (i % 3 == 0)
+         {
+            const string name = "replay" + fc::to_string(i - 2);
+            account_update_operation aop;
+            aop.account = get_account(db1, name).id;
+            aop.active = authority(1, pub_key, 1);
+            push(aop, active_keys.count(name) ? active_keys.at(name) : init_account_priv_key);
+            active_keys[name] = key;
+            // Only valid after the previous transaction
+            update_memo_key(name, init_account_pub_key);
+         }
+
+         db1.generate_block(db1.get_slot_time(1), db1.get_scheduled_blockproducer(1), init_account_priv_key,
+                            database::skip_nothing);
+      }
+
+      // Replay the chain with and without parallel checks
+      for (uint32_t num = 1; num <= db1.head_block_num(); ++num)
+      {
+         const signed_block b = *db1.fetch_block_by_number(num);
+         BOOST_REQUIRE_GT(b.transactions.size(), 1u);
+         PUSH_BLOCK(db2, b, database::skip_nothing);
+         PUSH_BLOCK(db3, b, database::skip_nothing);
+         BOOST_REQUIRE(db2.head_block_id() == b.id());
+         BOOST_REQUIRE(db3.head_block_id() == b.id());
+      }
+
+      const auto &accounts = db1.get_index_type<account_index>().indices().get<by_id>();
+      BOOST_REQUIRE_EQUAL(db2.get_index_type<account_index>().indices().size(), accounts.size());
+      BOOST_REQUIRE_EQUAL(db3.get_index_type<account_index>().indices().size(), accounts.size());
+      for (const account_object &account : accounts)
+      {
+         BOOST_CHECK_EQUAL(fc::json::to_string(get_account(db2, account.name)), fc::json::to_string(account));
+         BOOST_CHECK_EQUAL(fc::json::to_string(get_account(db3, account.name)), fc::json::to_string(account));
+      }
+   }
+   catch (fc::exception &e)
+   {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
 BOOST_AUTO_TEST_CASE(tapos)
 {
    try
@@ -1986,4 +2299,89 @@ BOOST_FIXTURE_TEST_CASE(block_size_test, database_fixture)
    }
 }
 
+BOOST_FIXTURE_TEST_CASE(generate_block_by_fee, database_fixture)
+{
+   try
+   {
+      ACTORS((alice)(bob)(carol)(dave));
+      for (const account_object *a : {&alice, &bob, &carol})
+         fund(*a, asset(100000));
+      generate_block();
+
+      vector<transaction_id_type> ids;
+      auto push = [this, &ids, dave_id](const account_object &from, const fc::ecc::private_key &key, int64_t fee) {
+         signed_transaction tx;
+         transfer_operation top;
+         top.from = from.id;
+         top.to = dave_id;
+         top.amount = asset(100);
+         top.fee = asset(fee);
+         tx.operations.push_back(top);
+         set_expiration(db, tx);
+         sign(tx, key);
+         PUSH_TX(db, tx);
+         ids.push_back(tx.id());
+      };
+      push(alice, alice_private_key, 1);
+      push(bob, bob_private_key, 1000);
+      push(alice, alice_private_key, 5000); // may depend on the first one of alice, so it stays behind it
+      push(carol, carol_private_key, 100);
+
+      auto b = generate_block();
+      BOOST_REQUIRE_EQUAL(b.transactions.size(), 4u);
+      BOOST_CHECK(b.transactions[0].id() == ids[1]);
+      BOOST_CHECK(b.transactions[1].id() == ids[3]);
+      BOOST_CHECK(b.transactions[2].id() == ids[0]);
+      BOOST_CHECK(b.transactions[3].id() == ids[2]);
+
+      // Equal fees keep the arrival order
+      ids.clear();
+      push(carol, carol_private_key, 10);
+      push(alice, alice_private_key, 10);
+      push(bob, bob_private_key, 10);
+      b = generate_block();
+      BOOST_REQUIRE_EQUAL(b.transactions.size(), 3u);
+      for (size_t i = 0; i < ids.size(); ++i)
+         BOOST_CHECK(b.transactions[i].id() == ids[i]);
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_FIXTURE_TEST_CASE(generate_block_with_cross_payer_dependency, database_fixture)
+{
+   try
+   {
+      ACTORS((alice)(bob)(carol));
+      fund(alice, asset(100000));
+      generate_block();
+
+      vector<transaction_id_type> ids;
+      auto push = [this, &ids](account_id_type from, account_id_type to, const fc::ecc::private_key &key,
+                               int64_t amount, int64_t fee) {
+         signed_transaction tx;
+         transfer_operation top;
+         top.from = from;
+         top.to = to;
+         top.amount = asset(amount);
+         top.fee = asset(fee);
+         tx.operations.push_back(top);
+         set_expiration(db, tx);
+         sign(tx, key);
+         PUSH_TX(db, tx);
+         ids.push_back(tx.id());
+      };
+      push(alice_id, bob_id, alice_private_key, 50000, 1);
+      // pays a higher fee, so it is tried first, but it spends what alice sends to bob
+      push(bob_id, carol_id, bob_private_key, 20000, 5000);
+
+      auto b = generate_block();
+      BOOST_REQUIRE_EQUAL(b.transactions.size(), 2u);
+      BOOST_CHECK(b.transactions[0].id() == ids[0]);
+      BOOST_CHECK(b.transactions[1].id() == ids[1]);
+      BOOST_CHECK_EQUAL(get_balance(bob_id, asset_id_type()), 25000);
+      BOOST_CHECK_EQUAL(get_balance(carol_id, asset_id_type()), 20000);
+   }
+   FC_LOG_AND_RETHROW()
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -329,4 +329,115 @@ catch (fc::exception &e) {
    throw;
 } }
 
+BOOST_AUTO_TEST_CASE(custom_operations_account_storage_catalog_test)
+{
+try {
+   ACTORS((matrix)(alice)(robert)(patty));
+
+   app.enable_plugin("custom_operations");
+   custom_operations_api custom_operations_api(app);
+
+   generate_block();
+   enable_fees();
+
+   int64_t init_balance(10000 * GRAPHENE_BLOCKCHAIN_PRECISION);
+
+   transfer(dxpcore_account, matrix_id, asset(init_balance));
+   transfer(dxpcore_account, alice_id, asset(init_balance));
+   transfer(dxpcore_account, robert_id, asset(init_balance));
+
+   // matrix sets a key twice in the same block, only the last value is stored
+   std::string catalog = "settings";
+   flat_map<string, optional<string>> pairs;
+   pairs["language"] = fc::json::to_string("en");
+   map_operation(pairs, false, catalog, matrix_id, matrix_private_key, db);
+   pairs["language"] = fc::json::to_string("de");
+   pairs["theme"] = fc::json::to_string("dark");
+   map_operation(pairs, false, catalog, matrix_id, matrix_private_key, db);
+
+   // alice sets a key and removes it again in the same block, nothing is stored
+   pairs.clear();
+   pairs["language"] = fc::json::to_string("fr");
+   map_operation(pairs, false, catalog, alice_id, alice_private_key, db);
+   map_operation(pairs, true, catalog, alice_id, alice_private_key, db);
+
+   // robert sets an invalid value after a valid one, the valid one is stored
+   pairs.clear();
+   pairs["language"] = fc::json::to_string("es");
+   map_operation(pairs, false, catalog, robert_id, robert_private_key, db);
+   pairs["language"] = "es";
+   map_operation(pairs, false, catalog, robert_id, robert_private_key, db);
+   generate_block();
+
+   auto results = custom_operations_api.get_storage_info("matrix", catalog);
+   BOOST_REQUIRE_EQUAL(results.size(), 2u);
+   BOOST_CHECK_EQUAL(results[0].key, "language");
+   BOOST_CHECK_EQUAL(results[0].value->as_string(), "de");
+   BOOST_CHECK_EQUAL(results[1].key, "theme");
+   BOOST_CHECK_EQUAL(custom_operations_api.get_storage_info("alice", catalog).size(), 0u);
+
+   results = custom_operations_api.get_storage_info_by_catalog_key(catalog, "language", 2);
+   BOOST_REQUIRE_EQUAL(results.size(), 2u);
+   BOOST_CHECK(results[0].account == matrix_id);
+   BOOST_CHECK_EQUAL(results[0].value->as_string(), "de");
+   BOOST_CHECK(results[1].account == robert_id);
+   BOOST_CHECK_EQUAL(results[1].value->as_string(), "es");
+
+   // alice stores the key too, and the accounts are fetched in pages
+   pairs.clear();
+   pairs["language"] = fc::json::to_string("fr");
+   map_operation(pairs, false, catalog, alice_id, alice_private_key, db);
+   generate_block();
+
+   results = custom_operations_api.get_storage_info_by_catalog_key(catalog, "language", 2);
+   BOOST_REQUIRE_EQUAL(results.size(), 2u);
+   BOOST_CHECK(results[0].account == matrix_id);
+   BOOST_CHECK(results[1].account == alice_id);
+   results = custom_operations_api.get_storage_info_by_catalog_key(catalog, "language", 2,
+                                                                    account_id_type(alice_id.instance.value + 1));
+   BOOST_REQUIRE_EQUAL(results.size(), 1u);
+   BOOST_CHECK(results[0].account == robert_id);
+   BOOST_CHECK_EQUAL(custom_operations_api.get_storage_info_by_catalog_key(catalog, "theme", 2).size(), 1u);
+   BOOST_CHECK_EQUAL(custom_operations_api.get_storage_info_by_catalog_key(catalog, "nothere", 2).size(), 0u);
+   GRAPHENE_CHECK_THROW(custom_operations_api.get_storage_info_by_catalog_key(catalog, "language", 3),
+                        fc::exception);
+
+   // every account is listed once, no matter how many keys it stores
+   auto accounts = custom_operations_api.get_accounts_by_catalog(catalog, 2);
+   BOOST_REQUIRE_EQUAL(accounts.size(), 2u);
+   BOOST_CHECK(accounts[0] == matrix_id);
+   BOOST_CHECK(accounts[1] == alice_id);
+   accounts = custom_operations_api.get_accounts_by_catalog(catalog, 2, robert_id);
+   BOOST_REQUIRE_EQUAL(accounts.size(), 1u);
+   BOOST_CHECK(accounts[0] == robert_id);
+
+   // removed keys are gone from the index
+   pairs.clear();
+   pairs["language"];
+   map_operation(pairs, true, catalog, matrix_id, matrix_private_key, db);
+   generate_block();
+
+   results = custom_operations_api.get_storage_info_by_catalog_key(catalog, "language", 2);
+   BOOST_REQUIRE_EQUAL(results.size(), 2u);
+   BOOST_CHECK(results[0].account == alice_id);
+   BOOST_CHECK(results[1].account == robert_id);
+   accounts = custom_operations_api.get_accounts_by_catalog(catalog, 2);
+   BOOST_REQUIRE_EQUAL(accounts.size(), 2u);
+   BOOST_CHECK(accounts[0] == matrix_id);
+
+   pairs.clear();
+   pairs["theme"];
+   map_operation(pairs, true, catalog, matrix_id, matrix_private_key, db);
+   generate_block();
+
+   accounts = custom_operations_api.get_accounts_by_catalog(catalog, 2);
+   BOOST_REQUIRE_EQUAL(accounts.size(), 2u);
+   BOOST_CHECK(accounts[0] == alice_id);
+   BOOST_CHECK(accounts[1] == robert_id);
+}
+catch (fc::exception &e) {
+   edump((e.to_detail_string()));
+   throw;
+} }
+
 BOOST_AUTO_TEST_SUITE_END()
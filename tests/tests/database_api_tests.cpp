@@ -1513,6 +1513,34 @@ BOOST_AUTO_TEST_CASE(get_transaction_hex)
    FC_LOG_AND_RETHROW()
 }
 
+BOOST_AUTO_TEST_CASE(get_blocks)
+{
+   try
+   {
+      graphene::app::database_api db_api(db, &(app.get_options()));
+      generate_blocks(5);
+      const uint32_t head_num = db.head_block_num();
+
+      vector<signed_block> blocks = db_api.get_blocks(2, 3);
+      BOOST_REQUIRE_EQUAL(blocks.size(), 3u);
+      for (uint32_t i = 0; i < blocks.size(); ++i)
+      {
+         BOOST_CHECK_EQUAL(blocks[i].block_num(), 2 + i);
+         BOOST_CHECK(blocks[i].id() == db.fetch_block_by_number(2 + i)->id());
+      }
+
+      // stops at the head block
+      blocks = db_api.get_blocks(head_num - 1, 10);
+      BOOST_REQUIRE_EQUAL(blocks.size(), 2u);
+      BOOST_CHECK(blocks.back().id() == db.head_block_id());
+      BOOST_CHECK(db_api.get_blocks(head_num + 1, 10).empty());
+      BOOST_CHECK(db_api.get_blocks(0, 10).empty());
+
+      GRAPHENE_CHECK_THROW(db_api.get_blocks(1, 101), fc::exception);
+   }
+   FC_LOG_AND_RETHROW()
+}
+
 BOOST_AUTO_TEST_CASE(verify_account_authority)
 {
    try
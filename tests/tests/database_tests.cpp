@@ -223,6 +223,76 @@ BOOST_AUTO_TEST_CASE( direct_index_test )
    // but the secondary has not updated its representation
 } FC_LOG_AND_RETHROW() }
 
+BOOST_AUTO_TEST_CASE( dense_index_test )
+{ try {
+   graphene::db::primary_index< account_balance_index > my_balances( db );
+   BOOST_CHECK_EQUAL( 0u, my_balances.size() );
+   BOOST_CHECK( nullptr == my_balances.find( account_balance_id_type( 0 ) ) );
+
+   account_balance_object test_balance;
+   test_balance.id = account_balance_id_type(5);
+   test_balance.owner = account_id_type(5);
+   test_balance.balance = 50;
+   my_balances.load( fc::raw::pack( test_balance ) );
+
+   // the second chunk
+   test_balance.id = account_balance_id_type(2000);
+   test_balance.owner = account_id_type(2000);
+   test_balance.balance = 20;
+   my_balances.load( fc::raw::pack( test_balance ) );
+
+   // index sequence counter is 0
+   const object& created = my_balances.create( [] ( object& o ) {
+       account_balance_object& bal = dynamic_cast< account_balance_object& >( o );
+       BOOST_CHECK_EQUAL( 0u, bal.id.instance() );
+       bal.balance = 10;
+   } );
+   BOOST_CHECK_EQUAL( 3u, my_balances.size() );
+   BOOST_CHECK( &created == my_balances.find( account_balance_id_type( 0 ) ) );
+   BOOST_CHECK( nullptr == my_balances.find( account_balance_id_type( 1 ) ) );
+   BOOST_CHECK( nullptr == my_balances.find( account_balance_id_type( 3000 ) ) );
+
+   // same asset and balance, different owner
+   test_balance.id = account_balance_id_type(6);
+   test_balance.owner = account_id_type(6);
+   test_balance.balance = 50;
+   my_balances.load( fc::raw::pack( test_balance ) );
+   // violates the uniqueness of by_asset_balance
+   GRAPHENE_REQUIRE_THROW( my_balances.load( fc::raw::pack( test_balance ) ), fc::assert_exception );
+   test_balance.id = account_balance_id_type(7);
+   GRAPHENE_REQUIRE_THROW( my_balances.load( fc::raw::pack( test_balance ) ), fc::assert_exception );
+   BOOST_CHECK( nullptr == my_balances.find( account_balance_id_type( 7 ) ) );
+   BOOST_CHECK_EQUAL( 4u, my_balances.size() );
+
+   // iterates by ID
+   std::vector<uint64_t> instances;
+   for( const account_balance_object& bal : my_balances )
+      instances.push_back( bal.id.instance() );
+   BOOST_CHECK( instances == std::vector<uint64_t>( { 0, 5, 6, 2000 } ) );
+
+   // secondary indices are updated on modification
+   my_balances.modify( *my_balances.find( account_balance_id_type( 0 ) ), [] ( object& o ) {
+      dynamic_cast< account_balance_object& >( o ).balance = 100;
+   });
+   const auto& by_balance = my_balances.indices().get<by_asset_balance>();
+   BOOST_CHECK_EQUAL( 0u, (*by_balance.begin())->id.instance() );
+   BOOST_CHECK_EQUAL( 2000u, (*by_balance.rbegin())->id.instance() );
+
+   my_balances.remove( *my_balances.find( account_balance_id_type( 5 ) ) );
+   BOOST_CHECK( nullptr == my_balances.find( account_balance_id_type( 5 ) ) );
+   BOOST_CHECK_EQUAL( 3u, my_balances.size() );
+   BOOST_CHECK_EQUAL( 3u, by_balance.size() );
+
+   // the ID of the removed object can be reused
+   test_balance.id = account_balance_id_type(5);
+   test_balance.owner = account_id_type(5);
+   test_balance.balance = 5;
+   my_balances.load( fc::raw::pack( test_balance ) );
+   BOOST_CHECK_EQUAL( 5, dynamic_cast< const account_balance_object* >(
+                             my_balances.find( account_balance_id_type( 5 ) ) )->balance.value );
+   BOOST_CHECK_EQUAL( 4u, by_balance.size() );
+} FC_LOG_AND_RETHROW() }
+
 BOOST_AUTO_TEST_CASE( required_approval_index_test ) // see https://gitlab.com/dxperts/dxperts-core/issues/1719
 { try {
    ACTORS( (alice)(bob)(charlie)(agnetha)(benny)(carlos) );
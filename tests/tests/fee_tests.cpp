@@ -3660,6 +3660,46 @@ BOOST_AUTO_TEST_CASE( defaults_test )
   }
 }
 
+BOOST_AUTO_TEST_CASE( fee_lookup_table_test )
+{ try {
+    fee_schedule schedule;
+    limit_order_create_operation::fee_parameters_type order_fee; order_fee.fee = 123;
+    schedule.parameters.insert( order_fee );
+    BOOST_CHECK_EQUAL( 123, schedule.calculate_fee( limit_order_create_operation() ).amount.value );
+
+    // modify the parameters in place
+    schedule.parameters.begin()->get<limit_order_create_operation::fee_parameters_type>().fee = 124;
+    BOOST_CHECK_EQUAL( 124, schedule.calculate_fee( limit_order_create_operation() ).amount.value );
+
+    // replace them with the same number of different parameters
+    const call_order_update_operation::fee_parameters_type default_short_fee {};
+    call_order_update_operation::fee_parameters_type short_fee; short_fee.fee = 125;
+    schedule.parameters.clear();
+    schedule.parameters.insert( short_fee );
+    BOOST_CHECK( !schedule.exists<limit_order_create_operation>() );
+    BOOST_CHECK_EQUAL( 125, schedule.calculate_fee( call_order_update_operation() ).amount.value );
+
+    // a copy has its own table
+    fee_schedule copy = schedule;
+    copy.parameters.insert( order_fee );
+    BOOST_CHECK_EQUAL( 123, copy.calculate_fee( limit_order_create_operation() ).amount.value );
+    BOOST_CHECK_EQUAL( 125, copy.calculate_fee( call_order_update_operation() ).amount.value );
+    BOOST_CHECK( !schedule.exists<limit_order_create_operation>() );
+
+    // deserialized schedules
+    copy.update_positions();
+    const auto unpacked = fc::raw::unpack< std::shared_ptr<const fee_schedule> >( fc::raw::pack( copy ) );
+    BOOST_CHECK_EQUAL( 123, unpacked->calculate_fee( limit_order_create_operation() ).amount.value );
+    BOOST_CHECK_EQUAL( 125, unpacked->calculate_fee( call_order_update_operation() ).amount.value );
+    std::shared_ptr<const fee_schedule> converted;
+    fc::from_variant( fc::variant( copy, GRAPHENE_MAX_NESTED_OBJECTS ), converted, GRAPHENE_MAX_NESTED_OBJECTS );
+    BOOST_CHECK_EQUAL( 123, converted->calculate_fee( limit_order_create_operation() ).amount.value );
+
+    schedule.parameters.clear();
+    BOOST_CHECK_EQUAL( (int64_t)default_short_fee.fee,
+                       schedule.calculate_fee( call_order_update_operation() ).amount.value );
+} FC_LOG_AND_RETHROW() }
+
 BOOST_AUTO_TEST_CASE( sub_asset_creation_fee_test )
 { try {
    fee_schedule schedule;
@@ -0,0 +1,330 @@
+/*
+ * Copyright (c) 2021 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "../common/database_fixture.hpp"
+
+#include <graphene/chain/buyback_object.hpp>
+#include <graphene/chain/confidential_object.hpp>
+#include <graphene/chain/custom_authority_object.hpp>
+#include <graphene/chain/hardfork.hpp>
+#include <graphene/chain/htlc_object.hpp>
+#include <graphene/chain/liquidity_pool_object.hpp>
+#include <graphene/chain/market_object.hpp>
+#include <graphene/chain/operation_footprint.hpp>
+#include <graphene/chain/proposal_object.hpp>
+#include <graphene/chain/special_authority_object.hpp>
+#include <graphene/chain/vesting_balance_object.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace graphene::chain;
+using namespace graphene::chain::test;
+
+struct footprint_fixture : database_fixture
+{
+   /// @return true if @p obj, which was changed by an operation, is described by @p fp
+   bool contains( const object_footprint& fp, const object& obj, bool is_new )const
+   {
+      auto in_accounts = [&fp]( account_id_type a ) { return fp.all_accounts || fp.accounts.count( a ) > 0; };
+      auto in_assets = [&fp]( asset_id_type a ) { return fp.all_assets || fp.assets.count( a ) > 0; };
+      auto in_markets = [&fp]( asset_id_type a, asset_id_type b ) {
+         return fp.markets.count( a ) > 0 || fp.markets.count( b ) > 0;
+      };
+
+      if( fp.everything || fp.objects.count( obj.id ) > 0 )
+         return true;
+      if( is_new && fp.new_objects.count( object_id_type( obj.id.space(), obj.id.type(), 0 ) ) > 0 )
+         return true;
+
+      if( obj.id.space() == protocol_ids )
+      {
+         switch( obj.id.type() )
+         {
+         case account_object_type:
+            return in_accounts( obj.id );
+         case asset_object_type:
+            return in_assets( obj.id );
+         case force_settlement_object_type: {
+            const auto& order = static_cast<const force_settlement_object&>( obj );
+            return in_markets( order.settlement_asset_id(), order.settlement_asset_id() );
+         } case limit_order_object_type: {
+            const auto& order = static_cast<const limit_order_object&>( obj );
+            return in_markets( order.sell_token_id(), order.receive_asset_id() );
+         } case call_order_object_type: {
+            const auto& order = static_cast<const call_order_object&>( obj );
+            return in_markets( order.debt_type(), order.collateral_type() );
+         } case vesting_balance_object_type:
+            return in_accounts( static_cast<const vesting_balance_object&>( obj ).owner );
+         default:
+            return false;
+         }
+      }
+
+      switch( obj.id.type() )
+      {
+      case impl_asset_dynamic_data_object_type:
+         for( const auto& a : db.get_index_type<asset_index>().indices() )
+            if( a.dynamic_asset_data_id == obj.id )
+               return in_assets( a.id );
+         return false;
+      case impl_asset_smarttoken_data_object_type:
+         return in_assets( static_cast<const asset_smarttoken_data_object&>( obj ).asset_id );
+      case impl_account_balance_object_type:
+         return in_accounts( static_cast<const account_balance_object&>( obj ).owner );
+      case impl_account_statistics_object_type:
+         return in_accounts( static_cast<const account_statistics_object&>( obj ).owner );
+      case impl_transaction_history_object_type: // belongs to the transaction
+         return true;
+      case impl_blinded_balance_object_type:
+         return in_assets( static_cast<const blinded_balance_object&>( obj ).asset_id );
+      case impl_special_authority_object_type:
+         return in_accounts( static_cast<const special_authority_object&>( obj ).account );
+      case impl_buyback_object_type:
+         return in_assets( static_cast<const buyback_object&>( obj ).asset_to_buy );
+      case impl_collateral_bid_object_type: {
+         const auto& bid = static_cast<const collateral_bid_object&>( obj );
+         return in_markets( bid.debt_type(), bid.inv_swan_price.base.asset_id );
+      } default:
+         return false;
+      }
+   }
+
+   /// Pushes @p op in a transaction of its own and checks that the footprint contains every object it changed
+   operation_footprint push_and_check( operation op )
+   {
+      db.current_fee_schedule().set_fee( op );
+      operation_footprint fp;
+      operation_get_footprint( db, op, fp );
+
+      // The pending state starts empty after a block, so it only contains the changes of this transaction
+      generate_block();
+      signed_transaction tx;
+      set_expiration( db, tx );
+      tx.operations.push_back( op );
+      PUSH_TX( db, tx, ~0 );
+
+      const auto& state = db._undo_db.head();
+      for( const auto& item : state.old_values )
+         BOOST_CHECK_MESSAGE( contains( fp.writes, *item.second, false ),
+                              "operation " << op.which() << " changed " << std::string( item.first ) );
+      for( const auto& item : state.removed )
+         BOOST_CHECK_MESSAGE( contains( fp.writes, *item.second, false ),
+                              "operation " << op.which() << " removed " << std::string( item.first ) );
+      for( const auto& id : state.new_ids )
+         BOOST_CHECK_MESSAGE( contains( fp.writes, db.get_object( id ), true ),
+                              "operation " << op.which() << " created " << std::string( id ) );
+      return fp;
+   }
+
+   operation_footprint footprint( operation op )const
+   {
+      operation_footprint fp;
+      operation_get_footprint( db, op, fp );
+      return fp;
+   }
+};
+
+BOOST_FIXTURE_TEST_SUITE( footprint_tests, footprint_fixture )
+
+BOOST_AUTO_TEST_CASE( footprint_covers_changes )
+{ try {
+   generate_blocks( HARDFORK_BSIP_40_TIME );
+   db.modify( global_property_id_type()(db), []( global_property_object& gpo ) {
+      gpo.parameters.extensions.value.custom_authority_options = custom_authority_options_type();
+      gpo.parameters.extensions.value.updatable_htlc_options = htlc_options{ 60 * 60 * 24, 1024 };
+   });
+   set_expiration( db, trx );
+
+   ACTORS( (alice)(bob)(sam) );
+   fund( alice, asset( 1000 * GRAPHENE_BLOCKCHAIN_PRECISION ) );
+   fund( bob, asset( 1000 * GRAPHENE_BLOCKCHAIN_PRECISION ) );
+   fund( sam, asset( 1000 * GRAPHENE_BLOCKCHAIN_PRECISION ) );
+   upgrade_to_lifetime_member( alice );
+   const asset_object& usd = create_user_issued_asset( "MYUSD", sam, charge_market_fee );
+   const asset_id_type usd_id = usd.id;
+   issue_uia( alice, usd.amount( 100000 ) );
+   issue_uia( sam, usd.amount( 100000 ) );
+
+   transfer_operation top;
+   top.from = alice_id;
+   top.to = bob_id;
+   top.amount = asset( 1000 );
+   operation_footprint fp = push_and_check( top );
+   BOOST_CHECK( fp.writes.accounts.count( alice_id ) && fp.writes.accounts.count( bob_id ) );
+   BOOST_CHECK( !fp.writes.all_accounts && !fp.writes.everything );
+
+   // A matched order pays its owner
+   create_sell_order( alice_id, asset( 100, usd_id ), asset( 100 ) );
+   const limit_order_id_type unmatched = create_sell_order( alice_id, asset( 100, usd_id ), asset( 300 ) )->id;
+   limit_order_create_operation loop;
+   loop.seller = bob_id;
+   loop.amount_to_sell = asset( 100 );
+   loop.min_to_receive = asset( 100, usd_id );
+   loop.expiration = time_point_sec::maximum();
+   push_and_check( loop );
+
+   limit_order_cancel_operation lcop;
+   lcop.fee_paying_account = alice_id;
+   lcop.order = unmatched;
+   push_and_check( lcop );
+
+   push_and_check( make_account( "carol", alice, alice ) );
+   const account_id_type carol_id = get_account( "carol" ).id;
+
+   account_update_operation auop;
+   auop.account = alice_id;
+   auop.new_options = alice_id(db).options;
+   auop.new_options->memo_key = bob_private_key.get_public_key();
+   push_and_check( auop );
+
+   asset_issue_operation iop;
+   iop.issuer = sam_id;
+   iop.asset_to_issue = asset( 1000, usd_id );
+   iop.issue_to_account = carol_id;
+   push_and_check( iop );
+
+   asset_fund_fee_pool_operation fpop;
+   fpop.from_account = bob_id;
+   fpop.asset_id = usd_id;
+   fpop.amount = 1000;
+   push_and_check( fpop );
+
+   // HTLCs
+   std::vector<char> preimage( 32, 'x' );
+   htlc_create_operation hcop;
+   hcop.from = alice_id;
+   hcop.to = bob_id;
+   hcop.amount = asset( 1000 );
+   hcop.preimage_hash = hash_it<fc::sha256>( preimage );
+   hcop.preimage_size = preimage.size();
+   hcop.claim_period_seconds = 3600;
+   htlc_id_type htlc_id = db.get_index_type<htlc_index>().get_next_id();
+   push_and_check( hcop );
+
+   htlc_redeem_operation hrop;
+   hrop.htlc_id = htlc_id;
+   hrop.redeemer = bob_id;
+   hrop.preimage = preimage;
+   push_and_check( hrop );
+
+   htlc_id = db.get_index_type<htlc_index>().get_next_id();
+   push_and_check( hcop );
+
+   htlc_extend_operation heop;
+   heop.htlc_id = htlc_id;
+   heop.update_issuer = alice_id;
+   heop.seconds_to_add = 3600;
+   push_and_check( heop );
+
+   // Custom authorities
+   custom_authority_create_operation cacop;
+   cacop.account = alice_id;
+   cacop.auth.add_authority( bob_id, 1 );
+   cacop.auth.weight_threshold = 1;
+   cacop.enabled = true;
+   cacop.valid_from = db.head_block_time();
+   cacop.valid_to = db.head_block_time() + 3600;
+   cacop.operation_type = operation::tag<transfer_operation>::value;
+   const custom_authority_id_type auth_id = db.get_index_type<custom_authority_index>().get_next_id();
+   push_and_check( cacop );
+
+   custom_authority_delete_operation cadop;
+   cadop.account = alice_id;
+   cadop.authority_to_delete = auth_id;
+   push_and_check( cadop );
+
+   // Proposals
+   const proposal_id_type deleted_proposal = db.get_index_type<proposal_index>().get_next_id();
+   push_and_check( make_proposal_create_op( top, alice_id ) );
+   const proposal_id_type approved_proposal = db.get_index_type<proposal_index>().get_next_id();
+   push_and_check( make_proposal_create_op( top, alice_id ) );
+
+   proposal_delete_operation pdop;
+   pdop.fee_paying_account = alice_id;
+   pdop.proposal = deleted_proposal;
+   push_and_check( pdop );
+
+   proposal_update_operation puop;
+   puop.fee_paying_account = alice_id;
+   puop.proposal = approved_proposal;
+   puop.active_approvals_to_add.insert( alice_id );
+   BOOST_CHECK( push_and_check( puop ).writes.everything );
+
+   // Liquidity pools
+   const asset_id_type lpa_id = create_user_issued_asset( "LPATEST", sam, charge_market_fee ).id;
+   const liquidity_pool_id_type pool_id = db.get_index_type<liquidity_pool_index>().get_next_id();
+   push_and_check( make_liquidity_pool_create_op( sam_id, asset_id_type(), usd_id, lpa_id, 0, 0 ) );
+   push_and_check( make_liquidity_pool_deposit_op( sam_id, pool_id, asset( 10000 ), asset( 10000, usd_id ) ) );
+   push_and_check( make_liquidity_pool_exchange_op( bob_id, pool_id, asset( 100 ), asset( 1, usd_id ) ) );
+   push_and_check( make_liquidity_pool_withdraw_op( sam_id, pool_id, asset( 100, lpa_id ) ) );
+   push_and_check( make_liquidity_pool_withdraw_op( sam_id, pool_id, db.get_balance( sam_id, lpa_id ) ) );
+   push_and_check( make_liquidity_pool_delete_op( sam_id, pool_id ) );
+
+   // Without the pool its assets are not known
+   BOOST_CHECK( footprint( make_liquidity_pool_delete_op( sam_id, pool_id ) ).writes.everything );
+
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( footprint_conflicts )
+{ try {
+   ACTORS( (alice)(bob)(sam)(carol) );
+
+   auto make_transfer = []( account_id_type from, account_id_type to ) {
+      transfer_operation op;
+      op.from = from;
+      op.to = to;
+      op.amount = asset( 1 );
+      return op;
+   };
+
+   const operation_footprint alice_to_bob = footprint( make_transfer( alice_id, bob_id ) );
+   BOOST_CHECK( !alice_to_bob.conflicts_with( footprint( make_transfer( sam_id, carol_id ) ) ) );
+   BOOST_CHECK( alice_to_bob.conflicts_with( footprint( make_transfer( bob_id, sam_id ) ) ) );
+   BOOST_CHECK( alice_to_bob.conflicts_with( alice_to_bob ) );
+
+   // Unrelated accounts may be paid when orders are matched
+   limit_order_create_operation loop;
+   loop.seller = sam_id;
+   loop.amount_to_sell = asset( 1 );
+   loop.min_to_receive = asset( 1, asset_id_type( 1 ) );
+   BOOST_CHECK( alice_to_bob.conflicts_with( footprint( loop ) ) );
+
+   // Both take the next account ID
+   BOOST_CHECK( footprint( make_account( "dan" ) ).conflicts_with( footprint( make_account( "eve" ) ) ) );
+
+   htlc_create_operation hcop;
+   hcop.from = alice_id;
+   hcop.to = bob_id;
+   hcop.amount = asset( 1 );
+   custom_authority_create_operation cacop;
+   cacop.account = sam_id;
+   cacop.auth.add_authority( carol_id, 1 );
+   BOOST_CHECK( !footprint( hcop ).conflicts_with( footprint( cacop ) ) );
+   // The recipient is read
+   BOOST_CHECK( footprint( hcop ).conflicts_with( footprint( make_transfer( bob_id, sam_id ) ) ) );
+   BOOST_CHECK( footprint( hcop ).conflicts_with( footprint( make_transfer( sam_id, alice_id ) ) ) );
+
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -58,4 +58,83 @@ BOOST_AUTO_TEST_CASE(api_limit_get_grouped_limit_orders) {
     throw;
    }
 }
+BOOST_AUTO_TEST_CASE(get_grouped_limit_orders_buckets) {
+   try
+   {
+   app.enable_plugin("grouped_orders");
+   graphene::app::orders_api orders_api(app);
+
+   ACTORS((seller));
+   const asset_id_type usd_id = create_user_issued_asset("USD").id;
+   const std::string core = std::string( static_cast<object_id_type>(asset_id_type()) );
+   const std::string usd = std::string( static_cast<object_id_type>(usd_id) );
+   transfer(dxpcore_account, seller_id, asset(1000000));
+
+   // prices of 1, 1.0005, 1.005 and 1.02, in the 0.1% buckets 0, 0, 4 and 19 and the 1% buckets 0, 0, 0 and 1
+   create_sell_order(seller_id, asset(1000), asset(1000, usd_id));
+   const limit_order_object* inner = create_sell_order(seller_id, asset(10005), asset(10000, usd_id));
+   BOOST_REQUIRE( inner );
+   create_sell_order(seller_id, asset(1005), asset(1000, usd_id));
+   const limit_order_object* highest = create_sell_order(seller_id, asset(1020), asset(1000, usd_id));
+   BOOST_REQUIRE( highest );
+
+   optional<price> start;
+   vector< limit_order_group > groups = orders_api.get_grouped_limit_orders(core, usd, 10, start, 10);
+   BOOST_REQUIRE_EQUAL( groups.size(), 3u );
+   BOOST_CHECK( groups[0].min_price == price(asset(1020), asset(1000, usd_id)) );
+   BOOST_CHECK( groups[0].max_price == price(asset(1020), asset(1000, usd_id)) );
+   BOOST_CHECK_EQUAL( groups[0].total_for_sale.value, 1020 );
+   BOOST_CHECK_EQUAL( groups[1].total_for_sale.value, 1005 );
+   BOOST_CHECK( groups[2].min_price == price(asset(1000), asset(1000, usd_id)) );
+   BOOST_CHECK( groups[2].max_price == price(asset(10005), asset(10000, usd_id)) );
+   BOOST_CHECK_EQUAL( groups[2].total_for_sale.value, 11005 );
+
+   groups = orders_api.get_grouped_limit_orders(core, usd, 100, start, 10);
+   BOOST_REQUIRE_EQUAL( groups.size(), 2u );
+   BOOST_CHECK_EQUAL( groups[0].total_for_sale.value, 1020 );
+   BOOST_CHECK_EQUAL( groups[1].total_for_sale.value, 12010 );
+
+   // start with the group that contains the price
+   start = price(asset(1001), asset(1000, usd_id));
+   groups = orders_api.get_grouped_limit_orders(core, usd, 10, start, 10);
+   BOOST_REQUIRE_EQUAL( groups.size(), 1u );
+   BOOST_CHECK_EQUAL( groups[0].total_for_sale.value, 11005 );
+   start = price(asset(1010), asset(1000, usd_id));
+   groups = orders_api.get_grouped_limit_orders(core, usd, 10, start, 1);
+   BOOST_REQUIRE_EQUAL( groups.size(), 1u );
+   BOOST_CHECK_EQUAL( groups[0].total_for_sale.value, 1005 );
+
+   // not tracked
+   start.reset();
+   BOOST_CHECK_EQUAL( orders_api.get_grouped_limit_orders(core, usd, 20, start, 10).size(), 0u );
+   BOOST_CHECK_EQUAL( orders_api.get_grouped_limit_orders(usd, core, 10, start, 10).size(), 0u );
+
+   // removed orders are gone from their groups
+   cancel_limit_order(*highest);
+   groups = orders_api.get_grouped_limit_orders(core, usd, 10, start, 10);
+   BOOST_REQUIRE_EQUAL( groups.size(), 2u );
+   BOOST_CHECK_EQUAL( groups[0].total_for_sale.value, 1005 );
+   BOOST_CHECK_EQUAL( groups[1].total_for_sale.value, 11005 );
+   groups = orders_api.get_grouped_limit_orders(core, usd, 100, start, 10);
+   BOOST_REQUIRE_EQUAL( groups.size(), 1u );
+   BOOST_CHECK_EQUAL( groups[0].total_for_sale.value, 12010 );
+
+   // the price range of a group shrinks when the order at its end is removed
+   cancel_limit_order(*inner);
+   groups = orders_api.get_grouped_limit_orders(core, usd, 10, start, 10);
+   BOOST_REQUIRE_EQUAL( groups.size(), 2u );
+   BOOST_CHECK( groups[1].min_price == price(asset(1000), asset(1000, usd_id)) );
+   BOOST_CHECK( groups[1].max_price == price(asset(1000), asset(1000, usd_id)) );
+   BOOST_CHECK_EQUAL( groups[1].total_for_sale.value, 1000 );
+   groups = orders_api.get_grouped_limit_orders(core, usd, 100, start, 10);
+   BOOST_REQUIRE_EQUAL( groups.size(), 1u );
+   BOOST_CHECK( groups[0].min_price == price(asset(1000), asset(1000, usd_id)) );
+   BOOST_CHECK( groups[0].max_price == price(asset(1005), asset(1000, usd_id)) );
+   BOOST_CHECK_EQUAL( groups[0].total_for_sale.value, 2005 );
+   }catch (fc::exception &e)
+   {
+    edump((e.to_detail_string()));
+    throw;
+   }
+}
 BOOST_AUTO_TEST_SUITE_END()
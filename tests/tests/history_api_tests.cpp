@@ -25,6 +25,9 @@
 #include <boost/test/unit_test.hpp>
 
 #include <graphene/app/api.hpp>
+#include <graphene/account_history/account_history_plugin.hpp>
+#include <graphene/account_history/account_history_store.hpp>
+#include <graphene/market_history/market_history_store.hpp>
 
 #include <graphene/utilities/tempdir.hpp>
 
@@ -741,6 +744,241 @@ BOOST_AUTO_TEST_CASE(api_limit_get_relative_account_history) {
    }
 }
 
+BOOST_AUTO_TEST_CASE(get_account_history_from_store) {
+   try {
+      graphene::app::history_api hist_api(app);
+      auto ah_plugin = app.get_plugin<graphene::account_history::account_history_plugin>( "account_history" );
+      BOOST_REQUIRE( ah_plugin->history_store() != nullptr );
+
+      create_smarttoken("USD", account_id_type()); // create op 0
+      const account_object& dan = create_account("dan");
+      create_smarttoken("CNY", dan.id);
+      create_smarttoken("BTC", account_id_type());
+      generate_block();
+      const uint32_t archived_block = db.head_block_num();
+
+      // move the operations above to the store
+      for( int i = 0; i < 100 && db.get_dynamic_global_properties().last_irreversible_block_num < archived_block; ++i )
+         generate_block();
+      BOOST_REQUIRE_GE( db.get_dynamic_global_properties().last_irreversible_block_num, archived_block );
+      BOOST_CHECK( db.find( operation_history_id_type() ) == nullptr );
+      BOOST_CHECK_GT( account_id_type()(db).statistics(db).removed_ops, 0u );
+      BOOST_CHECK_GE( ah_plugin->history_store()->last_sequence( account_id_type() ), 3u );
+
+      // these stay in memory
+      create_smarttoken("XMR", dan.id);
+      create_smarttoken("EUR", account_id_type());
+      generate_block();
+      const auto& stats = account_id_type()(db).statistics(db);
+      BOOST_REQUIRE_GT( stats.total_ops, stats.removed_ops );
+
+      vector<operation_history_object> histories = hist_api.get_account_history("1.2.0", operation_history_id_type(), 100, operation_history_id_type());
+      BOOST_REQUIRE_EQUAL( histories.size(), stats.total_ops );
+      for( size_t i = 1; i < histories.size(); ++i )
+         BOOST_CHECK_GT( histories[i-1].id.instance(), histories[i].id.instance() );
+      BOOST_CHECK_EQUAL( histories.back().id.instance(), 0u );
+      BOOST_CHECK_EQUAL( histories.back().op.which(), operation::tag<asset_create_operation>::value );
+
+      // relative history returns the same operations
+      vector<operation_history_object> relative = hist_api.get_relative_account_history("1.2.0", 0, 100, 0);
+      BOOST_REQUIRE_EQUAL( relative.size(), histories.size() );
+      for( size_t i = 0; i < histories.size(); ++i )
+         BOOST_CHECK( relative[i].id == histories[i].id );
+
+      // a range across memory and store, and one only in the store
+      relative = hist_api.get_relative_account_history("1.2.0", stats.removed_ops, 2, stats.removed_ops + 1);
+      BOOST_REQUIRE_EQUAL( relative.size(), 2u );
+      BOOST_CHECK( relative[0].id == histories[histories.size() - stats.removed_ops - 1].id );
+      BOOST_CHECK( relative[1].id == histories[histories.size() - stats.removed_ops].id );
+      relative = hist_api.get_relative_account_history("1.2.0", 1, 100, 2);
+      BOOST_REQUIRE_EQUAL( relative.size(), 2u );
+      BOOST_CHECK_EQUAL( relative[1].id.instance(), 0u );
+
+      // start by operation ID in the store
+      const operation_history_id_type second_op = histories[histories.size() - 2].id;
+      histories = hist_api.get_account_history("1.2.0", operation_history_id_type(0), 100, second_op);
+      BOOST_REQUIRE_EQUAL( histories.size(), 2u );
+      BOOST_CHECK( histories[0].id == second_op );
+      BOOST_CHECK_EQUAL( histories[1].id.instance(), 0u );
+
+      // dan has history in the store and in memory as well
+      histories = hist_api.get_account_history("dan", operation_history_id_type(), 100, operation_history_id_type());
+      BOOST_CHECK_EQUAL( histories.size(), dan.statistics(db).total_ops );
+
+   } catch (fc::exception &e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE(get_account_history_operations_from_store) {
+   try {
+      graphene::app::history_api hist_api(app);
+      auto ah_plugin = app.get_plugin<graphene::account_history::account_history_plugin>( "account_history" );
+      BOOST_REQUIRE( ah_plugin->history_store() != nullptr );
+
+      int asset_create_op_id = operation::tag<asset_create_operation>::value;
+      int account_create_op_id = operation::tag<account_create_operation>::value;
+
+      create_smarttoken("USD", account_id_type()); // create op 0
+      create_account("dan");
+      create_smarttoken("CNY", account_id_type());
+      generate_block();
+      const uint32_t archived_block = db.head_block_num();
+
+      // move the operations above to the store
+      for( int i = 0; i < 100 && db.get_dynamic_global_properties().last_irreversible_block_num < archived_block; ++i )
+         generate_block();
+      BOOST_REQUIRE_GE( db.get_dynamic_global_properties().last_irreversible_block_num, archived_block );
+      BOOST_CHECK( db.find( operation_history_id_type() ) == nullptr );
+
+      // only the operations in the store
+      const auto& stats = account_id_type()(db).statistics(db);
+      BOOST_REQUIRE_GT( stats.removed_ops, 0u );
+      BOOST_REQUIRE( db.find( stats.most_recent_op ) == nullptr );
+      vector<operation_history_object> histories = hist_api.get_account_history_operations(
+            "1.2.0", asset_create_op_id, operation_history_id_type(), operation_history_id_type(), 100);
+      BOOST_REQUIRE_EQUAL( histories.size(), 2u );
+      BOOST_CHECK_GT( histories[0].id.instance(), histories[1].id.instance() );
+      BOOST_CHECK_EQUAL( histories[1].id.instance(), 0u );
+
+      // these stay in memory
+      create_smarttoken("BTC", account_id_type());
+      create_account("bob");
+      generate_block();
+      BOOST_REQUIRE_GT( stats.total_ops, stats.removed_ops );
+
+      // the same operations as in the unfiltered history
+      const vector<operation_history_object> all = hist_api.get_account_history("1.2.0",
+            operation_history_id_type(), 100, operation_history_id_type());
+      for( int op_type : { asset_create_op_id, account_create_op_id } )
+      {
+         vector<operation_history_object> expected;
+         std::copy_if( all.begin(), all.end(), std::back_inserter( expected ),
+                       [op_type]( const operation_history_object& o ) { return o.op.which() == op_type; } );
+         histories = hist_api.get_account_history_operations(
+               "1.2.0", op_type, operation_history_id_type(), operation_history_id_type(), 100);
+         BOOST_REQUIRE_EQUAL( histories.size(), expected.size() );
+         for( size_t i = 0; i < histories.size(); ++i )
+            BOOST_CHECK( histories[i].id == expected[i].id );
+      }
+      histories = hist_api.get_account_history_operations(
+            "1.2.0", asset_create_op_id, operation_history_id_type(), operation_history_id_type(), 100);
+      BOOST_REQUIRE_EQUAL( histories.size(), 3u );
+      BOOST_CHECK_EQUAL( histories.back().id.instance(), 0u );
+
+      // the limit applies across memory and store
+      histories = hist_api.get_account_history_operations(
+            "1.2.0", asset_create_op_id, operation_history_id_type(), operation_history_id_type(), 2);
+      BOOST_REQUIRE_EQUAL( histories.size(), 2u );
+      BOOST_CHECK_GT( histories[1].id.instance(), 0u );
+
+   } catch (fc::exception &e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE(get_market_history_from_store) {
+   try {
+      graphene::app::history_api hist_api(app);
+      auto mh_plugin = app.get_plugin<graphene::market_history::market_history_plugin>( "market_history" );
+      BOOST_REQUIRE( mh_plugin->history_store() != nullptr );
+
+      ACTORS( (seller)(buyer) );
+      const asset_id_type test_id = create_user_issued_asset( "UIATEST" ).id;
+      transfer( account_id_type(), seller_id, asset( 100000000 ) );
+      transfer( account_id_type(), buyer_id, asset( 100000000 ) );
+      issue_uia( buyer_id, asset( 100000000, test_id ) );
+      generate_block();
+
+      // every trade fills two orders, in a bucket of its own
+      const fc::time_point_sec first_trade = db.head_block_time();
+      for( int i = 0; i < 10; ++i )
+      {
+         create_sell_order( seller_id, asset( 100 ), asset( 200, test_id ) );
+         create_sell_order( buyer_id, asset( 200, test_id ), asset( 100 ) );
+         generate_blocks( db.head_block_time() + fc::seconds(15) );
+      }
+
+      // move the removed history to the store
+      const uint32_t last_trade_block = db.head_block_num();
+      for( int i = 0; i < 100 && db.get_dynamic_global_properties().last_irreversible_block_num < last_trade_block;
+           ++i )
+         generate_block();
+      BOOST_REQUIRE_GE( db.get_dynamic_global_properties().last_irreversible_block_num, last_trade_block );
+      BOOST_CHECK_LT( get_market_order_history( asset_id_type(), test_id ).size(), 20u );
+
+      vector<order_history_object> fills = hist_api.get_fill_order_history( "1.3.0", "UIATEST", 100 );
+      BOOST_REQUIRE_EQUAL( fills.size(), 20u );
+      for( size_t i = 1; i < fills.size(); ++i )
+      {
+         BOOST_CHECK_LT( fills[i-1].key.sequence, fills[i].key.sequence );
+         BOOST_CHECK( fills[i-1].time >= fills[i].time );
+      }
+      // the first trade
+      const auto& maker_fill = ( fills[18].op.is_maker ? fills[18] : fills[19] );
+      BOOST_CHECK( maker_fill.op.pays == asset( 100 ) );
+      BOOST_CHECK( maker_fill.op.receives == asset( 200, test_id ) );
+      BOOST_CHECK( maker_fill.op.account_id == seller_id );
+      BOOST_CHECK( maker_fill.op.fill_price == asset( 100 ) / asset( 200, test_id ) );
+
+      // reading across memory and store in pages
+      vector<order_history_object> page = hist_api.get_fill_order_history( "1.3.0", "UIATEST", 5 );
+      BOOST_REQUIRE_EQUAL( page.size(), 5u );
+      BOOST_CHECK( page.back().id == fills[4].id );
+
+      vector<bucket_object> buckets = hist_api.get_market_history( "1.3.0", "UIATEST", 15,
+                                                                   first_trade, db.head_block_time() );
+      BOOST_REQUIRE_EQUAL( buckets.size(), 10u );
+      share_type base_volume = 0;
+      for( size_t i = 0; i < buckets.size(); ++i )
+      {
+         if( i > 0 )
+            BOOST_CHECK( buckets[i-1].key.open < buckets[i].key.open );
+         BOOST_CHECK_EQUAL( buckets[i].key.seconds, 15u );
+         base_volume += buckets[i].base_volume;
+      }
+      BOOST_CHECK_EQUAL( base_volume.value, 1000 );
+
+      // buckets of a multiple of the tracked size are rolled up from the tracked buckets
+      const fc::time_point_sec rolled_start( first_trade.sec_since_epoch() / 60 * 60 );
+      vector<bucket_object> rolled = hist_api.get_market_history( "1.3.0", "UIATEST", 60,
+                                                                  rolled_start, db.head_block_time() );
+      BOOST_REQUIRE_GE( rolled.size(), 3u );
+      BOOST_REQUIRE_LE( rolled.size(), 5u );
+      share_type rolled_volume = 0;
+      size_t next_bucket = 0;
+      for( const auto& r : rolled )
+      {
+         BOOST_CHECK_EQUAL( r.key.seconds, 60u );
+         BOOST_CHECK_EQUAL( r.key.open.sec_since_epoch() % 60, 0u );
+         BOOST_CHECK( r.open_base == buckets[next_bucket].open_base );
+         while( next_bucket < buckets.size() && buckets[next_bucket].key.open < r.key.open + 60 )
+            ++next_bucket;
+         BOOST_CHECK( r.close_base == buckets[next_bucket - 1].close_base );
+         rolled_volume += r.base_volume;
+      }
+      BOOST_CHECK_EQUAL( next_bucket, buckets.size() );
+      BOOST_CHECK_EQUAL( rolled_volume.value, 1000 );
+
+      // rolled up buckets that open before the start are not returned, even if some of their trades are after it
+      vector<bucket_object> rolled_later = hist_api.get_market_history( "1.3.0", "UIATEST", 60,
+                                                                        rolled.front().key.open + 1,
+                                                                        db.head_block_time() );
+      BOOST_REQUIRE_EQUAL( rolled_later.size(), rolled.size() - 1 );
+      for( size_t i = 0; i < rolled_later.size(); ++i )
+         BOOST_CHECK( rolled_later[i].key.open == rolled[i+1].key.open );
+
+      // other sizes are not available
+      BOOST_CHECK( hist_api.get_market_history( "1.3.0", "UIATEST", 20, first_trade, db.head_block_time() ).empty() );
+
+   } catch (fc::exception &e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
 BOOST_AUTO_TEST_CASE(api_limit_get_account_history_by_operations) {
    try {
    graphene::app::history_api hist_api(app);
@@ -0,0 +1,183 @@
+/*
+ * Copyright (c) 2021 Abit More, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include <graphene/utilities/tempdir.hpp>
+
+#include <boost/accumulators/accumulators.hpp>
+#include <boost/accumulators/statistics/stats.hpp>
+#include <boost/accumulators/statistics/rolling_mean.hpp>
+#include <boost/accumulators/statistics/min.hpp>
+#include <boost/accumulators/statistics/max.hpp>
+#include <boost/accumulators/statistics/sum.hpp>
+#include <boost/accumulators/statistics/count.hpp>
+#include <boost/circular_buffer.hpp>
+#include <boost/multi_index/ordered_index.hpp>
+#include <boost/preprocessor/seq/for_each.hpp>
+
+#include <fc/network/rate_limiting.hpp>
+#include <fc/thread/mutex.hpp>
+#include <fc/thread/scoped_lock.hpp>
+#include <fc/thread/thread.hpp>
+
+#include <graphene/net/config.hpp>
+#include <graphene/net/peer_database.hpp>
+
+// node_impl.hxx is not self-contained, it expects the includes of node.cpp above
+#include "../../libraries/net/node_impl.hxx"
+#include "../common/database_fixture.hpp"
+
+using namespace graphene::chain;
+using namespace graphene::chain::test;
+
+namespace {
+
+/// Handles transactions the way the application does, the other calls are not used by these tests
+class chain_node_delegate : public graphene::net::node_delegate
+{
+   public:
+      explicit chain_node_delegate( database& db ) : _db( db ) {}
+
+      void handle_transaction( const graphene::net::trx_message& trx_msg ) override
+      {
+         _db.precompute_parallel( trx_msg.trx ).wait();
+         _db.push_transaction( trx_msg.trx );
+      }
+
+      bool has_item( const graphene::net::item_id& ) override { FC_THROW( "not used" ); }
+      bool handle_block( const graphene::net::block_message&, bool,
+                         std::vector<graphene::net::message_hash_type>& ) override { FC_THROW( "not used" ); }
+      void handle_message( const graphene::net::message& ) override { FC_THROW( "not used" ); }
+      std::vector<graphene::net::item_hash_t> get_block_ids( const std::vector<graphene::net::item_hash_t>&,
+                                                             uint32_t&, uint32_t ) override
+      { FC_THROW( "not used" ); }
+      graphene::net::message get_item( const graphene::net::item_id& ) override { FC_THROW( "not used" ); }
+      chain_id_type get_chain_id()const override { return _db.get_chain_id(); }
+      std::vector<graphene::net::item_hash_t> get_blockchain_synopsis( const graphene::net::item_hash_t&,
+                                                                       uint32_t ) override
+      { FC_THROW( "not used" ); }
+      void sync_status( uint32_t, uint32_t ) override {}
+      void connection_count_changed( uint32_t ) override {}
+      uint32_t get_block_number( const graphene::net::item_hash_t& ) override { FC_THROW( "not used" ); }
+      fc::time_point_sec get_block_time( const graphene::net::item_hash_t& ) override { FC_THROW( "not used" ); }
+      graphene::net::item_hash_t get_head_block_id()const override { return _db.head_block_id(); }
+      uint32_t estimate_last_known_fork_from_git_revision_timestamp( uint32_t ) const override { return 0; }
+      void error_encountered( const std::string&, const fc::oexception& ) override {}
+      uint8_t get_current_block_interval_in_seconds()const override
+      { return _db.get_global_properties().parameters.block_interval; }
+
+   private:
+      database& _db;
+};
+
+}
+
+BOOST_FIXTURE_TEST_SUITE( node_delegate_tests, database_fixture )
+
+BOOST_AUTO_TEST_CASE( async_transactions_match_sync )
+{ try {
+   ACTORS( (alice)(bob)(carol) );
+   transfer( account_id_type(), alice_id, asset( 100000000 ) );
+   generate_block();
+
+   // two nodes at the head of the chain, one is handed the transactions synchronously, the other one through the
+   // queue that is drained on the chain thread
+   fc::temp_directory sync_dir( graphene::utilities::temp_directory_path() );
+   fc::temp_directory async_dir( graphene::utilities::temp_directory_path() );
+   database sync_db;
+   database async_db;
+   sync_db.open( sync_dir.path(), [this]{ return genesis_state; }, "TEST" );
+   async_db.open( async_dir.path(), [this]{ return genesis_state; }, "TEST" );
+   for( uint32_t n = 1; n <= db.head_block_num(); ++n )
+   {
+      PUSH_BLOCK( sync_db, *db.fetch_block_by_number( n ), ~0 );
+      PUSH_BLOCK( async_db, *db.fetch_block_by_number( n ), ~0 );
+   }
+
+   // bob can only pay carol after alice paid him, the duplicate and the overdraft of carol are rejected
+   vector<signed_transaction> transactions;
+   auto add_transfer = [this,&transactions]( account_id_type from, account_id_type to, int64_t amount,
+                                             const fc::ecc::private_key& key ) {
+      signed_transaction tx;
+      set_expiration( db, tx );
+      transfer_operation op;
+      op.from = from;
+      op.to = to;
+      op.amount = asset( amount );
+      tx.operations.push_back( op );
+      db.current_fee_schedule().set_fee( tx.operations.back() );
+      sign( tx, key );
+      transactions.push_back( tx );
+   };
+   add_transfer( alice_id, bob_id, 50000000, alice_private_key );
+   add_transfer( bob_id, carol_id, 20000000, bob_private_key );
+   transactions.push_back( transactions.front() );
+   add_transfer( carol_id, alice_id, 30000000, carol_private_key );
+   add_transfer( alice_id, carol_id, 1000000, alice_private_key );
+   const vector<bool> expected{ true, true, false, false, true };
+
+   fc::thread sync_thread( "sync chain" );
+   fc::thread async_thread( "async chain" );
+   graphene::net::detail::statistics_gathering_node_delegate_wrapper sync_node(
+         std::make_shared<chain_node_delegate>( sync_db ), &sync_thread );
+   graphene::net::detail::statistics_gathering_node_delegate_wrapper async_node(
+         std::make_shared<chain_node_delegate>( async_db ), &async_thread );
+
+   vector<bool> sync_accepted;
+   for( const auto& tx : transactions )
+   {
+      try
+      {
+         sync_node.handle_transaction( graphene::net::trx_message( tx ) );
+         sync_accepted.push_back( true );
+      }
+      catch( const fc::exception& )
+      {
+         sync_accepted.push_back( false );
+      }
+   }
+
+   vector<bool> async_accepted( transactions.size() );
+   size_t handled = 0;
+   for( size_t i = 0; i < transactions.size(); ++i )
+      async_node.handle_transaction_async( graphene::net::trx_message( transactions[i] ),
+            [&async_accepted,&handled,i]( const fc::oexception& e ) {
+               async_accepted[i] = !e.valid();
+               ++handled;
+            } );
+   // the results are reported in tasks on this thread
+   for( int i = 0; i < 1000 && handled < transactions.size(); ++i )
+      fc::usleep( fc::milliseconds( 10 ) );
+   BOOST_REQUIRE_EQUAL( handled, transactions.size() );
+
+   BOOST_CHECK( sync_accepted == expected );
+   BOOST_CHECK( async_accepted == expected );
+   for( const account_id_type account : { alice_id, bob_id, carol_id } )
+      BOOST_CHECK_EQUAL( async_db.get_balance( account, asset_id_type() ).amount.value,
+                         sync_db.get_balance( account, asset_id_type() ).amount.value );
+   BOOST_CHECK_EQUAL( sync_db.get_balance( carol_id, asset_id_type() ).amount.value, 21000000 );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -25,6 +25,8 @@
 #include <boost/test/unit_test.hpp>
 
 #include <graphene/chain/database.hpp>
+#include <graphene/net/core_messages.hpp>
+#include <graphene/net/message.hpp>
 
 
 #include <fc/crypto/digest.hpp>
@@ -74,6 +76,35 @@ BOOST_AUTO_TEST_CASE( serialization_json_test )
    }
 }
 
+BOOST_AUTO_TEST_CASE( message_id_test )
+{
+   try {
+      ACTORS( (alice)(bob) );
+      transfer_operation op;
+      op.from = alice_id;
+      op.to = bob_id;
+      op.amount = asset(100);
+      trx.operations.push_back( op );
+      test::set_expiration( db, trx );
+      sign( trx, alice_private_key );
+
+      // the cached message ID should be the same as the ID of the p2p message carrying the transaction
+      const auto expected_id = graphene::net::message( graphene::net::trx_message( trx ) ).id();
+      processed_transaction ptrx( trx );
+      ptrx.operation_results.emplace_back( void_result() );
+      BOOST_CHECK( ptrx.get_message_id() == expected_id );
+      BOOST_CHECK( precomputable_transaction( trx ).get_message_id() == expected_id );
+
+      // the cached value is kept when wrapping an already precomputed transaction into a p2p message
+      graphene::net::trx_message msg( ptrx );
+      BOOST_CHECK( msg.trx.get_message_id() == expected_id );
+      BOOST_CHECK( graphene::net::message( msg ).id() == expected_id );
+   } catch (fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
 BOOST_AUTO_TEST_CASE( json_tests )
 {
    try {
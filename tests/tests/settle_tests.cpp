@@ -1852,17 +1852,18 @@ BOOST_AUTO_TEST_CASE( market_fee_of_instant_settle_order_after_hardfork_1780 )
 /**
  * Test case to reproduce https://gitlab.com/dxperts/dxperts-core/issues/1883.
  * When there is only one fill_order object in the ticker rolling buffer, it should only be rolled out once.
+ * The fill is rolled out with the slot of the ticker that contains it.
  */
 BOOST_AUTO_TEST_CASE( global_settle_ticker_test )
 {
    try {
       generate_block();
 
-      const auto& meta_idx = db.get_index_type<simple_index<graphene::market_history::market_ticker_meta_object>>();
+      const auto& slot_idx = db.get_index_type<graphene::market_history::market_ticker_slot_index>().indices();
       const auto& ticker_idx = db.get_index_type<graphene::market_history::market_ticker_index>().indices();
       const auto& history_idx = db.get_index_type<graphene::market_history::history_index>().indices();
 
-      BOOST_CHECK_EQUAL( meta_idx.size(), 0 );
+      BOOST_CHECK_EQUAL( slot_idx.size(), 0 );
       BOOST_CHECK_EQUAL( ticker_idx.size(), 0 );
       BOOST_CHECK_EQUAL( history_idx.size(), 0 );
 
@@ -1885,16 +1886,17 @@ BOOST_AUTO_TEST_CASE( global_settle_ticker_test )
       fc::usleep(fc::milliseconds(200)); // sleep a while to execute callback in another thread
 
       {
-         BOOST_CHECK_EQUAL( meta_idx.size(), 1 );
+         BOOST_CHECK_EQUAL( slot_idx.size(), 1 );
          BOOST_CHECK_EQUAL( ticker_idx.size(), 1 );
          BOOST_CHECK_EQUAL( history_idx.size(), 1 );
 
-         const auto& meta = *meta_idx.begin();
+         const auto& slot = *slot_idx.begin();
          const auto& tick = *ticker_idx.begin();
          const auto& hist = *history_idx.begin();
 
-         BOOST_CHECK( meta.rolling_min_order_his_id == hist.id );
-         BOOST_CHECK( meta.skip_min_order_his_id == false );
+         BOOST_CHECK( slot.open <= hist.time );
+         BOOST_CHECK( slot.base_volume == 1000 );
+         BOOST_CHECK( slot.quote_volume == 1000 );
 
          BOOST_CHECK( tick.base_volume == 1000 );
          BOOST_CHECK( tick.quote_volume == 1000 );
@@ -1905,16 +1907,17 @@ BOOST_AUTO_TEST_CASE( global_settle_ticker_test )
 
       // nothing changes
       {
-         BOOST_CHECK_EQUAL( meta_idx.size(), 1 );
+         BOOST_CHECK_EQUAL( slot_idx.size(), 1 );
          BOOST_CHECK_EQUAL( ticker_idx.size(), 1 );
          BOOST_CHECK_EQUAL( history_idx.size(), 1 );
 
-         const auto& meta = *meta_idx.begin();
+         const auto& slot = *slot_idx.begin();
          const auto& tick = *ticker_idx.begin();
          const auto& hist = *history_idx.begin();
 
-         BOOST_CHECK( meta.rolling_min_order_his_id == hist.id );
-         BOOST_CHECK( meta.skip_min_order_his_id == false );
+         BOOST_CHECK( slot.open <= hist.time );
+         BOOST_CHECK( slot.base_volume == 1000 );
+         BOOST_CHECK( slot.quote_volume == 1000 );
 
          BOOST_CHECK( tick.base_volume == 1000 );
          BOOST_CHECK( tick.quote_volume == 1000 );
@@ -1925,16 +1928,11 @@ BOOST_AUTO_TEST_CASE( global_settle_ticker_test )
 
       // the history is rolled out, new 24h volume should be 0
       {
-         BOOST_CHECK_EQUAL( meta_idx.size(), 1 );
+         BOOST_CHECK_EQUAL( slot_idx.size(), 0 ); // the slot is removed, so it can not be rolled out again
          BOOST_CHECK_EQUAL( ticker_idx.size(), 1 );
          BOOST_CHECK_EQUAL( history_idx.size(), 1 );
 
-         const auto& meta = *meta_idx.begin();
          const auto& tick = *ticker_idx.begin();
-         const auto& hist = *history_idx.begin();
-
-         BOOST_CHECK( meta.rolling_min_order_his_id == hist.id );
-         BOOST_CHECK( meta.skip_min_order_his_id == true ); // the order should be skipped on next roll
 
          BOOST_CHECK( tick.base_volume == 0 );
          BOOST_CHECK( tick.quote_volume == 0 );
@@ -1945,16 +1943,11 @@ BOOST_AUTO_TEST_CASE( global_settle_ticker_test )
 
       // nothing changes
       {
-         BOOST_CHECK_EQUAL( meta_idx.size(), 1 );
+         BOOST_CHECK_EQUAL( slot_idx.size(), 0 );
          BOOST_CHECK_EQUAL( ticker_idx.size(), 1 );
          BOOST_CHECK_EQUAL( history_idx.size(), 1 );
 
-         const auto& meta = *meta_idx.begin();
          const auto& tick = *ticker_idx.begin();
-         const auto& hist = *history_idx.begin();
-
-         BOOST_CHECK( meta.rolling_min_order_his_id == hist.id );
-         BOOST_CHECK( meta.skip_min_order_his_id == true );
 
          BOOST_CHECK( tick.base_volume == 0 );
          BOOST_CHECK( tick.quote_volume == 0 );
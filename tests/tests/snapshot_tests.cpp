@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2021 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include <graphene/snapshot/snapshot.hpp>
+#include <graphene/chain/account_object.hpp>
+#include <graphene/utilities/tempdir.hpp>
+
+#include <fc/io/json.hpp>
+
+#include <fstream>
+
+#include "../common/database_fixture.hpp"
+
+using namespace graphene::chain;
+using namespace graphene::chain::test;
+using namespace graphene::snapshot_plugin;
+
+BOOST_FIXTURE_TEST_SUITE( snapshot_tests, database_fixture )
+
+BOOST_AUTO_TEST_CASE( snapshot_write_and_read )
+{ try {
+   ACTORS( (alice)(bob) );
+   generate_block();
+
+   fc::temp_directory dir( graphene::utilities::temp_directory_path() );
+   auto state = capture_snapshot( db );
+   BOOST_CHECK_EQUAL( state->header.block_num, db.head_block_num() );
+
+   const auto& accounts = db.get_index_type<account_index>().indices().get<by_id>();
+   const fc::path file = dir.path() / "snapshot.bin";
+   write_snapshot( *state, binary, file );
+   BOOST_REQUIRE( fc::exists( file ) );
+
+   snapshot_reader reader( file );
+   BOOST_CHECK_EQUAL( reader.header().format, binary );
+   BOOST_CHECK_EQUAL( reader.header().block_num, db.head_block_num() );
+   BOOST_CHECK( reader.header().block_id == db.head_block_id() );
+
+   size_t records = 0;
+   snapshot_chunk_header chunk;
+   while( reader.next_chunk( chunk ) )
+   {
+      BOOST_CHECK_LE( chunk.objects, snapshot_chunk_header::max_objects );
+      BOOST_CHECK_EQUAL( reader.read_records().size(), chunk.objects );
+      records += chunk.objects;
+   }
+   BOOST_CHECK_EQUAL( records, state->objects.size() );
+
+   // the records of other chunks are skipped without reading them
+   auto account = accounts.begin();
+   reader.for_each_object<account_object>( [&account,&accounts]( const account_object& a ) {
+      BOOST_REQUIRE( account != accounts.end() );
+      BOOST_CHECK( a.id == account->id );
+      BOOST_CHECK_EQUAL( a.name, account->name );
+      ++account;
+   });
+   BOOST_CHECK( account == accounts.end() );
+
+   // the JSON format is the plain file of earlier versions, one object per line
+   const fc::path json_file = dir.path() / "snapshot.json";
+   write_snapshot( *state, json, json_file );
+   std::ifstream in( json_file.string() );
+   std::string line;
+   size_t lines = 0;
+   account = accounts.begin();
+   while( std::getline( in, line ) )
+   {
+      const fc::variant_object obj = fc::json::from_string( line ).get_object();
+      if( account != accounts.end() && obj["id"].as<object_id_type>( 1 ) == account->id )
+      {
+         BOOST_CHECK_EQUAL( obj["name"].as_string(), account->name );
+         ++account;
+      }
+      ++lines;
+   }
+   BOOST_CHECK_EQUAL( lines, state->objects.size() );
+   BOOST_CHECK( account == accounts.end() );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_SUITE_END()